@@ -0,0 +1,393 @@
+/*
+  export a log as one column file per message type
+
+  Each message type in the log becomes NAME.apcol in the output
+  directory holding every field of that type as a contiguous column,
+  along with the field names, units and multipliers from the FMT,
+  FMTU, UNIT and MULT messages.  See read_columns.py for a reader
+ */
+
+#include "LogExport.h"
+
+#include <AP_HAL/AP_HAL.h>
+#include <AP_HAL/utility/getopt_cpp.h>
+#include <AP_Filesystem/AP_Filesystem.h>
+
+#include <fcntl.h>
+#include <stdio.h>
+#include <errno.h>
+
+#if AP_FILESYSTEM_FILE_WRITING_ENABLED
+
+void setup();
+void loop();
+
+const AP_HAL::HAL& hal = AP_HAL::get_HAL();
+
+LogExport::~LogExport()
+{
+    for (auto *t : types) {
+        if (t == nullptr) {
+            continue;
+        }
+        for (uint8_t i=0; i<t->num_columns; i++) {
+            free(t->columns[i].data);
+        }
+        delete t;
+    }
+}
+
+/*
+  bytes taken by a field of each format character; 0 if unknown
+ */
+uint8_t LogExport::format_width(char c)
+{
+    switch (c) {
+    case 'b':
+    case 'B':
+    case 'M':
+        return 1;
+    case 'h':
+    case 'H':
+    case 'c':
+    case 'C':
+    case 'g':
+        return 2;
+    case 'i':
+    case 'I':
+    case 'f':
+    case 'e':
+    case 'E':
+    case 'L':
+    case 'n':
+        return 4;
+    case 'd':
+    case 'q':
+    case 'Q':
+        return 8;
+    case 'N':
+        return 16;
+    case 'Z':
+    case 'a':
+        return 64;
+    }
+    return 0;
+}
+
+static bool is_type(const struct log_Format &f, const char *name)
+{
+    return strncmp(f.name, name, sizeof(f.name)) == 0;
+}
+
+static bool is_metadata(const struct log_Format &f)
+{
+    return is_type(f, "FMTU") || is_type(f, "UNIT") || is_type(f, "MULT");
+}
+
+bool LogExport::type_wanted(const struct log_Format &f) const
+{
+    if (type_list == nullptr) {
+        return true;
+    }
+    char name[5] {};
+    strncpy_noterm(name, f.name, 4);
+    const size_t len = strlen(name);
+    for (const char *p = type_list; *p != 0; ) {
+        const char *comma = strchr(p, ',');
+        const size_t n = comma != nullptr ? size_t(comma - p) : strlen(p);
+        if (n == len && strncmp(p, name, len) == 0) {
+            return true;
+        }
+        p += n;
+        if (*p == ',') {
+            p++;
+        }
+    }
+    return false;
+}
+
+bool LogExport::want_msg(const struct log_Format &f)
+{
+    return is_metadata(f) || type_wanted(f);
+}
+
+bool LogExport::handle_log_format_msg(const struct log_Format &f)
+{
+    ExportType *t = types[f.type];
+    if (t != nullptr) {
+        if (memcmp(&t->fmt, &f, sizeof(f)) == 0) {
+            return true;
+        }
+        if (t->rows != 0) {
+            // keep the columns we have; messages in the new format
+            // are counted as skipped
+            ::printf("Format of type %u changed, ignoring the new format\n", f.type);
+            return true;
+        }
+        for (uint8_t i=0; i<t->num_columns; i++) {
+            free(t->columns[i].data);
+        }
+        *t = {};
+    } else {
+        if (!type_wanted(f)) {
+            return true;
+        }
+        t = NEW_NOTHROW ExportType {};
+        if (t == nullptr) {
+            ::printf("Out of memory\n");
+            return false;
+        }
+        types[f.type] = t;
+    }
+
+    t->fmt = f;
+    t->enabled = true;
+    uint16_t offset = 3;
+    for (uint8_t i=0; i<sizeof(f.format) && f.format[i] != 0; i++) {
+        const uint8_t width = format_width(f.format[i]);
+        if (width == 0 || i >= max_columns) {
+            t->enabled = false;
+            break;
+        }
+        t->columns[i].format = f.format[i];
+        t->columns[i].offset = offset;
+        t->columns[i].width = width;
+        t->num_columns++;
+        offset += width;
+    }
+    if (offset != f.length) {
+        t->enabled = false;
+    }
+    if (!t->enabled) {
+        char name[5] {};
+        strncpy_noterm(name, f.name, 4);
+        ::printf("Can not export %s: bad format '%.16s'\n", name, f.format);
+    }
+    return true;
+}
+
+bool LogExport::add_row(ExportType &t, const uint8_t *msg)
+{
+    if (t.rows == t.space) {
+        const uint32_t new_space = t.space == 0 ? 1024 : t.space * 2;
+        for (uint8_t i=0; i<t.num_columns; i++) {
+            Column &c = t.columns[i];
+            uint8_t *data = (uint8_t *)realloc(c.data, size_t(new_space) * c.width);
+            if (data == nullptr) {
+                ::printf("Out of memory\n");
+                return false;
+            }
+            c.data = data;
+        }
+        t.space = new_space;
+    }
+    for (uint8_t i=0; i<t.num_columns; i++) {
+        const Column &c = t.columns[i];
+        memcpy(&c.data[size_t(t.rows) * c.width], &msg[c.offset], c.width);
+    }
+    t.rows++;
+    return true;
+}
+
+bool LogExport::handle_msg(const struct log_Format &f, const uint8_t *msg)
+{
+    if (is_type(f, "UNIT") && f.length >= sizeof(log_Unit)) {
+        const struct log_Unit &u = *(const struct log_Unit *)msg;
+        strncpy_noterm(unit_names[uint8_t(u.type)], u.unit, sizeof(unit_names[0])-1);
+    } else if (is_type(f, "MULT") && f.length >= sizeof(log_Format_Multiplier)) {
+        const struct log_Format_Multiplier &m = *(const struct log_Format_Multiplier *)msg;
+        multiplier_values[uint8_t(m.type)] = m.multiplier;
+        have_multiplier[uint8_t(m.type)] = true;
+    } else if (is_type(f, "FMTU") && f.length >= sizeof(log_Format_Units)) {
+        const struct log_Format_Units &u = *(const struct log_Format_Units *)msg;
+        memcpy(type_units[u.format_type], u.units, sizeof(u.units));
+        memcpy(type_multipliers[u.format_type], u.multipliers, sizeof(u.multipliers));
+    }
+
+    ExportType *t = types[f.type];
+    if (t == nullptr || !t->enabled) {
+        return true;
+    }
+    if (f.length != t->fmt.length) {
+        t->skipped++;
+        return true;
+    }
+    return add_row(*t, msg);
+}
+
+bool LogExport::write_type(const ExportType &t, const char *outdir)
+{
+    const uint8_t type = t.fmt.type;
+    char name[5] {};
+    strncpy_noterm(name, t.fmt.name, 4);
+
+    char filename[256];
+    hal.util->snprintf(filename, sizeof(filename), "%s/%s.apcol", outdir, name);
+
+    apcol_header hdr {};
+    memcpy(hdr.magic, APCOL_MAGIC, sizeof(hdr.magic));
+    hdr.version = APCOL_VERSION;
+    hdr.msg_type = type;
+    hdr.num_columns = t.num_columns;
+    hdr.num_rows = t.rows;
+    memcpy(hdr.name, name, sizeof(name));
+
+    // labels are a comma-separated list with one entry per column
+    apcol_column cols[max_columns] {};
+    const char *label = t.fmt.labels;
+    const char *labels_end = t.fmt.labels + strnlen(t.fmt.labels, sizeof(t.fmt.labels));
+    uint64_t ofs = sizeof(hdr) + t.num_columns * sizeof(apcol_column);
+    for (uint8_t i=0; i<t.num_columns; i++) {
+        apcol_column &c = cols[i];
+        const char *comma = (const char *)memchr(label, ',', labels_end - label);
+        const char *end = comma != nullptr ? comma : labels_end;
+        memcpy(c.label, label, MIN(size_t(end - label), sizeof(c.label)-1));
+        label = comma != nullptr ? comma + 1 : labels_end;
+
+        // units and multipliers are only known if the log has FMTU
+        const uint8_t unit = type_units[type][i];
+        if (unit != 0) {
+            strncpy_noterm(c.unit, unit_names[unit], sizeof(c.unit)-1);
+        }
+        const uint8_t mult = type_multipliers[type][i];
+        if (mult != 0 && have_multiplier[mult]) {
+            c.multiplier = multiplier_values[mult];
+        }
+
+        c.format = t.columns[i].format;
+        c.width = t.columns[i].width;
+        c.data_offset = ofs;
+        ofs += uint64_t(t.rows) * c.width;
+        ofs = (ofs + APCOL_ALIGN - 1) & ~uint64_t(APCOL_ALIGN - 1);
+    }
+
+    auto &fs = AP::FS();
+    const int fd = fs.open(filename, O_WRONLY|O_CREAT|O_TRUNC, true);
+    if (fd == -1) {
+        ::printf("open(%s): %s\n", filename, strerror(errno));
+        return false;
+    }
+    bool ok = fs.write(fd, &hdr, sizeof(hdr)) == sizeof(hdr) &&
+              fs.write(fd, cols, t.num_columns * sizeof(apcol_column)) == int32_t(t.num_columns * sizeof(apcol_column));
+    static const uint8_t padding[APCOL_ALIGN] {};
+    for (uint8_t i=0; ok && i<t.num_columns; i++) {
+        const uint8_t *data = t.columns[i].data;
+        uint64_t len = uint64_t(t.rows) * cols[i].width;
+        while (ok && len > 0) {
+            const uint32_t n = MIN(len, uint64_t(1U<<30));
+            ok = fs.write(fd, data, n) == int32_t(n);
+            data += n;
+            len -= n;
+        }
+        const uint8_t pad = (APCOL_ALIGN - (t.rows * cols[i].width) % APCOL_ALIGN) % APCOL_ALIGN;
+        ok = ok && fs.write(fd, padding, pad) == pad;
+    }
+    if (fs.close(fd) != 0) {
+        ok = false;
+    }
+    if (!ok) {
+        ::printf("Failed to write %s\n", filename);
+        return false;
+    }
+    ::printf("%-4s %8u rows %2u columns", name, unsigned(t.rows), t.num_columns);
+    if (t.skipped != 0) {
+        ::printf(" (%u skipped)", unsigned(t.skipped));
+    }
+    ::printf("\n");
+    return true;
+}
+
+bool LogExport::write_files(const char *outdir)
+{
+    auto &fs = AP::FS();
+    if (fs.mkdir(outdir) != 0 && errno != EEXIST) {
+        ::printf("mkdir(%s): %s\n", outdir, strerror(errno));
+        return false;
+    }
+    for (const auto *t : types) {
+        if (t == nullptr || !t->enabled || t->rows == 0) {
+            continue;
+        }
+        if (!write_type(*t, outdir)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+static void usage(void)
+{
+    ::printf("Usage: LogExport [OPTIONS] LOGFILE\n");
+    ::printf("Options:\n");
+    ::printf("\t--types LIST    only export these comma-separated message types\n");
+    ::printf("\t--outdir DIR    write column files to DIR (default: current directory)\n");
+}
+
+void setup()
+{
+    uint8_t argc;
+    char * const *argv;
+    hal.util->commandline_arguments(argc, argv);
+
+    const struct GetOptLong::option options[] = {
+        // name     has_arg flag val
+        {"types",   true,   0, 't'},
+        {"outdir",  true,   0, 'o'},
+        {"help",    false,  0, 'h'},
+        {0, false, 0, 0}
+    };
+    GetOptLong gopt(argc, argv, "t:o:h", options);
+
+    static LogExport exporter;
+    const char *outdir = ".";
+    bool filtered = false;
+
+    int opt;
+    while ((opt = gopt.getoption()) != -1) {
+        switch (opt) {
+        case 't':
+            exporter.set_types(gopt.optarg);
+            filtered = true;
+            break;
+        case 'o':
+            outdir = gopt.optarg;
+            break;
+        case 'h':
+        default:
+            usage();
+            exit(0);
+        }
+    }
+    if (gopt.optind >= argc) {
+        usage();
+        exit(1);
+    }
+    const char *filename = argv[gopt.optind];
+
+    if (!exporter.open_log(filename)) {
+        ::printf("open(%s): %m\n", filename);
+        exit(1);
+    }
+    // with a type list only the wanted messages need to be visited
+    if (filtered && !exporter.stream_wanted_only()) {
+        ::printf("Unable to index %s, reading all messages\n", filename);
+    }
+    while (exporter.update()) {
+    }
+    exit(exporter.write_files(outdir) ? 0 : 1);
+}
+
+void loop()
+{
+}
+
+#else
+
+void setup() {}
+void loop() {}
+
+const AP_HAL::HAL& hal = AP_HAL::get_HAL();
+
+#endif // AP_FILESYSTEM_FILE_WRITING_ENABLED
+
+AP_HAL_MAIN();
@@ -0,0 +1,95 @@
+#pragma once
+
+#include "../Replay/DataFlashFileReader.h"
+
+/*
+  column file layout, one file per message type:
+
+    apcol_header
+    apcol_column[num_columns]
+    column data
+
+  Column data is the raw little-endian field values, width bytes per
+  row, each column starting on an 8 byte boundary so the file can be
+  memory-mapped and the columns used in place
+ */
+#define APCOL_MAGIC "APCOL\0\0"
+#define APCOL_VERSION 1
+#define APCOL_ALIGN 8
+
+struct PACKED apcol_header {
+    char magic[8];
+    uint32_t version;
+    uint8_t msg_type;
+    uint8_t num_columns;
+    uint16_t reserved;
+    uint64_t num_rows;
+    char name[8];
+};
+
+struct PACKED apcol_column {
+    char label[64];
+    char unit[64];          // empty if the log gave no unit
+    double multiplier;      // 0 if the log gave no multiplier
+    char format;            // LogStructure.h format character
+    uint8_t width;          // bytes per row
+    uint8_t reserved[6];
+    uint64_t data_offset;   // from the start of the file
+};
+
+static_assert(sizeof(apcol_header) % APCOL_ALIGN == 0, "header must keep columns aligned");
+static_assert(sizeof(apcol_column) % APCOL_ALIGN == 0, "column must keep columns aligned");
+
+class LogExport : public AP_LoggerFileReader
+{
+public:
+    LogExport() {}
+    ~LogExport();
+
+    // only export types named in this comma-separated list
+    void set_types(const char *list) { type_list = list; }
+
+    bool handle_log_format_msg(const struct log_Format &f) override;
+    bool handle_msg(const struct log_Format &f, const uint8_t *msg) override;
+    bool want_msg(const struct log_Format &f) override;
+
+    // write one column file per exported type into outdir
+    bool write_files(const char *outdir);
+
+private:
+    static constexpr uint8_t max_columns = 16;
+
+    struct Column {
+        uint8_t *data;
+        uint8_t offset;     // within the message
+        uint8_t width;
+        char format;
+    };
+
+    // rows of a single message type, stored a column at a time
+    struct ExportType {
+        struct log_Format fmt;  // format the columns were built for
+        bool enabled;
+        bool bad_format;
+        uint8_t num_columns;
+        Column columns[max_columns];
+        uint32_t rows;
+        uint32_t space;
+        uint32_t skipped;   // messages not matching the format
+    };
+    ExportType *types[LOGREADER_MAX_FORMATS] {};
+
+    // from FMTU, UNIT and MULT messages, which may come in any order
+    char type_units[LOGREADER_MAX_FORMATS][16] {};
+    char type_multipliers[LOGREADER_MAX_FORMATS][16] {};
+    char unit_names[256][64] {};
+    double multiplier_values[256] {};
+    bool have_multiplier[256] {};
+
+    const char *type_list = nullptr;
+
+    bool type_wanted(const struct log_Format &f) const;
+    bool add_row(ExportType &t, const uint8_t *msg);
+    bool write_type(const ExportType &t, const char *outdir);
+    static uint8_t format_width(char c);
+};
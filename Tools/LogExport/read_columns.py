@@ -0,0 +1,122 @@
+#!/usr/bin/env python3
+
+'''
+Read the column files written by LogExport.
+
+Each NAME.apcol file holds every field of one message type as a
+contiguous little-endian array, so columns are memory-mapped rather
+than parsed:
+
+    from read_columns import ColumnFile
+    imu = ColumnFile('out/IMU.apcol')
+    gyr_x = imu['GyrX']
+
+AP_FLAKE8_CLEAN
+'''
+
+import argparse
+import struct
+
+import numpy
+
+HEADER = struct.Struct('<8sIBBHQ8s')
+COLUMN = struct.Struct('<64s64sdcB6xQ')
+MAGIC = b'APCOL\0\0\0'
+VERSION = 1
+
+# numpy type of each LogStructure.h format character
+DTYPES = {
+    'a': ('<i2', (32,)),
+    'b': '<i1',
+    'B': '<u1',
+    'M': '<u1',
+    'h': '<i2',
+    'H': '<u2',
+    'c': '<i2',
+    'C': '<u2',
+    'g': '<f2',
+    'i': '<i4',
+    'I': '<u4',
+    'e': '<i4',
+    'E': '<u4',
+    'L': '<i4',
+    'f': '<f4',
+    'd': '<f8',
+    'q': '<i8',
+    'Q': '<u8',
+    'n': 'S4',
+    'N': 'S16',
+    'Z': 'S64',
+}
+
+# scaling implied by the format character, applied by values()
+FORMAT_SCALE = {
+    'c': 0.01,
+    'C': 0.01,
+    'e': 0.01,
+    'E': 0.01,
+    'L': 1.0e-7,
+}
+
+
+def cstr(b):
+    return b.split(b'\0', 1)[0].decode('utf-8', 'replace')
+
+
+class Column(object):
+    def __init__(self, fields):
+        (label, unit, multiplier, fmt, width, offset) = fields
+        self.label = cstr(label)
+        self.unit = cstr(unit)
+        self.multiplier = multiplier
+        self.format = fmt.decode('ascii')
+        self.width = width
+        self.offset = offset
+
+
+class ColumnFile(object):
+    '''one message type exported by LogExport'''
+
+    def __init__(self, filename):
+        self.filename = filename
+        with open(filename, 'rb') as f:
+            hdr = f.read(HEADER.size)
+            (magic, version, self.msg_type, num_columns, _, self.rows, name) = HEADER.unpack(hdr)
+            if magic != MAGIC or version != VERSION:
+                raise ValueError("%s is not a version %u column file" % (filename, VERSION))
+            self.name = cstr(name)
+            self.columns = [Column(COLUMN.unpack(f.read(COLUMN.size))) for i in range(num_columns)]
+        self.by_label = {c.label: c for c in self.columns}
+
+    def labels(self):
+        return [c.label for c in self.columns]
+
+    def __getitem__(self, label):
+        '''the raw column as stored in the log'''
+        c = self.by_label[label]
+        return numpy.memmap(self.filename, dtype=DTYPES[c.format], mode='r',
+                            offset=c.offset, shape=(self.rows,))
+
+    def values(self, label):
+        '''the column with format scaling applied, e.g. centidegrees to degrees'''
+        c = self.by_label[label]
+        scale = FORMAT_SCALE.get(c.format)
+        if scale is None:
+            return self[label]
+        return self[label] * scale
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__)
+    parser.add_argument("files", nargs="+", help="column files")
+    args = parser.parse_args()
+
+    for filename in args.files:
+        cf = ColumnFile(filename)
+        print("%s: type %u, %u rows" % (cf.name, cf.msg_type, cf.rows))
+        for c in cf.columns:
+            print("  %-16s %s %-10s %g" % (c.label, c.format, c.unit, c.multiplier))
+
+
+if __name__ == '__main__':
+    main()
@@ -0,0 +1,1042 @@
+/*
+  offline gyro filter design
+
+  Reads the raw gyro samples from a log, either the GYR messages
+  written with INS_RAW_LOG_OPT or the ISBH/ISBD batch sampler
+  messages, and replays them through the harmonic notch and gyro low
+  pass filters for each candidate configuration. In FFT tracking mode
+  the notch is driven as on the vehicle: AP_GyroFFT's frame scheduling
+  is replayed and the peaks are tracked by the same AP_GyroFFT_Tracker
+  code, with its SNR gating, peak tracking and harmonic fit. As on the
+  ground before arming, the noise reference is calibrated from the
+  first frames of the replay, so logs should start before the motors
+  do. The throttle based estimate AP_GyroFFT falls back to when no
+  peak is found is not replayed, FFT_MINHZ is used instead.
+  Configurations are spread over all cores.
+
+  For each configuration the noise attenuation, the strongest peak
+  left after filtering and the phase lag at a probe frequency are
+  reported, so filter changes can be compared against the same flight
+  without flying them.
+
+  Configurations are given with --param and, optionally, a file with
+  one configuration per line. Both take vehicle parameter names, and a
+  value may be a START:STOP:STEP range to sweep it:
+
+    NotchDesign --param INS_HNTCH_MODE=4 --param FFT_WINDOW_SIZE=32:128:32 00000042.BIN
+ */
+
+#include "NotchDesign.h"
+
+#include <AP_HAL/utility/getopt_cpp.h>
+#include <AP_InertialSensor/AP_InertialSensor.h>
+#include <Filter/HarmonicNotchFilter.h>
+#include <Filter/LowPassFilter.h>
+#include <Filter/LowPassFilter2p.h>
+
+#include <atomic>
+#include <thread>
+
+#include <stdio.h>
+#include <errno.h>
+
+#if HAL_WITH_DSP
+
+void setup();
+void loop();
+
+const AP_HAL::HAL& hal = AP_HAL::get_HAL();
+
+// as AP_GyroFFT
+#define FFT_MIN_SAMPLES_PER_FRAME 16
+#define FFT_OPTION_ALL_AXES (1U << 3)
+// gyro samples filtered together, as the backends deliver them
+#define NOTCH_DESIGN_BLOCK_SAMPLES 8
+// segments must agree on the sample rate to within this ratio
+#define NOTCH_DESIGN_RATE_TOLERANCE 0.02f
+
+/*
+  set a field from its parameter name
+ */
+bool NotchDesignConfig::set(const char *name, float value)
+{
+    if (strcmp(name, "INS_HNTCH_FREQ") == 0) {
+        hntch_freq = value;
+    } else if (strcmp(name, "INS_HNTCH_BW") == 0) {
+        hntch_bw = value;
+    } else if (strcmp(name, "INS_HNTCH_ATT") == 0) {
+        hntch_att = value;
+    } else if (strcmp(name, "INS_HNTCH_HMNCS") == 0) {
+        hntch_hmncs = uint32_t(value);
+    } else if (strcmp(name, "INS_HNTCH_OPTS") == 0) {
+        hntch_opts = uint16_t(value);
+    } else if (strcmp(name, "INS_HNTCH_MODE") == 0) {
+        hntch_mode = uint8_t(value);
+    } else if (strcmp(name, "INS_HNTCH_FM_RAT") == 0) {
+        hntch_fm_rat = value;
+    } else if (strcmp(name, "INS_GYRO_FILTER") == 0) {
+        gyro_filter = value;
+    } else if (strcmp(name, "FFT_WINDOW_SIZE") == 0) {
+        fft_window_size = uint16_t(value);
+    } else if (strcmp(name, "FFT_WINDOW_OLAP") == 0) {
+        fft_window_olap = value;
+    } else if (strcmp(name, "FFT_MINHZ") == 0) {
+        fft_minhz = value;
+    } else if (strcmp(name, "FFT_MAXHZ") == 0) {
+        fft_maxhz = value;
+    } else if (strcmp(name, "FFT_ATT_REF") == 0) {
+        fft_att_ref = value;
+    } else if (strcmp(name, "FFT_SNR_REF") == 0) {
+        fft_snr_ref = value;
+    } else if (strcmp(name, "FFT_BW_HOVER") == 0) {
+        fft_bw_hover = value;
+    } else if (strcmp(name, "FFT_HMNC_FIT") == 0) {
+        fft_hmnc_fit = uint8_t(value);
+    } else if (strcmp(name, "FFT_HMNC_PEAK") == 0) {
+        fft_hmnc_peak = uint8_t(value);
+    } else if (strcmp(name, "FFT_NUM_FRAMES") == 0) {
+        fft_num_frames = uint8_t(value);
+    } else if (strcmp(name, "FFT_OPTIONS") == 0) {
+        fft_options = uint32_t(value);
+    } else {
+        return false;
+    }
+    return true;
+}
+
+bool NotchDesignConfig::valid(void) const
+{
+    // throttle, RPM and ESC telemetry tracking need data the log replay does not have
+    if (hntch_mode != uint8_t(HarmonicNotchDynamicMode::Fixed) &&
+        hntch_mode != uint8_t(HarmonicNotchDynamicMode::UpdateGyroFFT)) {
+        return false;
+    }
+    if (fft_window_size < 32 || fft_window_size > 512 || (fft_window_size & (fft_window_size - 1)) != 0) {
+        return false;
+    }
+    // the replay has a single gyro and only its raw samples
+    if ((fft_options & ~FFT_OPTION_ALL_AXES) != 0) {
+        return false;
+    }
+    return hntch_freq > 0 && hntch_bw > 0 && hntch_hmncs != 0 &&
+        fft_window_olap >= 0 && fft_window_olap <= 0.9f &&
+        fft_minhz > 0 && fft_maxhz > fft_minhz;
+}
+
+NotchDesign::SampleSet::~SampleSet()
+{
+    free(samples);
+    free(segments);
+}
+
+bool NotchDesign::SampleSet::start_segment(float rate)
+{
+    if (active) {
+        abandon_segment();
+    }
+    if (num_segments == segment_space) {
+        const uint16_t new_space = segment_space == 0 ? 64 : segment_space * 2;
+        Segment *s = (Segment *)realloc(segments, new_space * sizeof(Segment));
+        if (s == nullptr) {
+            return false;
+        }
+        segments = s;
+        segment_space = new_space;
+    }
+    segment_start = num_samples;
+    rate_hz = rate;
+    active = true;
+    return true;
+}
+
+bool NotchDesign::SampleSet::add(const Vector3f &sample)
+{
+    if (num_samples == sample_space) {
+        const uint32_t new_space = sample_space == 0 ? 65536 : sample_space * 2;
+        Vector3f *s = (Vector3f *)realloc(samples, size_t(new_space) * sizeof(Vector3f));
+        if (s == nullptr) {
+            return false;
+        }
+        samples = s;
+        sample_space = new_space;
+    }
+    samples[num_samples++] = sample;
+    return true;
+}
+
+void NotchDesign::SampleSet::end_segment(uint32_t min_samples)
+{
+    if (!active) {
+        return;
+    }
+    const uint32_t count = num_samples - segment_start;
+    if (count < min_samples || !is_positive(rate_hz)) {
+        abandon_segment();
+        return;
+    }
+    segments[num_segments++] = Segment { segment_start, count, rate_hz };
+    active = false;
+}
+
+NotchDesign::Spectrum::~Spectrum()
+{
+    delete state;
+    delete[] power;
+}
+
+bool NotchDesign::Spectrum::init(float rate)
+{
+    state = hal.dsp->fft_init(psd_window, uint16_t(rate));
+    if (state == nullptr) {
+        return false;
+    }
+    bin_resolution = state->_bin_resolution;
+    bin_count = state->_bin_count;
+    power = NEW_NOTHROW float[bin_count];
+    if (power == nullptr) {
+        return false;
+    }
+    for (uint8_t axis = 0; axis < XYZ_AXIS_COUNT; axis++) {
+        if (!buffers[axis].set_size(psd_window + psd_window / 2)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+void NotchDesign::Spectrum::restart(void)
+{
+    for (uint8_t axis = 0; axis < XYZ_AXIS_COUNT; axis++) {
+        buffers[axis].clear();
+    }
+}
+
+/*
+  add a sample, accumulating a frame of each axis into the spectrum
+  every half window
+ */
+void NotchDesign::Spectrum::push(const Vector3f &sample)
+{
+    buffers[0].push(sample.x);
+    buffers[1].push(sample.y);
+    buffers[2].push(sample.z);
+    if (buffers[0].available() < psd_window) {
+        return;
+    }
+    for (uint8_t axis = 0; axis < XYZ_AXIS_COUNT; axis++) {
+        hal.dsp->fft_start(state, buffers[axis], psd_window / 2);
+        hal.dsp->fft_analyse(state, 1, bin_count - 1, 0.5f);
+        for (uint16_t k = 0; k < bin_count; k++) {
+            power[k] += state->_freq_bins[k];
+        }
+    }
+}
+
+NotchDesign::Tracking::~Tracking()
+{
+    delete fft;
+}
+
+/*
+  set up as AP_GyroFFT::init() and update_parameters() set up the
+  analysis of the gyro, for the one harmonic notch it drives
+ */
+bool NotchDesign::Tracking::init(const NotchDesignConfig &config, float rate_hz)
+{
+    const uint16_t fft_rate_hz = rate_hz;
+    samples_per_frame = (1.0f - config.fft_window_olap) * config.fft_window_size;
+    samples_per_frame = MAX(FFT_MIN_SAMPLES_PER_FRAME, 1 << lrintf(log2f(samples_per_frame)));
+    uint8_t num_frames = 0;
+    if (config.fft_num_frames > 0) {
+        num_frames = constrain_int16(config.fft_num_frames, 2, AP_HAL::DSP::MAX_SLIDING_WINDOW_SIZE);
+    }
+    fft = hal.dsp->fft_init(config.fft_window_size, fft_rate_hz, num_frames);
+    if (fft == nullptr) {
+        return false;
+    }
+    for (uint8_t axis = 0; axis < XYZ_AXIS_COUNT; axis++) {
+        if (!buffers[axis].set_size(config.fft_window_size + samples_per_frame)) {
+            return false;
+        }
+    }
+
+    // AP_InertialSensor gives a dynamic harmonic notch driven by the FFT three notches
+    dynamic_harmonic = (config.hntch_opts & uint16_t(HarmonicNotchFilterParams::Options::DynamicHarmonic)) != 0;
+    const uint8_t num_notches = dynamic_harmonic ? AP_HAL::DSP::MAX_TRACKED_PEAKS : 1;
+    const uint16_t fft_max_hz = MIN(config.fft_maxhz, fft_rate_hz * 0.48f);
+
+    tracker_config._fft_min_hz = config.fft_minhz;
+    tracker_config._fft_max_hz = fft_max_hz;
+    tracker_config._snr_threshold_db = config.fft_snr_ref;
+    tracker_config._tracked_peaks = AP_GyroFFT_Tracker::calculate_tracked_peaks(config.hntch_hmncs, num_notches);
+    if (config.fft_hmnc_fit > 0) {
+        tracker_config._harmonic_multiplier = AP_GyroFFT_Tracker::calculate_harmonic_multiplier(config.hntch_hmncs);
+    }
+    tracker_config._bandwidth_hover_hz = config.fft_bw_hover;
+    start_bin = MAX(floorf(config.fft_minhz / fft->_bin_resolution), 1);
+    end_bin = MIN(ceilf(fft_max_hz / fft->_bin_resolution), fft->_bin_count);
+    attenuation_cutoff = powf(10.0f, -config.fft_att_ref * 0.1f);
+    harmonic_peak = config.fft_hmnc_peak;
+    harmonic_fit = config.fft_hmnc_fit;
+    all_axes = (config.fft_options & FFT_OPTION_ALL_AXES) != 0;
+
+    return tracker.init(config.fft_window_size, samples_per_frame, fft_rate_hz, false, tracker_config._fft_min_hz, state);
+}
+
+void NotchDesign::Tracking::restart(void)
+{
+    for (uint8_t axis = 0; axis < XYZ_AXIS_COUNT; axis++) {
+        buffers[axis].clear();
+    }
+}
+
+/*
+  add a sample to the gyro window and run the frames
+  AP_GyroFFT::run_cycle() would. The FFT thread keeps up with the
+  samples, so each frame is run as soon as it can be
+ */
+void NotchDesign::Tracking::push(const Vector3f &sample)
+{
+    buffers[0].push(sample.x);
+    buffers[1].push(sample.y);
+    buffers[2].push(sample.z);
+    sample_count++;
+
+    while (get_frame_samples() >= fft->_window_size) {
+        if (all_axes) {
+            for (uint8_t axis = 0; axis < XYZ_AXIS_COUNT; axis++) {
+                analyse_axis(axis);
+            }
+        } else {
+            analyse_axis(update_axis);
+            update_axis = (update_axis + 1) % XYZ_AXIS_COUNT;
+        }
+    }
+}
+
+uint16_t NotchDesign::Tracking::get_frame_samples(void) const
+{
+    if (all_axes) {
+        return MIN(MIN(buffers[0].available(), buffers[1].available()), buffers[2].available());
+    }
+    return buffers[update_axis].available();
+}
+
+/*
+  one axis of a frame, as AP_GyroFFT::analyse_axis()
+ */
+void NotchDesign::Tracking::analyse_axis(uint8_t axis)
+{
+    FloatBuffer &buffer = buffers[axis];
+    if (buffer.available() > uint32_t(fft->_window_size + uint16_t(samples_per_frame >> 1))) {
+        buffer.advance(buffer.available() - fft->_window_size);
+    }
+    hal.dsp->fft_start(fft, buffer, samples_per_frame);
+    hal.dsp->fft_analyse(fft, start_bin, end_bin, attenuation_cutoff);
+
+    tracker.update_ref_energy(*fft, axis, state, sem);
+    if (tracker.calculate_noise(*fft, axis, false, tracker_config, state) > 0) {
+        health_sample[axis] = sample_count;
+    } else {
+        health_sample[axis] = 0;
+    }
+}
+
+/*
+  the frequencies AP_GyroFFT gives the vehicle, with an axis healthy
+  while it has had a peak within the last FFT_MAX_MISSED_UPDATES
+  frames
+ */
+uint8_t NotchDesign::Tracking::get_notch_frequencies_hz(float *freqs) const
+{
+    const uint32_t output_delay = samples_per_frame * FFT_MAX_MISSED_UPDATES;
+    Vector3<uint8_t> health = state._health;
+    for (uint8_t axis = 0; axis < XYZ_AXIS_COUNT; axis++) {
+        if (health_sample[axis] == 0 || sample_count - health_sample[axis] > output_delay) {
+            health[axis] = 0;
+        }
+    }
+
+    uint8_t num_freqs = 1;
+    if (health.is_zero()) {
+        // in place of the throttle based estimate
+        freqs[0] = tracker_config._fft_min_hz;
+    } else if (dynamic_harmonic) {
+        num_freqs = AP_GyroFFT_Tracker::get_weighted_noise_center_frequencies_hz(state, health, harmonic_peak,
+                                                                                 AP_HAL::DSP::MAX_TRACKED_PEAKS, freqs);
+    } else {
+        freqs[0] = AP_GyroFFT_Tracker::get_weighted_noise_center_freq_hz(state, health, harmonic_peak, harmonic_fit);
+    }
+    // as AP_InertialSensor::HarmonicNotch::update_frequencies_hz()
+    for (uint8_t i = 0; i < num_freqs; i++) {
+        freqs[i] = fabsf(freqs[i]);
+    }
+    return num_freqs;
+}
+
+static bool is_type(const struct log_Format &f, const char *name)
+{
+    return strncmp(f.name, name, sizeof(f.name)) == 0;
+}
+
+bool NotchDesign::want_msg(const struct log_Format &f)
+{
+    return is_type(f, "ISBH") || is_type(f, "ISBD") || is_type(f, "GYR");
+}
+
+bool NotchDesign::handle_msg(const struct log_Format &f, uint8_t *msg)
+{
+    if (is_type(f, "ISBH") && f.length == sizeof(log_ISBH)) {
+        handle_isbh(msg);
+    } else if (is_type(f, "ISBD") && f.length == sizeof(log_ISBD)) {
+        handle_isbd(msg);
+    } else if (is_type(f, "GYR") && f.length == sizeof(log_GYR)) {
+        handle_gyr(msg);
+    }
+    return true;
+}
+
+/*
+  the start of a batch; a batch that was not completed is dropped
+ */
+void NotchDesign::handle_isbh(const uint8_t *msg)
+{
+    const struct log_ISBH &h = *(const struct log_ISBH *)msg;
+    if (h.sensor_type != AP_InertialSensor::IMU_SENSOR_TYPE_GYRO || h.instance != instance) {
+        return;
+    }
+    if (h.multiplier == 0 || h.sample_count == 0) {
+        return;
+    }
+    if (!batch.start_segment(h.sample_rate_hz)) {
+        ::printf("Out of memory\n");
+        return;
+    }
+    batch_seqno = h.seqno;
+    batch_remaining = h.sample_count;
+    batch_multiplier = h.multiplier;
+}
+
+void NotchDesign::handle_isbd(const uint8_t *msg)
+{
+    const struct log_ISBD &d = *(const struct log_ISBD *)msg;
+    if (!batch.active || d.isb_seqno != batch_seqno) {
+        return;
+    }
+    const uint16_t n = MIN(batch_remaining, uint16_t(ARRAY_SIZE(d.x)));
+    for (uint16_t i = 0; i < n; i++) {
+        if (!batch.add(Vector3f(d.x[i], d.y[i], d.z[i]) / batch_multiplier)) {
+            ::printf("Out of memory\n");
+            batch.abandon_segment();
+            return;
+        }
+    }
+    batch_remaining -= n;
+    if (batch_remaining == 0) {
+        batch.end_segment(2 * psd_window);
+    }
+}
+
+/*
+  GYR samples are split into segments wherever there is a gap, and the
+  rate of each segment comes from its timestamps
+ */
+void NotchDesign::handle_gyr(const uint8_t *msg)
+{
+    const struct log_GYR &g = *(const struct log_GYR *)msg;
+    if (g.instance != instance) {
+        return;
+    }
+    if (fast.active) {
+        const uint32_t count = fast.segment_count();
+        const uint64_t dt_us = g.sample_us - fast_last_us;
+        // allow for jitter but not for missing samples
+        const uint64_t max_dt_us = count > 1 ? 3 * (fast_last_us - fast_first_us) / (count - 1) : 20000;
+        if (g.sample_us <= fast_last_us || dt_us > max_dt_us) {
+            fast.rate_hz = count > 1 ? (count - 1) * 1.0e6f / (fast_last_us - fast_first_us) : 0;
+            fast.end_segment(2 * psd_window);
+        }
+    }
+    if (!fast.active) {
+        if (!fast.start_segment(0)) {
+            ::printf("Out of memory\n");
+            return;
+        }
+        fast_first_us = g.sample_us;
+    }
+    if (!fast.add(Vector3f(g.GyrX, g.GyrY, g.GyrZ))) {
+        ::printf("Out of memory\n");
+        fast.abandon_segment();
+        return;
+    }
+    fast_last_us = g.sample_us;
+}
+
+bool NotchDesign::segment_used(const Segment &seg) const
+{
+    return fabsf(seg.rate_hz - rate_hz) <= rate_hz * NOTCH_DESIGN_RATE_TOLERANCE;
+}
+
+/*
+  pick the samples to replay and calculate the spectrum of the input
+  that every configuration is measured against
+ */
+bool NotchDesign::prepare(void)
+{
+    if (fast.active) {
+        const uint32_t count = fast.segment_count();
+        fast.rate_hz = count > 1 ? (count - 1) * 1.0e6f / (fast_last_us - fast_first_us) : 0;
+        fast.end_segment(2 * psd_window);
+    }
+    batch.abandon_segment();
+
+    if (fast.num_segments > 0 && !(prefer_batch && batch.num_segments > 0)) {
+        replay = &fast;
+        ::printf("Using %u GYR samples in %u segments\n", unsigned(fast.num_samples), fast.num_segments);
+    } else if (batch.num_segments > 0) {
+        replay = &batch;
+        ::printf("Using %u batch samples in %u batches\n", unsigned(batch.num_samples), batch.num_segments);
+    } else {
+        ::printf("No usable gyro samples for instance %u\n", instance);
+        return false;
+    }
+
+    // replay at the rate of the longest segment
+    const Segment *longest = &replay->segments[0];
+    for (uint16_t s = 1; s < replay->num_segments; s++) {
+        if (replay->segments[s].count > longest->count) {
+            longest = &replay->segments[s];
+        }
+    }
+    rate_hz = longest->rate_hz;
+
+    uint16_t skipped = 0;
+    for (uint16_t s = 0; s < replay->num_segments; s++) {
+        if (!segment_used(replay->segments[s])) {
+            skipped++;
+        }
+    }
+    if (skipped > 0) {
+        ::printf("Skipping %u segments not at %.1fHz\n", skipped, rate_hz);
+    }
+
+    // leave out the first psd window, or 0.1s, of each segment
+    settle_samples = MAX(uint32_t(psd_window), uint32_t(rate_hz * 0.1f));
+
+    if (!input.init(rate_hz)) {
+        ::printf("Unable to allocate spectrum\n");
+        return false;
+    }
+    for (uint16_t s = 0; s < replay->num_segments; s++) {
+        const Segment &seg = replay->segments[s];
+        if (!segment_used(seg)) {
+            continue;
+        }
+        input.restart();
+        for (uint32_t i = settle_samples; i < seg.count; i++) {
+            input.push(replay->samples[seg.start + i]);
+        }
+    }
+    ::printf("Sample rate %.1fHz, spectrum resolution %.1fHz\n", rate_hz, input.bin_resolution);
+    return true;
+}
+
+/*
+  replay the samples through one filter configuration
+ */
+void NotchDesign::evaluate(const NotchDesignConfig &config, NotchDesignResult &result) const
+{
+    result = {};
+
+    HarmonicNotchFilterParams params {};
+    params.set_center_freq_hz(config.hntch_freq);
+    params.set_bandwidth_hz(config.hntch_bw);
+    params.set_attenuation(config.hntch_att);
+    params.set_harmonics(config.hntch_hmncs);
+    params.set_options(config.hntch_opts);
+    params.set_freq_min_ratio(config.hntch_fm_rat);
+
+    // FFT tracking of every peak is notched with dynamic harmonics, as AP_InertialSensor sets it up
+    const bool tracking = config.hntch_mode == uint8_t(HarmonicNotchDynamicMode::UpdateGyroFFT);
+    uint8_t num_notches = 1;
+    if (tracking && params.hasOption(HarmonicNotchFilterParams::Options::DynamicHarmonic)) {
+        num_notches = AP_HAL::DSP::MAX_TRACKED_PEAKS;
+    }
+
+    HarmonicNotchFilterVector3f notch;
+    notch.allocate_filters(num_notches, config.hntch_hmncs, params.num_composite_notches());
+    notch.init(rate_hz, params);
+    LowPassFilter2pVector3f lpf {rate_hz, config.gyro_filter};
+
+    // the same chain on a single axis, fed a sine to measure the phase lag
+    HarmonicNotchFilter<float> probe_notch;
+    probe_notch.allocate_filters(num_notches, config.hntch_hmncs, params.num_composite_notches());
+    probe_notch.init(rate_hz, params);
+    LowPassFilter2pFloat probe_lpf {rate_hz, config.gyro_filter};
+    const double probe_rad_per_sample = 2 * M_PI * lag_freq_hz / rate_hz;
+    double total_lag_samples = 0;
+    uint32_t lag_count = 0;
+
+    Spectrum output;
+    if (!output.init(rate_hz)) {
+        return;
+    }
+
+    // FFT tracking, allocated zeroed as AP_GyroFFT's state is
+    Tracking *fft_tracking = nullptr;
+    if (tracking) {
+        fft_tracking = NEW_NOTHROW Tracking;
+        if (fft_tracking == nullptr || !fft_tracking->init(config, rate_hz)) {
+            delete fft_tracking;
+            return;
+        }
+    }
+
+    double notch_sum = 0;
+    uint32_t notch_count = 0;
+
+    for (uint16_t s = 0; s < replay->num_segments; s++) {
+        const Segment &seg = replay->segments[s];
+        if (!segment_used(seg)) {
+            continue;
+        }
+
+        // every segment starts from rest, as after a gap in the log
+        float notch_hz = config.hntch_freq;
+        bool notch_active = true;
+        notch.reset();
+        notch.update(notch_hz);
+        lpf.reset();
+        probe_notch.reset();
+        probe_notch.update(notch_hz);
+        probe_lpf.reset();
+        output.restart();
+        if (tracking) {
+            fft_tracking->restart();
+        }
+        double last_in = 0;
+        double last_out = 0;
+        double last_crossing = -1;
+
+        for (uint32_t i = 0; i < seg.count; i += NOTCH_DESIGN_BLOCK_SAMPLES) {
+            const uint16_t n = MIN(uint32_t(NOTCH_DESIGN_BLOCK_SAMPLES), seg.count - i);
+            Vector3f block[NOTCH_DESIGN_BLOCK_SAMPLES];
+            memcpy(block, &replay->samples[seg.start + i], n * sizeof(Vector3f));
+
+            if (tracking) {
+                for (uint16_t j = 0; j < n; j++) {
+                    fft_tracking->push(block[j]);
+                }
+                // the notch follows the tracking as AP_Vehicle::update_dynamic_notch() updates it
+                float freqs[AP_HAL::DSP::MAX_TRACKED_PEAKS];
+                const uint8_t num_freqs = fft_tracking->get_notch_frequencies_hz(freqs);
+                notch_active = num_freqs > 0;
+                if (notch_active) {
+                    notch_hz = freqs[0];
+                    notch.update(num_freqs, freqs);
+                    probe_notch.update(num_freqs, freqs);
+                }
+            }
+
+            // an inactive notch is reset so it starts afresh, as the backends do
+            if (notch_active) {
+                notch.apply(block, n);
+            } else {
+                notch.reset();
+                probe_notch.reset();
+            }
+            lpf.apply(block, n);
+
+            for (uint16_t j = 0; j < n; j++) {
+                const uint32_t k = i + j;
+                const double in = sin(probe_rad_per_sample * k);
+                const double out = probe_lpf.apply(notch_active ? probe_notch.apply(float(in)) : float(in));
+                if (k >= settle_samples) {
+                    output.push(block[j]);
+                    // rising zero crossings interpolated between samples, as in the notch filter tests
+                    if (in >= 0 && last_in < 0) {
+                        last_crossing = k + in / (last_in - in);
+                    }
+                    if (out >= 0 && last_out < 0 && last_crossing >= 0) {
+                        total_lag_samples += (k + out / (last_out - out)) - last_crossing;
+                        lag_count++;
+                    }
+                }
+                last_in = in;
+                last_out = out;
+            }
+            if (notch_active) {
+                notch_sum += double(notch_hz) * n;
+                notch_count += n;
+            }
+        }
+    }
+    delete fft_tracking;
+
+    if (lag_count > 0) {
+        const float lag_samples = total_lag_samples / lag_count;
+        result.lag_deg = 360.0f * lag_samples * lag_freq_hz / rate_hz;
+        result.lag_ms = 1000.0f * lag_samples / rate_hz;
+    }
+    result.mean_notch_hz = notch_count > 0 ? notch_sum / notch_count : config.hntch_freq;
+    measure(config, output, result);
+}
+
+/*
+  attenuation of the filtered spectrum relative to the input
+ */
+void NotchDesign::measure(const NotchDesignConfig &config, const Spectrum &out, NotchDesignResult &result) const
+{
+    const float res = input.bin_resolution;
+    const float max_hz = MIN(config.fft_maxhz, rate_hz * 0.5f);
+    const uint16_t lo = constrain_int32(ceilf(config.fft_minhz / res), 1, input.bin_count - 1);
+    const uint16_t hi = constrain_int32(floorf(max_hz / res), lo, input.bin_count - 1);
+
+    double in_sum = 0;
+    double out_sum = 0;
+    uint16_t in_peak = lo;
+    uint16_t out_peak = lo;
+    for (uint16_t k = lo; k <= hi; k++) {
+        in_sum += input.power[k];
+        out_sum += out.power[k];
+        if (input.power[k] > input.power[in_peak]) {
+            in_peak = k;
+        }
+        if (out.power[k] > out.power[out_peak]) {
+            out_peak = k;
+        }
+    }
+    if (!is_positive(in_sum)) {
+        return;
+    }
+    result.band_att_db = 10.0f * log10f(in_sum / MAX(out_sum, double(FLT_MIN)));
+    result.peak_att_db = 10.0f * log10f(input.power[in_peak] / MAX(out.power[in_peak], FLT_MIN));
+    result.residual_peak_hz = out_peak * res;
+    result.valid = true;
+}
+
+/*
+  evaluate the configurations on a pool of threads, each taking the
+  next configuration as it finishes the last. The samples and input
+  spectrum are only read once prepared
+ */
+void NotchDesign::run(const NotchDesignConfig *configs, NotchDesignResult *results, uint32_t count, uint8_t jobs) const
+{
+    static const uint8_t max_jobs = 64;
+    std::atomic<uint32_t> next {0};
+    std::thread threads[max_jobs];
+
+    jobs = constrain_int16(jobs, 1, max_jobs);
+    for (uint8_t t = 0; t < jobs; t++) {
+        threads[t] = std::thread([this, configs, results, count, &next]() {
+            for (uint32_t i = next++; i < count; i = next++) {
+                evaluate(configs[i], results[i]);
+            }
+        });
+    }
+    for (uint8_t t = 0; t < jobs; t++) {
+        threads[t].join();
+    }
+}
+
+/*
+  parameter settings, each a single value or a START:STOP:STEP range
+ */
+struct ParamRange {
+    char name[17];
+    float start;
+    float stop;
+    float step;
+};
+
+static bool parse_range(const char *arg, ParamRange &r)
+{
+    const char *eq = strchr(arg, '=');
+    if (eq == nullptr || eq == arg || size_t(eq - arg) >= sizeof(r.name)) {
+        return false;
+    }
+    memset(r.name, 0, sizeof(r.name));
+    memcpy(r.name, arg, eq - arg);
+    NotchDesignConfig check;
+    if (!check.set(r.name, 0)) {
+        ::printf("Unknown parameter %s\n", r.name);
+        return false;
+    }
+    char *end;
+    r.start = strtof(eq + 1, &end);
+    r.stop = r.start;
+    r.step = 1;
+    if (*end == ':') {
+        r.stop = strtof(end + 1, &end);
+        if (*end != ':') {
+            return false;
+        }
+        r.step = strtof(end + 1, &end);
+        if (!is_positive(r.step) || r.stop < r.start) {
+            return false;
+        }
+    }
+    return *end == 0;
+}
+
+/*
+  add the cross product of the ranges to configs
+ */
+static bool expand_ranges(const ParamRange *ranges, uint8_t num_ranges, NotchDesignConfig config,
+                          NotchDesignConfig *configs, uint32_t &count, uint32_t max_count)
+{
+    if (num_ranges == 0) {
+        if (count == max_count) {
+            ::printf("Too many configurations, limit is %u\n", unsigned(max_count));
+            return false;
+        }
+        configs[count++] = config;
+        return true;
+    }
+    const ParamRange &r = ranges[0];
+    const uint32_t steps = uint32_t((r.stop - r.start) / r.step + 0.5f) + 1;
+    for (uint32_t i = 0; i < steps; i++) {
+        config.set(r.name, r.start + i * r.step);
+        if (!expand_ranges(&ranges[1], num_ranges - 1, config, configs, count, max_count)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+static const uint8_t max_ranges = 32;
+static const uint32_t max_configs = 10000;
+
+/*
+  read one configuration, or sweep, per line; the --param settings
+  apply to every line and a line may override them
+ */
+static bool load_configs(const char *filename, const ParamRange *base, uint8_t num_base,
+                         NotchDesignConfig *configs, uint32_t &count)
+{
+    FILE *f = ::fopen(filename, "r");
+    if (f == nullptr) {
+        ::printf("open(%s): %s\n", filename, strerror(errno));
+        return false;
+    }
+    char line[512];
+    uint32_t line_num = 0;
+    bool ok = true;
+    while (ok && fgets(line, sizeof(line), f) != nullptr) {
+        line_num++;
+        char *hash = strchr(line, '#');
+        if (hash != nullptr) {
+            *hash = 0;
+        }
+        ParamRange ranges[max_ranges];
+        memcpy(ranges, base, num_base * sizeof(ParamRange));
+        uint8_t num_ranges = num_base;
+        bool empty = true;
+        char *saveptr = nullptr;
+        for (char *tok = strtok_r(line, " \t\r\n", &saveptr); tok != nullptr; tok = strtok_r(nullptr, " \t\r\n", &saveptr)) {
+            if (num_ranges == max_ranges || !parse_range(tok, ranges[num_ranges])) {
+                ::printf("%s:%u: bad setting '%s'\n", filename, unsigned(line_num), tok);
+                ok = false;
+                break;
+            }
+            num_ranges++;
+            empty = false;
+        }
+        if (ok && !empty) {
+            ok = expand_ranges(ranges, num_ranges, NotchDesignConfig(), configs, count, max_configs);
+        }
+    }
+    fclose(f);
+    return ok;
+}
+
+static bool write_csv(const char *filename, const NotchDesignConfig *configs, const NotchDesignResult *results, uint32_t count)
+{
+    FILE *f = ::fopen(filename, "w");
+    if (f == nullptr) {
+        ::printf("open(%s): %s\n", filename, strerror(errno));
+        return false;
+    }
+    fprintf(f, "Config,INS_HNTCH_MODE,INS_HNTCH_FREQ,INS_HNTCH_BW,INS_HNTCH_ATT,INS_HNTCH_HMNCS,INS_HNTCH_OPTS,INS_HNTCH_FM_RAT,"
+            "INS_GYRO_FILTER,FFT_WINDOW_SIZE,FFT_WINDOW_OLAP,FFT_MINHZ,FFT_MAXHZ,FFT_ATT_REF,"
+            "FFT_SNR_REF,FFT_BW_HOVER,FFT_HMNC_FIT,FFT_HMNC_PEAK,FFT_NUM_FRAMES,FFT_OPTIONS,"
+            "BandAtt(dB),PeakAtt(dB),ResidualPeak(Hz),Lag(deg),Lag(ms),MeanNotch(Hz)\n");
+    for (uint32_t i = 0; i < count; i++) {
+        const NotchDesignConfig &c = configs[i];
+        const NotchDesignResult &r = results[i];
+        fprintf(f, "%u,%u,%.1f,%.1f,%.1f,%u,%u,%.2f,%.1f,%u,%.2f,%.1f,%.1f,%.1f,%.1f,%.1f,%u,%u,%u,%u,",
+                unsigned(i), c.hntch_mode, c.hntch_freq, c.hntch_bw, c.hntch_att, unsigned(c.hntch_hmncs),
+                c.hntch_opts, c.hntch_fm_rat, c.gyro_filter, c.fft_window_size, c.fft_window_olap,
+                c.fft_minhz, c.fft_maxhz, c.fft_att_ref, c.fft_snr_ref, c.fft_bw_hover,
+                c.fft_hmnc_fit, c.fft_hmnc_peak, c.fft_num_frames, unsigned(c.fft_options));
+        if (r.valid) {
+            fprintf(f, "%.2f,%.2f,%.1f,%.2f,%.3f,%.1f\n",
+                    r.band_att_db, r.peak_att_db, r.residual_peak_hz, r.lag_deg, r.lag_ms, r.mean_notch_hz);
+        } else {
+            fprintf(f, ",,,,,\n");
+        }
+    }
+    return fclose(f) == 0;
+}
+
+static void usage(void)
+{
+    ::printf("Usage: NotchDesign [OPTIONS] LOGFILE\n");
+    ::printf("Options:\n");
+    ::printf("\t--param NAME=VALUE      set a parameter for every configuration, VALUE may be START:STOP:STEP\n");
+    ::printf("\t--configs FILE          one configuration per line, as NAME=VALUE settings\n");
+    ::printf("\t--instance N            gyro instance to replay (default 0)\n");
+    ::printf("\t--batch                 replay ISBH/ISBD batch samples even if GYR samples are present\n");
+    ::printf("\t--lag-freq HZ           frequency to measure phase lag at (default 20)\n");
+    ::printf("\t--jobs N                number of threads (default: one per core)\n");
+    ::printf("\t--output FILE           write the results as CSV\n");
+    ::printf("FFT tracking (INS_HNTCH_MODE=4) calibrates its noise reference from the start of the log\n");
+    ::printf("and uses FFT_MINHZ in place of the throttle based estimate when no peak is found.\n");
+}
+
+void setup()
+{
+    uint8_t argc;
+    char * const *argv;
+    hal.util->commandline_arguments(argc, argv);
+
+    const struct GetOptLong::option options[] = {
+        // name         has_arg flag val
+        {"param",       true,   0, 'p'},
+        {"configs",     true,   0, 'c'},
+        {"instance",    true,   0, 'i'},
+        {"batch",       false,  0, 'b'},
+        {"lag-freq",    true,   0, 'l'},
+        {"jobs",        true,   0, 'j'},
+        {"output",      true,   0, 'o'},
+        {"help",        false,  0, 'h'},
+        {0, false, 0, 0}
+    };
+    GetOptLong gopt(argc, argv, "p:c:i:bl:j:o:h", options);
+
+    static NotchDesign design;
+    static ParamRange base[max_ranges];
+    uint8_t num_base = 0;
+    const char *config_file = nullptr;
+    const char *output_file = nullptr;
+    uint8_t jobs = constrain_int32(std::thread::hardware_concurrency(), 1, UINT8_MAX);
+
+    int opt;
+    while ((opt = gopt.getoption()) != -1) {
+        switch (opt) {
+        case 'p':
+            if (num_base == max_ranges || !parse_range(gopt.optarg, base[num_base])) {
+                ::printf("Bad setting '%s'\n", gopt.optarg);
+                exit(1);
+            }
+            num_base++;
+            break;
+        case 'c':
+            config_file = gopt.optarg;
+            break;
+        case 'i':
+            design.set_instance(atoi(gopt.optarg));
+            break;
+        case 'b':
+            design.set_prefer_batch(true);
+            break;
+        case 'l':
+            design.set_lag_freq(atof(gopt.optarg));
+            break;
+        case 'j':
+            jobs = atoi(gopt.optarg);
+            break;
+        case 'o':
+            output_file = gopt.optarg;
+            break;
+        case 'h':
+        default:
+            usage();
+            exit(0);
+        }
+    }
+    if (gopt.optind >= argc) {
+        usage();
+        exit(1);
+    }
+    const char *filename = argv[gopt.optind];
+
+    NotchDesignConfig *configs = NEW_NOTHROW NotchDesignConfig[max_configs];
+    if (configs == nullptr) {
+        ::printf("Out of memory\n");
+        exit(1);
+    }
+    uint32_t count = 0;
+    if (config_file != nullptr) {
+        if (!load_configs(config_file, base, num_base, configs, count)) {
+            exit(1);
+        }
+    } else if (!expand_ranges(base, num_base, NotchDesignConfig(), configs, count, max_configs)) {
+        exit(1);
+    }
+    for (uint32_t i = 0; i < count; i++) {
+        if (!configs[i].valid()) {
+            ::printf("Configuration %u can not be replayed; only INS_HNTCH_MODE 0 and 4 are supported\n", unsigned(i));
+            exit(1);
+        }
+    }
+
+    if (!design.open_log(filename)) {
+        ::printf("open(%s): %m\n", filename);
+        exit(1);
+    }
+    if (!design.stream_wanted_only()) {
+        ::printf("Unable to index %s, reading all messages\n", filename);
+    }
+    while (design.update()) {
+    }
+    if (!design.prepare()) {
+        exit(1);
+    }
+
+    NotchDesignResult *results = NEW_NOTHROW NotchDesignResult[count];
+    if (results == nullptr) {
+        ::printf("Out of memory\n");
+        exit(1);
+    }
+    const uint64_t start_us = AP_HAL::micros64();
+    design.run(configs, results, count, jobs);
+    ::printf("Replayed %u configurations in %.1fs\n", unsigned(count), (AP_HAL::micros64() - start_us) * 1.0e-6f);
+
+    ::printf("%6s %4s %7s %6s %5s %6s %5s | %8s %8s %8s %8s %7s\n",
+             "Config", "Mode", "Freq", "BW", "Att", "LPF", "Win",
+             "BandAtt", "PeakAtt", "Resid", "Lag", "Notch");
+    for (uint32_t i = 0; i < count; i++) {
+        const NotchDesignConfig &c = configs[i];
+        const NotchDesignResult &r = results[i];
+        ::printf("%6u %4u %7.1f %6.1f %5.1f %6.1f %5u | ",
+                 unsigned(i), c.hntch_mode,
+                 c.hntch_freq, c.hntch_bw, c.hntch_att, c.gyro_filter, c.fft_window_size);
+        if (r.valid) {
+            ::printf("%6.1fdB %6.1fdB %6.1fHz %6.1fms %5.1fHz\n",
+                     r.band_att_db, r.peak_att_db, r.residual_peak_hz, r.lag_ms, r.mean_notch_hz);
+        } else {
+            ::printf("no result\n");
+        }
+    }
+
+    if (output_file != nullptr && !write_csv(output_file, configs, results, count)) {
+        exit(1);
+    }
+    exit(0);
+}
+
+void loop()
+{
+}
+
+#else
+
+void setup() {}
+void loop() {}
+
+const AP_HAL::HAL& hal = AP_HAL::get_HAL();
+
+#endif // HAL_WITH_DSP
+
+AP_HAL_MAIN();
@@ -0,0 +1,206 @@
+#pragma once
+
+#include "../Replay/DataFlashFileReader.h"
+
+#include <AP_HAL/AP_HAL.h>
+#include <AP_Math/AP_Math.h>
+#include <AP_GyroFFT/AP_GyroFFT_Tracker.h>
+
+/*
+  one candidate gyro filter configuration. Fields mirror, and are set
+  by the names of, the vehicle parameters they stand in for
+ */
+struct NotchDesignConfig {
+    float hntch_freq = 80;          // INS_HNTCH_FREQ
+    float hntch_bw = 40;            // INS_HNTCH_BW
+    float hntch_att = 40;           // INS_HNTCH_ATT
+    uint32_t hntch_hmncs = 3;       // INS_HNTCH_HMNCS
+    uint16_t hntch_opts = 0;        // INS_HNTCH_OPTS
+    uint8_t hntch_mode = 0;         // INS_HNTCH_MODE, only fixed and FFT tracking can be replayed
+    float hntch_fm_rat = 1.0;       // INS_HNTCH_FM_RAT
+    float gyro_filter = 20;         // INS_GYRO_FILTER
+    uint16_t fft_window_size = 32;  // FFT_WINDOW_SIZE
+    float fft_window_olap = 0.5;    // FFT_WINDOW_OLAP
+    float fft_minhz = 50;           // FFT_MINHZ
+    float fft_maxhz = 450;          // FFT_MAXHZ
+    float fft_att_ref = 15;         // FFT_ATT_REF
+    float fft_snr_ref = 25;         // FFT_SNR_REF
+    float fft_bw_hover = 20;        // FFT_BW_HOVER
+    uint8_t fft_hmnc_fit = 10;      // FFT_HMNC_FIT
+    uint8_t fft_hmnc_peak = 0;      // FFT_HMNC_PEAK
+    uint8_t fft_num_frames = 0;     // FFT_NUM_FRAMES
+    uint32_t fft_options = 0;       // FFT_OPTIONS, only analysing all axes can be replayed
+
+    // set a field by parameter name, false if the name is unknown
+    bool set(const char *name, float value);
+    // false if the configuration can not be replayed
+    bool valid(void) const;
+};
+
+struct NotchDesignResult {
+    bool valid;
+    // attenuation of the noise band FFT_MINHZ to FFT_MAXHZ
+    float band_att_db;
+    // attenuation at the strongest input peak in the noise band
+    float peak_att_db;
+    // strongest peak left in the noise band after filtering
+    float residual_peak_hz;
+    // phase lag of the filter chain at the probe frequency
+    float lag_deg;
+    float lag_ms;
+    // mean notch center frequency over the log
+    float mean_notch_hz;
+};
+
+class NotchDesign : public AP_LoggerFileReader
+{
+public:
+    NotchDesign() {}
+
+    // gyro instance to take samples from
+    void set_instance(uint8_t i) { instance = i; }
+    // use ISBH/ISBD batch samples even when GYR samples are present
+    void set_prefer_batch(bool b) { prefer_batch = b; }
+    // frequency at which to measure phase lag
+    void set_lag_freq(float f) { lag_freq_hz = f; }
+
+    bool handle_log_format_msg(const struct log_Format &f) override { return true; }
+    bool handle_msg(const struct log_Format &f, uint8_t *msg) override;
+    bool want_msg(const struct log_Format &f) override;
+
+    // choose the samples to replay and measure their spectrum, once the log is read
+    bool prepare(void);
+
+    // replay every configuration, spreading the work over jobs threads
+    void run(const NotchDesignConfig *configs, NotchDesignResult *results, uint32_t count, uint8_t jobs) const;
+
+private:
+    // window of the spectrum used for the attenuation metrics
+    static constexpr uint16_t psd_window = 256;
+
+    // a run of evenly spaced samples at a single rate
+    struct Segment {
+        uint32_t start;
+        uint32_t count;
+        float rate_hz;
+    };
+
+    // samples from one kind of log message, split into segments
+    class SampleSet {
+    public:
+        ~SampleSet();
+        bool start_segment(float rate);
+        bool add(const Vector3f &sample);
+        // samples so far in the current segment
+        uint32_t segment_count(void) const { return num_samples - segment_start; }
+        // keep the current segment if it is long enough to analyse
+        void end_segment(uint32_t min_samples);
+        // drop the current segment
+        void abandon_segment(void) { num_samples = segment_start; active = false; }
+
+        Vector3f *samples = nullptr;
+        uint32_t num_samples = 0;
+        Segment *segments = nullptr;
+        uint16_t num_segments = 0;
+        bool active = false;
+        // rate for the current segment, if known
+        float rate_hz = 0;
+
+    private:
+        uint32_t sample_space = 0;
+        uint16_t segment_space = 0;
+        uint32_t segment_start = 0;
+    };
+
+    // three axis Welch power spectrum, using the same FFT engine as AP_GyroFFT
+    class Spectrum {
+    public:
+        ~Spectrum();
+        bool init(float rate_hz);
+        void push(const Vector3f &sample);
+        // drop buffered samples at a break in the data
+        void restart(void);
+        // power summed over the axes, psd_window/2 bins
+        float *power = nullptr;
+        float bin_resolution;
+        uint16_t bin_count;
+    private:
+        AP_HAL::DSP::FFTWindowState *state = nullptr;
+        FloatBuffer buffers[XYZ_AXIS_COUNT];
+    };
+
+    /*
+      AP_GyroFFT's analysis of a single gyro, with its peak tracking
+      and frame scheduling, driven by the replayed samples
+     */
+    class Tracking {
+    public:
+        ~Tracking();
+        bool init(const NotchDesignConfig &config, float rate_hz);
+        // drop buffered samples at a break in the data
+        void restart(void);
+        // add a sample, analysing every frame AP_GyroFFT would
+        void push(const Vector3f &sample);
+        // notch frequencies as AP_Vehicle::update_dynamic_notch() would set
+        // them, returns zero if the notch would be made inactive
+        uint8_t get_notch_frequencies_hz(float *freqs) const;
+    private:
+        // samples available to the next frame
+        uint16_t get_frame_samples(void) const;
+        void analyse_axis(uint8_t axis);
+
+        AP_GyroFFT_Tracker tracker;
+        AP_GyroFFT_Tracker::Config tracker_config;
+        AP_GyroFFT_Tracker::State state;
+        // AP_GyroFFT's lock on the results, the replay has no other thread
+        HAL_Semaphore sem;
+        AP_HAL::DSP::FFTWindowState *fft;
+        FloatBuffer buffers[XYZ_AXIS_COUNT];
+        uint16_t samples_per_frame;
+        uint16_t start_bin;
+        uint16_t end_bin;
+        float attenuation_cutoff;
+        int8_t harmonic_peak;
+        float harmonic_fit;
+        bool all_axes;
+        bool dynamic_harmonic;
+        uint8_t update_axis;
+        // samples since the start of the replay, which stands in for the time
+        uint32_t sample_count;
+        // sample count at the last frame with a peak on each axis, zero if none
+        uint32_t health_sample[XYZ_AXIS_COUNT];
+    };
+
+    void handle_isbh(const uint8_t *msg);
+    void handle_isbd(const uint8_t *msg);
+    void handle_gyr(const uint8_t *msg);
+
+    // true if a segment is at the rate being replayed
+    bool segment_used(const Segment &seg) const;
+    // replay one configuration over every segment
+    void evaluate(const NotchDesignConfig &config, NotchDesignResult &result) const;
+    // compare an output spectrum with the input spectrum
+    void measure(const NotchDesignConfig &config, const Spectrum &out, NotchDesignResult &result) const;
+
+    uint8_t instance;
+    bool prefer_batch;
+    float lag_freq_hz = 20;
+
+    // ISBH/ISBD batch samples
+    SampleSet batch;
+    uint16_t batch_seqno;
+    uint16_t batch_remaining;
+    float batch_multiplier;
+
+    // GYR samples
+    SampleSet fast;
+    uint64_t fast_first_us;
+    uint64_t fast_last_us;
+
+    // the samples being replayed, at a single rate
+    const SampleSet *replay;
+    float rate_hz;
+    // samples at the start of each segment left out of the metrics while the filters settle
+    uint32_t settle_samples;
+    Spectrum input;
+};
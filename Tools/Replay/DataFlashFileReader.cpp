@@ -8,38 +8,94 @@
 #include <stdio.h>
 #include <unistd.h>
 #include <time.h>
-#include <cinttypes>
-
-#ifndef PRIu64
-#define PRIu64 "llu"
-#endif
 
 AP_LoggerFileReader::AP_LoggerFileReader()
 {}
 
 AP_LoggerFileReader::~AP_LoggerFileReader()
 {
-    ::printf("Replay counts: %" PRIu64 " bytes  %u entries\n", bytes_read, message_count);
+#if AP_LOGGER_FILE_MMAP_ENABLED
+    free_index();
+#endif
+    delete[] frame.data;
+    delete[] frame.raw;
 }
 
 bool AP_LoggerFileReader::open_log(const char *logfile)
 {
-    fd = AP::FS().open(logfile, O_RDONLY);
-    if (fd == -1) {
+    if (!log.open(logfile)) {
+        return false;
+    }
+
+    uint8_t hdr[2];
+    if (log.read(0, hdr, sizeof(hdr)) == sizeof(hdr) &&
+        AP_Logger_Compressor::is_frame_header(hdr)) {
+        // compressed log; decode it a frame at a time
+        frame.data = NEW_NOTHROW uint8_t[AP_Logger_Compressor::max_raw_len];
+        frame.raw = NEW_NOTHROW uint8_t[AP_Logger_Compressor::max_raw_len];
+        return frame.data != nullptr && frame.raw != nullptr;
+    }
+
+#if AP_LOGGER_FILE_MMAP_ENABLED
+    map_base = log.mapped();
+    map_ofs = 0;
+#endif
+    return true;
+}
+
+/*
+  decode the next frame of a compressed log
+ */
+bool AP_LoggerFileReader::next_frame()
+{
+    log_compressed_frame hdr;
+    if (log.read(frame.file_ofs, &hdr, sizeof(hdr)) != sizeof(hdr)) {
+        return false;
+    }
+    if (!AP_Logger_Compressor::is_frame_header((const uint8_t *)&hdr) ||
+        hdr.raw_len > AP_Logger_Compressor::max_raw_len ||
+        hdr.data_len > hdr.raw_len) {
+        printf("bad compressed frame header\n");
         return false;
     }
-    // Get the file size for percentage calculation
-    struct stat st;
-    if (AP::FS().stat(logfile, &st) == 0) {
-        file_size = st.st_size;
+    if (log.read(frame.file_ofs + sizeof(hdr), frame.data, hdr.data_len) != hdr.data_len) {
+        return false;
+    }
+    if (!AP_Logger_Compressor::decompress_frame(hdr, frame.data, frame.raw)) {
+        printf("bad compressed frame\n");
+        return false;
     }
+    frame.file_ofs += sizeof(hdr) + hdr.data_len;
+    frame.raw_len = hdr.raw_len;
+    frame.raw_ofs = 0;
+    bytes_read = frame.file_ofs;
     return true;
 }
 
+ssize_t AP_LoggerFileReader::read_compressed(uint8_t *buf, size_t count)
+{
+    size_t ret = 0;
+    while (ret < count) {
+        if (frame.raw_ofs == frame.raw_len && !next_frame()) {
+            break;
+        }
+        const size_t n = MIN(count - ret, size_t(frame.raw_len - frame.raw_ofs));
+        memcpy(&buf[ret], &frame.raw[frame.raw_ofs], n);
+        frame.raw_ofs += n;
+        ret += n;
+    }
+    return ret;
+}
+
 ssize_t AP_LoggerFileReader::read_input(void *buffer, const size_t count)
 {
-    uint64_t ret = AP::FS().read(fd, buffer, count);
-    bytes_read += ret;
+    if (frame.raw != nullptr) {
+        return read_compressed((uint8_t *)buffer, count);
+    }
+    const ssize_t ret = log.read(bytes_read, buffer, count);
+    if (ret > 0) {
+        bytes_read += ret;
+    }
     return ret;
 }
 
@@ -58,6 +114,16 @@ void AP_LoggerFileReader::get_packet_counts(uint64_t dest[])
 }
 
 bool AP_LoggerFileReader::update()
+{
+#if AP_LOGGER_FILE_MMAP_ENABLED
+    if (map_base != nullptr) {
+        return update_mapped();
+    }
+#endif
+    return update_fd();
+}
+
+bool AP_LoggerFileReader::update_fd()
 {
     uint8_t hdr[3];
     if (read_input(hdr, 3) != 3) {
@@ -107,10 +173,196 @@ bool AP_LoggerFileReader::update()
     return handle_msg(f, msg);
 }
 
+#if AP_LOGGER_FILE_MMAP_ENABLED
+/*
+  return a pointer to the next message to process, or nullptr at
+  the end of the log
+ */
+const uint8_t *AP_LoggerFileReader::next_mapped_msg()
+{
+    if (index != nullptr) {
+        if (heap_len == 0) {
+            return nullptr;
+        }
+        TypeIndex &t = index[heap[0]];
+        const uint8_t *msg = &map_base[t.offsets[t.next++]];
+        if (t.next == t.count) {
+            heap[0] = heap[--heap_len];
+        }
+        heap_sift_down(0);
+        const uint16_t length = msg[2] == LOG_FORMAT_MSG ? sizeof(struct log_Format) : formats[msg[2]].length;
+        bytes_read = (msg - map_base) + length;
+        return msg;
+    }
+
+    if (log.size() - map_ofs < 3) {
+        return nullptr;
+    }
+    const uint8_t *msg = &map_base[map_ofs];
+    if (msg[0] != HEAD_BYTE1 || msg[1] != HEAD_BYTE2) {
+        printf("bad log header\n");
+        return nullptr;
+    }
+    uint16_t length = sizeof(struct log_Format);
+    if (msg[2] != LOG_FORMAT_MSG) {
+        length = formats[msg[2]].length;
+        if (length == 0) {
+            // can't just throw these away as the format specifies the
+            // number of bytes in the message
+            ::printf("No format defined for type (%d)\n", msg[2]);
+            exit(1);
+        }
+    }
+    if (log.size() - map_ofs < length) {
+        return nullptr;
+    }
+    map_ofs += length;
+    bytes_read = map_ofs;
+    return msg;
+}
+
+bool AP_LoggerFileReader::update_mapped()
+{
+    const uint8_t *msg = next_mapped_msg();
+    if (msg == nullptr) {
+        return false;
+    }
+    packet_counts[msg[2]]++;
+    message_count++;
+
+    if (msg[2] == LOG_FORMAT_MSG) {
+        struct log_Format f;
+        memcpy(&f, msg, sizeof(f));
+        memcpy(&formats[f.type], &f, sizeof(formats[f.type]));
+        return handle_log_format_msg(f);
+    }
+
+    return handle_msg(formats[msg[2]], msg);
+}
+
+/*
+  walk the log once, learning the formats and recording the offset
+  of every message in a per-type column
+ */
+bool AP_LoggerFileReader::build_index()
+{
+    index = NEW_NOTHROW TypeIndex[LOGREADER_MAX_FORMATS] {};
+    if (index == nullptr) {
+        return false;
+    }
+    uint64_t ofs = 0;
+    while (log.size() - ofs >= 3) {
+        const uint8_t *msg = &map_base[ofs];
+        if (msg[0] != HEAD_BYTE1 || msg[1] != HEAD_BYTE2) {
+            // a sequential read stops here too
+            break;
+        }
+        uint16_t length = sizeof(struct log_Format);
+        if (msg[2] == LOG_FORMAT_MSG) {
+            if (log.size() - ofs < length) {
+                break;
+            }
+            struct log_Format f;
+            memcpy(&f, msg, sizeof(f));
+            memcpy(&formats[f.type], &f, sizeof(formats[f.type]));
+        } else {
+            length = formats[msg[2]].length;
+            if (length == 0 || log.size() - ofs < length) {
+                break;
+            }
+        }
+        TypeIndex &t = index[msg[2]];
+        if (t.count == t.space) {
+            const uint32_t new_space = MAX(t.space * 2, 256U);
+            uint32_t *new_offsets = (uint32_t *)realloc(t.offsets, new_space * sizeof(uint32_t));
+            if (new_offsets == nullptr) {
+                // leave the log to be read sequentially
+                free_index();
+                return false;
+            }
+            t.offsets = new_offsets;
+            t.space = new_space;
+        }
+        t.offsets[t.count++] = ofs;
+        ofs += length;
+    }
+    return true;
+}
+
+void AP_LoggerFileReader::free_index()
+{
+    if (index == nullptr) {
+        return;
+    }
+    for (uint16_t i=0; i<LOGREADER_MAX_FORMATS; i++) {
+        free(index[i].offsets);
+    }
+    delete[] index;
+    index = nullptr;
+}
+
+void AP_LoggerFileReader::heap_sift_down(uint16_t i)
+{
+    while (true) {
+        const uint16_t l = 2*i + 1;
+        const uint16_t r = l + 1;
+        uint16_t smallest = i;
+        if (l < heap_len && heap_offset(l) < heap_offset(smallest)) {
+            smallest = l;
+        }
+        if (r < heap_len && heap_offset(r) < heap_offset(smallest)) {
+            smallest = r;
+        }
+        if (smallest == i) {
+            return;
+        }
+        const uint8_t tmp = heap[i];
+        heap[i] = heap[smallest];
+        heap[smallest] = tmp;
+        i = smallest;
+    }
+}
+
+bool AP_LoggerFileReader::stream_wanted_only()
+{
+    if (map_base == nullptr || map_ofs != 0 || log.size() > UINT32_MAX) {
+        return false;
+    }
+    if (!build_index()) {
+        ::printf("Failed to index log\n");
+        return false;
+    }
+
+    heap_len = 0;
+    for (uint16_t type=0; type<LOGREADER_MAX_FORMATS; type++) {
+        TypeIndex &t = index[type];
+        if (t.count == 0) {
+            continue;
+        }
+        if (type != LOG_FORMAT_MSG && !want_msg(formats[type])) {
+            // we will never look at these again
+            free(t.offsets);
+            t = {};
+            continue;
+        }
+        heap[heap_len++] = type;
+    }
+    for (int16_t i=heap_len/2-1; i>=0; i--) {
+        heap_sift_down(i);
+    }
+    return true;
+}
+#else
+bool AP_LoggerFileReader::stream_wanted_only()
+{
+    return false;
+}
+#endif // AP_LOGGER_FILE_MMAP_ENABLED
+
 float AP_LoggerFileReader::get_percent_read()
 {
-    if (file_size == 0) {
+    if (log.size() == 0) {
         return 0.0f;
     }
-    return (float)(bytes_read * 100.0 / file_size);
+    return (float)(bytes_read * 100.0 / log.size());
 }
@@ -1,8 +1,10 @@
 #pragma once
 
 #include <AP_Logger/AP_Logger.h>
+#include <AP_Logger/AP_Logger_FileView.h>
+#include <AP_Logger/AP_Logger_Compress.h>
 
-#define LOGREADER_MAX_FORMATS 255 // must be >= highest MESSAGE
+#define LOGREADER_MAX_FORMATS 256 // one entry for every possible message type
 
 class AP_LoggerFileReader
 {
@@ -15,22 +17,74 @@ public:
     bool update();
 
     virtual bool handle_log_format_msg(const struct log_Format &f) = 0;
-    virtual bool handle_msg(const struct log_Format &f, uint8_t *msg) = 0;
+    virtual bool handle_msg(const struct log_Format &f, const uint8_t *msg) = 0;
+
+    // return true if messages of this format should be passed to
+    // handle_msg when only wanted messages are being streamed
+    virtual bool want_msg(const struct log_Format &f) { return true; }
+
+    // build an index of message offsets by type and from then on
+    // only stream FMT messages and those for which want_msg()
+    // returns true.  Only available on memory-mapped logs
+    bool stream_wanted_only(void);
 
     void format_type(uint16_t type, char dest[5]);
     void get_packet_counts(uint64_t dest[]);
     float get_percent_read(); // Get percentage of log file read
+    uint64_t get_bytes_read() const { return bytes_read; }
+    uint32_t get_message_count() const { return message_count; }
 
 protected:
-    int fd = -1;
-
     struct log_Format formats[LOGREADER_MAX_FORMATS] {};
 
 private:
+    AP_Logger_FileView log;
+
     ssize_t read_input(void *buf, size_t count);
+    bool update_fd();
+
+    // state for logs written with LOG_FILE_COMPRESS
+    struct {
+        uint8_t *data;      // payload of the current frame
+        uint8_t *raw;       // decompressed current frame
+        uint16_t raw_len;
+        uint16_t raw_ofs;
+        uint64_t file_ofs;  // offset of the next frame
+    } frame {};
+    bool next_frame();
+    ssize_t read_compressed(uint8_t *buf, size_t count);
+
+#if AP_LOGGER_FILE_MMAP_ENABLED
+    bool update_mapped();
+    const uint8_t *next_mapped_msg();
+    bool build_index();
+    void free_index();
+
+    // the whole log when it could be memory-mapped, read-only
+    const uint8_t *map_base = nullptr;
+    uint64_t map_ofs = 0;
+
+    // offsets of every message in the log, one column per type
+    struct TypeIndex {
+        uint32_t *offsets;
+        uint32_t count;
+        uint32_t space;
+        uint32_t next;  // next entry to stream
+    };
+    TypeIndex *index = nullptr;
+
+    // min-heap of types ordered by the offset of their next message,
+    // used to merge the wanted columns back into log order
+    uint8_t heap[LOGREADER_MAX_FORMATS];
+    uint16_t heap_len = 0;
+    uint32_t heap_offset(uint16_t i) const {
+        const TypeIndex &t = index[heap[i]];
+        return t.offsets[t.next];
+    }
+    void heap_sift_down(uint16_t i);
+#endif
 
     uint64_t bytes_read = 0;
-    uint64_t file_size = 0; // Total size of the log file
     uint32_t message_count = 0;
     uint64_t start_micros;
 
@@ -14,13 +14,13 @@ LR_MsgHandler::LR_MsgHandler(struct log_Format &_f) :
     MsgHandler(_f) {
 }
 
-void LR_MsgHandler_RFRH::process_message(uint8_t *msgbytes)
+void LR_MsgHandler_RFRH::process_message(const uint8_t *msgbytes)
 {
     MSG_CREATE(RFRH, msgbytes);
     AP::dal().handle_message(msg);
 }
 
-void LR_MsgHandler_RFRF::process_message(uint8_t *msgbytes)
+void LR_MsgHandler_RFRF::process_message(const uint8_t *msgbytes)
 {
     MSG_CREATE(RFRF, msgbytes);
 #define MAP_FLAG(flag1, flag2) if (msg.frame_types & uint8_t(flag1)) msg.frame_types |= uint8_t(flag2)
@@ -41,13 +41,13 @@ void LR_MsgHandler_RFRF::process_message(uint8_t *msgbytes)
     AP::dal().handle_message(msg, ekf2, ekf3);
 }
 
-void LR_MsgHandler_RFRN::process_message(uint8_t *msgbytes)
+void LR_MsgHandler_RFRN::process_message(const uint8_t *msgbytes)
 {
     MSG_CREATE(RFRN, msgbytes);
     AP::dal().handle_message(msg);
 }
 
-void LR_MsgHandler_REV2::process_message(uint8_t *msgbytes)
+void LR_MsgHandler_REV2::process_message(const uint8_t *msgbytes)
 {
     MSG_CREATE(REV2, msgbytes);
 
@@ -80,7 +80,7 @@ void LR_MsgHandler_REV2::process_message(uint8_t *msgbytes)
     }
 }
 
-void LR_MsgHandler_RSO2::process_message(uint8_t *msgbytes)
+void LR_MsgHandler_RSO2::process_message(const uint8_t *msgbytes)
 {
     MSG_CREATE(RSO2, msgbytes);
     Location loc;
@@ -95,7 +95,7 @@ void LR_MsgHandler_RSO2::process_message(uint8_t *msgbytes)
     }
 }
 
-void LR_MsgHandler_RWA2::process_message(uint8_t *msgbytes)
+void LR_MsgHandler_RWA2::process_message(const uint8_t *msgbytes)
 {
     MSG_CREATE(RWA2, msgbytes);
     ekf2.writeDefaultAirSpeed(msg.airspeed);
@@ -106,7 +106,7 @@ void LR_MsgHandler_RWA2::process_message(uint8_t *msgbytes)
 }
 
 
-void LR_MsgHandler_REV3::process_message(uint8_t *msgbytes)
+void LR_MsgHandler_REV3::process_message(const uint8_t *msgbytes)
 {
     MSG_CREATE(REV3, msgbytes);
 
@@ -141,7 +141,7 @@ void LR_MsgHandler_REV3::process_message(uint8_t *msgbytes)
     }
 }
 
-void LR_MsgHandler_RSO3::process_message(uint8_t *msgbytes)
+void LR_MsgHandler_RSO3::process_message(const uint8_t *msgbytes)
 {
     MSG_CREATE(RSO3, msgbytes);
     Location loc;
@@ -155,7 +155,7 @@ void LR_MsgHandler_RSO3::process_message(uint8_t *msgbytes)
     }
 }
 
-void LR_MsgHandler_RWA3::process_message(uint8_t *msgbytes)
+void LR_MsgHandler_RWA3::process_message(const uint8_t *msgbytes)
 {
     MSG_CREATE(RWA3, msgbytes);
     ekf3.writeDefaultAirSpeed(msg.airspeed, msg.uncertainty);
@@ -165,137 +165,137 @@ void LR_MsgHandler_RWA3::process_message(uint8_t *msgbytes)
     }
 }
 
-void LR_MsgHandler_REY3::process_message(uint8_t *msgbytes)
+void LR_MsgHandler_REY3::process_message(const uint8_t *msgbytes)
 {
     MSG_CREATE(REY3, msgbytes);
     ekf3.writeEulerYawAngle(msg.yawangle, msg.yawangleerr, msg.timestamp_ms, msg.type);
 }
 
-void LR_MsgHandler_RISH::process_message(uint8_t *msgbytes)
+void LR_MsgHandler_RISH::process_message(const uint8_t *msgbytes)
 {
     MSG_CREATE(RISH, msgbytes);
     AP::dal().handle_message(msg);
 }
-void LR_MsgHandler_RISI::process_message(uint8_t *msgbytes)
+void LR_MsgHandler_RISI::process_message(const uint8_t *msgbytes)
 {
     MSG_CREATE(RISI, msgbytes);
     AP::dal().handle_message(msg);
 }
 
-void LR_MsgHandler_RASH::process_message(uint8_t *msgbytes)
+void LR_MsgHandler_RASH::process_message(const uint8_t *msgbytes)
 {
     MSG_CREATE(RASH, msgbytes);
     AP::dal().handle_message(msg);
 }
-void LR_MsgHandler_RASI::process_message(uint8_t *msgbytes)
+void LR_MsgHandler_RASI::process_message(const uint8_t *msgbytes)
 {
     MSG_CREATE(RASI, msgbytes);
     AP::dal().handle_message(msg);
 }
 
-void LR_MsgHandler_RBRH::process_message(uint8_t *msgbytes)
+void LR_MsgHandler_RBRH::process_message(const uint8_t *msgbytes)
 {
     MSG_CREATE(RBRH, msgbytes);
     AP::dal().handle_message(msg);
 }
 
-void LR_MsgHandler_RBRI::process_message(uint8_t *msgbytes)
+void LR_MsgHandler_RBRI::process_message(const uint8_t *msgbytes)
 {
     MSG_CREATE(RBRI, msgbytes);
     AP::dal().handle_message(msg);
 }
 
-void LR_MsgHandler_RRNH::process_message(uint8_t *msgbytes)
+void LR_MsgHandler_RRNH::process_message(const uint8_t *msgbytes)
 {
     MSG_CREATE(RRNH, msgbytes);
     AP::dal().handle_message(msg);
 }
 
-void LR_MsgHandler_RRNI::process_message(uint8_t *msgbytes)
+void LR_MsgHandler_RRNI::process_message(const uint8_t *msgbytes)
 {
     MSG_CREATE(RRNI, msgbytes);
     AP::dal().handle_message(msg);
 }
 
-void LR_MsgHandler_RGPH::process_message(uint8_t *msgbytes)
+void LR_MsgHandler_RGPH::process_message(const uint8_t *msgbytes)
 {
     MSG_CREATE(RGPH, msgbytes);
     AP::dal().handle_message(msg);
 }
 
-void LR_MsgHandler_RGPI::process_message(uint8_t *msgbytes)
+void LR_MsgHandler_RGPI::process_message(const uint8_t *msgbytes)
 {
     MSG_CREATE(RGPI, msgbytes);
     AP::dal().handle_message(msg);
 }
 
-void LR_MsgHandler_RGPJ::process_message(uint8_t *msgbytes)
+void LR_MsgHandler_RGPJ::process_message(const uint8_t *msgbytes)
 {
     MSG_CREATE(RGPJ, msgbytes);
     AP::dal().handle_message(msg);
 }
 
-void LR_MsgHandler_RMGH::process_message(uint8_t *msgbytes)
+void LR_MsgHandler_RMGH::process_message(const uint8_t *msgbytes)
 {
     MSG_CREATE(RMGH, msgbytes);
     AP::dal().handle_message(msg);
 }
 
-void LR_MsgHandler_RMGI::process_message(uint8_t *msgbytes)
+void LR_MsgHandler_RMGI::process_message(const uint8_t *msgbytes)
 {
     MSG_CREATE(RMGI, msgbytes);
     AP::dal().handle_message(msg);
 }
 
-void LR_MsgHandler_RBCH::process_message(uint8_t *msgbytes)
+void LR_MsgHandler_RBCH::process_message(const uint8_t *msgbytes)
 {
     MSG_CREATE(RBCH, msgbytes);
     AP::dal().handle_message(msg);
 }
 
-void LR_MsgHandler_RBCI::process_message(uint8_t *msgbytes)
+void LR_MsgHandler_RBCI::process_message(const uint8_t *msgbytes)
 {
     MSG_CREATE(RBCI, msgbytes);
     AP::dal().handle_message(msg);
 }
 
-void LR_MsgHandler_RVOH::process_message(uint8_t *msgbytes)
+void LR_MsgHandler_RVOH::process_message(const uint8_t *msgbytes)
 {
     MSG_CREATE(RVOH, msgbytes);
     AP::dal().handle_message(msg);
 }
 
-void LR_MsgHandler_ROFH::process_message(uint8_t *msgbytes)
+void LR_MsgHandler_ROFH::process_message(const uint8_t *msgbytes)
 {
     MSG_CREATE(ROFH, msgbytes);
     AP::dal().handle_message(msg, ekf2, ekf3);
 }
 
-void LR_MsgHandler_RWOH::process_message(uint8_t *msgbytes)
+void LR_MsgHandler_RWOH::process_message(const uint8_t *msgbytes)
 {
     MSG_CREATE(RWOH, msgbytes);
     AP::dal().handle_message(msg, ekf2, ekf3);
 }
 
-void LR_MsgHandler_RBOH::process_message(uint8_t *msgbytes)
+void LR_MsgHandler_RBOH::process_message(const uint8_t *msgbytes)
 {
     MSG_CREATE(RBOH, msgbytes);
     AP::dal().handle_message(msg, ekf2, ekf3);
 }
 
-void LR_MsgHandler_REPH::process_message(uint8_t *msgbytes)
+void LR_MsgHandler_REPH::process_message(const uint8_t *msgbytes)
 {
     MSG_CREATE(REPH, msgbytes);
     AP::dal().handle_message(msg, ekf2, ekf3);
 }
 
-void LR_MsgHandler_RSLL::process_message(uint8_t *msgbytes)
+void LR_MsgHandler_RSLL::process_message(const uint8_t *msgbytes)
 {
     MSG_CREATE(RSLL, msgbytes);
     AP::dal().handle_message(msg, ekf2, ekf3);
 }
 
-void LR_MsgHandler_REVH::process_message(uint8_t *msgbytes)
+void LR_MsgHandler_REVH::process_message(const uint8_t *msgbytes)
 {
     MSG_CREATE(REVH, msgbytes);
     AP::dal().handle_message(msg, ekf2, ekf3);
@@ -320,7 +320,7 @@ bool LR_MsgHandler_PARM::set_parameter(const char *name, const float value)
     return LogReader::set_parameter(name, value);
 }
 
-void LR_MsgHandler_PARM::process_message(uint8_t *msg)
+void LR_MsgHandler_PARM::process_message(const uint8_t *msg)
 {
     const uint8_t parameter_name_len = AP_MAX_NAME_SIZE + 1; // null-term
     char parameter_name[parameter_name_len];
@@ -331,7 +331,7 @@ void LR_MsgHandler_PARM::process_message(uint8_t *msg)
     set_parameter(parameter_name, value);
 }
 
-void LR_MsgHandler_RTER::process_message(uint8_t *msgbytes)
+void LR_MsgHandler_RTER::process_message(const uint8_t *msgbytes)
 {
     MSG_CREATE(RTER, msgbytes);
     AP::dal().handle_message(msg, ekf2, ekf3);
@@ -51,12 +51,28 @@ bool LogReader::handle_log_format_msg(const struct log_Format &f)
     // emit the output as we receive it:
     AP::logger().WriteBlock((void*)&f, sizeof(f));
 
+    create_parser(f);
+
+    return true;
+}
+
+/*
+  Replay only needs messages for which we have a parser
+ */
+bool LogReader::want_msg(const struct log_Format &f)
+{
+    create_parser(f);
+    return msgparser[f.type] != NULL;
+}
+
+void LogReader::create_parser(const struct log_Format &f)
+{
 	char name[5];
 	memset(name, '\0', 5);
 	memcpy(name, f.name, 4);
 
     if (msgparser[f.type] != NULL) {
-        return true;
+        return;
     }
 
     // map from format name to a parser subclass:
@@ -131,11 +147,9 @@ bool LogReader::handle_log_format_msg(const struct log_Format &f)
 	} else {
         // debug("  No parser for (%s)\n", name);
     }
-
-    return true;
 }
 
-bool LogReader::handle_msg(const struct log_Format &f, uint8_t *msg) {
+bool LogReader::handle_msg(const struct log_Format &f, const uint8_t *msg) {
     // emit the output as we receive it:
     AP::logger().WriteBlock(msg, f.length);
 
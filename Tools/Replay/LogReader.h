@@ -16,7 +16,8 @@ public:
     static bool set_parameter(const char *name, float value, bool force=false);
 
     bool handle_log_format_msg(const struct log_Format &f) override;
-    bool handle_msg(const struct log_Format &f, uint8_t *msg) override;
+    bool handle_msg(const struct log_Format &f, const uint8_t *msg) override;
+    bool want_msg(const struct log_Format &f) override;
 
     static bool in_list(const char *type, const char *list[]);
 
@@ -31,6 +32,8 @@ private:
     uint8_t _log_structure_count;
 
     class LR_MsgHandler *msgparser[LOGREADER_MAX_FORMATS] {};
+
+    void create_parser(const struct log_Format &f);
 };
 
 // some vars are difficult to get through the layers
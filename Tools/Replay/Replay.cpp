@@ -18,6 +18,7 @@
 #include "LogReader.h"
 
 #include <stdio.h>
+#include <cinttypes>
 #include <AP_HAL/utility/getopt_cpp.h>
 
 #include <AP_Vehicle/AP_Vehicle.h>
@@ -31,6 +32,10 @@
 #include <AP_HAL_Linux/Scheduler.h>
 #endif
 
+#ifndef PRIu64
+#define PRIu64 "llu"
+#endif
+
 #define streq(x, y) (!strcmp(x, y))
 
 static ReplayVehicle replayvehicle;
@@ -126,11 +131,13 @@ void Replay::usage(void)
     ::printf("\t--force-ekf2 force enable EKF2\n");
     ::printf("\t--force-ekf3 force enable EKF3\n");
     ::printf("\t--progress  show a progress bar during replay\n");
+    ::printf("\t--replay-msgs-only  only read messages Replay consumes; output can not be checked with check_replay.py\n");
 }
 
 enum param_key : uint8_t {
     FORCE_EKF2 = 1,
     FORCE_EKF3,
+    REPLAY_MSGS_ONLY,
 };
 
 void Replay::_parse_command_line(uint8_t argc, char * const argv[])
@@ -143,6 +150,7 @@ void Replay::_parse_command_line(uint8_t argc, char * const argv[])
         {"force-ekf2",      false,  0, param_key::FORCE_EKF2},
         {"force-ekf3",      false,  0, param_key::FORCE_EKF3},
         {"progress",        false,  0, 'P'},
+        {"replay-msgs-only", false, 0, param_key::REPLAY_MSGS_ONLY},
         {"help",            false,  0, 'h'},
         {0, false, 0, 0}
     };
@@ -182,6 +190,10 @@ void Replay::_parse_command_line(uint8_t argc, char * const argv[])
             show_progress = true;
             break;
 
+        case param_key::REPLAY_MSGS_ONLY:
+            replay_msgs_only = true;
+            break;
+
         case 'h':
         default:
             usage();
@@ -289,6 +301,10 @@ void Replay::setup()
         exit(1);
     }
 
+    if (replay_msgs_only && !reader.stream_wanted_only()) {
+        ::printf("Unable to index %s, reading all messages\n", filename);
+    }
+
     if (replay_force_ekf2) {
         write_EKF_formats();
     }
@@ -297,6 +313,8 @@ void Replay::setup()
 void Replay::loop()
 {
     if (!reader.update()) {
+        ::printf("Replay counts: %" PRIu64 " bytes  %u entries\n",
+                 reader.get_bytes_read(), (unsigned)reader.get_message_count());
 #if CONFIG_HAL_BOARD == HAL_BOARD_LINUX
     // If we don't tear down the threads then they continue to access
     // global state during object destruction.
@@ -102,6 +102,7 @@ private:
     LogReader reader{_vehicle.log_structure, _vehicle.ekf2, _vehicle.ekf3};
     bool show_progress = false;  // Flag to determine if progress bar should be shown
     uint32_t last_progress_update = 0; // Last time progress was displayed
+    bool replay_msgs_only = false;  // only stream messages we have a parser for
 
     void _parse_command_line(uint8_t argc, char * const argv[]);
 
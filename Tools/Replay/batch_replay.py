@@ -0,0 +1,155 @@
+#!/usr/bin/env python3
+
+# AP_FLAKE8_CLEAN
+
+'''
+run Replay over many logs in parallel processes and summarise the results
+
+each log is replayed in its own scratch directory so the Replay
+instances do not fight over logs/LASTLOG.TXT.  Unless --no-check is
+given the Replay output is run through check_replay.py
+'''
+
+import glob
+import os
+import shutil
+import subprocess
+import sys
+import tempfile
+import time
+
+from concurrent.futures import ProcessPoolExecutor, as_completed
+
+import check_replay
+
+
+def replay_one(replay, logfile, replay_args, output_dir, check, check_args):
+    '''replay a single log, returning a dictionary of results'''
+    result = {
+        'log': logfile,
+        'status': 'FAILED',
+        'time': 0.0,
+        'errors': [],
+        'output': None,
+    }
+    tstart = time.time()
+    workdir = tempfile.mkdtemp(prefix='replay-')
+    try:
+        cmd = [replay] + replay_args + [os.path.abspath(logfile)]
+        p = subprocess.run(cmd, cwd=workdir, stdout=subprocess.PIPE, stderr=subprocess.STDOUT)
+        if p.returncode != 0:
+            result['errors'].append("Replay exited with %d" % p.returncode)
+            result['errors'].extend(p.stdout.decode('utf-8', 'replace').splitlines()[-10:])
+            return result
+        outlogs = sorted(glob.glob(os.path.join(workdir, 'logs', '*.BIN')))
+        if len(outlogs) != 1:
+            result['errors'].append("Expected a single output log, got %u" % len(outlogs))
+            return result
+        outlog = outlogs[0]
+        if output_dir is not None:
+            name = os.path.splitext(os.path.basename(logfile))[0] + '-replay.BIN'
+            dest = os.path.join(output_dir, name)
+            shutil.move(outlog, dest)
+            outlog = dest
+            result['output'] = dest
+        if check:
+            messages = []
+            if not check_replay.check_log(outlog, progress=messages.append, **check_args):
+                result['errors'].extend([str(m) for m in messages[-10:]])
+                result['status'] = 'MISMATCH'
+                return result
+        result['status'] = 'OK'
+        return result
+    finally:
+        result['time'] = time.time() - tstart
+        shutil.rmtree(workdir, ignore_errors=True)
+
+
+def find_logs(paths):
+    '''expand directories into the .BIN logs they contain'''
+    logs = []
+    for path in paths:
+        if os.path.isdir(path):
+            logs.extend(sorted(glob.glob(os.path.join(path, '**', '*.BIN'), recursive=True)))
+        else:
+            logs.append(path)
+    return logs
+
+
+if __name__ == '__main__':
+    from argparse import ArgumentParser
+    parser = ArgumentParser(description=__doc__)
+    parser.add_argument("--replay", default="build/sitl/tool/Replay", help="path to Replay binary")
+    parser.add_argument("-j", "--jobs", type=int, default=os.cpu_count(), help="number of parallel Replay processes")
+    parser.add_argument("--output-dir", default=None, help="keep Replay output logs in this directory")
+    parser.add_argument("--no-check", action='store_true', help="do not run check_replay.py over the output")
+    parser.add_argument("--replay-msgs-only", action='store_true',
+                        help="pass --replay-msgs-only to Replay; implies --no-check")
+    parser.add_argument("--parm", action='append', default=[], help="set parameter NAME=VALUE for every replay")
+    parser.add_argument("--param-file", default=None, help="load parameters from a file for every replay")
+    parser.add_argument("--ekf2-only", action='store_true', help="only check EKF2")
+    parser.add_argument("--ekf3-only", action='store_true', help="only check EKF3")
+    parser.add_argument("--accuracy", type=float, default=0.0, help="accuracy percentage for match")
+    parser.add_argument("--ignore-field", action='append', default=[], help="ignore message field when comparing")
+    parser.add_argument("logs", metavar="LOG", nargs="+", help="logs or directories of logs")
+
+    args = parser.parse_args()
+
+    replay = os.path.abspath(args.replay)
+    if not os.path.exists(replay):
+        print("Replay binary %s not found" % replay)
+        sys.exit(1)
+
+    replay_args = []
+    for p in args.parm:
+        replay_args.extend(["--parm", p])
+    if args.param_file is not None:
+        replay_args.extend(["--param-file", os.path.abspath(args.param_file)])
+    check = not args.no_check
+    if args.replay_msgs_only:
+        # the output no longer contains the original EKF messages
+        replay_args.append("--replay-msgs-only")
+        check = False
+    check_args = {
+        'ekf2_only': args.ekf2_only,
+        'ekf3_only': args.ekf3_only,
+        'accuracy': args.accuracy,
+        'ignores': set(args.ignore_field),
+    }
+
+    output_dir = None
+    if args.output_dir is not None:
+        output_dir = os.path.abspath(args.output_dir)
+        os.makedirs(output_dir, exist_ok=True)
+
+    logs = find_logs(args.logs)
+    if len(logs) == 0:
+        print("No logs found")
+        sys.exit(1)
+
+    tstart = time.time()
+    results = []
+    with ProcessPoolExecutor(max_workers=args.jobs) as executor:
+        futures = [executor.submit(replay_one, replay, log, replay_args, output_dir, check, check_args) for log in logs]
+        for f in as_completed(futures):
+            r = f.result()
+            results.append(r)
+            print("[%u/%u] %-8s %7.1fs %s" % (len(results), len(logs), r['status'], r['time'], r['log']))
+
+    results.sort(key=lambda r: r['log'])
+    failed = [r for r in results if r['status'] != 'OK']
+    print("")
+    print("Summary:")
+    for r in results:
+        print("  %-8s %7.1fs %s" % (r['status'], r['time'], r['log']))
+        for e in r['errors']:
+            print("      %s" % e)
+    total = sum([r['time'] for r in results])
+    print("%u logs, %u OK, %u failed; %.1fs elapsed, %.1fs of replay" %
+          (len(results), len(results)-len(failed), len(failed), time.time()-tstart, total))
+
+    if len(failed) != 0:
+        print("FAILED")
+        sys.exit(1)
+    print("Passed")
+    sys.exit(0)
@@ -0,0 +1,367 @@
+/*
+  lock-step physics for a swarm of SITL vehicles
+
+  Every vehicle runs as its own ArduPilot process using the JSON SITL
+  backend, while the physics of all of them runs here in one
+  process. Each frame waits for a servo packet from every vehicle,
+  advances every model by one step, spreading the models over a pool
+  of threads, and then answers each vehicle with the new state of its
+  model. No vehicle can run ahead of the others, so a swarm behaves
+  the same however loaded the machine is, and is no longer limited by
+  the number of physics processes the machine can keep up with.
+
+  The vehicles are laid out on a grid around one home location, which
+  every vehicle must also be given, so that all of them share a
+  common origin:
+
+    SwarmSim --model quad --count 4 --spacing 5 --home -35.363261,149.165230,584,353
+    arducopter --model JSON -I 0 --home -35.363261,149.165230,584,353 --defaults copter.parm
+    arducopter --model JSON -I 1 --home -35.363261,149.165230,584,353 --defaults copter.parm
+    ...
+
+  Models are stepped at SIM_RATE_HZ. Wind and turbulence come from
+  the SIM_WIND parameters as in SITL, with the height used by
+  SIM_WIND_T taken as each vehicle's height above home. Each model draws its turbulence,
+  sensor noise and rangefinder noise from its own random number
+  generators, seeded from its instance, so runs are repeatable
+  whatever the number of jobs. Payload simulations owned by the SIM
+  parameters, such as the slung payload and tether, are not
+  supported. The simulated rangefinder takes its height above ground
+  from the SIM state, which is not filled in here, so it only sees
+  the noise.
+ */
+
+#include "SwarmSim.h"
+
+#include <AP_HAL/SIMState.h>
+#include <AP_HAL/utility/getopt_cpp.h>
+#include <AP_HAL_SITL/SITL_State.h>
+
+#include <thread>
+
+#include <stdio.h>
+#include <errno.h>
+
+void setup();
+void loop();
+
+const AP_HAL::HAL& hal = AP_HAL::get_HAL();
+
+static SITL::SIM sitl;
+
+#define SWARM_SIM_MAX_VEHICLES 128
+
+// as the JSON backend
+#define SWARM_SIM_MAGIC_16 18458
+#define SWARM_SIM_MAGIC_32 29569
+
+bool SwarmSim::init(const char *model_str, const Location &home, float home_yaw,
+                    uint8_t count, float spacing, uint16_t _base_port)
+{
+    vehicles = NEW_NOTHROW Vehicle[count];
+    if (vehicles == nullptr) {
+        ::printf("Out of memory\n");
+        return false;
+    }
+    num_vehicles = count;
+    base_port = _base_port;
+
+    // fill a square grid, row by row, north and east of home
+    const uint8_t columns = ceilf(sqrtf(count));
+
+    for (uint8_t i = 0; i < count; i++) {
+        Vehicle &v = vehicles[i];
+        v.model = HALSITL::SITL_State::create_model(model_str);
+        if (v.model == nullptr) {
+            ::printf("Vehicle model (%s) not found\n", model_str);
+            return false;
+        }
+        v.offset = Vector3d((i / columns) * spacing, (i % columns) * spacing, 0);
+        Location start = home;
+        start.offset(v.offset.x, v.offset.y);
+        v.model->set_start_location(start, home_yaw);
+        v.model->set_instance(i);
+        // the vehicles pace the simulation, not the wall clock
+        v.model->set_time_sync(false);
+
+        const uint16_t port = base_port + 10 * i;
+        if (!v.sock.reuseaddress() || !v.sock.bind("127.0.0.1", port)) {
+            ::printf("Unable to bind port %u: %s\n", port, strerror(errno));
+            return false;
+        }
+    }
+    ::printf("Simulating %u %s on ports %u to %u\n",
+             count, model_str, base_port, base_port + 10 * (count - 1));
+    return true;
+}
+
+/*
+  wait for a servo packet from a vehicle. A repeat of the last packet
+  means the vehicle missed our reply, so it is sent again and we carry
+  on waiting. Returns true once a new packet has arrived
+ */
+bool SwarmSim::receive(Vehicle &v, uint32_t timeout_ms)
+{
+    struct servo_packet pkt;
+    const ssize_t ret = v.sock.recv(&pkt, sizeof(pkt), timeout_ms);
+    if (ret <= 0) {
+        return false;
+    }
+
+    uint8_t num_channels;
+    if (pkt.magic == SWARM_SIM_MAGIC_16 && ret == ssize_t(offsetof(servo_packet, pwm) + 16 * sizeof(uint16_t))) {
+        num_channels = 16;
+    } else if (pkt.magic == SWARM_SIM_MAGIC_32 && ret == ssize_t(sizeof(pkt))) {
+        num_channels = 32;
+    } else {
+        return false;
+    }
+
+    v.sock.last_recv_address(v.reply_addr, v.reply_port);
+
+    if (v.reply_len > 0) {
+        if (pkt.frame_count == v.frame_count) {
+            send_state(v);
+            return false;
+        }
+        if (pkt.frame_count < v.frame_count) {
+            ::printf("Vehicle %u restarted\n", unsigned(&v - vehicles));
+        }
+    }
+    v.frame_count = pkt.frame_count;
+
+    for (uint8_t i = 0; i < ARRAY_SIZE(v.input.servos); i++) {
+        v.input.servos[i] = i < num_channels ? pkt.pwm[i] : 0;
+    }
+    return true;
+}
+
+/*
+  send the model state in the JSON backend's format. Positions are
+  relative to the common home
+ */
+void SwarmSim::send_state(Vehicle &v)
+{
+    const struct sitl_fdm &fdm = v.fdm;
+    const Vector3d position = v.offset + v.model->get_position_relhome();
+
+    v.reply_len = snprintf(v.reply, sizeof(v.reply),
+                           "\n{\"timestamp\":%f,\"imu\":{\"gyro\":[%f,%f,%f],\"accel_body\":[%f,%f,%f]},\"position\":[%f,%f,%f],\"quaternion\":[%f,%f,%f,%f],\"velocity\":[%f,%f,%f]}\n",
+                           fdm.timestamp_us * 1e-6,
+                           radians(fdm.rollRate), radians(fdm.pitchRate), radians(fdm.yawRate),
+                           fdm.xAccel, fdm.yAccel, fdm.zAccel,
+                           position.x, position.y, position.z,
+                           fdm.quaternion.q1, fdm.quaternion.q2, fdm.quaternion.q3, fdm.quaternion.q4,
+                           fdm.speedN, fdm.speedE, fdm.speedD);
+    if (v.reply_len <= 0 || size_t(v.reply_len) >= sizeof(v.reply)) {
+        AP_HAL::panic("SwarmSim: state too long");
+    }
+    v.sock.sendto(v.reply, v.reply_len, v.reply_addr, v.reply_port);
+}
+
+/*
+  fill the wind of every model from the SIM_WIND parameters. The wind
+  profile uses the SIM height above ground, which is set to each
+  vehicle's height above home in turn, as terrain is not simulated
+ */
+void SwarmSim::update_wind(void)
+{
+#if AP_SIM_WIND_SIMULATION_ENABLED
+    const float height_agl = sitl.state.height_agl;
+    for (uint8_t i = 0; i < num_vehicles; i++) {
+        Vehicle &v = vehicles[i];
+        sitl.state.height_agl = -v.model->get_position_relhome().z;
+        hal.simstate->update_simulated_wind(v.input);
+    }
+    sitl.state.height_agl = height_agl;
+#endif
+}
+
+/*
+  pool worker: wait for a frame to start, then step models until none
+  are left
+ */
+void SwarmSim::worker(void)
+{
+    uint32_t last_generation = 0;
+    while (true) {
+        {
+            std::unique_lock<std::mutex> lock(pool_mtx);
+            pool_start.wait(lock, [&]() { return generation != last_generation; });
+            last_generation = generation;
+        }
+        for (uint32_t i = next_model++; i < num_vehicles; i = next_model++) {
+            vehicles[i].model->update_model(vehicles[i].input);
+        }
+        std::lock_guard<std::mutex> lock(pool_mtx);
+        if (--busy_workers == 0) {
+            pool_done.notify_one();
+        }
+    }
+}
+
+/*
+  the models only share state they read, so may be stepped in any
+  order and on any thread
+ */
+void SwarmSim::step_models(void)
+{
+    if (num_workers == 0) {
+        for (uint8_t i = 0; i < num_vehicles; i++) {
+            vehicles[i].model->update_model(vehicles[i].input);
+        }
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> lock(pool_mtx);
+        next_model = 0;
+        busy_workers = num_workers;
+        generation++;
+    }
+    pool_start.notify_all();
+    std::unique_lock<std::mutex> lock(pool_mtx);
+    pool_done.wait(lock, [this]() { return busy_workers == 0; });
+}
+
+void SwarmSim::run(uint8_t jobs)
+{
+    // with a single job the models are stepped on this thread
+    jobs = constrain_int16(jobs, 1, num_vehicles);
+    num_workers = jobs > 1 ? jobs : 0;
+    for (uint8_t t = 0; t < num_workers; t++) {
+        std::thread(&SwarmSim::worker, this).detach();
+    }
+
+    uint64_t frames = 0;
+    while (true) {
+        // gather this frame's servo outputs from every vehicle
+        for (uint8_t i = 0; i < num_vehicles; i++) {
+            uint32_t waited_ms = 0;
+            while (!receive(vehicles[i], 100)) {
+                waited_ms += 100;
+                if (waited_ms == 5000) {
+                    ::printf("Waiting for vehicle %u on port %u\n", i, base_port + 10 * i);
+                }
+            }
+        }
+
+        // the simulation clock is the same for every model
+        hal.scheduler->stop_clock(vehicles[0].fdm.timestamp_us);
+        update_wind();
+        step_models();
+
+        for (uint8_t i = 0; i < num_vehicles; i++) {
+            vehicles[i].model->fill_fdm(vehicles[i].fdm);
+            send_state(vehicles[i]);
+        }
+
+        if (++frames % 10000 == 0) {
+            ::printf("%llu frames, simulation time %.1fs\n",
+                     (unsigned long long)frames, vehicles[0].fdm.timestamp_us * 1.0e-6);
+        }
+    }
+}
+
+static void usage(void)
+{
+    ::printf("Usage: SwarmSim [OPTIONS]\n");
+    ::printf("Options:\n");
+    ::printf("\t--model MODEL           vehicle model, as for the SITL --model option\n");
+    ::printf("\t--count N               number of vehicles\n");
+    ::printf("\t--home HOME             common home, LAT,LON,ALT,HDG or a locations.txt name\n");
+    ::printf("\t--spacing METRES        distance between vehicles on the grid\n");
+    ::printf("\t--base-port PORT        JSON port of vehicle instance 0, instance i uses PORT+10*i\n");
+    ::printf("\t--jobs N                number of threads stepping models\n");
+}
+
+void setup()
+{
+    uint8_t argc;
+    char * const *argv;
+    hal.util->commandline_arguments(argc, argv);
+
+    const struct GetOptLong::option options[] = {
+        // name         has_arg flag val
+        {"model",       true,   0, 'm'},
+        {"count",       true,   0, 'n'},
+        {"home",        true,   0, 'O'},
+        {"spacing",     true,   0, 's'},
+        {"base-port",   true,   0, 'p'},
+        {"jobs",        true,   0, 'j'},
+        {"help",        false,  0, 'h'},
+        {0, false, 0, 0}
+    };
+    GetOptLong gopt(argc, argv, "m:n:O:s:p:j:h", options);
+
+    static SwarmSim swarm;
+    const char *model_str = nullptr;
+    // the default SIM_OPOS location
+    const char *home_str = "-35.363261,149.165230,584,353";
+    int count = 1;
+    float spacing = 5;
+    int base_port = 9002;
+    uint8_t jobs = constrain_int32(std::thread::hardware_concurrency(), 1, UINT8_MAX);
+
+    int opt;
+    while ((opt = gopt.getoption()) != -1) {
+        switch (opt) {
+        case 'm':
+            model_str = gopt.optarg;
+            break;
+        case 'n':
+            count = atoi(gopt.optarg);
+            break;
+        case 'O':
+            home_str = gopt.optarg;
+            break;
+        case 's':
+            spacing = atof(gopt.optarg);
+            break;
+        case 'p':
+            base_port = atoi(gopt.optarg);
+            break;
+        case 'j':
+            jobs = constrain_int32(atoi(gopt.optarg), 1, UINT8_MAX);
+            break;
+        case 'h':
+        default:
+            usage();
+            exit(0);
+        }
+    }
+    if (model_str == nullptr) {
+        usage();
+        exit(1);
+    }
+    if (count < 1 || count > SWARM_SIM_MAX_VEHICLES) {
+        ::printf("Count must be between 1 and %u\n", SWARM_SIM_MAX_VEHICLES);
+        exit(1);
+    }
+    if (base_port < 1 || base_port + 10 * (count - 1) > UINT16_MAX) {
+        ::printf("Bad base port %d\n", base_port);
+        exit(1);
+    }
+
+    Location home;
+    float home_yaw;
+    if (strchr(home_str, ',') == nullptr) {
+        if (!HALSITL::SITL_State::lookup_location(home_str, home, home_yaw)) {
+            ::printf("Failed to find location (%s)\n", home_str);
+            exit(1);
+        }
+    } else if (!HALSITL::SITL_State::parse_home(home_str, home, home_yaw)) {
+        ::printf("Failed to parse home string (%s).  Should be LAT,LON,ALT,HDG e.g. 37.4003371,-122.0800351,0,353\n", home_str);
+        exit(1);
+    }
+
+    if (!swarm.init(model_str, home, home_yaw, count, spacing, base_port)) {
+        exit(1);
+    }
+    swarm.run(jobs);
+}
+
+void loop()
+{
+}
+
+AP_HAL_MAIN();
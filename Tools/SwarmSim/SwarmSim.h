@@ -0,0 +1,80 @@
+#pragma once
+
+#include <AP_HAL/AP_HAL.h>
+#include <AP_HAL/utility/Socket_native.h>
+#include <AP_Common/Location.h>
+#include <SITL/SIM_Aircraft.h>
+#include <SITL/SITL_Input.h>
+
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+
+/*
+  physics for a swarm of vehicles, each talking to its own ArduPilot
+  process over the JSON SITL interface
+ */
+class SwarmSim
+{
+public:
+    SwarmSim() {}
+
+    // create count models laid out on a grid around home, listening on
+    // base_port + 10 * instance as the JSON backend expects
+    bool init(const char *model_str, const Location &home, float home_yaw,
+              uint8_t count, float spacing, uint16_t base_port);
+
+    // step the models in lock-step with the vehicles, forever
+    void run(uint8_t jobs);
+
+private:
+    // servo packet sent by the JSON backend, 16 or 32 channels
+    struct servo_packet {
+        uint16_t magic;
+        uint16_t frame_rate;
+        uint32_t frame_count;
+        uint16_t pwm[32];
+    };
+
+    struct Vehicle {
+        SITL::Aircraft *model;
+        SocketAPM_native sock{true};
+        // offset of this vehicle's start location from the common home
+        Vector3d offset;
+        struct sitl_input input;
+        struct sitl_fdm fdm;
+        uint32_t frame_count;
+        // address the last servo packet came from
+        uint32_t reply_addr;
+        uint16_t reply_port;
+        // last state sent, kept to answer repeated servo packets
+        char reply[512];
+        int reply_len;
+    };
+
+    // wait up to timeout_ms for a new servo packet from a vehicle
+    bool receive(Vehicle &v, uint32_t timeout_ms);
+    // send a vehicle the state of its model
+    void send_state(Vehicle &v);
+
+    // set the wind input of every model from the SIM parameters
+    void update_wind(void);
+
+    // advance every model by one frame, on the worker pool if there is one
+    void step_models(void);
+    void worker(void);
+
+    Vehicle *vehicles;
+    uint8_t num_vehicles;
+    uint16_t base_port;
+
+    // worker pool; each frame the workers take models from next_model
+    // until none are left
+    uint8_t num_workers;
+    std::mutex pool_mtx;
+    std::condition_variable pool_start;
+    std::condition_variable pool_done;
+    uint32_t generation;
+    uint8_t busy_workers;
+    std::atomic<uint32_t> next_model;
+};
@@ -8014,6 +8014,85 @@ class AutoTestCopter(vehicle_test_suite.TestSuite):
             "FFT_ENABLE": 0,
         })
 
+    def fly_gyro_fft_all_axes(self, num_imus, fft_options):
+        """Fly analysing every axis each frame with a 256 sample window and check the FFT keeps up
+        and produces results for num_imus IMUs."""
+        self.set_parameters({
+            "AHRS_EKF_TYPE": 10,    # magic tridge EKF type that dramatically speeds up the test
+            "EK2_ENABLE": 0,
+            "EK3_ENABLE": 0,
+            "SIM_IMU_COUNT": num_imus,
+            "INS_GYRO_FILTER": 100,
+            "INS_FAST_SAMPLE": 7,
+            "LOG_BITMASK": 958,
+            "LOG_DISARMED": 0,
+            "SIM_DRIFT_SPEED": 0,
+            "SIM_DRIFT_TIME": 0,
+            "INS_HNTCH_ENABLE": 1,
+            "INS_HNTCH_FREQ": 80,
+            "INS_HNTCH_REF": 1.0,
+            "INS_HNTCH_HMNCS": 3,   # first and second harmonic
+            "INS_HNTCH_ATT": 50,
+            "INS_HNTCH_BW": 40,
+            "INS_HNTCH_MODE": 4,    # in-flight FFT
+            "INS_HNTCH_OPTS": 2,    # notch-per-FFT peak
+            "FFT_ENABLE": 1,
+            "FFT_WINDOW_SIZE": 256,
+            "FFT_OPTIONS": fft_options,
+            "FFT_MINHZ": 50,
+            "FFT_MAXHZ": 450,
+            "SIM_VIB_MOT_MAX": 250, # gives a motor peak at about 145Hz
+        })
+        if num_imus > 2:
+            self.set_parameters({
+                "INS_ACC3OFFS_X": 0.001,
+                "INS_ACC3OFFS_Y": 0.001,
+                "INS_ACC3OFFS_Z": 0.001,
+            })
+            # force-calibration of accel so that the third IMU is usable
+            self.run_cmd(mavutil.mavlink.MAV_CMD_PREFLIGHT_CALIBRATION, p5=76)
+        self.reboot_sitl()
+
+        self.takeoff(10, mode="ALT_HOLD")
+        tstart, tend, hover_throttle = self.hover_for_interval(30)
+        self.do_RTL()
+
+        # every cycle must finish before the gyros get ahead of the FFT
+        mlog = self.dfreader_for_current_onboard_log()
+        loads = []
+        imus = set()
+        while True:
+            m = mlog.recv_match(type=['FTN1', 'FTN2'], blocking=False)
+            if m is None:
+                break
+            if m.TimeUS < tstart * 1.0e6 or m.TimeUS > tend * 1.0e6:
+                continue
+            if m.get_type() == 'FTN1':
+                loads.append(m.Ld)
+            else:
+                imus.add(m.IMU)
+        if len(loads) == 0:
+            raise NotAchievedException("No FTN1 messages")
+        load = numpy.median(numpy.asarray(loads))
+        self.progress("FFT median load %.1f%% over %u FTN1 messages, IMUs %s" % (load, len(loads), sorted(imus)))
+        if load >= 100:
+            raise NotAchievedException("FFT cycle over budget, median load %.1f%%" % load)
+        if len(imus) != num_imus:
+            raise NotAchievedException("Expected FFT results for %u IMUs, got %s" % (num_imus, sorted(imus)))
+
+        # prevent update parameters from messing with the settings when we pop the context
+        self.set_parameter("FFT_ENABLE", 0)
+
+    def GyroFFTAllAxes(self):
+        """Use FFT to analyse every axis of a single IMU each frame and check it keeps up."""
+        self.progress("Flying with gyro FFT analysing all axes of one IMU")
+        self.fly_gyro_fft_all_axes(1, 8)    # analyse all axes
+
+    def GyroFFTAllIMUs(self):
+        """Use FFT to analyse every IMU with a 256 sample window and check it keeps up."""
+        self.progress("Flying with gyro FFT analysing all IMUs")
+        self.fly_gyro_fft_all_axes(3, 4)    # analyse all IMUs, which analyses all axes
+
     def BrakeMode(self):
         '''Fly Brake Mode'''
         # test brake mode
@@ -15184,6 +15263,8 @@ return update, 1000
             self.WPYawBehaviour1RTL,
             self.GyroFFTPostFilter,
             self.GyroFFTMotorNoiseCheck,
+            self.GyroFFTAllAxes,
+            self.GyroFFTAllIMUs,
             self.CompassReordering,
             self.CRSF,
             self.MotorTest,
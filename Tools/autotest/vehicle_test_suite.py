@@ -12443,6 +12443,7 @@ switch value'''
             now = self.get_sim_time_cached()
             if not start_done or now - last_parameter_received > 10:
                 start_done = True
+                tstart = now
                 if attempt_count > 3:
                     raise AutoTestTimeoutException("Failed to download parameters  (have %s/%s) (seen_ids-count=%u)" %
                                                    (str(count), str(expected_count), len(seen_ids.keys())))
@@ -12482,8 +12483,9 @@ switch value'''
                 if count == expected_count:
                     break
 
-        self.progress("Downloaded %u parameters OK (attempt=%u)" %
-                      (count, attempt_count))
+        duration = self.get_sim_time_cached() - tstart
+        self.progress("Downloaded %u parameters OK (attempt=%u) in %.2fs (%.0f params/s)" %
+                      (count, attempt_count, duration, count / max(duration, 0.001)))
         return (seen_ids, id_seq)
 
     def test_parameters_download(self):
@@ -0,0 +1,103 @@
+#!/usr/bin/env python3
+
+'''
+Expand a log written with LOG_FILE_COMPRESS=1 back into a plain .BIN
+log which other log tools can read.
+
+A compressed log is a series of independent frames, each a 6 byte
+header (0xA3 0x5A, raw length, payload length; little-endian) then
+the payload. The payload is an LZ4 block, or the raw data when the
+two lengths are equal.
+
+AP_FLAKE8_CLEAN
+'''
+
+import argparse
+import struct
+import sys
+
+FRAME_HEADER = struct.Struct('<BBHH')
+FRAME_MAGIC1 = 0xA3
+FRAME_MAGIC2 = 0x5A
+
+
+def lz4_block_decompress(data, raw_len):
+    '''decode a single LZ4 block'''
+    out = bytearray()
+    ip = 0
+    while ip < len(data):
+        token = data[ip]
+        ip += 1
+        lit_len = token >> 4
+        if lit_len == 15:
+            while True:
+                b = data[ip]
+                ip += 1
+                lit_len += b
+                if b != 255:
+                    break
+        out += data[ip:ip+lit_len]
+        ip += lit_len
+        if ip >= len(data):
+            break
+        offset = data[ip] | (data[ip+1] << 8)
+        ip += 2
+        if offset == 0 or offset > len(out):
+            raise ValueError("bad match offset")
+        match_len = token & 0x0F
+        if match_len == 15:
+            while True:
+                b = data[ip]
+                ip += 1
+                match_len += b
+                if b != 255:
+                    break
+        match_len += 4
+        start = len(out) - offset
+        for i in range(match_len):
+            out.append(out[start+i])
+    if len(out) != raw_len:
+        raise ValueError("frame decoded to %u bytes, expected %u" % (len(out), raw_len))
+    return out
+
+
+def decompress(infile, outfile):
+    '''expand infile into outfile, returning the number of frames'''
+    frames = 0
+    while True:
+        hdr = infile.read(FRAME_HEADER.size)
+        if len(hdr) < FRAME_HEADER.size:
+            break
+        (magic1, magic2, raw_len, data_len) = FRAME_HEADER.unpack(hdr)
+        if magic1 != FRAME_MAGIC1 or magic2 != FRAME_MAGIC2 or data_len > raw_len:
+            raise ValueError("bad frame header at offset %u" % (infile.tell() - FRAME_HEADER.size))
+        data = infile.read(data_len)
+        if len(data) < data_len:
+            # truncated final frame, e.g. from a power loss
+            break
+        if data_len == raw_len:
+            outfile.write(data)
+        else:
+            outfile.write(lz4_block_decompress(data, raw_len))
+        frames += 1
+    return frames
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__)
+    parser.add_argument("infile", help="compressed log")
+    parser.add_argument("outfile", help="expanded log to write")
+    args = parser.parse_args()
+
+    with open(args.infile, 'rb') as infile:
+        if infile.read(2) != bytes([FRAME_MAGIC1, FRAME_MAGIC2]):
+            print("%s is not a compressed log" % args.infile)
+            sys.exit(1)
+        infile.seek(0)
+        with open(args.outfile, 'wb') as outfile:
+            frames = decompress(infile, outfile)
+    print("Expanded %u frames" % frames)
+
+
+if __name__ == '__main__':
+    main()
@@ -16,6 +16,7 @@
 #include "AccelCalibrator.h"
 #include <stdio.h>
 #include <AP_HAL/AP_HAL.h>
+#include <AP_Math/LevenbergMarquardt.h>
 
 const extern AP_HAL::HAL& hal;
 /*
@@ -324,6 +325,20 @@ void AccelCalibrator::set_status(enum accel_cal_status_t status) {
     and crosstalk/offdiagonal parameters
 */
 void AccelCalibrator::run_fit(uint8_t max_iterations, float& fitness)
+{
+    switch (get_num_params()) {
+    case 9:
+        run_fit<9>(max_iterations, fitness);
+        break;
+    default:
+        run_fit<6>(max_iterations, fitness);
+        break;
+    }
+}
+
+// Gauss-Newton fit of the first N parameters, an undamped Levenberg-Marquardt step per iteration
+template <uint8_t N>
+void AccelCalibrator::run_fit(uint8_t max_iterations, float& fitness)
 {
     if (_sample_buffer == nullptr) {
         return;
@@ -334,8 +349,7 @@ void AccelCalibrator::run_fit(uint8_t max_iterations, float& fitness)
     uint8_t num_iterations = 0;
 
     while(num_iterations < max_iterations) {
-        float JTJ[ACCEL_CAL_MAX_NUM_PARAMS*ACCEL_CAL_MAX_NUM_PARAMS] {};
-        VectorP JTFI;
+        LevenbergMarquardt<N> lm;
 
         for(uint16_t k = 0; k<_samples_collected; k++) {
             Vector3f sample;
@@ -344,27 +358,13 @@ void AccelCalibrator::run_fit(uint8_t max_iterations, float& fitness)
             VectorN<float,ACCEL_CAL_MAX_NUM_PARAMS> jacob;
 
             calc_jacob(sample, fit_param.s, jacob);
-
-            for(uint8_t i = 0; i < get_num_params(); i++) {
-                // compute JTJ
-                for(uint8_t j = 0; j < get_num_params(); j++) {
-                    JTJ[i*get_num_params()+j] += jacob[i] * jacob[j];
-                }
-                // compute JTFI
-                JTFI[i] += jacob[i] * calc_residual(sample, fit_param.s);
-            }
+            lm.add(&jacob[0], calc_residual(sample, fit_param.s));
         }
 
-        if (!mat_inverse(JTJ, JTJ, get_num_params())) {
+        if (!lm.solve(0, &fit_param.a[0])) {
             return;
         }
 
-        for(uint8_t row=0; row < get_num_params(); row++) {
-            for(uint8_t col=0; col < get_num_params(); col++) {
-                fit_param.a[row] -= JTFI[col] * JTJ[row*get_num_params()+col];
-            }
-        }
-
         fitness = calc_mean_squared_residuals(fit_param.s);
 
         if (isnan(fitness) || isinf(fitness)) {
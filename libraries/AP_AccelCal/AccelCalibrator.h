@@ -140,4 +140,6 @@ private:
     float calc_mean_squared_residuals(const struct param_t& params) const;
     void calc_jacob(const Vector3f& sample, const struct param_t& params, VectorP& ret) const;
     void run_fit(uint8_t max_iterations, float& fitness);
+    template <uint8_t N>
+    void run_fit(uint8_t max_iterations, float& fitness);
 };
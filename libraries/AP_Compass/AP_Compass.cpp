@@ -616,6 +616,7 @@ const AP_Param::GroupInfo Compass::var_info[] = {
     // @Description: This sets options to change the behaviour of the compass
     // @Bitmask: 0:CalRequireGPS
     // @Bitmask: 1: Allow missing DroneCAN compasses to be automaticaly replaced (calibration still required)
+    // @Bitmask: 2: Run calibration fits in a background thread
     // @User: Advanced
     AP_GROUPINFO("OPTIONS", 43, Compass, _options, 0),
 #endif
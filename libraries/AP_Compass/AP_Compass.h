@@ -390,6 +390,7 @@ private:
 #if COMPASS_CAL_ENABLED
     // compass cal
     void _update_calibration_trampoline();
+    void _calibration_fit_trampoline();
     bool _accept_calibration(uint8_t i);
     bool _accept_calibration_mask(uint8_t mask);
     void _cancel_calibration(uint8_t i);
@@ -622,6 +623,7 @@ private:
     enum class Option : uint16_t {
         CAL_REQUIRE_GPS = (1U<<0),
         ALLOW_DRONECAN_AUTO_REPLACEMENT = (1U<<1),
+        CAL_FIT_THREAD = (1U<<2),
     };
     bool option_set(Option opt) const { return (_options.get() & uint16_t(opt)) != 0; }
     AP_Int16 _options;
@@ -660,6 +662,7 @@ private:
     bool _initial_location_set;
 
     bool _cal_thread_started;
+    bool _cal_fit_thread_started;
 
 #if AP_COMPASS_MSP_ENABLED
     uint8_t msp_instance_mask;
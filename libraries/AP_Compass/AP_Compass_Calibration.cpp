@@ -103,6 +103,18 @@ bool Compass::_start_calibration(uint8_t i, bool retry, float delay)
         }
         _cal_thread_started = true;
     }
+    bool background_fit = false;
+    if (option_set(Option::CAL_FIT_THREAD)) {
+        if (!_cal_fit_thread_started &&
+            hal.scheduler->thread_create(FUNCTOR_BIND(this, &Compass::_calibration_fit_trampoline, void), "compassfit", 2048, AP_HAL::Scheduler::PRIORITY_IO, -1)) {
+            _cal_fit_thread_started = true;
+        }
+        if (!_cal_fit_thread_started) {
+            GCS_SEND_TEXT(MAV_SEVERITY_WARNING, "CompassCalibrator: Cannot start fit thread.");
+        }
+        background_fit = _cal_fit_thread_started;
+    }
+    _calibrator[prio]->set_background_fit(background_fit);
 
     // disable compass learning both for calibration and after completion
     _learn.set_and_save(LearnType::NONE);
@@ -122,6 +134,23 @@ void Compass::_update_calibration_trampoline() {
     }
 }
 
+/*
+  run the calibrators' Levenberg-Marquardt fits against a snapshot of
+  their samples, so a full fit stage completes without waiting on the
+  one step per loop of the calibration thread
+ */
+void Compass::_calibration_fit_trampoline() {
+    while(true) {
+        for (Priority i(0); i<COMPASS_MAX_INSTANCES; i++) {
+            if (_calibrator[i] == nullptr) {
+                continue;
+            }
+            _calibrator[i]->run_background_fit();
+        }
+        hal.scheduler->delay(1);
+    }
+}
+
 bool Compass::_start_calibration_mask(uint8_t mask, bool retry, bool autosave, float delay, bool autoreboot)
 {
     _cal_autosave = autosave;
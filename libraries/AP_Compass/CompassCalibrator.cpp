@@ -69,10 +69,15 @@
 #include <AP_GPS/AP_GPS.h>
 #include <GCS_MAVLink/GCS.h>
 #include <AP_InternalError/AP_InternalError.h>
+#include <AP_Math/LevenbergMarquardt.h>
 
 #define FIELD_RADIUS_MIN 150
 #define FIELD_RADIUS_MAX 950
 
+#define COMPASS_CAL_STEP_ONE_FITS           10  // sphere fits in step one
+#define COMPASS_CAL_STEP_TWO_SPHERE_FITS    15  // sphere fits at the start of step two
+#define COMPASS_CAL_STEP_TWO_FITS           35  // sphere and ellipsoid fits in step two
+
 ////////////////////////////////////////////////////////////
 ///////////////////// PUBLIC INTERFACE /////////////////////
 ////////////////////////////////////////////////////////////
@@ -101,6 +106,12 @@ void CompassCalibrator::set_orientation(enum Rotation orientation, bool is_exter
     cal_settings.always_45_deg = always_45_deg;
 }
 
+void CompassCalibrator::set_background_fit(bool enable)
+{
+    WITH_SEMAPHORE(state_sem);
+    cal_settings.background_fit = enable;
+}
+
 void CompassCalibrator::start(bool retry, float delay, uint16_t offset_max, uint8_t compass_idx, float tolerance)
 {
     if (compass_idx > COMPASS_MAX_INSTANCES) {
@@ -200,8 +211,13 @@ void CompassCalibrator::update()
         return;
     }
 
+    // wait for the fit thread to finish this stage's fits
+    if (_background_fit && !update_background_fit()) {
+        return;
+    }
+
     if (_status == Status::RUNNING_STEP_ONE) {
-        if (_fit_step >= 10) {
+        if (_fit_step >= COMPASS_CAL_STEP_ONE_FITS) {
             if (is_equal(_fitness, _initial_fitness) || isnan(_fitness)) {  // if true, means that fitness is diverging instead of converging
                 set_status(Status::FAILED);
             } else {
@@ -209,19 +225,19 @@ void CompassCalibrator::update()
             }
         } else {
             if (_fit_step == 0) {
-                calc_initial_offset();
+                calc_initial_offset(_sample_buffer, _samples_collected, _params);
             }
             run_sphere_fit();
             _fit_step++;
         }
     } else if (_status == Status::RUNNING_STEP_TWO) {
-        if (_fit_step >= 35) {
+        if (_fit_step >= COMPASS_CAL_STEP_TWO_FITS) {
             if (fit_acceptable() && fix_radius() && calculate_orientation()) {
                 set_status(Status::SUCCESS);
             } else {
                 set_status(Status::FAILED);
             }
-        } else if (_fit_step < 15) {
+        } else if (_fit_step < COMPASS_CAL_STEP_TWO_SPHERE_FITS) {
             run_sphere_fit();
             _fit_step++;
         } else {
@@ -231,6 +247,120 @@ void CompassCalibrator::update()
     }
 }
 
+/*
+  hand the fits for the current stage to the fit thread, which runs
+  them all in one go against a snapshot of the samples, and pick up the
+  results on a later update
+ */
+bool CompassCalibrator::update_background_fit()
+{
+    WITH_SEMAPHORE(fit_sem);
+
+    switch (_fit_job.state) {
+    case FitJobState::IDLE:
+        break;
+    case FitJobState::PENDING:
+    case FitJobState::RUNNING:
+        return false;
+    case FitJobState::DONE:
+        _fit_job.state = FitJobState::IDLE;
+        if (_fit_job.generation != _fit_generation) {
+            // the calibration has moved on since the job started
+            break;
+        }
+        _params = _fit_job.params;
+        _fitness = _fit_job.fitness;
+        _sphere_lambda = _fit_job.sphere_lambda;
+        _ellipsoid_lambda = _fit_job.ellipsoid_lambda;
+        _fit_step = _fit_job.fit_step;
+        update_completion_mask();
+        return true;
+    }
+
+    if (_fit_job.samples == nullptr) {
+        _fit_job.samples = alloc_fit_samples();
+        if (_fit_job.samples == nullptr) {
+            // fall back to fitting a step at a time in this thread
+            _background_fit = false;
+            return true;
+        }
+    }
+    memcpy(_fit_job.samples, _sample_buffer, _samples_collected * sizeof(CompassSample));
+    _fit_job.num_samples = _samples_collected;
+    _fit_job.generation = _fit_generation;
+    _fit_job.status = _status;
+    _fit_job.params = _params;
+    _fit_job.fitness = _fitness;
+    _fit_job.sphere_lambda = _sphere_lambda;
+    _fit_job.ellipsoid_lambda = _ellipsoid_lambda;
+    _fit_job.fit_step = _fit_step;
+    _fit_job.state = FitJobState::PENDING;
+    return false;
+}
+
+void CompassCalibrator::run_background_fit()
+{
+    {
+        WITH_SEMAPHORE(fit_sem);
+        if (_fit_job.state != FitJobState::PENDING) {
+            return;
+        }
+        _fit_job.state = FitJobState::RUNNING;
+    }
+
+    // the job is ours until it is marked done, so fit without holding the semaphore
+    run_fit_job(_fit_job);
+
+    WITH_SEMAPHORE(fit_sem);
+    _fit_job.state = FitJobState::DONE;
+}
+
+// run the same fit steps update() would, without waiting between them
+void CompassCalibrator::run_fit_job(FitJob &job) const
+{
+    if (job.status == Status::RUNNING_STEP_ONE) {
+        if (job.fit_step == 0) {
+            calc_initial_offset(job.samples, job.num_samples, job.params);
+        }
+        for (; job.fit_step < COMPASS_CAL_STEP_ONE_FITS; job.fit_step++) {
+            run_sphere_fit(job.samples, job.num_samples, job.params, job.fitness, job.sphere_lambda);
+        }
+    } else if (job.status == Status::RUNNING_STEP_TWO) {
+        for (; job.fit_step < COMPASS_CAL_STEP_TWO_FITS; job.fit_step++) {
+            if (job.fit_step < COMPASS_CAL_STEP_TWO_SPHERE_FITS) {
+                run_sphere_fit(job.samples, job.num_samples, job.params, job.fitness, job.sphere_lambda);
+            } else {
+                run_ellipsoid_fit(job.samples, job.num_samples, job.params, job.fitness, job.ellipsoid_lambda);
+            }
+        }
+    }
+}
+
+void CompassCalibrator::free_fit_job()
+{
+    WITH_SEMAPHORE(fit_sem);
+    if (_fit_job.state == FitJobState::RUNNING) {
+        // its result will be discarded as stale when it completes
+        return;
+    }
+    _fit_job.state = FitJobState::IDLE;
+    if (_fit_job.samples != nullptr) {
+        free(_fit_job.samples);
+        _fit_job.samples = nullptr;
+    }
+}
+
+CompassCalibrator::CompassSample *CompassCalibrator::alloc_fit_samples() const
+{
+#if CONFIG_HAL_BOARD == HAL_BOARD_SITL
+    if (_fail_fit_alloc) {
+        // a test standing in for an exhausted heap
+        return nullptr;
+    }
+#endif
+    return (CompassSample*)calloc(COMPASS_CAL_NUM_SAMPLES, sizeof(CompassSample));
+}
+
 void CompassCalibrator::pull_sample()
 {
     CompassSample mag_sample;
@@ -268,6 +398,7 @@ void CompassCalibrator::update_cal_settings()
     _start_time_ms = cal_settings.start_time_ms;
     _compass_idx = cal_settings.compass_idx;
     _always_45_deg = cal_settings.always_45_deg;
+    _background_fit = cal_settings.background_fit;
 }
 
 // update completion mask based on latest sample
@@ -365,6 +496,7 @@ void CompassCalibrator::initialize_fit()
     _sphere_lambda = 1.0f;
     _ellipsoid_lambda = 1.0f;
     _fit_step = 0;
+    _fit_generation++;
 }
 
 void CompassCalibrator::reset_state()
@@ -395,6 +527,7 @@ bool CompassCalibrator::set_status(CompassCalibrator::Status status)
                 free(_sample_buffer);
                 _sample_buffer = nullptr;
             }
+            free_fit_job();
             return true;
 
         case Status::WAITING_TO_START:
@@ -441,6 +574,7 @@ bool CompassCalibrator::set_status(CompassCalibrator::Status status)
                 free(_sample_buffer);
                 _sample_buffer = nullptr;
             }
+            free_fit_job();
 
             _status = Status::SUCCESS;
             return true;
@@ -468,6 +602,7 @@ bool CompassCalibrator::set_status(CompassCalibrator::Status status)
                 free(_sample_buffer);
                 _sample_buffer = nullptr;
             }
+            free_fit_job();
 
             _status = status;
             return true;
@@ -580,28 +715,33 @@ float CompassCalibrator::calc_residual(const Vector3f& sample, const param_t& pa
 // calc the fitness given a set of parameters (offsets, diagonals, off diagonals)
 float CompassCalibrator::calc_mean_squared_residuals(const param_t& params) const
 {
-    if (_sample_buffer == nullptr || _samples_collected == 0) {
+    return calc_mean_squared_residuals(_sample_buffer, _samples_collected, params);
+}
+
+float CompassCalibrator::calc_mean_squared_residuals(const CompassSample *samples, uint16_t num_samples, const param_t& params) const
+{
+    if (samples == nullptr || num_samples == 0) {
         return 1.0e30f;
     }
     float sum = 0.0f;
-    for (uint16_t i=0; i < _samples_collected; i++) {
-        Vector3f sample = _sample_buffer[i].get();
+    for (uint16_t i=0; i < num_samples; i++) {
+        Vector3f sample = samples[i].get();
         float resid = calc_residual(sample, params);
         sum += sq(resid);
     }
-    sum /= _samples_collected;
+    sum /= num_samples;
     return sum;
 }
 
 // calculate initial offsets by simply taking the average values of the samples
-void CompassCalibrator::calc_initial_offset()
+void CompassCalibrator::calc_initial_offset(const CompassSample *samples, uint16_t num_samples, param_t &params) const
 {
     // Set initial offset to the average value of the samples
-    _params.offset.zero();
-    for (uint16_t k = 0; k < _samples_collected; k++) {
-        _params.offset -= _sample_buffer[k].get();
+    params.offset.zero();
+    for (uint16_t k = 0; k < num_samples; k++) {
+        params.offset -= samples[k].get();
     }
-    _params.offset /= _samples_collected;
+    params.offset /= num_samples;
 }
 
 void CompassCalibrator::calc_sphere_jacob(const Vector3f& sample, const param_t& params, float* ret) const
@@ -635,84 +775,30 @@ void CompassCalibrator::run_sphere_fit()
         return;
     }
 
-    const float lma_damping = 10.0f;
-
-    // take backup of fitness and parameters so we can determine later if this fit has improved the calibration
-    float fitness = _fitness;
-    float fit1, fit2;
-    param_t fit1_params, fit2_params;
-    fit1_params = fit2_params = _params;
+    if (run_sphere_fit(_sample_buffer, _samples_collected, _params, _fitness, _sphere_lambda)) {
+        update_completion_mask();
+    }
+}
 
-    float JTJ[COMPASS_CAL_NUM_SPHERE_PARAMS*COMPASS_CAL_NUM_SPHERE_PARAMS] = { };
-    float JTJ2[COMPASS_CAL_NUM_SPHERE_PARAMS*COMPASS_CAL_NUM_SPHERE_PARAMS] = { };
-    float JTFI[COMPASS_CAL_NUM_SPHERE_PARAMS] = { };
+bool CompassCalibrator::run_sphere_fit(const CompassSample *samples, uint16_t num_samples, param_t &params, float &fitness, float &lambda) const
+{
+    const float lma_damping = 10.0f;
 
     // Gauss Newton Part common for all kind of extensions including LM
-    for (uint16_t k = 0; k<_samples_collected; k++) {
-        Vector3f sample = _sample_buffer[k].get();
+    LevenbergMarquardt<COMPASS_CAL_NUM_SPHERE_PARAMS> lm;
+    for (uint16_t k = 0; k<num_samples; k++) {
+        Vector3f sample = samples[k].get();
 
         float sphere_jacob[COMPASS_CAL_NUM_SPHERE_PARAMS];
 
-        calc_sphere_jacob(sample, fit1_params, sphere_jacob);
-
-        for (uint8_t i = 0;i < COMPASS_CAL_NUM_SPHERE_PARAMS; i++) {
-            // compute JTJ
-            for (uint8_t j = 0; j < COMPASS_CAL_NUM_SPHERE_PARAMS; j++) {
-                JTJ[i*COMPASS_CAL_NUM_SPHERE_PARAMS+j] += sphere_jacob[i] * sphere_jacob[j];
-                JTJ2[i*COMPASS_CAL_NUM_SPHERE_PARAMS+j] += sphere_jacob[i] * sphere_jacob[j];   //a backup JTJ for LM
-            }
-            // compute JTFI
-            JTFI[i] += sphere_jacob[i] * calc_residual(sample, fit1_params);
-        }
-    }
-
-    //------------------------Levenberg-Marquardt-part-starts-here---------------------------------//
-    // refer: http://en.wikipedia.org/wiki/Levenberg%E2%80%93Marquardt_algorithm#Choice_of_damping_parameter
-    for (uint8_t i = 0; i < COMPASS_CAL_NUM_SPHERE_PARAMS; i++) {
-        JTJ[i*COMPASS_CAL_NUM_SPHERE_PARAMS+i] += _sphere_lambda;
-        JTJ2[i*COMPASS_CAL_NUM_SPHERE_PARAMS+i] += _sphere_lambda/lma_damping;
-    }
-
-    if (!mat_inverse(JTJ, JTJ, 4)) {
-        return;
-    }
-
-    if (!mat_inverse(JTJ2, JTJ2, 4)) {
-        return;
-    }
-
-    // extract radius, offset, diagonals and offdiagonal parameters
-    for (uint8_t row=0; row < COMPASS_CAL_NUM_SPHERE_PARAMS; row++) {
-        for (uint8_t col=0; col < COMPASS_CAL_NUM_SPHERE_PARAMS; col++) {
-            fit1_params.get_sphere_params()[row] -= JTFI[col] * JTJ[row*COMPASS_CAL_NUM_SPHERE_PARAMS+col];
-            fit2_params.get_sphere_params()[row] -= JTFI[col] * JTJ2[row*COMPASS_CAL_NUM_SPHERE_PARAMS+col];
-        }
-    }
-
-    // calculate fitness of two possible sets of parameters
-    fit1 = calc_mean_squared_residuals(fit1_params);
-    fit2 = calc_mean_squared_residuals(fit2_params);
-
-    // decide which of the two sets of parameters is best and store in fit1_params
-    if (fit1 > _fitness && fit2 > _fitness) {
-        // if neither set of parameters provided better results, increase lambda
-        _sphere_lambda *= lma_damping;
-    } else if (fit2 < _fitness && fit2 < fit1) {
-        // if fit2 was better we will use it. decrease lambda
-        _sphere_lambda /= lma_damping;
-        fit1_params = fit2_params;
-        fitness = fit2;
-    } else if (fit1 < _fitness) {
-        fitness = fit1;
+        calc_sphere_jacob(sample, params, sphere_jacob);
+        lm.add(sphere_jacob, calc_residual(sample, params));
     }
-    //--------------------Levenberg-Marquardt-part-ends-here--------------------------------//
 
-    // store new parameters and update fitness
-    if (!isnan(fitness) && fitness < _fitness) {
-        _fitness = fitness;
-        _params = fit1_params;
-        update_completion_mask();
-    }
+    // extract radius and offsets, keeping them if they improve fitness
+    return lm.iterate(params, fitness, lambda, lma_damping,
+                      [](param_t &p) { return p.get_sphere_params(); },
+                      [&](const param_t &p) { return calc_mean_squared_residuals(samples, num_samples, p); });
 }
 
 void CompassCalibrator::calc_ellipsoid_jacob(const Vector3f& sample, const param_t& params, float* ret) const
@@ -751,84 +837,30 @@ void CompassCalibrator::run_ellipsoid_fit()
         return;
     }
 
-    const float lma_damping = 10.0f;
-
-    // take backup of fitness and parameters so we can determine later if this fit has improved the calibration
-    float fitness = _fitness;
-    float fit1, fit2;
-    param_t fit1_params, fit2_params;
-    fit1_params = fit2_params = _params;
+    if (run_ellipsoid_fit(_sample_buffer, _samples_collected, _params, _fitness, _ellipsoid_lambda)) {
+        update_completion_mask();
+    }
+}
 
-    float JTJ[COMPASS_CAL_NUM_ELLIPSOID_PARAMS*COMPASS_CAL_NUM_ELLIPSOID_PARAMS] = { };
-    float JTJ2[COMPASS_CAL_NUM_ELLIPSOID_PARAMS*COMPASS_CAL_NUM_ELLIPSOID_PARAMS] = { };
-    float JTFI[COMPASS_CAL_NUM_ELLIPSOID_PARAMS] = { };
+bool CompassCalibrator::run_ellipsoid_fit(const CompassSample *samples, uint16_t num_samples, param_t &params, float &fitness, float &lambda) const
+{
+    const float lma_damping = 10.0f;
 
     // Gauss Newton Part common for all kind of extensions including LM
-    for (uint16_t k = 0; k<_samples_collected; k++) {
-        Vector3f sample = _sample_buffer[k].get();
+    LevenbergMarquardt<COMPASS_CAL_NUM_ELLIPSOID_PARAMS> lm;
+    for (uint16_t k = 0; k<num_samples; k++) {
+        Vector3f sample = samples[k].get();
 
         float ellipsoid_jacob[COMPASS_CAL_NUM_ELLIPSOID_PARAMS];
 
-        calc_ellipsoid_jacob(sample, fit1_params, ellipsoid_jacob);
-
-        for (uint8_t i = 0;i < COMPASS_CAL_NUM_ELLIPSOID_PARAMS; i++) {
-            // compute JTJ
-            for (uint8_t j = 0; j < COMPASS_CAL_NUM_ELLIPSOID_PARAMS; j++) {
-                JTJ [i*COMPASS_CAL_NUM_ELLIPSOID_PARAMS+j] += ellipsoid_jacob[i] * ellipsoid_jacob[j];
-                JTJ2[i*COMPASS_CAL_NUM_ELLIPSOID_PARAMS+j] += ellipsoid_jacob[i] * ellipsoid_jacob[j];
-            }
-            // compute JTFI
-            JTFI[i] += ellipsoid_jacob[i] * calc_residual(sample, fit1_params);
-        }
-    }
-
-    //------------------------Levenberg-Marquardt-part-starts-here---------------------------------//
-    //refer: http://en.wikipedia.org/wiki/Levenberg%E2%80%93Marquardt_algorithm#Choice_of_damping_parameter
-    for (uint8_t i = 0; i < COMPASS_CAL_NUM_ELLIPSOID_PARAMS; i++) {
-        JTJ[i*COMPASS_CAL_NUM_ELLIPSOID_PARAMS+i] += _ellipsoid_lambda;
-        JTJ2[i*COMPASS_CAL_NUM_ELLIPSOID_PARAMS+i] += _ellipsoid_lambda/lma_damping;
+        calc_ellipsoid_jacob(sample, params, ellipsoid_jacob);
+        lm.add(ellipsoid_jacob, calc_residual(sample, params));
     }
 
-    if (!mat_inverse(JTJ, JTJ, 9)) {
-        return;
-    }
-
-    if (!mat_inverse(JTJ2, JTJ2, 9)) {
-        return;
-    }
-
-    // extract radius, offset, diagonals and offdiagonal parameters
-    for (uint8_t row=0; row < COMPASS_CAL_NUM_ELLIPSOID_PARAMS; row++) {
-        for (uint8_t col=0; col < COMPASS_CAL_NUM_ELLIPSOID_PARAMS; col++) {
-            fit1_params.get_ellipsoid_params()[row] -= JTFI[col] * JTJ[row*COMPASS_CAL_NUM_ELLIPSOID_PARAMS+col];
-            fit2_params.get_ellipsoid_params()[row] -= JTFI[col] * JTJ2[row*COMPASS_CAL_NUM_ELLIPSOID_PARAMS+col];
-        }
-    }
-
-    // calculate fitness of two possible sets of parameters
-    fit1 = calc_mean_squared_residuals(fit1_params);
-    fit2 = calc_mean_squared_residuals(fit2_params);
-
-    // decide which of the two sets of parameters is best and store in fit1_params
-    if (fit1 > _fitness && fit2 > _fitness) {
-        // if neither set of parameters provided better results, increase lambda
-        _ellipsoid_lambda *= lma_damping;
-    } else if (fit2 < _fitness && fit2 < fit1) {
-        // if fit2 was better we will use it. decrease lambda
-        _ellipsoid_lambda /= lma_damping;
-        fit1_params = fit2_params;
-        fitness = fit2;
-    } else if (fit1 < _fitness) {
-        fitness = fit1;
-    }
-    //--------------------Levenberg-part-ends-here--------------------------------//
-
-    // store new parameters and update fitness
-    if (fitness < _fitness) {
-        _fitness = fitness;
-        _params = fit1_params;
-        update_completion_mask();
-    }
+    // extract offset, diagonals and offdiagonal parameters, keeping them if they improve fitness
+    return lm.iterate(params, fitness, lambda, lma_damping,
+                      [](param_t &p) { return p.get_ellipsoid_params(); },
+                      [&](const param_t &p) { return calc_mean_squared_residuals(samples, num_samples, p); });
 }
 
 
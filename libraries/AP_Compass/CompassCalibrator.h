@@ -11,6 +11,8 @@
 #define COMPASS_CAL_NUM_SAMPLES             300     // number of samples required before fitting begins
 
 class CompassCalibrator {
+    friend class CompassCalibrator_Test;
+
 public:
     CompassCalibrator();
 
@@ -34,6 +36,12 @@ public:
     // update the state machine and calculate offsets, diagonals and offdiagonals
     void update();
 
+    // run the fits on a snapshot of the samples in a separate thread, which calls run_background_fit()
+    void set_background_fit(bool enable);
+
+    // run a fit handed over by update() to completion, called from the fit thread
+    void run_background_fit();
+
     // compass calibration states - these correspond to the mavlink
     // MAG_CAL_STATUS enumeration
     enum class Status {
@@ -87,6 +95,7 @@ public:
         uint32_t start_time_ms;
         uint8_t compass_idx;
         bool always_45_deg;
+        bool background_fit;
     } cal_settings;
 
     // Get calibration result
@@ -177,17 +186,54 @@ private:
     // calc the fitness of the parameters (offsets, diagonals, off diagonals) vs all the samples collected
     // returns 1.0e30f if the sample buffer is empty
     float calc_mean_squared_residuals(const param_t& params) const;
+    float calc_mean_squared_residuals(const CompassSample *samples, uint16_t num_samples, const param_t& params) const;
 
     // calculate initial offsets by simply taking the average values of the samples
-    void calc_initial_offset();
+    void calc_initial_offset(const CompassSample *samples, uint16_t num_samples, param_t &params) const;
 
     // run sphere fit to calculate diagonals and offdiagonals
+    // the overload taking samples returns true if it improved params and fitness
     void calc_sphere_jacob(const Vector3f& sample, const param_t& params, float* ret) const;
     void run_sphere_fit();
+    bool run_sphere_fit(const CompassSample *samples, uint16_t num_samples, param_t &params, float &fitness, float &lambda) const;
 
     // run ellipsoid fit to calculate diagonals and offdiagonals
     void calc_ellipsoid_jacob(const Vector3f& sample, const param_t& params, float* ret) const;
     void run_ellipsoid_fit();
+    bool run_ellipsoid_fit(const CompassSample *samples, uint16_t num_samples, param_t &params, float &fitness, float &lambda) const;
+
+    // fit handed to the fit thread, a snapshot of the samples and fit state
+    enum class FitJobState : uint8_t {
+        IDLE,       // free for update() to start a job
+        PENDING,    // waiting for the fit thread
+        RUNNING,    // owned by the fit thread
+        DONE,       // results waiting for update()
+    };
+    struct FitJob {
+        FitJobState state;
+        uint16_t generation;                // _fit_generation when the job was started
+        Status status;
+        CompassSample *samples;
+        uint16_t num_samples;
+        param_t params;
+        float fitness;
+        float sphere_lambda;
+        float ellipsoid_lambda;
+        uint16_t fit_step;
+    };
+
+    // run the remaining fit steps of the job's stage
+    void run_fit_job(FitJob &job) const;
+
+    // start a background fit for the current stage or collect its results
+    // returns true once the stage's fit steps are complete
+    bool update_background_fit();
+
+    // free the background fit's sample snapshot if the fit thread is not using it
+    void free_fit_job();
+
+    // allocate the background fit's sample snapshot
+    CompassSample *alloc_fit_samples() const;
 
     // update the completion mask based on a single sample
     void update_completion_mask(const Vector3f& sample);
@@ -234,6 +280,14 @@ private:
     float _initial_fitness;                 // fitness before latest "fit" was attempted (used to determine if fit was an improvement)
     float _sphere_lambda;                   // sphere fit's lambda
     float _ellipsoid_lambda;                // ellipsoid fit's lambda
+    uint16_t _fit_generation;               // incremented each time a fit is initialized, to spot stale background fits
+
+    // background fit, see set_background_fit()
+    bool _background_fit;                   // true if fits are run in the fit thread
+    FitJob _fit_job;                        // protected by fit_sem
+#if CONFIG_HAL_BOARD == HAL_BOARD_SITL
+    bool _fail_fit_alloc = false;           // set by tests to fail the snapshot allocation
+#endif
 
     // variables for orientation checking
     enum Rotation _orientation;             // latest detected orientation
@@ -256,6 +310,9 @@ private:
 
     // Semaphore for intermediate structure for point sample collection
     HAL_Semaphore sample_sem;
+
+    // Semaphore for the background fit job
+    HAL_Semaphore fit_sem;
 };
 
 #endif  // COMPASS_CAL_ENABLED
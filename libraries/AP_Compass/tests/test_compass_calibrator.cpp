@@ -0,0 +1,351 @@
+#include <AP_gtest.h>
+
+#include <AP_Compass/CompassCalibrator.h>
+
+#include <chrono>
+#include <thread>
+
+const AP_HAL::HAL& hal = AP_HAL::get_HAL();
+
+/*
+  drive the fits of a single calibration stage, as the calibration
+  thread and, with background fits, the fit thread would
+ */
+class CompassCalibrator_Test
+{
+public:
+    using Status = CompassCalibrator::Status;
+    using FitJobState = CompassCalibrator::FitJobState;
+
+    CompassCalibrator_Test(bool background_fit)
+    {
+        cal.set_background_fit(background_fit);
+    }
+
+    ~CompassCalibrator_Test()
+    {
+        // frees the sample buffer and the fit job's snapshot
+        cal.set_status(Status::NOT_STARTED);
+    }
+
+    // fill the sample buffer, leaving the stage ready to fit
+    void start_stage(Status status, const Vector3f *samples)
+    {
+        if (cal._sample_buffer == nullptr) {
+            cal._sample_buffer = (CompassCalibrator::CompassSample*)calloc(COMPASS_CAL_NUM_SAMPLES, sizeof(CompassCalibrator::CompassSample));
+        }
+        for (uint16_t i = 0; i < COMPASS_CAL_NUM_SAMPLES; i++) {
+            cal._sample_buffer[i].set(samples[i]);
+        }
+        cal._samples_collected = COMPASS_CAL_NUM_SAMPLES;
+        cal._params.radius = 200;
+        cal._params.offset.zero();
+        cal._params.diag = Vector3f(1, 1, 1);
+        cal._params.offdiag.zero();
+        if (status == Status::RUNNING_STEP_TWO) {
+            // step one would have found the offsets
+            cal.calc_initial_offset(cal._sample_buffer, cal._samples_collected, cal._params);
+        }
+        cal._status = status;
+        cal.initialize_fit();
+    }
+
+    // number of fit steps in a stage, as in CompassCalibrator.cpp
+    uint16_t stage_fits() const
+    {
+        return cal._status == Status::RUNNING_STEP_ONE ? 10 : 35;
+    }
+
+    // a loop of the calibration thread
+    void update() { cal.update(); }
+
+    // a loop of the fit thread
+    void run_background_fit() { cal.run_background_fit(); }
+
+    // pick up a finished background fit, as update() does before acting on the fit
+    bool collect_background_fit() { return cal.update_background_fit(); }
+
+    // the fit thread taking a job, without running it yet
+    void take_job()
+    {
+        WITH_SEMAPHORE(cal.fit_sem);
+        ASSERT_EQ(cal._fit_job.state, FitJobState::PENDING);
+        cal._fit_job.state = FitJobState::RUNNING;
+    }
+
+    // the fit thread finishing the job it took
+    void finish_job()
+    {
+        cal.run_fit_job(cal._fit_job);
+        WITH_SEMAPHORE(cal.fit_sem);
+        cal._fit_job.state = FitJobState::DONE;
+    }
+
+    // the calibration moving on, as on a change of stage or a restart
+    void restart_fit() { cal.initialize_fit(); }
+
+    void free_fit_job() { cal.free_fit_job(); }
+
+#if CONFIG_HAL_BOARD == HAL_BOARD_SITL
+    // make the allocation of the fit job's snapshot fail, as it would
+    // with the heap exhausted
+    void fail_fit_alloc(bool fail) { cal._fail_fit_alloc = fail; }
+#endif
+
+    FitJobState job_state() const { return cal._fit_job.state; }
+    bool job_has_samples() const { return cal._fit_job.samples != nullptr; }
+    bool job_is_current() const { return cal._fit_job.generation == cal._fit_generation; }
+    bool background_fit() const { return cal._background_fit; }
+    uint16_t fit_step() const { return cal._fit_step; }
+    float fitness() const { return cal._fitness; }
+    float radius() const { return cal._params.radius; }
+    const Vector3f &offset() const { return cal._params.offset; }
+    const Vector3f &diag() const { return cal._params.diag; }
+    const Vector3f &offdiag() const { return cal._params.offdiag; }
+
+private:
+    CompassCalibrator cal;
+};
+
+using FitJobState = CompassCalibrator_Test::FitJobState;
+
+/*
+  samples spread evenly over a compass style ellipsoid with offsets
+  and soft iron errors
+ */
+class CompassCalibratorTest : public ::testing::Test {
+protected:
+    void SetUp() override
+    {
+        const Vector3f offset(120, -80, 35);
+        const Matrix3f softiron(1.1,  0.05,  -0.03,
+                                0.05, 0.9,   0.02,
+                               -0.03, 0.02,  1.05);
+        Matrix3f inv;
+        ASSERT_TRUE(softiron.inverse(inv));
+
+        const float golden_angle = M_PI * (3 - sqrtf(5));
+        for (uint16_t i = 0; i < COMPASS_CAL_NUM_SAMPLES; i++) {
+            const float z = 1 - 2 * (i + 0.5f) / COMPASS_CAL_NUM_SAMPLES;
+            const float r = sqrtf(1 - sq(z));
+            const Vector3f field = Vector3f(r * cosf(golden_angle * i), r * sinf(golden_angle * i), z) * 400;
+            samples[i] = inv * field - offset;
+        }
+    }
+
+    Vector3f samples[COMPASS_CAL_NUM_SAMPLES];
+};
+
+class CompassCalibratorStageTest : public CompassCalibratorTest,
+                                  public ::testing::WithParamInterface<CompassCalibrator::Status> {};
+
+TEST_P(CompassCalibratorStageTest, BackgroundMatchesSliced)
+{
+    CompassCalibrator_Test *sliced = NEW_NOTHROW CompassCalibrator_Test(false);
+    CompassCalibrator_Test *background = NEW_NOTHROW CompassCalibrator_Test(true);
+    ASSERT_NE(sliced, nullptr);
+    ASSERT_NE(background, nullptr);
+    sliced->start_stage(GetParam(), samples);
+    background->start_stage(GetParam(), samples);
+    const uint16_t fits = sliced->stage_fits();
+
+    // one fit step per update
+    for (uint16_t i = 0; i < fits; i++) {
+        sliced->update();
+        EXPECT_EQ(sliced->fit_step(), i + 1);
+    }
+    EXPECT_EQ(sliced->job_state(), FitJobState::IDLE);
+    EXPECT_FALSE(sliced->job_has_samples());
+
+    // the whole stage is handed to the fit thread
+    background->update();
+    EXPECT_EQ(background->job_state(), FitJobState::PENDING);
+    EXPECT_EQ(background->fit_step(), 0);
+    background->run_background_fit();
+    EXPECT_EQ(background->job_state(), FitJobState::DONE);
+    EXPECT_TRUE(background->collect_background_fit());
+    EXPECT_EQ(background->job_state(), FitJobState::IDLE);
+    EXPECT_EQ(background->fit_step(), fits);
+
+    EXPECT_EQ(sliced->fitness(), background->fitness());
+    EXPECT_EQ(sliced->radius(), background->radius());
+    EXPECT_EQ(sliced->offset(), background->offset());
+    EXPECT_EQ(sliced->diag(), background->diag());
+    EXPECT_EQ(sliced->offdiag(), background->offdiag());
+
+    if (GetParam() == CompassCalibrator::Status::RUNNING_STEP_TWO) {
+        EXPECT_LT(sqrtf(background->fitness()), 1.0f);
+        EXPECT_NEAR(background->offset().x, 120, 2.0f);
+        EXPECT_NEAR(background->offset().y, -80, 2.0f);
+        EXPECT_NEAR(background->offset().z, 35, 2.0f);
+    }
+
+    delete sliced;
+    delete background;
+}
+
+/*
+  wall clock time to finish a stage. The sliced fit takes one step per
+  1ms loop of the calibration thread, while the fit thread runs every
+  step of the stage in one go. The bound is loose so a loaded machine
+  doesn't fail the test
+ */
+TEST_P(CompassCalibratorStageTest, BackgroundFasterThanSliced)
+{
+    using clock = std::chrono::steady_clock;
+
+    CompassCalibrator_Test *sliced = NEW_NOTHROW CompassCalibrator_Test(false);
+    CompassCalibrator_Test *background = NEW_NOTHROW CompassCalibrator_Test(true);
+    ASSERT_NE(sliced, nullptr);
+    ASSERT_NE(background, nullptr);
+    sliced->start_stage(GetParam(), samples);
+    background->start_stage(GetParam(), samples);
+    const uint16_t fits = sliced->stage_fits();
+
+    const auto sliced_start = clock::now();
+    auto next_loop = sliced_start;
+    for (uint16_t i = 0; i < fits; i++) {
+        std::this_thread::sleep_until(next_loop);
+        next_loop += std::chrono::milliseconds(1);
+        sliced->update();
+    }
+    const auto sliced_time = clock::now() - sliced_start;
+    EXPECT_EQ(sliced->fit_step(), fits);
+
+    const auto background_start = clock::now();
+    background->update();
+    background->run_background_fit();
+    EXPECT_TRUE(background->collect_background_fit());
+    const auto background_time = clock::now() - background_start;
+    EXPECT_EQ(background->fit_step(), fits);
+
+    EXPECT_GE(sliced_time, std::chrono::milliseconds(fits - 1));
+    EXPECT_LT(background_time, sliced_time);
+    RecordProperty("sliced_us", int(std::chrono::duration_cast<std::chrono::microseconds>(sliced_time).count()));
+    RecordProperty("background_us", int(std::chrono::duration_cast<std::chrono::microseconds>(background_time).count()));
+
+    delete sliced;
+    delete background;
+}
+
+INSTANTIATE_TEST_CASE_P(Stages, CompassCalibratorStageTest,
+                        ::testing::Values(CompassCalibrator::Status::RUNNING_STEP_ONE,
+                                          CompassCalibrator::Status::RUNNING_STEP_TWO));
+
+class CompassCalibratorFitJobTest : public CompassCalibratorTest {
+protected:
+    void SetUp() override
+    {
+        CompassCalibratorTest::SetUp();
+        cal = NEW_NOTHROW CompassCalibrator_Test(true);
+        ASSERT_NE(cal, nullptr);
+        cal->start_stage(CompassCalibrator::Status::RUNNING_STEP_ONE, samples);
+    }
+
+    void TearDown() override
+    {
+        delete cal;
+    }
+
+    CompassCalibrator_Test *cal;
+};
+
+TEST_F(CompassCalibratorFitJobTest, WaitsForFitThread)
+{
+    cal->update();
+    EXPECT_EQ(cal->job_state(), FitJobState::PENDING);
+    EXPECT_TRUE(cal->job_has_samples());
+    EXPECT_TRUE(cal->job_is_current());
+
+    // nothing happens until the fit thread takes the job
+    cal->update();
+    EXPECT_EQ(cal->job_state(), FitJobState::PENDING);
+    EXPECT_EQ(cal->fit_step(), 0);
+
+    // or while it is fitting
+    cal->take_job();
+    cal->update();
+    EXPECT_EQ(cal->job_state(), FitJobState::RUNNING);
+    EXPECT_EQ(cal->fit_step(), 0);
+    EXPECT_FALSE(cal->collect_background_fit());
+
+    // a running job is not taken again
+    cal->run_background_fit();
+    EXPECT_EQ(cal->job_state(), FitJobState::RUNNING);
+
+    cal->finish_job();
+    EXPECT_EQ(cal->job_state(), FitJobState::DONE);
+    EXPECT_EQ(cal->fit_step(), 0);
+    EXPECT_TRUE(cal->collect_background_fit());
+    EXPECT_EQ(cal->job_state(), FitJobState::IDLE);
+    EXPECT_EQ(cal->fit_step(), cal->stage_fits());
+}
+
+TEST_F(CompassCalibratorFitJobTest, DiscardsStaleFit)
+{
+    cal->update();
+    cal->run_background_fit();
+    EXPECT_EQ(cal->job_state(), FitJobState::DONE);
+
+    cal->restart_fit();
+    const float fitness = cal->fitness();
+    const Vector3f offset = cal->offset();
+    EXPECT_FALSE(cal->collect_background_fit());
+
+    // the result is dropped and a fit for the new stage started instead
+    EXPECT_EQ(cal->fitness(), fitness);
+    EXPECT_EQ(cal->offset(), offset);
+    EXPECT_EQ(cal->fit_step(), 0);
+    EXPECT_EQ(cal->job_state(), FitJobState::PENDING);
+    EXPECT_TRUE(cal->job_is_current());
+}
+
+TEST_F(CompassCalibratorFitJobTest, FreeWhileRunning)
+{
+    cal->update();
+
+    // a pending job can be freed
+    cal->free_fit_job();
+    EXPECT_EQ(cal->job_state(), FitJobState::IDLE);
+    EXPECT_FALSE(cal->job_has_samples());
+
+    // but the snapshot of a running job belongs to the fit thread
+    cal->update();
+    cal->take_job();
+    cal->restart_fit();
+    cal->free_fit_job();
+    EXPECT_EQ(cal->job_state(), FitJobState::RUNNING);
+    EXPECT_TRUE(cal->job_has_samples());
+
+    // once it finishes its result is stale
+    cal->finish_job();
+    EXPECT_FALSE(cal->job_is_current());
+    EXPECT_FALSE(cal->collect_background_fit());
+    EXPECT_EQ(cal->fit_step(), 0);
+    EXPECT_TRUE(cal->job_is_current());
+
+    cal->free_fit_job();
+    EXPECT_EQ(cal->job_state(), FitJobState::IDLE);
+    EXPECT_FALSE(cal->job_has_samples());
+}
+
+#if CONFIG_HAL_BOARD == HAL_BOARD_SITL
+TEST_F(CompassCalibratorFitJobTest, FallsBackToSliced)
+{
+    // no memory for the snapshot, so the fit carries on a step at a time
+    cal->fail_fit_alloc(true);
+    cal->update();
+    cal->fail_fit_alloc(false);
+    EXPECT_FALSE(cal->background_fit());
+    EXPECT_EQ(cal->job_state(), FitJobState::IDLE);
+    EXPECT_FALSE(cal->job_has_samples());
+    EXPECT_EQ(cal->fit_step(), 1);
+
+    cal->update();
+    EXPECT_EQ(cal->job_state(), FitJobState::IDLE);
+    EXPECT_FALSE(cal->job_has_samples());
+    EXPECT_EQ(cal->fit_step(), 2);
+}
+#endif
+
+AP_GTEST_MAIN()
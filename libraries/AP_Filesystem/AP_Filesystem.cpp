@@ -175,6 +175,18 @@ int32_t AP_Filesystem::lseek(int fd, int32_t offset, int seek_from)
     return backend.fs.lseek(fd, offset, seek_from);
 }
 
+const void *AP_Filesystem::map(int fd, size_t length)
+{
+    const Backend &backend = backend_by_fd(fd);
+    return backend.fs.map(fd, length);
+}
+
+void AP_Filesystem::unmap(int fd, const void *addr, size_t length)
+{
+    const Backend &backend = backend_by_fd(fd);
+    backend.fs.unmap(addr, length);
+}
+
 int AP_Filesystem::stat(const char *pathname, struct stat *stbuf)
 {
     const Backend &backend = backend_by_path(pathname);
@@ -148,6 +148,15 @@ public:
      */
     FileData *load_file(const char *filename);
 
+    /*
+      map the first length bytes of an open file read-only into
+      memory, for backends that support it. Returns nullptr if the
+      file can't be mapped. The mapping must be removed with unmap()
+      before the file is closed
+     */
+    const void *map(int fd, size_t length);
+    void unmap(int fd, const void *addr, size_t length);
+
     // get_singleton for scripting
     static AP_Filesystem *get_singleton(void);
 
@@ -59,6 +59,14 @@ int AP_Filesystem_Param::open(const char *fname, int flags, bool allow_absolute_
             errno = ENOMEM;
             return -1;
         }
+#if AP_PARAM_SNAPSHOT_ENABLED
+        // without a snapshot parameters are read from the tree
+        r.snapshot = NEW_NOTHROW AP_Param_Snapshot();
+        if (r.snapshot != nullptr && !r.snapshot->build()) {
+            delete r.snapshot;
+            r.snapshot = nullptr;
+        }
+#endif
     }
     r.file_ofs = 0;
     r.open = true;
@@ -122,6 +130,10 @@ int AP_Filesystem_Param::open(const char *fname, int flags, bool allow_absolute_
 
 failed:
     delete [] r.cursors;
+#if AP_PARAM_SNAPSHOT_ENABLED
+    delete r.snapshot;
+    r.snapshot = nullptr;
+#endif
     r.open = false;
     errno = EINVAL;
     return -1;
@@ -144,6 +156,10 @@ int AP_Filesystem_Param::close(int fd)
     r.cursors = nullptr;
     delete r.writebuf;
     r.writebuf = nullptr;
+#if AP_PARAM_SNAPSHOT_ENABLED
+    delete r.snapshot;
+    r.snapshot = nullptr;
+#endif
     return ret;
 }
 
@@ -176,30 +192,57 @@ uint8_t AP_Filesystem_Param::pack_param(const struct rfile &r, struct cursor &c,
     char name[AP_MAX_NAME_SIZE+1];
     name[AP_MAX_NAME_SIZE] = 0;
     enum ap_var_type ptype;
-    AP_Param *ap;
     float default_val;
+    const void *value;
+#if AP_PARAM_DEFAULTS_ENABLED
+    float value_float;
+#endif
 
-    if (c.token_ofs == 0) {
-        c.idx = 0;
-        ap = AP_Param::first(&c.token, &ptype, &default_val);
-        uint16_t idx = 0;
-        while (idx < r.start && ap) {
+#if AP_PARAM_SNAPSHOT_ENABLED
+    if (r.snapshot != nullptr) {
+        c.idx = c.token_ofs == 0 ? 0 : c.idx + 1;
+        const uint32_t i = uint32_t(r.start) + c.idx;
+        if (i >= r.snapshot->count() || (r.count && c.idx >= r.count)) {
+            return 0;
+        }
+        const AP_Param_Snapshot::Entry &e = r.snapshot->entry(i);
+        memcpy(name, e.name, AP_MAX_NAME_SIZE);
+        ptype = (enum ap_var_type)e.type;
+        value = e.value;
+#if AP_PARAM_DEFAULTS_ENABLED
+        value_float = e.value_float();
+        default_val = e.default_value;
+#endif
+    } else
+#endif
+    {
+        AP_Param *ap;
+        if (c.token_ofs == 0) {
+            c.idx = 0;
+            ap = AP_Param::first(&c.token, &ptype, &default_val);
+            uint16_t idx = 0;
+            while (idx < r.start && ap) {
+                ap = AP_Param::next_scalar(&c.token, &ptype, &default_val);
+                idx++;
+            }
+        } else {
+            c.idx++;
             ap = AP_Param::next_scalar(&c.token, &ptype, &default_val);
-            idx++;
         }
-    } else {
-        c.idx++;
-        ap = AP_Param::next_scalar(&c.token, &ptype, &default_val);
-    }
-    if (ap == nullptr || (r.count && c.idx >= r.count)) {
-        if (r.count == 0 && c.idx != AP_Param::count_parameters()) {
-            // the parameter count is incorrect, invalidate so a
-            // repeated param download avoids an error
-            AP_Param::invalidate_count();
+        if (ap == nullptr || (r.count && c.idx >= r.count)) {
+            if (r.count == 0 && c.idx != AP_Param::count_parameters()) {
+                // the parameter count is incorrect, invalidate so a
+                // repeated param download avoids an error
+                AP_Param::invalidate_count();
+            }
+            return 0;
         }
-        return 0;
+        ap->copy_name_token(c.token, name, AP_MAX_NAME_SIZE, true);
+        value = ap;
+#if AP_PARAM_DEFAULTS_ENABLED
+        value_float = ap->cast_to_float(ptype);
+#endif
     }
-    ap->copy_name_token(c.token, name, AP_MAX_NAME_SIZE, true);
 
     uint8_t common_len = 0;
     const char *last_name = c.last_name;
@@ -216,7 +259,7 @@ uint8_t AP_Filesystem_Param::pack_param(const struct rfile &r, struct cursor &c,
         pname--;
     }
 #if AP_PARAM_DEFAULTS_ENABLED
-    const bool add_default = r.with_defaults && !is_equal(ap->cast_to_float(ptype), default_val);
+    const bool add_default = r.with_defaults && !is_equal(value_float, default_val);
 #else
     const bool add_default = false;
 #endif
@@ -243,7 +286,7 @@ uint8_t AP_Filesystem_Param::pack_param(const struct rfile &r, struct cursor &c,
     buf[0] = uint8_t(ptype) | (flags<<4);
     buf[1] = common_len | ((name_len-1)<<4);
     memcpy(&buf[2], pname, name_len);
-    memcpy(&buf[2+name_len], ap, type_len);
+    memcpy(&buf[2+name_len], value, type_len);
 #if AP_PARAM_DEFAULTS_ENABLED
     if (add_default) {
         switch (ptype) {
@@ -360,6 +403,11 @@ int32_t AP_Filesystem_Param::read(int fd, void *buf, uint32_t count)
     if (r.file_ofs < sizeof(struct header)) {
         struct header hdr;
         hdr.total_params = AP_Param::count_parameters();
+#if AP_PARAM_SNAPSHOT_ENABLED
+        if (r.snapshot != nullptr) {
+            hdr.total_params = r.snapshot->count();
+        }
+#endif
         if (hdr.total_params <= r.start) {
             errno = EINVAL;
             return -1;
@@ -23,6 +23,7 @@
 #include <AP_Common/ExpandingString.h>
 
 #include <AP_Param/AP_Param.h>
+#include <AP_Param/AP_Param_Snapshot.h>
 
 class AP_Filesystem_Param : public AP_Filesystem_Backend
 {
@@ -76,6 +77,11 @@ private:
         uint32_t file_size;
         struct cursor *cursors;
         ExpandingString *writebuf; // for upload
+#if AP_PARAM_SNAPSHOT_ENABLED
+        // parameters as they were at open, so reads are consistent
+        // and do not walk the parameter tree
+        AP_Param_Snapshot *snapshot;
+#endif
     } file[max_open_file];
 
     bool token_seek(const struct rfile &r, const uint32_t data_ofs, struct cursor &c);
@@ -18,6 +18,7 @@
 #pragma once
 
 #include <stdint.h>
+#include <stddef.h>
 #include <AP_HAL/AP_HAL_Boards.h>
 
 #include "AP_Filesystem_config.h"
@@ -100,6 +101,13 @@ public:
     // unload data from load_file()
     virtual void unload_file(FileData *fd);
 
+    // map the first length bytes of an open file read-only into
+    // memory. Returns nullptr if the backend can't map files
+    virtual const void *map(int fd, size_t length) { return nullptr; }
+
+    // undo map(), before the file is closed
+    virtual void unmap(const void *addr, size_t length) {}
+
 protected:
     // return true if file operations are allowed
     bool file_op_allowed(void) const;
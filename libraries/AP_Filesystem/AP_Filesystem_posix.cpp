@@ -34,6 +34,10 @@
 #include <utime.h>
 #endif
 
+#if AP_FILESYSTEM_POSIX_HAVE_MMAP
+#include <sys/mman.h>
+#endif
+
 extern const AP_HAL::HAL& hal;
 
 /*
@@ -252,4 +256,25 @@ bool AP_Filesystem_Posix::set_mtime(const char *filename, const uint32_t mtime_s
 #endif
 }
 
+#if AP_FILESYSTEM_POSIX_HAVE_MMAP
+/*
+  the mapping is shared, so sees later writes to the file through
+  other file descriptors
+ */
+const void *AP_Filesystem_Posix::map(int fd, size_t length)
+{
+    FS_CHECK_ALLOWED(nullptr);
+    void *p = ::mmap(nullptr, length, PROT_READ, MAP_SHARED, fd, 0);
+    if (p == MAP_FAILED) {
+        return nullptr;
+    }
+    return p;
+}
+
+void AP_Filesystem_Posix::unmap(const void *addr, size_t length)
+{
+    ::munmap(const_cast<void *>(addr), length);
+}
+#endif  // AP_FILESYSTEM_POSIX_HAVE_MMAP
+
 #endif  // AP_FILESYSTEM_POSIX_ENABLED
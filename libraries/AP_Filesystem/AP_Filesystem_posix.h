@@ -41,6 +41,10 @@
 #define AP_FILESYSTEM_POSIX_HAVE_STATFS 1
 #endif
 
+#ifndef AP_FILESYSTEM_POSIX_HAVE_MMAP
+#define AP_FILESYSTEM_POSIX_HAVE_MMAP 1
+#endif
+
 #ifndef O_CLOEXEC
 #define O_CLOEXEC 0
 #endif
@@ -71,6 +75,11 @@ public:
 
     // set modification time on a file
     bool set_mtime(const char *filename, const uint32_t mtime_sec) override;
+
+#if AP_FILESYSTEM_POSIX_HAVE_MMAP
+    const void *map(int fd, size_t length) override;
+    void unmap(const void *addr, size_t length) override;
+#endif
 };
 
 #endif  // AP_FILESYSTEM_POSIX_ENABLED
@@ -53,10 +53,7 @@ extern const AP_HAL::HAL& hal;
 #define FFT_STACK_SIZE              1024
 #define FFT_MIN_SAMPLES_PER_FRAME   16
 #define FFT_HARMONIC_FIT_DEFAULT    10
-#define FFT_HARMONIC_FIT_FILTER_HZ  15.0f
-#define FFT_HARMONIC_FIT_MULT       50.0f
-#define FFT_HARMONIC_FIT_TRACK_ROLL    4
-#define FFT_HARMONIC_FIT_TRACK_PITCH   5
+#define FFT_IMU_RATE_TOLERANCE      0.02f   // fraction the gyro rate of an IMU may differ from the FFT rate
 
 // table of user settable parameters
 const AP_Param::GroupInfo AP_GyroFFT::var_info[] = {
@@ -169,8 +166,8 @@ const AP_Param::GroupInfo AP_GyroFFT::var_info[] = {
 
     // @Param: OPTIONS
     // @DisplayName: FFT options
-    // @Description: FFT configuration options. Values: 1:Apply the FFT *after* the filter bank,2:Check noise at the motor frequencies using ESC data as a reference
-    // @Bitmask: 0:Enable post-filter FFT,1:Check motor noise
+    // @Description: FFT configuration options. Values: 1:Apply the FFT *after* the filter bank,2:Check noise at the motor frequencies using ESC data as a reference,4:Analyse every axis of every IMU sampled at the same rate as the primary each frame, allowing FFT tracked harmonic notches to use per-IMU frequencies,8:Analyse every axis each frame rather than one axis per frame, lowering tracking latency at three times the CPU cost per frame. Always the case when analysing all IMUs
+    // @Bitmask: 0:Enable post-filter FFT,1:Check motor noise,2:Analyse all IMUs,3:Analyse all axes
     // @User: Advanced
     // @RebootRequired: True
     AP_GROUPINFO("OPTIONS", 15, AP_GyroFFT, _options, 0),
@@ -190,7 +187,6 @@ const extern AP_HAL::HAL& hal;
 
 AP_GyroFFT::AP_GyroFFT()
 {
-    _thread_state._noise_needs_calibration = 0x07; // all axes need calibration
     AP_Param::setup_object_defaults(this, var_info);
 
     if (_singleton != nullptr) {
@@ -232,9 +228,38 @@ __INITFUNC__ void AP_GyroFFT::init(uint16_t loop_rate_hz)
         _num_frames.set(constrain_int16(_num_frames, 2, AP_HAL::DSP::MAX_SLIDING_WINDOW_SIZE));
     }
 
+    // determine the FFT sample rate based on the gyro rate, loop rate and configuration
+    if (_sample_mode == 0) {
+        _fft_sampling_rate_hz = _ins->get_raw_gyro_rate_hz();
+    } else {
+        _fft_sampling_rate_hz = loop_rate_hz / _sample_mode;
+    }
+
+    // analyse every IMU or just the primary. The window state and bin limits are
+    // shared, so when sampling at the gyro rate only IMUs at the FFT rate can be analysed
+    uint8_t instances[FFT_MAX_IMUS];
+    _num_imus = 0;
+    if (_options & uint32_t(Options::AllIMUs)) {
+        for (uint8_t i = 0; i < _ins->get_gyro_count() && _num_imus < FFT_MAX_IMUS; i++) {
+            if (_sample_mode == 0 &&
+                fabsf(_ins->get_raw_gyro_rate_hz(i) - _fft_sampling_rate_hz) > _fft_sampling_rate_hz * FFT_IMU_RATE_TOLERANCE) {
+                GCS_SEND_TEXT(MAV_SEVERITY_WARNING, "FFT: IMU%u at %uHz not analysed", unsigned(i + 1), unsigned(_ins->get_raw_gyro_rate_hz(i)));
+                continue;
+            }
+            instances[_num_imus++] = i;
+        }
+    }
+    if (_num_imus < 2) {
+        // only the primary, whichever IMU that is
+        _num_imus = 1;
+        instances[0] = 0;
+    }
+    // several IMUs are always analysed a frame at a time
+    _all_axes = _num_imus > 1 || (_options & uint32_t(Options::AllAxes));
+
     // check that we have enough memory for the window size requested
-    // INS: XYZ_AXIS_COUNT * INS_MAX_INSTANCES * _window_size, DSP: 3 * _window_size, FFT: XYZ_AXIS_COUNT + 3 * _window_size
-    const uint32_t allocation_count = (XYZ_AXIS_COUNT * INS_MAX_INSTANCES + 3 + XYZ_AXIS_COUNT + 3 + _num_frames) * sizeof(float);
+    // INS: XYZ_AXIS_COUNT * INS_MAX_INSTANCES * _window_size, DSP: 3 * _window_size, FFT: XYZ_AXIS_COUNT * IMUs + 3 * _window_size
+    const uint32_t allocation_count = (XYZ_AXIS_COUNT * INS_MAX_INSTANCES + 3 + XYZ_AXIS_COUNT * _num_imus + 3 + _num_frames) * sizeof(float);
     if (allocation_count * FFT_DEFAULT_WINDOW_SIZE > hal.util->available_memory() / 2) {
         GCS_SEND_TEXT(MAV_SEVERITY_WARNING, "AP_GyroFFT: disabled, required %u bytes", (unsigned int)allocation_count * FFT_DEFAULT_WINDOW_SIZE);
         return;
@@ -245,26 +270,27 @@ __INITFUNC__ void AP_GyroFFT::init(uint16_t loop_rate_hz)
     // save any changes that were made
     _window_size.save();
 
-    // determine the FFT sample rate based on the gyro rate, loop rate and configuration
-    if (_sample_mode == 0) {
-        _fft_sampling_rate_hz = _ins->get_raw_gyro_rate_hz();
-    } else {
-        _fft_sampling_rate_hz = loop_rate_hz / _sample_mode;
-        for (uint8_t axis = 0; axis < XYZ_AXIS_COUNT; axis++) {
-            if (!_downsampled_gyro_data[axis].set_size(_window_size + _samples_per_frame)) {
-                GCS_SEND_TEXT(MAV_SEVERITY_WARNING, "Failed to allocate window for AP_GyroFFT");
-                return;
+    _imus = NEW_NOTHROW IMUState[_num_imus];
+    if (_imus == nullptr) {
+        GCS_SEND_TEXT(MAV_SEVERITY_WARNING, "Failed to allocate window for AP_GyroFFT");
+        return;
+    }
+    for (uint8_t i = 0; i < _num_imus; i++) {
+        _imus[i]._instance = instances[i];
+    }
+
+    if (_sample_mode != 0) {
+        for (uint8_t i = 0; i < _num_imus; i++) {
+            for (uint8_t axis = 0; axis < XYZ_AXIS_COUNT; axis++) {
+                if (!_imus[i]._downsampled_gyro_data[axis].set_size(_window_size + _samples_per_frame)) {
+                    GCS_SEND_TEXT(MAV_SEVERITY_WARNING, "Failed to allocate window for AP_GyroFFT");
+                    return;
+                }
             }
         }
     }
     _current_sample_mode = _sample_mode & 0x07; // mask matches previous 3 bit storage and param range
 
-    _ref_energy = NEW_NOTHROW Vector3f[_window_size];
-    if (_ref_energy == nullptr) {
-        GCS_SEND_TEXT(MAV_SEVERITY_WARNING, "Failed to allocate window for AP_GyroFFT");
-        return;
-    }
-
     // make the gyro window match the window size plus a buffer to cope with the backend
     // getting too far ahead.
     if (!_ins->set_gyro_window_size(_window_size + _samples_per_frame)) {
@@ -287,27 +313,10 @@ __INITFUNC__ void AP_GyroFFT::init(uint16_t loop_rate_hz)
         harmonics = 3;
     }
     // count the number of active harmonics or dynamic notchs
-    _tracked_peaks = constrain_int16(MAX(__builtin_popcount(harmonics),
-                                         num_notches), 1, FrequencyPeak::MAX_TRACKED_PEAKS);
+    _tracked_peaks = AP_GyroFFT_Tracker::calculate_tracked_peaks(harmonics, num_notches);
 
-    // calculate harmonic multiplier. this assumes the harmonics configured on the 
-    // harmonic notch reflect the multiples of the fundamental harmonic that should be tracked
     if (_harmonic_fit > 0) {
-        uint8_t first_harmonic = 0;
-        for (uint8_t i = 0; i < HNF_MAX_HARMONICS; i++) {
-            if (harmonics & (1<<i)) {
-                if (first_harmonic == 0) {
-                    first_harmonic = i + 1;
-                } else {
-                    _harmonic_multiplier = float(i + 1) / first_harmonic;
-                    break;
-                }
-            }
-        }
-        // if no harmonic specified then select a simple 2x multiple
-        if (is_zero(_harmonic_multiplier)) {
-            _harmonic_multiplier = 2.0f;
-        }
+        _harmonic_multiplier = AP_GyroFFT_Tracker::calculate_harmonic_multiplier(harmonics);
     }
 #endif  // AP_INERTIALSENSOR_HARMONICNOTCH_ENABLED
 
@@ -320,41 +329,21 @@ __INITFUNC__ void AP_GyroFFT::init(uint16_t loop_rate_hz)
 
     // per-axis frame time
     _frame_time_ms = _samples_per_frame * 1000 / _fft_sampling_rate_hz;
-    // The update rate for the output, defaults are 1Khz / (1 - 0.5) * 32 == 62hz
-    const float output_rate = static_cast<float>(_fft_sampling_rate_hz) / static_cast<float>(_samples_per_frame);
-    // establish suitable defaults for the detected values
-    for (uint8_t axis = 0; axis < XYZ_AXIS_COUNT; axis++) {
-        _thread_state._center_freq_hz[axis] = _fft_min_hz;
-
-        for (uint8_t peak = 0; peak < FrequencyPeak::MAX_TRACKED_PEAKS; peak++) {
-            _thread_state._center_freq_hz_filtered[axis][peak] = _fft_min_hz;
-        }
-        // number of cycles to average over, two complete windows to be sure
-        _noise_calibration_cycles[axis] = (_window_size / _samples_per_frame) * 2;
-        // harmonic frequency fit should change relatively slowly
-        _harmonic_fit_filter[axis].set_cutoff_frequency(output_rate, MIN(output_rate * 0.48f, FFT_HARMONIC_FIT_FILTER_HZ));
-    }
 
-    // configure a filter for frequency, bandwidth and energy for each of the three tracked noise peaks
-    // filter more aggressively post-filter since the noise is harder to detect
-    const float scale_factor = using_post_filter_samples() ? 0.1f : 1.0f;
-    for (uint8_t peak = 0; peak < FrequencyPeak::MAX_TRACKED_PEAKS; peak++) {
-        // calculate low-pass filter characteristics based on window size and overlap
-        _center_freq_filter[peak].set_cutoff_frequency(output_rate, output_rate * 0.48f * scale_factor);
-        // the bin energy jumps around a lot so requires more filtering
-        _center_freq_energy_filter[peak].set_cutoff_frequency(output_rate, output_rate * 0.25f * scale_factor);
-        // smooth the bandwidth output more aggressively
-        _center_bandwidth_filter[peak].set_cutoff_frequency(output_rate, output_rate * 0.25f * scale_factor);
+    for (uint8_t i = 0; i < _num_imus; i++) {
+        if (!_imus[i]._tracker.init(_window_size, _samples_per_frame, _fft_sampling_rate_hz, using_post_filter_samples(),
+                                    _fft_min_hz, _imus[i]._thread_state)) {
+            GCS_SEND_TEXT(MAV_SEVERITY_WARNING, "Failed to allocate window for AP_GyroFFT");
+            return;
+        }
     }
+    _update_imu = &_imus[0];
 
     // turn down the SNR threshold if examining post-filter
     if (using_post_filter_samples()) {
         _snr_threshold_db.set_default(FFT_SNR_PFILT_DEFAULT);
     }
 
-    // the number of cycles required to have a proper noise reference
-    _noise_cycles = (_window_size / _samples_per_frame) * XYZ_AXIS_COUNT;
-
     // finally we are done
     _initialized = true;
     update_parameters(true);
@@ -374,19 +363,27 @@ void AP_GyroFFT::sample_gyros()
 
     // update counters for gyro window
     if (_current_sample_mode > 0) {
-        // for loop rate sampling accumulate and average gyro samples
-        _oversampled_gyro_accum += _ins->get_gyro_for_fft();
         _oversampled_gyro_count++;
+        const bool downsample = (_oversampled_gyro_count % _current_sample_mode) == 0;
+
+        for (uint8_t i = 0; i < _num_imus; i++) {
+            IMUState& imu = _imus[i];
+            // for loop rate sampling accumulate and average gyro samples
+            imu._oversampled_gyro_accum += analysing_all_imus() ? _ins->get_gyro_for_fft(imu._instance) : _ins->get_gyro_for_fft();
+
+            if (downsample) {
+                // calculate mean value of accumulated samples
+                Vector3f sample = imu._oversampled_gyro_accum / _current_sample_mode;
+                // fast sampling means that the raw gyro values have already been averaged over 8 samples
+                imu._downsampled_gyro_data[0].push(sample.x);
+                imu._downsampled_gyro_data[1].push(sample.y);
+                imu._downsampled_gyro_data[2].push(sample.z);
+
+                imu._oversampled_gyro_accum.zero();
+            }
+        }
 
-        if ((_oversampled_gyro_count % _current_sample_mode) == 0) {
-            // calculate mean value of accumulated samples
-            Vector3f sample = _oversampled_gyro_accum / _current_sample_mode;
-            // fast sampling means that the raw gyro values have already been averaged over 8 samples
-            _downsampled_gyro_data[0].push(sample.x);
-            _downsampled_gyro_data[1].push(sample.y);
-            _downsampled_gyro_data[2].push(sample.z);
-
-            _oversampled_gyro_accum.zero();
+        if (downsample) {
             _oversampled_gyro_count = 0;
         }
     }
@@ -403,7 +400,8 @@ void AP_GyroFFT::update()
     WITH_SEMAPHORE(_sem);
 
     _config._analysis_enabled = _analysis_enabled;
-    _global_state = _thread_state;
+    // learned while flying, so kept up to date even when armed
+    _config._bandwidth_hover_hz = _bandwidth_hover_hz;
 
     // calculate health based on being 5 frames behind, SITL needs longer
 #if CONFIG_HAL_BOARD == HAL_BOARD_SITL
@@ -412,19 +410,25 @@ void AP_GyroFFT::update()
     const uint32_t output_delay = _frame_time_ms * FFT_MAX_MISSED_UPDATES;
 #endif
     uint32_t now = AP_HAL::millis();
-    _rpy_health.x = (now - _global_state._health_ms.x <= output_delay);
-    _rpy_health.y = (now - _global_state._health_ms.y <= output_delay);
-    _rpy_health.z = (now - _global_state._health_ms.z <= output_delay);
 
-    _health = _global_state._health;
-    if (!_rpy_health.x) {
-        _health.x = 0;
-    }
-    if (!_rpy_health.y) {
-        _health.y = 0;
-    }
-    if (!_rpy_health.z) {
-        _health.z = 0;
+    for (uint8_t i = 0; i < _num_imus; i++) {
+        IMUState& imu = _imus[i];
+        imu._global_state = imu._thread_state;
+
+        imu._rpy_health.x = (now - imu._global_state._health_ms.x <= output_delay);
+        imu._rpy_health.y = (now - imu._global_state._health_ms.y <= output_delay);
+        imu._rpy_health.z = (now - imu._global_state._health_ms.z <= output_delay);
+
+        imu._health = imu._global_state._health;
+        if (!imu._rpy_health.x) {
+            imu._health.x = 0;
+        }
+        if (!imu._rpy_health.y) {
+            imu._health.y = 0;
+        }
+        if (!imu._rpy_health.z) {
+            imu._health.z = 0;
+        }
     }
 }
 
@@ -442,7 +446,7 @@ uint16_t AP_GyroFFT::run_cycle()
 
     // do we have enough samples for another pass?
     if (!start_analysis()) {
-        uint16_t new_sample_count =  get_available_samples(_update_axis);
+        uint16_t new_sample_count = get_frame_samples();
         _sem.give();
         return new_sample_count;
     }
@@ -454,9 +458,61 @@ uint16_t AP_GyroFFT::run_cycle()
 
     uint32_t now = AP_HAL::micros();
 
+    if (analysing_all_axes()) {
+        // analyse every axis of every IMU in the same frame, the DSP window state is shared
+        // so the only per-IMU cost is the FFT itself and the peak tracking
+        for (uint8_t i = 0; i < _num_imus; i++) {
+            _update_imu = &_imus[i];
+            // a secondary IMU may have stopped producing samples
+            if (get_available_samples(*_update_imu) < _state->_window_size) {
+                continue;
+            }
+            for (uint8_t axis = 0; axis < XYZ_AXIS_COUNT; axis++) {
+                _update_axis = axis;
+                analyse_axis(config);
+            }
+        }
+    } else {
+        // otherwise a single IMU is analysed one axis per frame
+        _update_imu = &_imus[0];
+        analyse_axis(config);
+        // move onto the next axis
+        _update_axis = (_update_axis + 1) % XYZ_AXIS_COUNT;
+    }
+
+    // record how we are doing
+    _output_cycle_micros = AP_HAL::micros() - now;
+
+    // ready to receive another frame, because lock contention is so expensive we don't lock
+    // around this flag but rather rely on the semaphore at the beginning of the loop to
+    // ensure eventual visibility to the main loop
+    for (uint8_t i = 0; i < _num_imus; i++) {
+        _imus[i]._thread_state._analysis_started = false;
+    }
+
+    // samples remaining for the next frame
+    return get_frame_samples();
+}
+
+// samples available for the next frame, all axes of the primary IMU or
+// just the next axis when the axes are analysed one per frame
+// called from FFT thread
+uint16_t AP_GyroFFT::get_frame_samples()
+{
+    IMUState& primary = _imus[get_primary_imu_index()];
+    if (analysing_all_axes()) {
+        return get_available_samples(primary);
+    }
+    return get_gyro_window(primary, _update_axis).available();
+}
+
+// run the FFT over _update_axis of _update_imu
+// called from FFT thread
+void AP_GyroFFT::analyse_axis(const EngineConfig& config)
+{
     // get the appropriate gyro buffer
-    FloatBuffer& gyro_buffer = (_sample_mode == 0 ?_ins->get_raw_gyro_window(_update_axis) : _downsampled_gyro_data[_update_axis]);
-    // if we have many more samples than the window size then we are struggling to 
+    FloatBuffer& gyro_buffer = get_gyro_window(*_update_imu, _update_axis);
+    // if we have many more samples than the window size then we are struggling to
     // stay ahead of the gyro loop so drop samples so that this cycle will use all available samples
     if (gyro_buffer.available() > uint32_t(_state->_window_size + uint16_t(_samples_per_frame >> 1))) { // half the frame size is a heuristic
         gyro_buffer.advance(gyro_buffer.available() - _state->_window_size);
@@ -465,15 +521,13 @@ uint16_t AP_GyroFFT::run_cycle()
     hal.dsp->fft_start(_state, gyro_buffer, _samples_per_frame);
 
     // calculate FFT and update filters outside the semaphore
-    uint16_t bin_max = hal.dsp->fft_analyse(_state, config._fft_start_bin, config._fft_end_bin, config._attenuation_cutoff);
+    hal.dsp->fft_analyse(_state, config._fft_start_bin, config._fft_end_bin, config._attenuation_cutoff);
 
     // something has been detected, update the peak frequency and associated metrics
-    update_ref_energy(bin_max);
+    _update_imu->_tracker.update_ref_energy(*_state, _update_axis, _update_imu->_thread_state, _sem);
     calculate_noise(false, config);
 
-    // record how we are doing
-    _thread_state._last_output_us[_update_axis] = AP_HAL::micros();
-    _output_cycle_micros = _thread_state._last_output_us[_update_axis] - now;
+    _update_imu->_thread_state._last_output_us[_update_axis] = AP_HAL::micros();
 
 #if AP_SIM_ENABLED && HAL_LOGGING_ENABLED
     // extra logging when running simulations
@@ -490,12 +544,13 @@ uint16_t AP_GyroFFT::run_cycle()
     // @Field: En1: Peak 1 Maximum energy
     // @Field: En2: Peak 2 Maximum energy
     // @Field: En3: Peak 3 Maximum energy
+    // @Field: IMU: IMU instance
     AP::logger().WriteStreaming(
         "FTN3",
-        "TimeUS,Id,Pk1,Pk2,Pk3,Bw1,Bw2,Bw3,En1,En2,En3",
-        "s#zzzzzz---",
-        "F----------",
-        "QBfffffffff",
+        "TimeUS,Id,Pk1,Pk2,Pk3,Bw1,Bw2,Bw3,En1,En2,En3,IMU",
+        "s#zzzzzz----",
+        "F-----------",
+        "QBfffffffffB",
         AP_HAL::micros64(),
         _update_axis,
         _state->_peak_data[0]._freq_hz,
@@ -506,34 +561,29 @@ uint16_t AP_GyroFFT::run_cycle()
         _state->_peak_data[2]._noise_width_hz,
         _state->_freq_bins[_state->_peak_data[0]._bin],
         _state->_freq_bins[_state->_peak_data[1]._bin],
-        _state->_freq_bins[_state->_peak_data[2]._bin]);
+        _state->_freq_bins[_state->_peak_data[2]._bin],
+        analysing_all_imus() ? _update_imu->_instance : _ins->get_fft_primary_instance());
 #endif
-
-    // move onto the next axis
-    _update_axis = (_update_axis + 1) % XYZ_AXIS_COUNT;
-
-    // ready to receive another frame, because lock contention is so expensive we don't lock
-    // around this flag but rather rely on the semaphore at the beginning of the loop to
-    // ensure eventual visibility to the main loop
-    _thread_state._analysis_started = false;
-
-    // samples remaining in the next axis
-    return get_available_samples(_update_axis);
 }
 
 // whether analysis can be run again or not
 // called from FFT thread with the semaphore held
 bool AP_GyroFFT::start_analysis() {
-    if (_thread_state._analysis_started) {
+    IMUState& primary = _imus[get_primary_imu_index()];
+
+    if (primary._thread_state._analysis_started) {
         return false;
     }
     // don't run any more gyro cycles once noise is calibrated and the self-test is running
-    if (!_thread_state._noise_needs_calibration && !_calibrated) {
+    if (!primary._thread_state._noise_needs_calibration && !_calibrated) {
         return false;
     }
 
-    if (get_available_samples(_update_axis) >= _state->_window_size) {
-        _thread_state._analysis_started = true;
+    // a frame is driven by the primary IMU, other IMUs are analysed if they have kept up
+    if (get_frame_samples() >= _state->_window_size) {
+        for (uint8_t i = 0; i < _num_imus; i++) {
+            _imus[i]._thread_state._analysis_started = true;
+        }
         return true;
     }
     return false;
@@ -566,6 +616,9 @@ void AP_GyroFFT::update_parameters(bool force)
     _config._fft_end_bin = MIN(ceilf(_fft_max_hz.get() / _state->_bin_resolution), _state->_bin_count);
     // actual attenuation from the db value
     _config._attenuation_cutoff = powf(10.0f, -_attenuation_power_db * 0.1f);
+    _config._tracked_peaks = _tracked_peaks;
+    _config._harmonic_multiplier = _harmonic_multiplier;
+    _config._bandwidth_hover_hz = _bandwidth_hover_hz;
 }
 
 // thread for processing gyro data via FFT
@@ -621,13 +674,13 @@ bool AP_GyroFFT::pre_arm_check(char *failure_msg, const uint8_t failure_msg_len)
     }
 
     // analysis is started in the main thread, don't trample on in-flight analysis
-    if (_global_state._analysis_started) {
+    if (get_primary_imu()._global_state._analysis_started) {
         hal.util->snprintf(failure_msg, failure_msg_len, "FFT still analyzing");
         return false;
     }
 
     // still calibrating noise so not ready
-    if (_global_state._noise_needs_calibration) {
+    if (get_primary_imu()._global_state._noise_needs_calibration) {
         hal.util->snprintf(failure_msg, failure_msg_len, "FFT calibrating noise");
         return false;
     }
@@ -766,7 +819,14 @@ void AP_GyroFFT::stop_notch_tune()
 
     float freqs[FrequencyPeak::MAX_TRACKED_PEAKS] {};
 
-    uint16_t numpeaks = hal.dsp->fft_stop_average(_state, _config._fft_start_bin, _config._fft_end_bin, freqs);
+    // the configuration may be updated on a scheduler worker
+    uint16_t start_bin, end_bin;
+    {
+        WITH_SEMAPHORE(_sem);
+        start_bin = _config._fft_start_bin;
+        end_bin = _config._fft_end_bin;
+    }
+    uint16_t numpeaks = hal.dsp->fft_stop_average(_state, start_bin, end_bin, freqs);
 
     if (numpeaks == 0) {
         return;
@@ -800,53 +860,10 @@ void AP_GyroFFT::stop_notch_tune()
 #endif  // AP_INERTIALSENSOR_HARMONICNOTCH_ENABLED
 }
 
-// return the noise peak that is being tracked
-// called from main thread
-AP_GyroFFT::FrequencyPeak AP_GyroFFT::get_tracked_noise_peak() const
-{
-    // if the user has specified a specific axis to track then use that
-    if (_harmonic_peak > FrequencyPeak::MAX_TRACKED_PEAKS) {
-        switch (_harmonic_peak) {
-        case FFT_HARMONIC_FIT_TRACK_ROLL:
-            if (_global_state._harmonic_fit.x < _harmonic_fit) {
-                return FrequencyPeak(_global_state._tracked_peak.x);
-            }
-            break;
-        case FFT_HARMONIC_FIT_TRACK_PITCH:
-            if (_global_state._harmonic_fit.y < _harmonic_fit) {
-                return FrequencyPeak(_global_state._tracked_peak.y);
-            }
-            break;
-        default:
-            break;
-        }
-        return FrequencyPeak::CENTER;
-    }
-    // if the user has specified a specific peak to track then use that
-    if (_harmonic_peak > 0) {
-        return FrequencyPeak(constrain_int16(_harmonic_peak - 1, FrequencyPeak::CENTER, FrequencyPeak::UPPER_SHOULDER));
-    }
-
-    // required fit of 10% is fairly conservative when testing in SITL, testing shows that it's safer to
-    // require both tracked axes to fit - biasing towards the highest energy peak
-    if (_global_state._harmonic_fit.x < _harmonic_fit && _global_state._harmonic_fit.y < _harmonic_fit) {
-        return FrequencyPeak(_global_state._tracked_peak.x);
-    }
-
-    return FrequencyPeak::CENTER;
-}
-
 // weighted center frequency
 float AP_GyroFFT::get_weighted_freq_hz(FrequencyPeak peak) const
 {
-    const Vector3f& energy = get_center_freq_energy(peak);
-    const Vector3f& freq = get_noise_center_freq_hz(peak);
-
-    if (!energy.is_nan() && !is_zero(energy.x) && !is_zero(energy.y)) {
-        return (freq.x * energy.x + freq.y * energy.y) / (energy.x + energy.y);
-    } else {
-        return (freq.x + freq.y) * 0.5f;
-    }
+    return get_weighted_freq_hz(get_primary_imu(), peak);
 }
 
 // return an average center frequency weighted by bin energy
@@ -857,7 +874,9 @@ float AP_GyroFFT::get_weighted_noise_center_freq_hz() const
         return _fft_min_hz;
     }
 
-    if (_health.is_zero()) {
+    const IMUState& imu = get_primary_imu();
+
+    if (imu._health.is_zero()) {
 #if APM_BUILD_COPTER_OR_HELI || APM_BUILD_TYPE(APM_BUILD_ArduPlane)
         // if we are post-filter sampling then throttle estimate will be useless
         if (using_post_filter_samples()) {
@@ -871,17 +890,7 @@ float AP_GyroFFT::get_weighted_noise_center_freq_hz() const
 #endif
     }
 
-    const FrequencyPeak peak = get_tracked_noise_peak();
-    // pitch was good or required, roll was not, use pitch only
-    if (!_health.x || _harmonic_peak == FFT_HARMONIC_FIT_TRACK_PITCH) {
-        return get_noise_center_freq_hz(peak).y;    // Y-axis
-    }
-    // roll was good or required, pitch was not, use roll only
-    if (!_health.y || _harmonic_peak == FFT_HARMONIC_FIT_TRACK_ROLL) {
-        return get_noise_center_freq_hz(peak).x;    // X-axis
-    }
-
-    return get_weighted_freq_hz(peak);
+    return AP_GyroFFT_Tracker::get_weighted_noise_center_freq_hz(imu._global_state, imu._health, _harmonic_peak, _harmonic_fit);
 }
 
 // return all the center frequencies weighted by bin energy
@@ -893,7 +902,9 @@ uint8_t AP_GyroFFT::get_weighted_noise_center_frequencies_hz(uint8_t num_freqs,
         return 1;
     }
 
-    if (_health.is_zero()) {
+    const IMUState& imu = get_primary_imu();
+
+    if (imu._health.is_zero()) {
 #if APM_BUILD_COPTER_OR_HELI || APM_BUILD_TYPE(APM_BUILD_ArduPlane)
         // if we are post-filter sampling then throttle estimate will be useless
         if (using_post_filter_samples()) {
@@ -908,28 +919,40 @@ uint8_t AP_GyroFFT::get_weighted_noise_center_frequencies_hz(uint8_t num_freqs,
 #endif
     }
 
-    // pitch was good or required, roll was not, use pitch only
-    if (!_health.x || _harmonic_peak == FFT_HARMONIC_FIT_TRACK_PITCH) {
-        const uint8_t tracked_peaks = MIN(_health.y, num_freqs);
-        for (uint8_t i = 0; i < tracked_peaks; i++) {
-            freqs[i] = get_noise_center_freq_hz(FrequencyPeak(i)).y;    // Y-axis
-        }
-        return tracked_peaks;
+    return get_weighted_noise_center_frequencies_hz(imu, num_freqs, freqs);
+}
+
+// return all the center frequencies of a single IMU weighted by bin energy
+// there is no throttle fallback, callers should use the primary frequencies if nothing is returned
+// called from main thread
+uint8_t AP_GyroFFT::get_weighted_noise_center_frequencies_hz(uint8_t instance, uint8_t num_freqs, float* freqs) const
+{
+    if (!analysis_enabled() || !analysing_all_imus()) {
+        return 0;
     }
-    // roll was good or required, pitch was not, use roll only
-    if (!_health.y || _harmonic_peak == FFT_HARMONIC_FIT_TRACK_ROLL) {
-        const uint8_t tracked_peaks = MIN(_health.x, num_freqs);
-        for (uint8_t i = 0; i < tracked_peaks; i++) {
-            freqs[i] = get_noise_center_freq_hz(FrequencyPeak(i)).x;    // X-axis
+
+    for (uint8_t i = 0; i < _num_imus; i++) {
+        if (_imus[i]._instance == instance) {
+            return get_weighted_noise_center_frequencies_hz(_imus[i], num_freqs, freqs);
         }
-        return tracked_peaks;
     }
+    return 0;
+}
 
-    const uint8_t tracked_peaks = MIN(MAX(_health.x, _health.y), num_freqs);
-    for (uint8_t i = 0; i < tracked_peaks; i++) {
-        freqs[i] = get_weighted_freq_hz(FrequencyPeak(i));
+// the IMU whose results are used for the single IMU accessors, this follows the primary gyro
+// if it is analysed and otherwise uses the first analysed IMU
+uint8_t AP_GyroFFT::get_primary_imu_index() const
+{
+    if (!analysing_all_imus()) {
+        return 0;
     }
-    return tracked_peaks;
+    const uint8_t primary = _ins->get_fft_primary_instance();
+    for (uint8_t i = 0; i < _num_imus; i++) {
+        if (_imus[i]._instance == primary) {
+            return i;
+        }
+    }
+    return 0;
 }
 
 // return noise energy at the requested frequency
@@ -947,7 +970,7 @@ float AP_GyroFFT::has_noise_at_frequency_hz(float freq) const
         const Vector3f& snr = get_noise_signal_to_noise_db(FrequencyPeak(i));
 
         for (uint8_t j = 0; j < XYZ_AXIS_COUNT; j++) {
-            if (!_rpy_health[j]) {
+            if (!get_primary_imu()._rpy_health[j]) {
                 continue;
             }
 
@@ -960,19 +983,6 @@ float AP_GyroFFT::has_noise_at_frequency_hz(float freq) const
     return max_energy;
 }
 
-float AP_GyroFFT::calculate_weighted_freq_hz(const Vector3f& energy, const Vector3f& freq) const
-{
-    // there is generally a lot of high-energy, slightly lower frequency noise on yaw, however this
-    // appears to be a second-order effect as only targetting pitch and roll (x & y) produces much cleaner output all round
-    if (!energy.is_nan() && !is_zero(energy.x) && !is_zero(energy.y)) {
-        return (freq.x * energy.x + freq.y * energy.y)
-            / (energy.x + energy.y);
-    }
-    else {
-        return (freq.x + freq.y) * 0.5f;
-    }
-}
-
 // @LoggerMessage: FTN1
 // @Description: FFT Filter Tuning
 // @Field: TimeUS: microseconds since system startup
@@ -987,7 +997,8 @@ float AP_GyroFFT::calculate_weighted_freq_hz(const Vector3f& energy, const Vecto
 // @Field: FHX: FFT health, X-axis
 // @Field: FHY: FFT health, Y-axis
 // @Field: FHZ: FFT health, Z-axis
-// @Field: Tc: FFT cycle time
+// @Field: Tc: FFT cycle time, one axis of the primary or every axis of every IMU when all IMUs are analysed
+// @Field: Ld: FFT cycle time as a percentage of the time available to keep up with the gyros
 
 #if HAL_LOGGING_ENABLED
 
@@ -998,12 +1009,17 @@ void AP_GyroFFT::write_log_messages()
         return;
     }
 
+    const IMUState& imu = get_primary_imu();
+    // time available to process a cycle before the gyros get ahead, analysing one axis
+    // per cycle takes a cycle per axis to process each frame
+    const float frame_budget_us = _samples_per_frame * 1.0e6f / _fft_sampling_rate_hz / (analysing_all_axes() ? 1 : XYZ_AXIS_COUNT);
+
     AP::logger().WriteStreaming(
         "FTN1",
-        "TimeUS,PkAvg,BwAvg,SnX,SnY,SnZ,FtX,FtY,FtZ,FHX,FHY,FHZ,Tc",
-        "szz---%%%---s",
-        "F-----------F",
-        "QffffffffBBBI",
+        "TimeUS,PkAvg,BwAvg,SnX,SnY,SnZ,FtX,FtY,FtZ,FHX,FHY,FHZ,Tc,Ld",
+        "szz---%%%---s%",
+        "F-----------F-",
+        "QffffffffBBBIf",
         AP_HAL::micros64(),
         get_weighted_noise_center_freq_hz(),
         get_weighted_noise_center_bandwidth_hz(),
@@ -1013,12 +1029,15 @@ void AP_GyroFFT::write_log_messages()
         get_raw_noise_harmonic_fit().x,
         get_raw_noise_harmonic_fit().y,
         get_raw_noise_harmonic_fit().z,
-        _health.x, _health.y, _health.z, _output_cycle_micros);
-
-    log_noise_peak(0, FrequencyPeak::CENTER);
-    if (_tracked_peaks> 1) {
-        log_noise_peak(1, FrequencyPeak::LOWER_SHOULDER);
-        log_noise_peak(2, FrequencyPeak::UPPER_SHOULDER);
+        imu._health.x, imu._health.y, imu._health.z, _output_cycle_micros,
+        100.0f * _output_cycle_micros / frame_budget_us);
+
+    for (uint8_t i = 0; i < _num_imus; i++) {
+        log_noise_peak(_imus[i], 0, FrequencyPeak::CENTER);
+        if (_tracked_peaks> 1) {
+            log_noise_peak(_imus[i], 1, FrequencyPeak::LOWER_SHOULDER);
+            log_noise_peak(_imus[i], 2, FrequencyPeak::UPPER_SHOULDER);
+        }
     }
 
 #if DEBUG_FFT
@@ -1030,7 +1049,7 @@ void AP_GyroFFT::write_log_messages()
         GCS_SEND_TEXT(MAV_SEVERITY_WARNING, "FFT: f:%.1f, fr:%.1f, b:%u, fd:%.1f",
                         _debug_state._center_freq_hz_filtered[FrequencyPeak::CENTER][_update_axis], _debug_state._center_freq_hz[_update_axis], _debug_max_bin, _debug_max_bin_freq);
         GCS_SEND_TEXT(MAV_SEVERITY_WARNING, "FFT: bw:%.1f, e:%.1f, r:%.1f, snr:%.1f",
-                        _debug_state._center_bandwidth_hz_filtered[FrequencyPeak::CENTER][_update_axis], _debug_max_freq_bin, _ref_energy[_debug_max_bin][_update_axis], _debug_snr);
+                        _debug_state._center_bandwidth_hz_filtered[FrequencyPeak::CENTER][_update_axis], _debug_max_freq_bin, get_primary_imu()._tracker.get_ref_energy(_debug_max_bin, _update_axis), _debug_snr);
         _last_output_ms = now;
     }
 #endif
@@ -1052,25 +1071,29 @@ void AP_GyroFFT::write_log_messages()
 // @Field: EnX: power spectral density bin energy of the peak on roll
 // @Field: EnY: power spectral density bin energy of the peak on roll
 // @Field: EnZ: power spectral density bin energy of the peak on roll
+// @Field: IMU: IMU instance, only differs from the primary when all IMUs are analysed
 
 // write a single log message
-void AP_GyroFFT::log_noise_peak(uint8_t id, FrequencyPeak peak) const
+void AP_GyroFFT::log_noise_peak(const IMUState& imu, uint8_t id, FrequencyPeak peak) const
 {
-    AP::logger().WriteStreaming("FTN2", "TimeUS,Id,PkX,PkY,PkZ,BwX,BwY,BwZ,SnX,SnY,SnZ,EnX,EnY,EnZ", "s#zzzzzz------", "F-------------", "QBffffffffffff",
+    const EngineState& state = imu._global_state;
+
+    AP::logger().WriteStreaming("FTN2", "TimeUS,Id,PkX,PkY,PkZ,BwX,BwY,BwZ,SnX,SnY,SnZ,EnX,EnY,EnZ,IMU", "s#zzzzzz-------", "F--------------", "QBffffffffffffB",
         AP_HAL::micros64(),
         id,
-        get_noise_center_freq_hz(peak).x,
-        get_noise_center_freq_hz(peak).y,
-        get_noise_center_freq_hz(peak).z,
-        get_noise_center_bandwidth_hz(peak).x,
-        get_noise_center_bandwidth_hz(peak).y,
-        get_noise_center_bandwidth_hz(peak).z,
-        get_noise_signal_to_noise_db(peak).x,
-        get_noise_signal_to_noise_db(peak).y,
-        get_noise_signal_to_noise_db(peak).z,
-        get_center_freq_energy(peak).x,
-        get_center_freq_energy(peak).y,
-        get_center_freq_energy(peak).z);
+        state._center_freq_hz_filtered[peak].x,
+        state._center_freq_hz_filtered[peak].y,
+        state._center_freq_hz_filtered[peak].z,
+        state._center_bandwidth_hz_filtered[peak].x,
+        state._center_bandwidth_hz_filtered[peak].y,
+        state._center_bandwidth_hz_filtered[peak].z,
+        state._center_freq_snr[peak].x,
+        state._center_freq_snr[peak].y,
+        state._center_freq_snr[peak].z,
+        state._center_freq_energy_filtered[peak].x,
+        state._center_freq_energy_filtered[peak].y,
+        state._center_freq_energy_filtered[peak].z,
+        analysing_all_imus() ? imu._instance : _ins->get_fft_primary_instance());
 }
 
 #endif
@@ -1083,319 +1106,33 @@ float AP_GyroFFT::get_weighted_noise_center_bandwidth_hz() const
         return 0.0f;
     }
 
-    const FrequencyPeak peak = get_tracked_noise_peak();
+    const FrequencyPeak peak = get_tracked_noise_peak(get_primary_imu());
 
-    return calculate_weighted_freq_hz(get_center_freq_energy(peak), get_noise_center_bandwidth_hz(peak));
+    return AP_GyroFFT_Tracker::calculate_weighted_freq_hz(get_center_freq_energy(peak), get_noise_center_bandwidth_hz(peak));
 }
 
 // calculate noise frequencies from FFT data provided by the HAL subsystem
 // called from FFT thread
 void AP_GyroFFT::calculate_noise(bool calibrating, const EngineConfig& config)
 {
-    // calculate the SNR and center frequency energy
-    float weighted_center_freq_hz = 0.0f;
+    const uint8_t num_peaks = _update_imu->_tracker.calculate_noise(*_state, _update_axis, calibrating, config, _update_imu->_thread_state);
 
-    uint8_t num_peaks = calculate_tracking_peaks(weighted_center_freq_hz, calibrating, config);
-
-    _thread_state._center_freq_bin[_update_axis] = _state->_peak_data[_thread_state._center_peak[_update_axis]]._bin;
-    _thread_state._center_freq_hz[_update_axis] = weighted_center_freq_hz;
     // record the last time we had a good signal on this axis
     if (num_peaks > 0) {
-        _thread_state._health_ms[_update_axis] = AP_HAL::millis();
-    } else {
-        _thread_state._health_ms[_update_axis] = 0;
-    }
-    _thread_state._health[_update_axis] = num_peaks;
-    FrequencyPeak tracked_peak = FrequencyPeak::CENTER;
-
-    // record the tracked peak for harmonic fit, but only if we have more than one noise peak
-    // this checks filtered energies and so can allow energies to be closer together
-    if (num_peaks > 1 && _tracked_peaks > 1 && !is_zero(get_tl_noise_center_freq_hz(FrequencyPeak::CENTER, _update_axis))) {
-        if (get_tl_noise_center_freq_hz(FrequencyPeak::CENTER, _update_axis) > get_tl_noise_center_freq_hz(FrequencyPeak::LOWER_SHOULDER, _update_axis)
-            // ignore the fit if there is too big a discrepancy between the energies
-            && get_tl_center_freq_energy(FrequencyPeak::CENTER, _update_axis) < get_tl_center_freq_energy(FrequencyPeak::LOWER_SHOULDER, _update_axis) * FFT_HARMONIC_FIT_MULT) {
-            tracked_peak = FrequencyPeak::LOWER_SHOULDER;
-        } else if (num_peaks > 2 && get_tl_noise_center_freq_hz(FrequencyPeak::CENTER, _update_axis) > get_tl_noise_center_freq_hz(FrequencyPeak::UPPER_SHOULDER, _update_axis)
-            // ignore the fit if there is too big a discrepancy between the energies
-            && get_tl_center_freq_energy(FrequencyPeak::CENTER, _update_axis) < get_tl_center_freq_energy(FrequencyPeak::UPPER_SHOULDER, _update_axis) * FFT_HARMONIC_FIT_MULT) {
-            tracked_peak = FrequencyPeak::UPPER_SHOULDER;
-        }
-    }
-
-    _thread_state._tracked_peak[_update_axis] = tracked_peak;
-
-    // if targetting more than one harmonic then make sure we get the fundamental
-    // on larger copters the second harmonic often has more energy
-    // if the highest peak is above the second highest then check for harmonic fit
-    // comparisons are made using filter, normalised data
-    if (_thread_state._tracked_peak[_update_axis] != FrequencyPeak::CENTER) {
-        // calculate the fit and filter at 10hz
-        const float harmonic_fit = 100.0f * fabsf(get_tl_noise_center_freq_hz(FrequencyPeak::CENTER, _update_axis)
-            - get_tl_noise_center_freq_hz(tracked_peak, _update_axis) * _harmonic_multiplier)
-            / get_tl_noise_center_freq_hz(FrequencyPeak::CENTER, _update_axis);
-
-        // calculate the fit and filter at 10hz
-        if (isfinite(harmonic_fit)) {
-            _thread_state._harmonic_fit[_update_axis] = _harmonic_fit_filter[_update_axis].apply(harmonic_fit);
-        }
+        _update_imu->_thread_state._health_ms[_update_axis] = AP_HAL::millis();
     } else {
-        _thread_state._harmonic_fit[_update_axis] = 100.0f;
+        _update_imu->_thread_state._health_ms[_update_axis] = 0;
     }
 #if DEBUG_FFT
     WITH_SEMAPHORE(_sem);
-    _debug_state = _thread_state;
+    _debug_state = _update_imu->_thread_state;
     _debug_max_freq_bin = _state->get_freq_bin(_state->_peak_data[FrequencyPeak::CENTER]._bin);
     _debug_max_bin_freq = _state->_peak_data[FrequencyPeak::CENTER]._freq_hz;
-    _debug_snr = snr;
+    _debug_snr = _update_imu->_thread_state._center_freq_snr[FrequencyPeak::CENTER][_update_axis];
     _debug_max_bin = _state->_peak_data[FrequencyPeak::CENTER]._bin;
 #endif
 }
 
-
-// calculate noise peaks based on the frequencies closest to the recent historical average, switching peaks around as necessary
-uint8_t AP_GyroFFT::calculate_tracking_peaks(float& weighted_center_freq_hz, bool calibrating, const EngineConfig& config)
-{
-    uint8_t num_peaks = 0;
-    FrequencyData freqs(*this, config);
-
-    // the noise peaks are returned by the HAL in decreasing order of magnitude, however each peak can temporarily
-    // switch places with another depending on a whole host of hardware and software factors
-    // thus we must be able to temporarily reassign the peaks so that the filtered values track
-    // a continuous frequency
-    DistanceMatrix distance_matrix;
-    find_distance_matrix(distance_matrix, freqs, config);
-
-    FrequencyPeak center = find_closest_peak(FrequencyPeak::CENTER, distance_matrix);
-    FrequencyPeak lower = find_closest_peak(FrequencyPeak::LOWER_SHOULDER, distance_matrix, 1 << center);
-    FrequencyPeak upper = find_closest_peak(FrequencyPeak::UPPER_SHOULDER, distance_matrix, 1 << center | 1 << lower);
-
-    // if we have had the maximum number of swapped cycles, force a full calculation
-    if (calibrating || _distorted_cycles[_update_axis] == 0) {
-        num_peaks = calculate_tracking_peaks(weighted_center_freq_hz, freqs, config);
-#if DEBUG_FFT
-        printf("Skipped update, order would have been is %d/%.1f(%.1f) %d/%.1f(%.1f) %d/%.1f(%.1f) n = %d\n",
-            center, _state->_peak_data[center]._freq_hz, get_tl_noise_center_freq_hz(FrequencyPeak::CENTER, _update_axis),
-            lower, _state->_peak_data[lower]._freq_hz, get_tl_noise_center_freq_hz(FrequencyPeak::LOWER_SHOULDER, _update_axis),
-            upper, _state->_peak_data[upper]._freq_hz, get_tl_noise_center_freq_hz(FrequencyPeak::UPPER_SHOULDER, _update_axis), num_peaks);
-#endif
-        return num_peaks;
-    }
-
-    // another peak is closer to what is currently considered the center frequency
-    if (center != FrequencyPeak::CENTER || lower != FrequencyPeak::LOWER_SHOULDER || upper != FrequencyPeak::UPPER_SHOULDER) {
-        if (lower != FrequencyPeak::NONE && calculate_filtered_noise(FrequencyPeak::LOWER_SHOULDER, lower, freqs, config)) {
-            num_peaks++;
-        } else {
-            lower = FrequencyPeak::NONE;
-        }
-        if (upper != FrequencyPeak::NONE && calculate_filtered_noise(FrequencyPeak::UPPER_SHOULDER, upper, freqs, config)) {
-            num_peaks++;
-        } else {
-            upper = FrequencyPeak::NONE;
-        }
-        if (center != FrequencyPeak::NONE && calculate_filtered_noise(FrequencyPeak::CENTER,  center, freqs, config)) {
-            num_peaks++;
-        } else {
-            center = FrequencyPeak::NONE;
-        }
-        weighted_center_freq_hz = freqs.get_weighted_frequency(center);
-        _thread_state._center_peak[_update_axis] = center;
-        update_snr_values(freqs);
-        // if two adjacent peaks have simply swapped, we will allow this to continue indefinitely
-        // as there is no loss of fidelity
-        if (!((center == FrequencyPeak::LOWER_SHOULDER && lower == FrequencyPeak::CENTER)
-            || (center == FrequencyPeak::UPPER_SHOULDER && upper == FrequencyPeak::CENTER))) {
-            _distorted_cycles[_update_axis]--;
-        }
-        return num_peaks;
-    }
-
-    num_peaks = calculate_tracking_peaks(weighted_center_freq_hz, freqs, config);
-
-    return num_peaks;
-}
-
-// calculate the noise and whether valid for each peak
-uint8_t AP_GyroFFT::calculate_tracking_peaks(float& weighted_center_freq_hz, const FrequencyData& freqs, const EngineConfig& config)
-{
-    uint8_t num_peaks = 0;
-    if (calculate_filtered_noise(FrequencyPeak::LOWER_SHOULDER, FrequencyPeak::LOWER_SHOULDER, freqs, config)) {
-        num_peaks++;
-    }
-    if (calculate_filtered_noise(FrequencyPeak::UPPER_SHOULDER, FrequencyPeak::UPPER_SHOULDER, freqs, config)) {
-        num_peaks++;
-    }
-    if (calculate_filtered_noise(FrequencyPeak::CENTER, FrequencyPeak::CENTER, freqs, config)) {
-        num_peaks++;
-    }
-    // record the number of cycles where something was tracked
-    _distorted_cycles[_update_axis] = constrain_int16(_distorted_cycles[_update_axis] + 1, 0, FFT_MAX_MISSED_UPDATES);
-    weighted_center_freq_hz = freqs.get_weighted_frequency(FrequencyPeak::CENTER);
-    _thread_state._center_peak[_update_axis] = FrequencyPeak::CENTER;
-
-    update_snr_values(freqs);
-
-    return num_peaks;
-}
-
-// calculate noise frequencies from FFT data provided by the HAL subsystem
-// target_peak is the filtered record we want to apply the new fft data to, source peak is where the fft data is coming from
-// called from FFT thread
-bool AP_GyroFFT::calculate_filtered_noise(FrequencyPeak target_peak, FrequencyPeak source_peak, const FrequencyData& freqs, const EngineConfig& config)
-{
-    if (source_peak > FrequencyPeak::MAX_TRACKED_PEAKS) {
-        // if we failed to find a signal, carry on using the previous readings
-        if (_missed_cycles[_update_axis][target_peak]++ < FFT_MAX_MISSED_UPDATES) {
-            return true; // the peak is synthetic
-        }
-        update_tl_center_freq_energy(target_peak, _update_axis, 0.0f);
-        update_tl_noise_center_bandwidth_hz(target_peak, _update_axis, _bandwidth_hover_hz);
-        update_tl_noise_center_freq_hz(target_peak, _update_axis, config._fft_min_hz);
-        return false;
-    }
-
-    AP_HAL::DSP::FrequencyPeakData* peak_data = &_state->_peak_data[source_peak];
-
-    const uint16_t nb = peak_data->_bin;
-
-    if (freqs.is_valid(FrequencyPeak(source_peak))) {
-        // total peak energy requires an integration, as an approximation use amplitude * noise width * 5/6
-        update_tl_center_freq_energy(target_peak, _update_axis, _state->get_freq_bin(nb) * peak_data->_noise_width_hz * 0.8333f);
-        update_tl_noise_center_bandwidth_hz(target_peak, _update_axis, peak_data->_noise_width_hz);
-        update_tl_noise_center_freq_hz(target_peak, _update_axis, freqs.get_weighted_frequency(FrequencyPeak(source_peak)));
-        _missed_cycles[_update_axis][target_peak] = 0;
-        return true;
-    }
-
-    // if we failed to find a signal, carry on using the previous readings
-    if (_missed_cycles[_update_axis][target_peak]++ < FFT_MAX_MISSED_UPDATES) {
-        return true; // the peak is synthetic
-    }
-
-    // we failed to find a signal for more than FFT_MAX_MISSED_UPDATES cycles
-    update_tl_center_freq_energy(target_peak, _update_axis, _state->get_freq_bin(nb) * peak_data->_noise_width_hz * 0.8333f);     // use the actual energy detected rather than 0
-    update_tl_noise_center_bandwidth_hz(target_peak, _update_axis, _bandwidth_hover_hz);
-    update_tl_noise_center_freq_hz(target_peak, _update_axis, config._fft_min_hz);
-
-    return false;
-}
-
-void AP_GyroFFT::update_snr_values(const FrequencyData& freqs)
-{
-    _thread_state._center_freq_snr[FrequencyPeak::CENTER][_update_axis] = freqs.get_signal_to_noise(FrequencyPeak::CENTER);
-    _thread_state._center_freq_snr[FrequencyPeak::LOWER_SHOULDER][_update_axis] = freqs.get_signal_to_noise(FrequencyPeak::LOWER_SHOULDER);
-    _thread_state._center_freq_snr[FrequencyPeak::UPPER_SHOULDER][_update_axis] = freqs.get_signal_to_noise(FrequencyPeak::UPPER_SHOULDER);
-}
-
-
-// filter values through a median sliding window followed by low pass filter
-// this eliminates temporary spikes in the detected frequency that are either pure noise
-// or a different peak that will erroneously bias the peak we are tracking
-float AP_GyroFFT::MedianLowPassFilter3dFloat::apply(uint8_t axis, float sample)
-{
-    _median_filter[axis].apply(sample);
-    const float a = _median_filter[axis].get_sample(0);
-    const float b = _median_filter[axis].get_sample(1);
-    const float c = _median_filter[axis].get_sample(2);
-    float median = MAX(MIN(a, b), MIN(MAX(a, b), c));
-    return _lowpass_filter[axis].apply(median);
-}
-
-// initialize a FrequencyData structure with peak frequency information for use in the swapping algorithm
-AP_GyroFFT::FrequencyData::FrequencyData(const AP_GyroFFT& gyrofft, const EngineConfig& config)
-{
-    for (uint8_t i = 0; i < FrequencyPeak::MAX_TRACKED_PEAKS; i++) {
-        valid[i] = gyrofft.get_weighted_frequency(FrequencyPeak(i), frequency[i], snr[i], config);
-    }
-}
-
-// calculate noise frequencies from FFT data provided by the HAL subsystem
-bool AP_GyroFFT::get_weighted_frequency(FrequencyPeak peak, float& weighted_peak_freq_hz, float& snr, const EngineConfig& config) const
-{
-    AP_HAL::DSP::FrequencyPeakData* peak_data = &_state->_peak_data[peak];
-
-    const uint16_t bin = peak_data->_bin;
-
-    // calculate the SNR and center frequency energy
-    const float max_energy = MAX(1.0f, _state->get_freq_bin(bin));
-    const float ref_energy = MAX(1.0f, _ref_energy[bin][_update_axis]);
-    snr = 10.f * (log10f(max_energy) - log10f(ref_energy));
-
-    // if the bin energy is above the noise threshold then we have a signal
-    if (!_thread_state._noise_needs_calibration && isfinite(_state->get_freq_bin(bin)) && snr > config._snr_threshold_db) {
-        weighted_peak_freq_hz = constrain_float(peak_data->_freq_hz, (float)config._fft_min_hz, (float)config._fft_max_hz);
-        return true;
-    }
-
-    weighted_peak_freq_hz = (float)config._fft_min_hz;
-
-    return false;
-}
-
-// calculate a matrix of distances between the current filtered estimates and instantaneous values from the current cycle
-void AP_GyroFFT::find_distance_matrix(DistanceMatrix& distance_matrix, const FrequencyData& freqs, const EngineConfig& config) const
-{
-    float curr_freqs[FrequencyPeak::MAX_TRACKED_PEAKS];
-    // get the current frequency estimate for all peaks
-    for (uint8_t i = 0; i < FrequencyPeak::MAX_TRACKED_PEAKS; i++) {
-        curr_freqs[i] = get_tl_noise_center_freq_hz(FrequencyPeak(i), _update_axis);
-    }
-    // calculate the matrix
-    for (uint8_t i = 0; i < FrequencyPeak::MAX_TRACKED_PEAKS; i++) {
-        for (uint8_t j = 0; j < FrequencyPeak::MAX_TRACKED_PEAKS; j++) {
-            distance_matrix[i][j] = fabsf((freqs.is_valid(FrequencyPeak(i)) ?
-                freqs.get_weighted_frequency(FrequencyPeak(i)) : FLT_MAX) - curr_freqs[j]);
-        }
-    }
-}
-
-// return the instantaneous peak that is closest to the target estimate peak
-AP_GyroFFT::FrequencyPeak AP_GyroFFT::find_closest_peak(const FrequencyPeak target, const DistanceMatrix& distance_matrix, uint8_t ignore) const
-{
-    // find the closest peak to target
-    uint8_t closest = target;
-    for (uint8_t i = 0; i < FrequencyPeak::MAX_TRACKED_PEAKS; i++) {
-        if (distance_matrix[i][target] < distance_matrix[closest][target] && (1 << i & ~ignore)) {
-            closest = i;
-        }
-    }
-    // didn't find anything
-    if (!(1<<closest & ~ignore)) {
-        return FrequencyPeak::NONE;
-    }
-    return FrequencyPeak(closest);
-}
-
-// calculate noise baseline from FFT data provided by the HAL subsystem
-// called from FFT thread
-void AP_GyroFFT::update_ref_energy(uint16_t max_bin)
-{
-    if (!_thread_state._noise_needs_calibration) {
-        return;
-    }
-
-    // according to https://www.tcd.ie/Physics/research/groups/magnetism/files/lectures/py5021/MagneticSensors3.pdf sensor noise is not necessarily gaussian
-    // determine a PS noise reference at each of the possible center frequencies
-    if (_noise_cycles == 0 && _noise_calibration_cycles[_update_axis] > 0) {
-        for (uint16_t i = 1; i < _state->_bin_count; i++) {
-            _ref_energy[i][_update_axis] += _state->get_freq_bin(i);
-        }
-        if (--_noise_calibration_cycles[_update_axis] == 0) {
-            for (uint16_t i = 1; i < _state->_bin_count; i++) {
-                const float cycles = (static_cast<float>(_window_size) / static_cast<float>(_samples_per_frame)) * 2;
-                // overall random noise is reduced by sqrt(N) when averaging periodigrams so adjust for that
-                _ref_energy[i][_update_axis] = (_ref_energy[i][_update_axis] / cycles) * sqrtf(cycles);
-            }
-
-            WITH_SEMAPHORE(_sem);
-            _thread_state._noise_needs_calibration &= ~(1 << _update_axis);
-        }
-    }
-    else if (_noise_cycles > 0) {
-        _noise_cycles--;
-    }
-}
-
 // perform FFT analysis on the range of frequencies supported by the analyser
 // called from main thread
 float AP_GyroFFT::self_test_bin_frequencies()
@@ -1413,12 +1150,19 @@ float AP_GyroFFT::self_test_bin_frequencies()
 
     float max_divergence = 0;
 
-    for (uint16_t bin = _config._fft_start_bin; bin <= _config._fft_end_bin; bin++) {
+    // the configuration may be updated on a scheduler worker
+    EngineConfig config;
+    {
+        WITH_SEMAPHORE(_sem);
+        config = _config;
+    }
+
+    for (uint16_t bin = config._fft_start_bin; bin <= config._fft_end_bin; bin++) {
         // the algorithm will only ever return values in this range
-        float frequency = constrain_float(bin * _state->_bin_resolution, _fft_min_hz, _fft_max_hz);
-        max_divergence = MAX(max_divergence, self_test(frequency, test_window)); // test bin centers
-        frequency = constrain_float(bin * _state->_bin_resolution - _state->_bin_resolution / 4, _fft_min_hz, _fft_max_hz);
-        max_divergence = MAX(max_divergence, self_test(frequency, test_window)); // test bin off-centers
+        float frequency = constrain_float(bin * _state->_bin_resolution, config._fft_min_hz, config._fft_max_hz);
+        max_divergence = MAX(max_divergence, self_test(frequency, test_window, config)); // test bin centers
+        frequency = constrain_float(bin * _state->_bin_resolution - _state->_bin_resolution / 4, config._fft_min_hz, config._fft_max_hz);
+        max_divergence = MAX(max_divergence, self_test(frequency, test_window, config)); // test bin off-centers
     }
 
     return max_divergence;
@@ -1426,7 +1170,7 @@ float AP_GyroFFT::self_test_bin_frequencies()
 
 // perform FFT analysis of a single sine wave at the selected frequency
 // called from main thread
-float AP_GyroFFT::self_test(float frequency, FloatBuffer& test_window)
+float AP_GyroFFT::self_test(float frequency, FloatBuffer& test_window, const EngineConfig& config)
 {
     test_window.clear();
     for(uint16_t i = 0; i < _state->_window_size; i++) {
@@ -1435,32 +1179,33 @@ float AP_GyroFFT::self_test(float frequency, FloatBuffer& test_window)
         }
     }
 
+    _update_imu = &_imus[get_primary_imu_index()];
     _update_axis = 0;
 
     // if using averaging we need to process _num_frames in order to not bias the result
     for (uint8_t i = 1; i < _num_frames; i++) {
         hal.dsp->fft_start(_state, test_window, 0);
-        hal.dsp->fft_analyse(_state, _config._fft_start_bin, _config._fft_end_bin, _config._attenuation_cutoff);
+        hal.dsp->fft_analyse(_state, config._fft_start_bin, config._fft_end_bin, config._attenuation_cutoff);
     }
     // final cycle is the one we want
     hal.dsp->fft_start(_state, test_window, 0);
-    uint16_t max_bin = hal.dsp->fft_analyse(_state, _config._fft_start_bin, _config._fft_end_bin, _config._attenuation_cutoff);
+    uint16_t max_bin = hal.dsp->fft_analyse(_state, config._fft_start_bin, config._fft_end_bin, config._attenuation_cutoff);
 
     if (max_bin == 0) {
         GCS_SEND_TEXT(MAV_SEVERITY_WARNING, "FFT: self-test failed, failed to find frequency %.1f", frequency);
     }
 
-    calculate_noise(true, _config);
+    calculate_noise(true, config);
 
     float max_divergence = 0;
     // make sure the selected frequencies are in the right bin
-    max_divergence = MAX(max_divergence, fabsf(frequency - _thread_state._center_freq_hz[0]));
-    if (_thread_state._center_freq_hz[0] < (frequency - MAX(_state->_bin_resolution * 0.5f, 1)) || _thread_state._center_freq_hz[0] > (frequency + MAX(_state->_bin_resolution * 0.5f, 1))) {
-        GCS_SEND_TEXT(MAV_SEVERITY_WARNING, "FFT: self-test failed: wanted %.1f, had %.1f", frequency, _thread_state._center_freq_hz[0]);
+    max_divergence = MAX(max_divergence, fabsf(frequency - _update_imu->_thread_state._center_freq_hz[0]));
+    if (_update_imu->_thread_state._center_freq_hz[0] < (frequency - MAX(_state->_bin_resolution * 0.5f, 1)) || _update_imu->_thread_state._center_freq_hz[0] > (frequency + MAX(_state->_bin_resolution * 0.5f, 1))) {
+        GCS_SEND_TEXT(MAV_SEVERITY_WARNING, "FFT: self-test failed: wanted %.1f, had %.1f", frequency, _update_imu->_thread_state._center_freq_hz[0]);
     }
 #if DEBUG_FFT
     else {
-        GCS_SEND_TEXT(MAV_SEVERITY_INFO, "FFT: self-test succeeded: wanted %.1f, had %.1f", frequency, _thread_state._center_freq_hz[0]);
+        GCS_SEND_TEXT(MAV_SEVERITY_INFO, "FFT: self-test succeeded: wanted %.1f, had %.1f", frequency, _update_imu->_thread_state._center_freq_hz[0]);
     }
 #endif
 
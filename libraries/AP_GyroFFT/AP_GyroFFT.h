@@ -27,8 +27,11 @@
 #include <AP_InertialSensor/AP_InertialSensor.h>
 #include <Filter/LowPassFilter.h>
 #include <Filter/FilterWithBuffer.h>
+#include "AP_GyroFFT_Tracker.h"
 
-#define DEBUG_FFT   0
+#ifndef FFT_MAX_IMUS
+#define FFT_MAX_IMUS INS_MAX_INSTANCES
+#endif
 
 // a library that leverages the HAL DSP support to perform FFT analysis on gyro samples
 class AP_GyroFFT
@@ -40,7 +43,9 @@ public:
 
     enum class Options : uint32_t {
         FFTPostFilter = 1 << 0,
-        ESCNoiseCheck = 1 << 1
+        ESCNoiseCheck = 1 << 1,
+        AllIMUs = 1 << 2,
+        AllAxes = 1 << 3,
     };
 
     AP_GyroFFT();
@@ -56,7 +61,7 @@ public:
     void sample_gyros();
     // update the engine state - runs at 400Hz
     void update();
-    // update calculated values of dynamic parameters - runs at 1Hz
+    // update calculated values of dynamic parameters - runs at 1Hz, on a scheduler worker if there are any
     void update_parameters() { update_parameters(false); }
     // thread for processing gyro data via FFT
     void update_thread();
@@ -81,28 +86,30 @@ public:
 
     // detected peak frequency filtered at 1/3 the update rate
     const Vector3f& get_noise_center_freq_hz() const { return get_noise_center_freq_hz(FrequencyPeak::CENTER); }
-    const Vector3f& get_noise_center_freq_hz(FrequencyPeak peak) const { return _global_state._center_freq_hz_filtered[peak]; }
+    const Vector3f& get_noise_center_freq_hz(FrequencyPeak peak) const { return get_primary_imu()._global_state._center_freq_hz_filtered[peak]; }
     // frequency values
     float get_weighted_freq_hz(FrequencyPeak peak) const;
     // energy of the background noise at the detected center frequency
     const Vector3f& get_noise_signal_to_noise_db() const { return get_noise_signal_to_noise_db(FrequencyPeak::CENTER); }
-    const Vector3f& get_noise_signal_to_noise_db(FrequencyPeak peak) const { return _global_state._center_freq_snr[peak];; }
+    const Vector3f& get_noise_signal_to_noise_db(FrequencyPeak peak) const { return get_primary_imu()._global_state._center_freq_snr[peak]; }
     // detected peak frequency weighted by energy
     float get_weighted_noise_center_freq_hz() const;
     // all detected peak frequencies weighted by energy
     uint8_t get_weighted_noise_center_frequencies_hz(uint8_t num_freqs, float* freqs) const;
+    // all detected peak frequencies of a single IMU weighted by energy, zero if that IMU is not analysed
+    uint8_t get_weighted_noise_center_frequencies_hz(uint8_t instance, uint8_t num_freqs, float* freqs) const;
     // detected peak frequency
-    const Vector3f& get_raw_noise_center_freq_hz() const { return _global_state._center_freq_hz; }
+    const Vector3f& get_raw_noise_center_freq_hz() const { return get_primary_imu()._global_state._center_freq_hz; }
     // match between first and second harmonics
-    const Vector3f& get_raw_noise_harmonic_fit() const { return _global_state._harmonic_fit; }
+    const Vector3f& get_raw_noise_harmonic_fit() const { return get_primary_imu()._global_state._harmonic_fit; }
     // energy of the detected peak frequency
     const Vector3f& get_center_freq_energy() const { return get_center_freq_energy(FrequencyPeak::CENTER); }
-    const Vector3f& get_center_freq_energy(FrequencyPeak peak) const { return _global_state._center_freq_energy_filtered[peak]; }
+    const Vector3f& get_center_freq_energy(FrequencyPeak peak) const { return get_primary_imu()._global_state._center_freq_energy_filtered[peak]; }
     // index of the FFT bin containing the detected peak frequency
-    const Vector3<uint16_t>& get_center_freq_bin() const { return _global_state._center_freq_bin; }
+    const Vector3<uint16_t>& get_center_freq_bin() const { return get_primary_imu()._global_state._center_freq_bin; }
     // detected peak bandwidth
     const Vector3f& get_noise_center_bandwidth_hz() const { return get_noise_center_bandwidth_hz(FrequencyPeak::CENTER); }
-    const Vector3f& get_noise_center_bandwidth_hz(FrequencyPeak peak) const { return _global_state._center_bandwidth_hz_filtered[peak]; };
+    const Vector3f& get_noise_center_bandwidth_hz(FrequencyPeak peak) const { return get_primary_imu()._global_state._center_bandwidth_hz_filtered[peak]; };
     // weighted detected peak bandwidth
     float get_weighted_noise_center_bandwidth_hz() const;
     // log gyro fft messages
@@ -111,6 +118,10 @@ public:
     bool using_post_filter_samples() const { return (_options & uint32_t(Options::FFTPostFilter)) != 0; }
     // post filter mask of IMUs
     bool check_esc_noise() const { return (_options & uint32_t(Options::ESCNoiseCheck)) != 0; }
+    // whether every IMU is analysed rather than just the primary
+    bool analysing_all_imus() const { return _num_imus > 1; }
+    // whether every axis is analysed each frame rather than one axis per frame
+    bool analysing_all_axes() const { return _all_axes; }
     // look for a frequency in the detected noise
     float has_noise_at_frequency_hz(float freq) const;
     static float calculate_notch_frequency(float* freqs, uint16_t numpeaks, float harmonic_fit, uint8_t& harmonics);
@@ -123,150 +134,103 @@ public:
     static AP_GyroFFT *get_singleton() { return _singleton; }
 
 private:
+    struct IMUState;
+
     // configuration data local to the FFT thread but set from the main thread
-    struct EngineConfig {
+    struct EngineConfig : public AP_GyroFFT_Tracker::Config {
         // whether the analyzer should be run
         bool _analysis_enabled;
-        // minimum frequency of the detection window
-        uint16_t _fft_min_hz;
-        // maximum frequency of the detection window
-        uint16_t _fft_max_hz;
         // configured start bin based on min hz
         uint16_t _fft_start_bin;
         // configured end bin based on max hz
         uint16_t _fft_end_bin;
         // attenuation cutoff for calculation of hover bandwidth
         float _attenuation_cutoff;
-        // SNR Threshold
-        float _snr_threshold_db;
     } _config;
 
-    // smoothing filter that first takes the median from a sliding window and then
-    // applies a low pass filter to the result
-    class MedianLowPassFilter3dFloat {
-    public:
-        MedianLowPassFilter3dFloat() { }
-
-        float apply(uint8_t axis, float sample);
-        float get(uint8_t axis) const { return _lowpass_filter[axis].get(); }
-
-        void set_cutoff_frequency(float sample_freq, float cutoff_freq) {
-            for (uint8_t i = 0; i < XYZ_AXIS_COUNT; i++) {
-                _lowpass_filter[i].set_cutoff_frequency(sample_freq, cutoff_freq);
-            }
-        }
-
-    private:
-        LowPassFilterConstDtFloat _lowpass_filter[XYZ_AXIS_COUNT];
-        FilterWithBuffer<float,3> _median_filter[XYZ_AXIS_COUNT];
-    };
-
-    // structure for holding noise peak data while calculating swaps
-    class FrequencyData {
-    public:
-        FrequencyData(const AP_GyroFFT& gyrofft, const EngineConfig& config);
-        float get_weighted_frequency(FrequencyPeak i) const { return frequency[i]; }
-        float get_signal_to_noise(FrequencyPeak i) const { return snr[i]; }
-        bool is_valid(FrequencyPeak i) const { return valid[i]; }
-    private:
-        float frequency[FrequencyPeak::MAX_TRACKED_PEAKS];
-        float snr[FrequencyPeak::MAX_TRACKED_PEAKS];
-        bool valid[FrequencyPeak::MAX_TRACKED_PEAKS];
-    };
-    // distance matrix between filtered and instantaneous peaks
-    typedef float DistanceMatrix[FrequencyPeak::MAX_TRACKED_PEAKS][FrequencyPeak::MAX_TRACKED_PEAKS];
-
-    // thread-local accessors of filtered state
-    float get_tl_noise_center_freq_hz(FrequencyPeak peak, uint8_t axis) const { return _thread_state._center_freq_hz_filtered[peak][axis]; }
-    float get_tl_center_freq_energy(FrequencyPeak peak, uint8_t axis) const { return _thread_state._center_freq_energy_filtered[peak][axis]; }
-    float get_tl_noise_center_bandwidth_hz(FrequencyPeak peak, uint8_t axis) const { return _thread_state._center_bandwidth_hz_filtered[peak][axis]; };
-    // thread-local mutators of filtered state
-    float update_tl_noise_center_freq_hz(FrequencyPeak peak, uint8_t axis, float value) {
-        return (_thread_state._center_freq_hz_filtered[peak][axis] = _center_freq_filter[peak].apply(axis, value));
-    }
-    float update_tl_center_freq_energy(FrequencyPeak peak, uint8_t axis, float value) {
-        return (_thread_state._center_freq_energy_filtered[peak][axis] = _center_freq_energy_filter[peak].apply(axis, value));
-    }
-    float update_tl_noise_center_bandwidth_hz(FrequencyPeak peak, uint8_t axis, float value) {
-        return (_thread_state._center_bandwidth_hz_filtered[peak][axis] = _center_bandwidth_filter[peak].apply(axis, value));
-    }
     // write single log messages
-    void log_noise_peak(uint8_t id, FrequencyPeak peak) const;
-    // calculate the peak noise frequency
+    void log_noise_peak(const IMUState& imu, uint8_t id, FrequencyPeak peak) const;
+    // run the FFT over one axis of one IMU
+    void analyse_axis(const EngineConfig& config);
+    // samples available for the next frame
+    uint16_t get_frame_samples();
+    // calculate the peak noise frequency of _update_axis of _update_imu
     void calculate_noise(bool calibrating, const EngineConfig& config);
-    // calculate noise peaks based on energy and history
-    uint8_t calculate_tracking_peaks(float& weighted_peak_freq_hz, bool calibrating, const EngineConfig& config);
-    uint8_t calculate_tracking_peaks(float& weighted_center_freq_hz, const FrequencyData& freqs, const EngineConfig& config);
-    // calculate noise peak frequency characteristics
-    bool calculate_filtered_noise(FrequencyPeak target_peak, FrequencyPeak source_peak, const FrequencyData& freqs, const EngineConfig& config);
-    void update_snr_values(const FrequencyData& freqs);
-    // get the weighted frequency
-    bool get_weighted_frequency(FrequencyPeak peak, float& weighted_peak_freq_hz, float& snr, const EngineConfig& config) const;
     // return the tracked noise peak
-    FrequencyPeak get_tracked_noise_peak() const;
-    // calculate the distance matrix between the current estimates and the current cycle
-    void find_distance_matrix(DistanceMatrix& distance_matrix, const FrequencyData& freqs, const EngineConfig& config) const;
-    // return the instantaneous peak that is closest to the target estimate peak
-    FrequencyPeak find_closest_peak(const FrequencyPeak target, const DistanceMatrix& distance_matrix, uint8_t ignore = 0) const;
-    // detected peak frequency weighted by energy
-    float calculate_weighted_freq_hz(const Vector3f& energy, const Vector3f& freq) const;
-    // update the estimation of the background noise energy
-    void update_ref_energy(uint16_t max_bin);
+    FrequencyPeak get_tracked_noise_peak(const IMUState& imu) const {
+        return AP_GyroFFT_Tracker::get_tracked_noise_peak(imu._global_state, _harmonic_peak, _harmonic_fit);
+    }
+    // frequency values of a single IMU
+    float get_weighted_freq_hz(const IMUState& imu, FrequencyPeak peak) const {
+        return AP_GyroFFT_Tracker::get_weighted_freq_hz(imu._global_state, peak);
+    }
+    uint8_t get_weighted_noise_center_frequencies_hz(const IMUState& imu, uint8_t num_freqs, float* freqs) const {
+        return AP_GyroFFT_Tracker::get_weighted_noise_center_frequencies_hz(imu._global_state, imu._health, _harmonic_peak, num_freqs, freqs);
+    }
     // test frequency detection for all of the allowable bins
     float self_test_bin_frequencies();
     // detect the provided frequency
-    float self_test(float frequency, FloatBuffer& test_window);
+    float self_test(float frequency, FloatBuffer& test_window, const EngineConfig& config);
     // whether to run analysis or not
     bool analysis_enabled() const { return _initialized && _analysis_enabled && _thread_created; };
     // whether analysis can be run again or not
     bool start_analysis();
-    // return samples available in the gyro window
-    uint16_t get_available_samples(uint8_t axis) {
-        return _sample_mode == 0 ?_ins->get_raw_gyro_window(axis).available() : _downsampled_gyro_data[axis].available();
+    // return the gyro window of the given IMU
+    FloatBuffer& get_gyro_window(IMUState& imu, uint8_t axis) {
+        if (_sample_mode != 0) {
+            return imu._downsampled_gyro_data[axis];
+        }
+        return analysing_all_imus() ? _ins->get_raw_gyro_window(imu._instance, axis) : _ins->get_raw_gyro_window(axis);
     }
+    // return samples available in the gyro window, the axes fill together so the least is taken
+    uint16_t get_available_samples(IMUState& imu) {
+        return MIN(MIN(get_gyro_window(imu, 0).available(), get_gyro_window(imu, 1).available()), get_gyro_window(imu, 2).available());
+    }
+    // the IMU whose results are used for the single IMU accessors
+    uint8_t get_primary_imu_index() const;
+    const IMUState& get_primary_imu() const { return _imus[get_primary_imu_index()]; }
     void update_parameters(bool force);
     // semaphore for access to shared FFT data
     HAL_Semaphore _sem;
 
     // data set from the FFT thread but accessible from the main thread protected by the semaphore
-    struct EngineState {
-        // energy of the detected peak frequency in dB
-        Vector3f _center_freq_energy_db;
-        // detected peak frequency
-        Vector3f _center_freq_hz;
-        // fit between first and second harmonics
-        Vector3f _harmonic_fit;
-        // bin of detected peak frequency
-        Vector3ui _center_freq_bin;
-        // fft engine health
-        Vector3<uint8_t> _health;
+    struct EngineState : public AP_GyroFFT_Tracker::State {
+        // when each axis last had a signal
         Vector3ul _health_ms;
         // fft engine output rate
         uint32_t _output_cycle_ms;
-        // tracked frequency peak for the purposes of notching
-        Vector3<uint8_t> _tracked_peak;
-        // center frequency peak ignoring temporary energy changes / order switching
-        Vector3<uint8_t> _center_peak;
-        // signal to noise ratio of PSD at each of the detected centre frequencies
-        Vector3f _center_freq_snr[FrequencyPeak::MAX_TRACKED_PEAKS];
-        // filtered version of the peak frequency
-        Vector3f _center_freq_hz_filtered[FrequencyPeak::MAX_TRACKED_PEAKS];
         // when we last calculated a value
         Vector3ul _last_output_us;
-        // filtered energy of the detected peak frequency
-        Vector3f _center_freq_energy_filtered[FrequencyPeak::MAX_TRACKED_PEAKS];
-        // filtered detected peak width
-        Vector3f _center_bandwidth_hz_filtered[FrequencyPeak::MAX_TRACKED_PEAKS];
-        // axes that still require noise calibration
-        uint8_t _noise_needs_calibration;
         // whether the analyzer is mid-cycle
         bool _analysis_started;
     };
 
-    // Shared FFT engine state local to the FFT thread
-    EngineState _thread_state;
-    // Shared FFT engine state accessible by the main thread
-    EngineState _global_state;
+    // analysis state of a single IMU, the FFT window state is shared between all of them
+    struct IMUState {
+        // Shared FFT engine state local to the FFT thread
+        EngineState _thread_state;
+        // Shared FFT engine state accessible by the main thread
+        EngineState _global_state;
+        // downsampled gyro data circular buffer for frequency analysis
+        FloatBuffer _downsampled_gyro_data[XYZ_AXIS_COUNT];
+        // accumulator for sampled gyro data
+        Vector3f _oversampled_gyro_accum;
+        // peak detection and tracking
+        AP_GyroFFT_Tracker _tracker;
+        // engine health in tracked peaks per axis
+        Vector3<uint8_t> _health;
+        // engine health on roll/pitch/yaw
+        Vector3<uint8_t> _rpy_health;
+        // IMU instance being analysed when analysing all IMUs, only IMUs sampled at
+        // _fft_sampling_rate_hz are analysed
+        uint8_t _instance;
+    };
+
+    // per-IMU analysis state, only the primary IMU unless all IMUs are analysed
+    IMUState* _imus;
+    uint8_t _num_imus;
+    // every axis analysed each frame, always the case when all IMUs are analysed
+    bool _all_axes;
 
     // number of samples needed before a new frame can be processed
     uint16_t _samples_per_frame;
@@ -274,51 +238,25 @@ private:
     uint16_t _frame_time_ms;
     // last cycle time
     uint32_t _output_cycle_micros;
-    // downsampled gyro data circular buffer for frequency analysis
-    FloatBuffer _downsampled_gyro_data[XYZ_AXIS_COUNT];
-    // accumulator for sampled gyro data
-    Vector3f _oversampled_gyro_accum;
     // count of oversamples
     uint16_t _oversampled_gyro_count;
 
     // state of the FFT engine
     AP_HAL::DSP::FFTWindowState* _state;
     // update state machine step information
+    IMUState* _update_imu;
     uint8_t _update_axis;
-    // noise base of the gyros
-    Vector3f* _ref_energy;
-    // the number of cycles required to have a proper noise reference
-    uint16_t _noise_cycles;
-    // number of cycles over which to generate noise ensemble averages
-    uint16_t _noise_calibration_cycles[XYZ_AXIS_COUNT];
     // current _sample_mode
     uint8_t _current_sample_mode;
     // harmonic multiplier for two highest peaks
     float _harmonic_multiplier;
     // number of tracked peaks
     uint8_t _tracked_peaks;
-    // engine health in tracked peaks per axis
-    Vector3<uint8_t> _health;
-    // engine health on roll/pitch/yaw
-    Vector3<uint8_t> _rpy_health;
     // averaged throttle output over averaging period
     float _avg_throttle_out;
 
-    // smoothing filter on the output
-    MedianLowPassFilter3dFloat _center_freq_filter[FrequencyPeak::MAX_TRACKED_PEAKS];
-    // smoothing filter on the energy
-    MedianLowPassFilter3dFloat _center_freq_energy_filter[FrequencyPeak::MAX_TRACKED_PEAKS];
-    // smoothing filter on the bandwidth
-    MedianLowPassFilter3dFloat _center_bandwidth_filter[FrequencyPeak::MAX_TRACKED_PEAKS];
-    // smoothing filter on the frequency fit
-    LowPassFilterConstDtFloat _harmonic_fit_filter[XYZ_AXIS_COUNT];
-
     // configured sampling rate
     uint16_t _fft_sampling_rate_hz;
-    // number of cycles without a detected signal
-    uint8_t _missed_cycles[XYZ_AXIS_COUNT][FrequencyPeak::MAX_TRACKED_PEAKS];
-    // number of cycles where peaks have swapped places
-    uint8_t _distorted_cycles[XYZ_AXIS_COUNT];
     // whether the analyzer initialized correctly
     bool _initialized;
 
@@ -0,0 +1,497 @@
+/*
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+   Code by Andy Piper with help from betaflight
+ */
+
+#include "AP_GyroFFT_Tracker.h"
+
+#if HAL_WITH_DSP
+
+#include <Filter/HarmonicNotchFilter.h>
+#include <stdio.h>
+
+// allocate the noise reference and set up the filters and state
+bool AP_GyroFFT_Tracker::init(uint16_t window_size, uint16_t samples_per_frame, float sample_rate_hz, bool post_filter,
+                              uint16_t fft_min_hz, State& state)
+{
+    _window_size = window_size;
+    _samples_per_frame = samples_per_frame;
+
+    delete[] _ref_energy;
+    _ref_energy = NEW_NOTHROW Vector3f[_window_size];
+    if (_ref_energy == nullptr) {
+        return false;
+    }
+
+    // The update rate for the output, defaults are 1Khz / (1 - 0.5) * 32 == 62hz
+    const float output_rate = sample_rate_hz / static_cast<float>(_samples_per_frame);
+    // filter more aggressively post-filter since the noise is harder to detect
+    const float scale_factor = post_filter ? 0.1f : 1.0f;
+
+    state._noise_needs_calibration = 0x07; // all axes need calibration
+
+    // establish suitable defaults for the detected values
+    for (uint8_t axis = 0; axis < XYZ_AXIS_COUNT; axis++) {
+        state._center_freq_hz[axis] = fft_min_hz;
+
+        for (uint8_t peak = 0; peak < FrequencyPeak::MAX_TRACKED_PEAKS; peak++) {
+            state._center_freq_hz_filtered[axis][peak] = fft_min_hz;
+        }
+        // number of cycles to average over, two complete windows to be sure
+        _noise_calibration_cycles[axis] = (_window_size / _samples_per_frame) * 2;
+        // harmonic frequency fit should change relatively slowly
+        _harmonic_fit_filter[axis].set_cutoff_frequency(output_rate, MIN(output_rate * 0.48f, FFT_HARMONIC_FIT_FILTER_HZ));
+    }
+
+    // configure a filter for frequency, bandwidth and energy for each of the three tracked noise peaks
+    for (uint8_t peak = 0; peak < FrequencyPeak::MAX_TRACKED_PEAKS; peak++) {
+        // calculate low-pass filter characteristics based on window size and overlap
+        _center_freq_filter[peak].set_cutoff_frequency(output_rate, output_rate * 0.48f * scale_factor);
+        // the bin energy jumps around a lot so requires more filtering
+        _center_freq_energy_filter[peak].set_cutoff_frequency(output_rate, output_rate * 0.25f * scale_factor);
+        // smooth the bandwidth output more aggressively
+        _center_bandwidth_filter[peak].set_cutoff_frequency(output_rate, output_rate * 0.25f * scale_factor);
+    }
+
+    // the number of cycles required to have a proper noise reference
+    _noise_cycles = (_window_size / _samples_per_frame) * XYZ_AXIS_COUNT;
+
+    return true;
+}
+
+// number of noise peaks needed for the notched harmonics and dynamic notches
+uint8_t AP_GyroFFT_Tracker::calculate_tracked_peaks(uint32_t harmonics, uint8_t num_notches)
+{
+    return constrain_int16(MAX(__builtin_popcount(harmonics), num_notches), 1, FrequencyPeak::MAX_TRACKED_PEAKS);
+}
+
+// calculate harmonic multiplier. this assumes the harmonics configured on the
+// harmonic notch reflect the multiples of the fundamental harmonic that should be tracked
+float AP_GyroFFT_Tracker::calculate_harmonic_multiplier(uint32_t harmonics)
+{
+    uint8_t first_harmonic = 0;
+    for (uint8_t i = 0; i < HNF_MAX_HARMONICS; i++) {
+        if (harmonics & (1<<i)) {
+            if (first_harmonic == 0) {
+                first_harmonic = i + 1;
+            } else {
+                return float(i + 1) / first_harmonic;
+            }
+        }
+    }
+    // if no harmonic specified then select a simple 2x multiple
+    return 2.0f;
+}
+
+// return the noise peak that is being tracked
+AP_GyroFFT_Tracker::FrequencyPeak AP_GyroFFT_Tracker::get_tracked_noise_peak(const State& state, int8_t harmonic_peak, float harmonic_fit)
+{
+    // if the user has specified a specific axis to track then use that
+    if (harmonic_peak > FrequencyPeak::MAX_TRACKED_PEAKS) {
+        switch (harmonic_peak) {
+        case FFT_HARMONIC_FIT_TRACK_ROLL:
+            if (state._harmonic_fit.x < harmonic_fit) {
+                return FrequencyPeak(state._tracked_peak.x);
+            }
+            break;
+        case FFT_HARMONIC_FIT_TRACK_PITCH:
+            if (state._harmonic_fit.y < harmonic_fit) {
+                return FrequencyPeak(state._tracked_peak.y);
+            }
+            break;
+        default:
+            break;
+        }
+        return FrequencyPeak::CENTER;
+    }
+    // if the user has specified a specific peak to track then use that
+    if (harmonic_peak > 0) {
+        return FrequencyPeak(constrain_int16(harmonic_peak - 1, FrequencyPeak::CENTER, FrequencyPeak::UPPER_SHOULDER));
+    }
+
+    // required fit of 10% is fairly conservative when testing in SITL, testing shows that it's safer to
+    // require both tracked axes to fit - biasing towards the highest energy peak
+    if (state._harmonic_fit.x < harmonic_fit && state._harmonic_fit.y < harmonic_fit) {
+        return FrequencyPeak(state._tracked_peak.x);
+    }
+
+    return FrequencyPeak::CENTER;
+}
+
+// weighted center frequency
+float AP_GyroFFT_Tracker::get_weighted_freq_hz(const State& state, FrequencyPeak peak)
+{
+    return calculate_weighted_freq_hz(state._center_freq_energy_filtered[peak], state._center_freq_hz_filtered[peak]);
+}
+
+float AP_GyroFFT_Tracker::calculate_weighted_freq_hz(const Vector3f& energy, const Vector3f& freq)
+{
+    // there is generally a lot of high-energy, slightly lower frequency noise on yaw, however this
+    // appears to be a second-order effect as only targetting pitch and roll (x & y) produces much cleaner output all round
+    if (!energy.is_nan() && !is_zero(energy.x) && !is_zero(energy.y)) {
+        return (freq.x * energy.x + freq.y * energy.y)
+            / (energy.x + energy.y);
+    }
+    else {
+        return (freq.x + freq.y) * 0.5f;
+    }
+}
+
+// return an average center frequency weighted by bin energy
+float AP_GyroFFT_Tracker::get_weighted_noise_center_freq_hz(const State& state, const Vector3<uint8_t>& health,
+                                                            int8_t harmonic_peak, float harmonic_fit)
+{
+    const FrequencyPeak peak = get_tracked_noise_peak(state, harmonic_peak, harmonic_fit);
+    // pitch was good or required, roll was not, use pitch only
+    if (!health.x || harmonic_peak == FFT_HARMONIC_FIT_TRACK_PITCH) {
+        return state._center_freq_hz_filtered[peak].y;    // Y-axis
+    }
+    // roll was good or required, pitch was not, use roll only
+    if (!health.y || harmonic_peak == FFT_HARMONIC_FIT_TRACK_ROLL) {
+        return state._center_freq_hz_filtered[peak].x;    // X-axis
+    }
+
+    return get_weighted_freq_hz(state, peak);
+}
+
+// return all the center frequencies weighted by bin energy
+uint8_t AP_GyroFFT_Tracker::get_weighted_noise_center_frequencies_hz(const State& state, const Vector3<uint8_t>& health,
+                                                                     int8_t harmonic_peak, uint8_t num_freqs, float* freqs)
+{
+    // pitch was good or required, roll was not, use pitch only
+    if (!health.x || harmonic_peak == FFT_HARMONIC_FIT_TRACK_PITCH) {
+        const uint8_t tracked_peaks = MIN(health.y, num_freqs);
+        for (uint8_t i = 0; i < tracked_peaks; i++) {
+            freqs[i] = state._center_freq_hz_filtered[i].y;    // Y-axis
+        }
+        return tracked_peaks;
+    }
+    // roll was good or required, pitch was not, use roll only
+    if (!health.y || harmonic_peak == FFT_HARMONIC_FIT_TRACK_ROLL) {
+        const uint8_t tracked_peaks = MIN(health.x, num_freqs);
+        for (uint8_t i = 0; i < tracked_peaks; i++) {
+            freqs[i] = state._center_freq_hz_filtered[i].x;    // X-axis
+        }
+        return tracked_peaks;
+    }
+
+    const uint8_t tracked_peaks = MIN(MAX(health.x, health.y), num_freqs);
+    for (uint8_t i = 0; i < tracked_peaks; i++) {
+        freqs[i] = get_weighted_freq_hz(state, FrequencyPeak(i));
+    }
+    return tracked_peaks;
+}
+
+// calculate noise frequencies from FFT data provided by the HAL subsystem
+uint8_t AP_GyroFFT_Tracker::calculate_noise(AP_HAL::DSP::FFTWindowState& fft, uint8_t axis, bool calibrating,
+                                            const Config& config, State& state)
+{
+    // calculate the SNR and center frequency energy
+    float weighted_center_freq_hz = 0.0f;
+
+    uint8_t num_peaks = calculate_tracking_peaks(fft, axis, weighted_center_freq_hz, calibrating, config, state);
+
+    state._center_freq_bin[axis] = fft._peak_data[state._center_peak[axis]]._bin;
+    state._center_freq_hz[axis] = weighted_center_freq_hz;
+    state._health[axis] = num_peaks;
+    FrequencyPeak tracked_peak = FrequencyPeak::CENTER;
+
+    const Vector3f* freq_hz = state._center_freq_hz_filtered;
+    const Vector3f* energy = state._center_freq_energy_filtered;
+
+    // record the tracked peak for harmonic fit, but only if we have more than one noise peak
+    // this checks filtered energies and so can allow energies to be closer together
+    if (num_peaks > 1 && config._tracked_peaks > 1 && !is_zero(freq_hz[FrequencyPeak::CENTER][axis])) {
+        if (freq_hz[FrequencyPeak::CENTER][axis] > freq_hz[FrequencyPeak::LOWER_SHOULDER][axis]
+            // ignore the fit if there is too big a discrepancy between the energies
+            && energy[FrequencyPeak::CENTER][axis] < energy[FrequencyPeak::LOWER_SHOULDER][axis] * FFT_HARMONIC_FIT_MULT) {
+            tracked_peak = FrequencyPeak::LOWER_SHOULDER;
+        } else if (num_peaks > 2 && freq_hz[FrequencyPeak::CENTER][axis] > freq_hz[FrequencyPeak::UPPER_SHOULDER][axis]
+            // ignore the fit if there is too big a discrepancy between the energies
+            && energy[FrequencyPeak::CENTER][axis] < energy[FrequencyPeak::UPPER_SHOULDER][axis] * FFT_HARMONIC_FIT_MULT) {
+            tracked_peak = FrequencyPeak::UPPER_SHOULDER;
+        }
+    }
+
+    state._tracked_peak[axis] = tracked_peak;
+
+    // if targetting more than one harmonic then make sure we get the fundamental
+    // on larger copters the second harmonic often has more energy
+    // if the highest peak is above the second highest then check for harmonic fit
+    // comparisons are made using filter, normalised data
+    if (state._tracked_peak[axis] != FrequencyPeak::CENTER) {
+        // calculate the fit and filter at 10hz
+        const float harmonic_fit = 100.0f * fabsf(freq_hz[FrequencyPeak::CENTER][axis]
+            - freq_hz[tracked_peak][axis] * config._harmonic_multiplier)
+            / freq_hz[FrequencyPeak::CENTER][axis];
+
+        // calculate the fit and filter at 10hz
+        if (isfinite(harmonic_fit)) {
+            state._harmonic_fit[axis] = _harmonic_fit_filter[axis].apply(harmonic_fit);
+        }
+    } else {
+        state._harmonic_fit[axis] = 100.0f;
+    }
+
+    return num_peaks;
+}
+
+// calculate noise peaks based on the frequencies closest to the recent historical average, switching peaks around as necessary
+uint8_t AP_GyroFFT_Tracker::calculate_tracking_peaks(AP_HAL::DSP::FFTWindowState& fft, uint8_t axis, float& weighted_center_freq_hz,
+                                                     bool calibrating, const Config& config, State& state)
+{
+    uint8_t num_peaks = 0;
+    FrequencyData freqs(*this, fft, axis, config, state);
+
+    // the noise peaks are returned by the HAL in decreasing order of magnitude, however each peak can temporarily
+    // switch places with another depending on a whole host of hardware and software factors
+    // thus we must be able to temporarily reassign the peaks so that the filtered values track
+    // a continuous frequency
+    DistanceMatrix distance_matrix;
+    find_distance_matrix(distance_matrix, axis, freqs, state);
+
+    FrequencyPeak center = find_closest_peak(FrequencyPeak::CENTER, distance_matrix);
+    FrequencyPeak lower = find_closest_peak(FrequencyPeak::LOWER_SHOULDER, distance_matrix, 1 << center);
+    FrequencyPeak upper = find_closest_peak(FrequencyPeak::UPPER_SHOULDER, distance_matrix, 1 << center | 1 << lower);
+
+    // if we have had the maximum number of swapped cycles, force a full calculation
+    if (calibrating || _distorted_cycles[axis] == 0) {
+        num_peaks = calculate_tracking_peaks(fft, axis, weighted_center_freq_hz, freqs, config, state);
+#if DEBUG_FFT
+        printf("Skipped update, order would have been is %d/%.1f(%.1f) %d/%.1f(%.1f) %d/%.1f(%.1f) n = %d\n",
+            center, fft._peak_data[center]._freq_hz, state._center_freq_hz_filtered[FrequencyPeak::CENTER][axis],
+            lower, fft._peak_data[lower]._freq_hz, state._center_freq_hz_filtered[FrequencyPeak::LOWER_SHOULDER][axis],
+            upper, fft._peak_data[upper]._freq_hz, state._center_freq_hz_filtered[FrequencyPeak::UPPER_SHOULDER][axis], num_peaks);
+#endif
+        return num_peaks;
+    }
+
+    // another peak is closer to what is currently considered the center frequency
+    if (center != FrequencyPeak::CENTER || lower != FrequencyPeak::LOWER_SHOULDER || upper != FrequencyPeak::UPPER_SHOULDER) {
+        if (lower != FrequencyPeak::NONE && calculate_filtered_noise(fft, axis, FrequencyPeak::LOWER_SHOULDER, lower, freqs, config, state)) {
+            num_peaks++;
+        } else {
+            lower = FrequencyPeak::NONE;
+        }
+        if (upper != FrequencyPeak::NONE && calculate_filtered_noise(fft, axis, FrequencyPeak::UPPER_SHOULDER, upper, freqs, config, state)) {
+            num_peaks++;
+        } else {
+            upper = FrequencyPeak::NONE;
+        }
+        if (center != FrequencyPeak::NONE && calculate_filtered_noise(fft, axis, FrequencyPeak::CENTER,  center, freqs, config, state)) {
+            num_peaks++;
+        } else {
+            center = FrequencyPeak::NONE;
+        }
+        weighted_center_freq_hz = freqs.get_weighted_frequency(center);
+        state._center_peak[axis] = center;
+        update_snr_values(axis, freqs, state);
+        // if two adjacent peaks have simply swapped, we will allow this to continue indefinitely
+        // as there is no loss of fidelity
+        if (!((center == FrequencyPeak::LOWER_SHOULDER && lower == FrequencyPeak::CENTER)
+            || (center == FrequencyPeak::UPPER_SHOULDER && upper == FrequencyPeak::CENTER))) {
+            _distorted_cycles[axis]--;
+        }
+        return num_peaks;
+    }
+
+    num_peaks = calculate_tracking_peaks(fft, axis, weighted_center_freq_hz, freqs, config, state);
+
+    return num_peaks;
+}
+
+// calculate the noise and whether valid for each peak
+uint8_t AP_GyroFFT_Tracker::calculate_tracking_peaks(AP_HAL::DSP::FFTWindowState& fft, uint8_t axis, float& weighted_center_freq_hz,
+                                                     const FrequencyData& freqs, const Config& config, State& state)
+{
+    uint8_t num_peaks = 0;
+    if (calculate_filtered_noise(fft, axis, FrequencyPeak::LOWER_SHOULDER, FrequencyPeak::LOWER_SHOULDER, freqs, config, state)) {
+        num_peaks++;
+    }
+    if (calculate_filtered_noise(fft, axis, FrequencyPeak::UPPER_SHOULDER, FrequencyPeak::UPPER_SHOULDER, freqs, config, state)) {
+        num_peaks++;
+    }
+    if (calculate_filtered_noise(fft, axis, FrequencyPeak::CENTER, FrequencyPeak::CENTER, freqs, config, state)) {
+        num_peaks++;
+    }
+    // record the number of cycles where something was tracked
+    _distorted_cycles[axis] = constrain_int16(_distorted_cycles[axis] + 1, 0, FFT_MAX_MISSED_UPDATES);
+    weighted_center_freq_hz = freqs.get_weighted_frequency(FrequencyPeak::CENTER);
+    state._center_peak[axis] = FrequencyPeak::CENTER;
+
+    update_snr_values(axis, freqs, state);
+
+    return num_peaks;
+}
+
+// calculate noise frequencies from FFT data provided by the HAL subsystem
+// target_peak is the filtered record we want to apply the new fft data to, source peak is where the fft data is coming from
+bool AP_GyroFFT_Tracker::calculate_filtered_noise(AP_HAL::DSP::FFTWindowState& fft, uint8_t axis, FrequencyPeak target_peak, FrequencyPeak source_peak,
+                                                  const FrequencyData& freqs, const Config& config, State& state)
+{
+    if (source_peak > FrequencyPeak::MAX_TRACKED_PEAKS) {
+        // if we failed to find a signal, carry on using the previous readings
+        if (_missed_cycles[axis][target_peak]++ < FFT_MAX_MISSED_UPDATES) {
+            return true; // the peak is synthetic
+        }
+        update_center_freq_energy(state, target_peak, axis, 0.0f);
+        update_noise_center_bandwidth_hz(state, target_peak, axis, config._bandwidth_hover_hz);
+        update_noise_center_freq_hz(state, target_peak, axis, config._fft_min_hz);
+        return false;
+    }
+
+    AP_HAL::DSP::FrequencyPeakData* peak_data = &fft._peak_data[source_peak];
+
+    const uint16_t nb = peak_data->_bin;
+
+    if (freqs.is_valid(FrequencyPeak(source_peak))) {
+        // total peak energy requires an integration, as an approximation use amplitude * noise width * 5/6
+        update_center_freq_energy(state, target_peak, axis, fft.get_freq_bin(nb) * peak_data->_noise_width_hz * 0.8333f);
+        update_noise_center_bandwidth_hz(state, target_peak, axis, peak_data->_noise_width_hz);
+        update_noise_center_freq_hz(state, target_peak, axis, freqs.get_weighted_frequency(FrequencyPeak(source_peak)));
+        _missed_cycles[axis][target_peak] = 0;
+        return true;
+    }
+
+    // if we failed to find a signal, carry on using the previous readings
+    if (_missed_cycles[axis][target_peak]++ < FFT_MAX_MISSED_UPDATES) {
+        return true; // the peak is synthetic
+    }
+
+    // we failed to find a signal for more than FFT_MAX_MISSED_UPDATES cycles
+    update_center_freq_energy(state, target_peak, axis, fft.get_freq_bin(nb) * peak_data->_noise_width_hz * 0.8333f);     // use the actual energy detected rather than 0
+    update_noise_center_bandwidth_hz(state, target_peak, axis, config._bandwidth_hover_hz);
+    update_noise_center_freq_hz(state, target_peak, axis, config._fft_min_hz);
+
+    return false;
+}
+
+void AP_GyroFFT_Tracker::update_snr_values(uint8_t axis, const FrequencyData& freqs, State& state) const
+{
+    state._center_freq_snr[FrequencyPeak::CENTER][axis] = freqs.get_signal_to_noise(FrequencyPeak::CENTER);
+    state._center_freq_snr[FrequencyPeak::LOWER_SHOULDER][axis] = freqs.get_signal_to_noise(FrequencyPeak::LOWER_SHOULDER);
+    state._center_freq_snr[FrequencyPeak::UPPER_SHOULDER][axis] = freqs.get_signal_to_noise(FrequencyPeak::UPPER_SHOULDER);
+}
+
+// filter values through a median sliding window followed by low pass filter
+// this eliminates temporary spikes in the detected frequency that are either pure noise
+// or a different peak that will erroneously bias the peak we are tracking
+float AP_GyroFFT_Tracker::MedianLowPassFilter3dFloat::apply(uint8_t axis, float sample)
+{
+    _median_filter[axis].apply(sample);
+    const float a = _median_filter[axis].get_sample(0);
+    const float b = _median_filter[axis].get_sample(1);
+    const float c = _median_filter[axis].get_sample(2);
+    float median = MAX(MIN(a, b), MIN(MAX(a, b), c));
+    return _lowpass_filter[axis].apply(median);
+}
+
+// initialize a FrequencyData structure with peak frequency information for use in the swapping algorithm
+AP_GyroFFT_Tracker::FrequencyData::FrequencyData(const AP_GyroFFT_Tracker& tracker, AP_HAL::DSP::FFTWindowState& fft, uint8_t axis,
+                                                 const Config& config, const State& state)
+{
+    for (uint8_t i = 0; i < FrequencyPeak::MAX_TRACKED_PEAKS; i++) {
+        valid[i] = tracker.get_weighted_frequency(fft, axis, FrequencyPeak(i), frequency[i], snr[i], config, state);
+    }
+}
+
+// calculate noise frequencies from FFT data provided by the HAL subsystem
+bool AP_GyroFFT_Tracker::get_weighted_frequency(AP_HAL::DSP::FFTWindowState& fft, uint8_t axis, FrequencyPeak peak, float& weighted_peak_freq_hz,
+                                                float& snr, const Config& config, const State& state) const
+{
+    AP_HAL::DSP::FrequencyPeakData* peak_data = &fft._peak_data[peak];
+
+    const uint16_t bin = peak_data->_bin;
+
+    // calculate the SNR and center frequency energy
+    const float max_energy = MAX(1.0f, fft.get_freq_bin(bin));
+    const float ref_energy = MAX(1.0f, _ref_energy[bin][axis]);
+    snr = 10.f * (log10f(max_energy) - log10f(ref_energy));
+
+    // if the bin energy is above the noise threshold then we have a signal
+    if (!state._noise_needs_calibration && isfinite(fft.get_freq_bin(bin)) && snr > config._snr_threshold_db) {
+        weighted_peak_freq_hz = constrain_float(peak_data->_freq_hz, (float)config._fft_min_hz, (float)config._fft_max_hz);
+        return true;
+    }
+
+    weighted_peak_freq_hz = (float)config._fft_min_hz;
+
+    return false;
+}
+
+// calculate a matrix of distances between the current filtered estimates and instantaneous values from the current cycle
+void AP_GyroFFT_Tracker::find_distance_matrix(DistanceMatrix& distance_matrix, uint8_t axis, const FrequencyData& freqs, const State& state) const
+{
+    float curr_freqs[FrequencyPeak::MAX_TRACKED_PEAKS];
+    // get the current frequency estimate for all peaks
+    for (uint8_t i = 0; i < FrequencyPeak::MAX_TRACKED_PEAKS; i++) {
+        curr_freqs[i] = state._center_freq_hz_filtered[i][axis];
+    }
+    // calculate the matrix
+    for (uint8_t i = 0; i < FrequencyPeak::MAX_TRACKED_PEAKS; i++) {
+        for (uint8_t j = 0; j < FrequencyPeak::MAX_TRACKED_PEAKS; j++) {
+            distance_matrix[i][j] = fabsf((freqs.is_valid(FrequencyPeak(i)) ?
+                freqs.get_weighted_frequency(FrequencyPeak(i)) : FLT_MAX) - curr_freqs[j]);
+        }
+    }
+}
+
+// return the instantaneous peak that is closest to the target estimate peak
+AP_GyroFFT_Tracker::FrequencyPeak AP_GyroFFT_Tracker::find_closest_peak(const FrequencyPeak target, const DistanceMatrix& distance_matrix, uint8_t ignore) const
+{
+    // find the closest peak to target
+    uint8_t closest = target;
+    for (uint8_t i = 0; i < FrequencyPeak::MAX_TRACKED_PEAKS; i++) {
+        if (distance_matrix[i][target] < distance_matrix[closest][target] && (1 << i & ~ignore)) {
+            closest = i;
+        }
+    }
+    // didn't find anything
+    if (!(1<<closest & ~ignore)) {
+        return FrequencyPeak::NONE;
+    }
+    return FrequencyPeak(closest);
+}
+
+// calculate noise baseline from FFT data provided by the HAL subsystem
+void AP_GyroFFT_Tracker::update_ref_energy(AP_HAL::DSP::FFTWindowState& fft, uint8_t axis, State& state, HAL_Semaphore& sem)
+{
+    if (!state._noise_needs_calibration) {
+        return;
+    }
+
+    // according to https://www.tcd.ie/Physics/research/groups/magnetism/files/lectures/py5021/MagneticSensors3.pdf sensor noise is not necessarily gaussian
+    // determine a PS noise reference at each of the possible center frequencies
+    if (_noise_cycles == 0 && _noise_calibration_cycles[axis] > 0) {
+        for (uint16_t i = 1; i < fft._bin_count; i++) {
+            _ref_energy[i][axis] += fft.get_freq_bin(i);
+        }
+        if (--_noise_calibration_cycles[axis] == 0) {
+            for (uint16_t i = 1; i < fft._bin_count; i++) {
+                const float cycles = (static_cast<float>(_window_size) / static_cast<float>(_samples_per_frame)) * 2;
+                // overall random noise is reduced by sqrt(N) when averaging periodigrams so adjust for that
+                _ref_energy[i][axis] = (_ref_energy[i][axis] / cycles) * sqrtf(cycles);
+            }
+
+            WITH_SEMAPHORE(sem);
+            state._noise_needs_calibration &= ~(1 << axis);
+        }
+    }
+    else if (_noise_cycles > 0) {
+        _noise_cycles--;
+    }
+}
+
+#endif // HAL_WITH_DSP
@@ -0,0 +1,213 @@
+/*
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+    Code by Andy Piper
+ */
+#pragma once
+
+#include <AP_HAL/AP_HAL.h>
+
+#if HAL_WITH_DSP
+
+#include <AP_Common/AP_Common.h>
+#include <AP_Math/AP_Math.h>
+#include <Filter/LowPassFilter.h>
+#include <Filter/FilterWithBuffer.h>
+
+#define DEBUG_FFT   0
+
+#define FFT_HARMONIC_FIT_FILTER_HZ  15.0f
+#define FFT_HARMONIC_FIT_MULT       50.0f
+#define FFT_HARMONIC_FIT_TRACK_ROLL    4
+#define FFT_HARMONIC_FIT_TRACK_PITCH   5
+
+/*
+  detection and tracking of the noise peaks in the FFT output of the
+  three gyro axes of one IMU. AP_GyroFFT runs one per analysed IMU on
+  the FFT thread, offline tools run it over logged gyro samples
+ */
+class AP_GyroFFT_Tracker
+{
+public:
+    typedef AP_HAL::DSP::FrequencyPeak FrequencyPeak;
+
+    AP_GyroFFT_Tracker() { }
+    ~AP_GyroFFT_Tracker() { delete[] _ref_energy; }
+
+    // Do not allow copies
+    CLASS_NO_COPY(AP_GyroFFT_Tracker);
+
+    // settings read by the tracking each cycle
+    struct Config {
+        // minimum frequency of the detection window
+        uint16_t _fft_min_hz;
+        // maximum frequency of the detection window
+        uint16_t _fft_max_hz;
+        // SNR Threshold
+        float _snr_threshold_db;
+        // number of tracked peaks
+        uint8_t _tracked_peaks;
+        // harmonic multiplier for two highest peaks
+        float _harmonic_multiplier;
+        // peak bandwidth to fall back to when a peak is lost
+        float _bandwidth_hover_hz;
+    };
+
+    // results of the tracking, for all three axes
+    struct State {
+        // energy of the detected peak frequency in dB
+        Vector3f _center_freq_energy_db;
+        // detected peak frequency
+        Vector3f _center_freq_hz;
+        // fit between first and second harmonics
+        Vector3f _harmonic_fit;
+        // bin of detected peak frequency
+        Vector3ui _center_freq_bin;
+        // fft engine health
+        Vector3<uint8_t> _health;
+        // tracked frequency peak for the purposes of notching
+        Vector3<uint8_t> _tracked_peak;
+        // center frequency peak ignoring temporary energy changes / order switching
+        Vector3<uint8_t> _center_peak;
+        // signal to noise ratio of PSD at each of the detected centre frequencies
+        Vector3f _center_freq_snr[FrequencyPeak::MAX_TRACKED_PEAKS];
+        // filtered version of the peak frequency
+        Vector3f _center_freq_hz_filtered[FrequencyPeak::MAX_TRACKED_PEAKS];
+        // filtered energy of the detected peak frequency
+        Vector3f _center_freq_energy_filtered[FrequencyPeak::MAX_TRACKED_PEAKS];
+        // filtered detected peak width
+        Vector3f _center_bandwidth_hz_filtered[FrequencyPeak::MAX_TRACKED_PEAKS];
+        // axes that still require noise calibration
+        uint8_t _noise_needs_calibration;
+    };
+
+    // allocate the noise reference and set up the filters and state for frames of
+    // samples_per_frame samples from a window_size window at sample_rate_hz
+    bool init(uint16_t window_size, uint16_t samples_per_frame, float sample_rate_hz, bool post_filter,
+              uint16_t fft_min_hz, State& state);
+    // update the estimation of the background noise energy from the last analysis of axis
+    void update_ref_energy(AP_HAL::DSP::FFTWindowState& fft, uint8_t axis, State& state, HAL_Semaphore& sem);
+    // track the peaks of the last analysis of axis, returns the number of peaks found
+    uint8_t calculate_noise(AP_HAL::DSP::FFTWindowState& fft, uint8_t axis, bool calibrating,
+                            const Config& config, State& state);
+
+    // number of peaks to track for the notched harmonics and the number of dynamic notches
+    static uint8_t calculate_tracked_peaks(uint32_t harmonics, uint8_t num_notches);
+    // multiple of the first notched harmonic that the second is at
+    static float calculate_harmonic_multiplier(uint32_t harmonics);
+    // return the tracked noise peak
+    static FrequencyPeak get_tracked_noise_peak(const State& state, int8_t harmonic_peak, float harmonic_fit);
+    // roll and pitch frequency of a peak weighted by energy
+    static float get_weighted_freq_hz(const State& state, FrequencyPeak peak);
+    // detected peak frequency weighted by energy
+    static float calculate_weighted_freq_hz(const Vector3f& energy, const Vector3f& freq);
+    // frequency of the tracked peak, health is the number of peaks found on each axis
+    static float get_weighted_noise_center_freq_hz(const State& state, const Vector3<uint8_t>& health,
+                                                   int8_t harmonic_peak, float harmonic_fit);
+    // frequencies of all the tracked peaks
+    static uint8_t get_weighted_noise_center_frequencies_hz(const State& state, const Vector3<uint8_t>& health,
+                                                            int8_t harmonic_peak, uint8_t num_freqs, float* freqs);
+    // background noise energy of a bin
+    float get_ref_energy(uint16_t bin, uint8_t axis) const { return _ref_energy[bin][axis]; }
+
+private:
+    // smoothing filter that first takes the median from a sliding window and then
+    // applies a low pass filter to the result
+    class MedianLowPassFilter3dFloat {
+    public:
+        MedianLowPassFilter3dFloat() { }
+
+        float apply(uint8_t axis, float sample);
+        float get(uint8_t axis) const { return _lowpass_filter[axis].get(); }
+
+        void set_cutoff_frequency(float sample_freq, float cutoff_freq) {
+            for (uint8_t i = 0; i < XYZ_AXIS_COUNT; i++) {
+                _lowpass_filter[i].set_cutoff_frequency(sample_freq, cutoff_freq);
+            }
+        }
+
+    private:
+        LowPassFilterConstDtFloat _lowpass_filter[XYZ_AXIS_COUNT];
+        FilterWithBuffer<float,3> _median_filter[XYZ_AXIS_COUNT];
+    };
+
+    // structure for holding noise peak data while calculating swaps
+    class FrequencyData {
+    public:
+        FrequencyData(const AP_GyroFFT_Tracker& tracker, AP_HAL::DSP::FFTWindowState& fft, uint8_t axis,
+                      const Config& config, const State& state);
+        float get_weighted_frequency(FrequencyPeak i) const { return frequency[i]; }
+        float get_signal_to_noise(FrequencyPeak i) const { return snr[i]; }
+        bool is_valid(FrequencyPeak i) const { return valid[i]; }
+    private:
+        float frequency[FrequencyPeak::MAX_TRACKED_PEAKS];
+        float snr[FrequencyPeak::MAX_TRACKED_PEAKS];
+        bool valid[FrequencyPeak::MAX_TRACKED_PEAKS];
+    };
+    // distance matrix between filtered and instantaneous peaks
+    typedef float DistanceMatrix[FrequencyPeak::MAX_TRACKED_PEAKS][FrequencyPeak::MAX_TRACKED_PEAKS];
+
+    // calculate noise peaks based on energy and history
+    uint8_t calculate_tracking_peaks(AP_HAL::DSP::FFTWindowState& fft, uint8_t axis, float& weighted_center_freq_hz,
+                                     bool calibrating, const Config& config, State& state);
+    uint8_t calculate_tracking_peaks(AP_HAL::DSP::FFTWindowState& fft, uint8_t axis, float& weighted_center_freq_hz,
+                                     const FrequencyData& freqs, const Config& config, State& state);
+    // calculate noise peak frequency characteristics
+    bool calculate_filtered_noise(AP_HAL::DSP::FFTWindowState& fft, uint8_t axis, FrequencyPeak target_peak, FrequencyPeak source_peak,
+                                  const FrequencyData& freqs, const Config& config, State& state);
+    void update_snr_values(uint8_t axis, const FrequencyData& freqs, State& state) const;
+    // get the weighted frequency
+    bool get_weighted_frequency(AP_HAL::DSP::FFTWindowState& fft, uint8_t axis, FrequencyPeak peak, float& weighted_peak_freq_hz,
+                                float& snr, const Config& config, const State& state) const;
+    // calculate the distance matrix between the current estimates and the current cycle
+    void find_distance_matrix(DistanceMatrix& distance_matrix, uint8_t axis, const FrequencyData& freqs, const State& state) const;
+    // return the instantaneous peak that is closest to the target estimate peak
+    FrequencyPeak find_closest_peak(const FrequencyPeak target, const DistanceMatrix& distance_matrix, uint8_t ignore = 0) const;
+
+    // mutators of filtered state
+    float update_noise_center_freq_hz(State& state, FrequencyPeak peak, uint8_t axis, float value) {
+        return (state._center_freq_hz_filtered[peak][axis] = _center_freq_filter[peak].apply(axis, value));
+    }
+    float update_center_freq_energy(State& state, FrequencyPeak peak, uint8_t axis, float value) {
+        return (state._center_freq_energy_filtered[peak][axis] = _center_freq_energy_filter[peak].apply(axis, value));
+    }
+    float update_noise_center_bandwidth_hz(State& state, FrequencyPeak peak, uint8_t axis, float value) {
+        return (state._center_bandwidth_hz_filtered[peak][axis] = _center_bandwidth_filter[peak].apply(axis, value));
+    }
+
+    // size of the FFT window
+    uint16_t _window_size;
+    // number of samples needed before a new frame can be processed
+    uint16_t _samples_per_frame;
+    // noise base of the gyros
+    Vector3f* _ref_energy;
+    // the number of cycles required to have a proper noise reference
+    uint16_t _noise_cycles;
+    // number of cycles over which to generate noise ensemble averages
+    uint16_t _noise_calibration_cycles[XYZ_AXIS_COUNT];
+    // smoothing filter on the output
+    MedianLowPassFilter3dFloat _center_freq_filter[FrequencyPeak::MAX_TRACKED_PEAKS];
+    // smoothing filter on the energy
+    MedianLowPassFilter3dFloat _center_freq_energy_filter[FrequencyPeak::MAX_TRACKED_PEAKS];
+    // smoothing filter on the bandwidth
+    MedianLowPassFilter3dFloat _center_bandwidth_filter[FrequencyPeak::MAX_TRACKED_PEAKS];
+    // smoothing filter on the frequency fit
+    LowPassFilterConstDtFloat _harmonic_fit_filter[XYZ_AXIS_COUNT];
+    // number of cycles without a detected signal
+    uint8_t _missed_cycles[XYZ_AXIS_COUNT][FrequencyPeak::MAX_TRACKED_PEAKS];
+    // number of cycles where peaks have swapped places
+    uint8_t _distorted_cycles[XYZ_AXIS_COUNT];
+};
+
+#endif // HAL_WITH_DSP
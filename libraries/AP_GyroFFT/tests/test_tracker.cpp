@@ -0,0 +1,89 @@
+#include <AP_gtest.h>
+#include <AP_HAL/AP_HAL.h>
+#include <AP_GyroFFT/AP_GyroFFT_Tracker.h>
+
+const AP_HAL::HAL& hal = AP_HAL::get_HAL();
+
+#if HAL_WITH_DSP
+
+TEST(AP_GyroFFT_Tracker, HarmonicSettings)
+{
+    // a peak for each notched harmonic or dynamic notch, up to three
+    EXPECT_EQ(AP_GyroFFT_Tracker::calculate_tracked_peaks(0x03, 1), 2);
+    EXPECT_EQ(AP_GyroFFT_Tracker::calculate_tracked_peaks(0x01, 3), 3);
+    EXPECT_EQ(AP_GyroFFT_Tracker::calculate_tracked_peaks(0xFF, 1), 3);
+
+    EXPECT_FLOAT_EQ(AP_GyroFFT_Tracker::calculate_harmonic_multiplier(0x03), 2.0f);
+    EXPECT_FLOAT_EQ(AP_GyroFFT_Tracker::calculate_harmonic_multiplier(0x05), 3.0f);
+    EXPECT_FLOAT_EQ(AP_GyroFFT_Tracker::calculate_harmonic_multiplier(0x06), 1.5f);
+    EXPECT_FLOAT_EQ(AP_GyroFFT_Tracker::calculate_harmonic_multiplier(0x01), 2.0f);
+}
+
+/*
+  calibrate against low level sensor noise, then follow a motor peak
+  on roll and pitch, analysing every axis each frame
+ */
+TEST(AP_GyroFFT_Tracker, TracksPeak)
+{
+    const uint16_t window_size = 64;
+    const uint16_t samples_per_frame = 32;
+    const uint16_t rate_hz = 1000;
+    const float peak_hz = 130;
+
+    AP_HAL::DSP::FFTWindowState *fft = hal.dsp->fft_init(window_size, rate_hz);
+    ASSERT_NE(fft, nullptr);
+    FloatBuffer buffers[XYZ_AXIS_COUNT];
+    for (uint8_t axis = 0; axis < XYZ_AXIS_COUNT; axis++) {
+        ASSERT_TRUE(buffers[axis].set_size(window_size + samples_per_frame));
+    }
+
+    // zeroed, as AP_GyroFFT allocates them
+    AP_GyroFFT_Tracker *tracker = NEW_NOTHROW AP_GyroFFT_Tracker;
+    AP_GyroFFT_Tracker::State *state = NEW_NOTHROW AP_GyroFFT_Tracker::State;
+    ASSERT_NE(tracker, nullptr);
+    ASSERT_NE(state, nullptr);
+    ASSERT_TRUE(tracker->init(window_size, samples_per_frame, rate_hz, false, 50, *state));
+
+    AP_GyroFFT_Tracker::Config config {};
+    config._fft_min_hz = 50;
+    config._fft_max_hz = 450;
+    config._snr_threshold_db = 25;
+    config._tracked_peaks = 1;
+    config._harmonic_multiplier = 2;
+    config._bandwidth_hover_hz = 20;
+    const uint16_t start_bin = MAX(floorf(config._fft_min_hz / fft->_bin_resolution), 1);
+    const uint16_t end_bin = MIN(ceilf(config._fft_max_hz / fft->_bin_resolution), fft->_bin_count);
+    const float attenuation_cutoff = powf(10.0f, -15 * 0.1f);
+    HAL_Semaphore sem;
+
+    for (uint32_t i = 0; i < 4000; i++) {
+        // motors start once the noise reference is calibrated
+        const float signal = i < 1000 ? 0 : sinf(2 * M_PI * peak_hz * i / rate_hz);
+        buffers[0].push(signal + rand_float() * 0.001f);
+        buffers[1].push(signal + rand_float() * 0.001f);
+        buffers[2].push(rand_float() * 0.001f);
+        if (buffers[0].available() < window_size) {
+            continue;
+        }
+        for (uint8_t axis = 0; axis < XYZ_AXIS_COUNT; axis++) {
+            hal.dsp->fft_start(fft, buffers[axis], samples_per_frame);
+            hal.dsp->fft_analyse(fft, start_bin, end_bin, attenuation_cutoff);
+            tracker->update_ref_energy(*fft, axis, *state, sem);
+            tracker->calculate_noise(*fft, axis, false, config, *state);
+        }
+    }
+
+    EXPECT_EQ(state->_noise_needs_calibration, 0);
+    EXPECT_GT(state->_health.x, 0);
+    EXPECT_GT(state->_health.y, 0);
+    EXPECT_NEAR(AP_GyroFFT_Tracker::get_weighted_noise_center_freq_hz(*state, state->_health, 0, 10),
+                peak_hz, fft->_bin_resolution * 0.5f);
+
+    delete state;
+    delete tracker;
+    delete fft;
+}
+
+#endif // HAL_WITH_DSP
+
+AP_GTEST_MAIN()
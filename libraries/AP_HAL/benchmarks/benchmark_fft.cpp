@@ -0,0 +1,65 @@
+/*
+  cost of one FFT analysis frame with the vectorised DSP used by SITL
+  and Linux, across the supported FFT window sizes
+ */
+#include <AP_gbenchmark.h>
+#include <AP_HAL/AP_HAL.h>
+#include <AP_HAL/utility/DSP_SIMD.h>
+
+const AP_HAL::HAL& hal = AP_HAL::get_HAL();
+
+#if AP_HAL_DSP_SIMD_ENABLED
+
+// the analysis steps are protected, expose them for timing
+class DSP_Bench : public DSP_SIMD {
+public:
+    using DSP_SIMD::vector_max_float;
+};
+
+static void BM_FFTAnalyse(benchmark::State& state)
+{
+    const uint16_t window_size = state.range_x();
+    DSP_Bench dsp;
+    AP_HAL::DSP::FFTWindowState* fft = dsp.fft_init(window_size, 2000, 0);
+    FloatBuffer samples{uint32_t(window_size)};
+    for (uint16_t i = 0; i < window_size; i++) {
+        const float t = i / 2000.0f;
+        samples.push(sinf(2 * M_PI * 180.0f * t) + 0.5f * sinf(2 * M_PI * 360.0f * t));
+    }
+
+    while (state.KeepRunning()) {
+        // advance of zero leaves the same window in the buffer for the next frame
+        dsp.fft_start(fft, samples, 0);
+        uint16_t bin = dsp.fft_analyse(fft, 1, window_size / 2 - 1, 0.5f);
+        gbenchmark_escape(&bin);
+    }
+
+    delete fft;
+}
+
+BENCHMARK(BM_FFTAnalyse)->RangeMultiplier(2)->Range(32, 1024);
+
+static void BM_VectorMax(benchmark::State& state)
+{
+    const uint16_t len = state.range_x();
+    DSP_Bench dsp;
+    float* v = new float[len];
+    for (uint16_t i = 0; i < len; i++) {
+        v[i] = sinf(i * 0.1f);
+    }
+
+    while (state.KeepRunning()) {
+        float max_value;
+        uint16_t max_index;
+        dsp.vector_max_float(v, len, &max_value, &max_index);
+        gbenchmark_escape(&max_index);
+    }
+
+    delete[] v;
+}
+
+BENCHMARK(BM_VectorMax)->RangeMultiplier(2)->Range(16, 512);
+
+#endif  // AP_HAL_DSP_SIMD_ENABLED
+
+BENCHMARK_MAIN()
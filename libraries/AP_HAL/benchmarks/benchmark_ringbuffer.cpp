@@ -0,0 +1,93 @@
+/*
+  compare the cost of moving data through the lock free ring buffers
+  against the semaphore protected ObjectBuffer_TS
+ */
+#include <AP_gbenchmark.h>
+#include <AP_HAL/AP_HAL.h>
+#include <AP_HAL/utility/RingBuffer.h>
+
+#include <string.h>
+#include <thread>
+
+const AP_HAL::HAL& hal = AP_HAL::get_HAL();
+
+static void BM_ObjectBuffer_TS_PushPop(benchmark::State& state)
+{
+    ObjectBuffer_TS<uint32_t> buf{64};
+    uint32_t v = 0;
+
+    while (state.KeepRunning()) {
+        buf.push(v);
+        gbenchmark_escape(&v);
+        UNUSED_RESULT(buf.pop(v));
+    }
+}
+
+BENCHMARK(BM_ObjectBuffer_TS_PushPop);
+
+static void BM_ObjectBuffer_PushPop(benchmark::State& state)
+{
+    ObjectBuffer<uint32_t> buf{64};
+    uint32_t v = 0;
+
+    while (state.KeepRunning()) {
+        buf.push(v);
+        gbenchmark_escape(&v);
+        UNUSED_RESULT(buf.pop(v));
+    }
+}
+
+BENCHMARK(BM_ObjectBuffer_PushPop);
+
+/*
+  stream bytes from a writer thread to the benchmark thread in chunks
+  of range_x() bytes. Arg y selects write() (0) or writeptr() and
+  commit() (1) on the writer side
+ */
+static void BM_ByteBuffer_Stream(benchmark::State& state)
+{
+    ByteBuffer buf{4096};
+    const uint32_t chunk = state.range_x();
+    const bool zero_copy = state.range_y() != 0;
+    std::atomic<bool> done{false};
+
+    std::thread writer([&]() {
+        uint8_t src[512] {};
+        while (!done.load(std::memory_order_relaxed)) {
+            if (zero_copy) {
+                uint32_t n = 0;
+                uint8_t *p = buf.writeptr(n);
+                if (p == nullptr) {
+                    std::this_thread::yield();
+                    continue;
+                }
+                n = n < chunk ? n : chunk;
+                memset(p, 0x55, n);
+                buf.commit(n);
+            } else if (buf.write(src, chunk) == 0) {
+                std::this_thread::yield();
+            }
+        }
+    });
+
+    uint8_t dst[512];
+    while (state.KeepRunning()) {
+        uint32_t got = 0;
+        while (got < chunk) {
+            const uint32_t n = buf.read(&dst[got], chunk - got);
+            if (n == 0) {
+                std::this_thread::yield();
+            }
+            got += n;
+        }
+        gbenchmark_escape(dst);
+    }
+
+    done = true;
+    writer.join();
+    state.SetBytesProcessed(uint64_t(state.iterations()) * chunk);
+}
+
+BENCHMARK(BM_ByteBuffer_Stream)->ArgPair(16, 0)->ArgPair(16, 1)->ArgPair(256, 0)->ArgPair(256, 1);
+
+BENCHMARK_MAIN()
@@ -0,0 +1,357 @@
+/*
+ * This file is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This file is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "DSP_SIMD.h"
+
+#if AP_HAL_DSP_SIMD_ENABLED
+
+#include <AP_HAL/AP_HAL.h>
+#include <AP_Math/AP_Math.h>
+#include <string.h>
+
+extern const AP_HAL::HAL& hal;
+
+/*
+  four lane float vector. GCC and clang lower this to SSE or NEON
+  registers where available and to scalar code otherwise. Loads and
+  stores go through memcpy so no alignment is assumed
+ */
+typedef float v4f __attribute__((vector_size(16)));
+
+static inline v4f load4(const float* p)
+{
+    v4f v;
+    memcpy(&v, p, sizeof(v));
+    return v;
+}
+
+static inline void store4(float* p, const v4f &v)
+{
+    memcpy(p, &v, sizeof(v));
+}
+
+static inline v4f splat4(float f)
+{
+    return v4f{f, f, f, f};
+}
+
+// initialize the FFT state machine
+AP_HAL::DSP::FFTWindowState* DSP_SIMD::fft_init(uint16_t window_size, uint16_t sample_rate, uint8_t sliding_window_size)
+{
+    // the real FFT is built from a half length radix-2 complex FFT
+    if (window_size < 8 || (window_size & (window_size - 1)) != 0) {
+        return nullptr;
+    }
+    FFTWindowStateSIMD* fft = NEW_NOTHROW FFTWindowStateSIMD(window_size, sample_rate, sliding_window_size);
+    if (fft == nullptr || fft->_hanning_window == nullptr || fft->_rfft_data == nullptr || fft->_freq_bins == nullptr
+        || fft->_derivative_freq_bins == nullptr || fft->_bitrev == nullptr) {
+        delete fft;
+        return nullptr;
+    }
+    return fft;
+}
+
+// start an FFT analysis
+void DSP_SIMD::fft_start(AP_HAL::DSP::FFTWindowState* state, FloatBuffer& samples, uint16_t advance)
+{
+    step_hanning((FFTWindowStateSIMD*)state, samples, advance);
+}
+
+// perform remaining steps of an FFT analysis
+uint16_t DSP_SIMD::fft_analyse(AP_HAL::DSP::FFTWindowState* state, uint16_t start_bin, uint16_t end_bin, float noise_att_cutoff)
+{
+    FFTWindowStateSIMD* fft = (FFTWindowStateSIMD*)state;
+    step_fft(fft);
+    step_cmplx_mag(fft, start_bin, end_bin, noise_att_cutoff);
+    return step_calc_frequencies(fft, start_bin, end_bin);
+}
+
+// create an instance of the FFT state machine
+DSP_SIMD::FFTWindowStateSIMD::FFTWindowStateSIMD(uint16_t window_size, uint16_t sample_rate, uint8_t sliding_window_size)
+    : AP_HAL::DSP::FFTWindowState::FFTWindowState(window_size, sample_rate, sliding_window_size)
+{
+    if (_freq_bins == nullptr || _hanning_window == nullptr || _rfft_data == nullptr || _derivative_freq_bins == nullptr) {
+        return;
+    }
+
+    const uint16_t m = window_size / 2;
+    _re = (float*)hal.util->malloc_type(sizeof(float) * m, DSP_MEM_REGION);
+    _im = (float*)hal.util->malloc_type(sizeof(float) * m, DSP_MEM_REGION);
+    _twiddle_re = (float*)hal.util->malloc_type(sizeof(float) * m, DSP_MEM_REGION);
+    _twiddle_im = (float*)hal.util->malloc_type(sizeof(float) * m, DSP_MEM_REGION);
+    _split_re = (float*)hal.util->malloc_type(sizeof(float) * (m / 2 + 1), DSP_MEM_REGION);
+    _split_im = (float*)hal.util->malloc_type(sizeof(float) * (m / 2 + 1), DSP_MEM_REGION);
+    uint16_t* bitrev = (uint16_t*)hal.util->malloc_type(sizeof(uint16_t) * m, DSP_MEM_REGION);
+
+    if (_re == nullptr || _im == nullptr || _twiddle_re == nullptr || _twiddle_im == nullptr
+        || _split_re == nullptr || _split_im == nullptr || bitrev == nullptr) {
+        hal.util->free_type(bitrev, sizeof(uint16_t) * m, DSP_MEM_REGION);
+        return;
+    }
+
+    uint16_t log2m = 0;
+    while ((1U << log2m) < m) {
+        log2m++;
+    }
+    for (uint16_t k = 0; k < m; k++) {
+        uint16_t r = 0;
+        for (uint16_t b = 0; b < log2m; b++) {
+            r |= ((k >> b) & 1U) << (log2m - 1 - b);
+        }
+        bitrev[k] = r;
+    }
+
+    // twiddles for the stage with half width h are exp(-i*pi*k/h), k < h
+    for (uint16_t h = 1; h < m; h <<= 1) {
+        for (uint16_t k = 0; k < h; k++) {
+            const double a = -M_PI * k / h;
+            _twiddle_re[h - 1 + k] = cos(a);
+            _twiddle_im[h - 1 + k] = sin(a);
+        }
+    }
+
+    // split twiddles are exp(-2*i*pi*k/N), k <= N/4
+    for (uint16_t k = 0; k <= m / 2; k++) {
+        const double a = -M_PI * k / m;
+        _split_re[k] = cos(a);
+        _split_im[k] = sin(a);
+    }
+
+    _bitrev = bitrev;
+}
+
+DSP_SIMD::FFTWindowStateSIMD::~FFTWindowStateSIMD()
+{
+    const uint16_t m = _window_size / 2;
+    hal.util->free_type(_re, sizeof(float) * m, DSP_MEM_REGION);
+    hal.util->free_type(_im, sizeof(float) * m, DSP_MEM_REGION);
+    hal.util->free_type(_twiddle_re, sizeof(float) * m, DSP_MEM_REGION);
+    hal.util->free_type(_twiddle_im, sizeof(float) * m, DSP_MEM_REGION);
+    hal.util->free_type(_split_re, sizeof(float) * (m / 2 + 1), DSP_MEM_REGION);
+    hal.util->free_type(_split_im, sizeof(float) * (m / 2 + 1), DSP_MEM_REGION);
+    hal.util->free_type(_bitrev, sizeof(uint16_t) * m, DSP_MEM_REGION);
+}
+
+// step 1: filter the incoming samples through a Hanning window
+void DSP_SIMD::step_hanning(FFTWindowStateSIMD* fft, FloatBuffer& samples, uint16_t advance)
+{
+    uint32_t read_window = samples.peek(&fft->_freq_bins[0], fft->_window_size);
+    if (read_window != fft->_window_size) {
+        return;
+    }
+    samples.advance(advance);
+    vector_mult_float(&fft->_freq_bins[0], &fft->_hanning_window[0], &fft->_freq_bins[0], fft->_window_size);
+}
+
+/*
+  step 2: real FFT of the windowed data in _freq_bins. The even and odd
+  samples are packed as the real and imaginary parts of a half length
+  complex sequence, transformed, and then split into the spectrum of
+  the real input. _rfft_data receives bins 0 to N/2 as interleaved
+  complex values and _freq_bins their squared magnitudes
+ */
+void DSP_SIMD::step_fft(FFTWindowStateSIMD* fft)
+{
+    const uint16_t m = fft->_window_size / 2;
+    const float* x = fft->_freq_bins;
+    float* re = fft->_re;
+    float* im = fft->_im;
+
+    // pack with the bit reversal applied on the way in
+    for (uint16_t k = 0; k < m; k++) {
+        const uint16_t r = fft->_bitrev[k];
+        re[r] = x[2 * k];
+        im[r] = x[2 * k + 1];
+    }
+
+    calculate_cfft(fft);
+
+    float* out = fft->_rfft_data;
+
+    // DC and nyquist are real only
+    out[0] = re[0] + im[0];
+    out[1] = 0;
+    out[2 * m] = re[0] - im[0];
+    out[2 * m + 1] = 0;
+
+    /*
+      X[k] = (Z[k] + conj(Z[m-k]))/2 - i*W^k*(Z[k] - conj(Z[m-k]))/2
+      with W = exp(-2*i*pi/N). Bins k and m-k are computed together
+     */
+    for (uint16_t k = 1; k <= m / 2; k++) {
+        const uint16_t j = m - k;
+        const float er = 0.5f * (re[k] + re[j]);
+        const float ei = 0.5f * (im[k] - im[j]);
+        const float or_ = 0.5f * (im[k] + im[j]);
+        const float oi = -0.5f * (re[k] - re[j]);
+        const float wr = fft->_split_re[k];
+        const float wi = fft->_split_im[k];
+        const float tr = or_ * wr - oi * wi;
+        const float ti = or_ * wi + oi * wr;
+        out[2 * k] = er + tr;
+        out[2 * k + 1] = ei + ti;
+        // bin m-k uses the conjugate symmetric terms and W^(m-k) = -conj(W^k)
+        out[2 * j] = er - tr;
+        out[2 * j + 1] = -ei + ti;
+    }
+
+    // squared magnitudes of bins 0 to N/2
+    uint16_t k = 0;
+    for (; k + 4 <= m; k += 4) {
+        float a[8], b[8];
+        memcpy(a, &out[2 * k], sizeof(a));
+        const v4f r = v4f{a[0], a[2], a[4], a[6]};
+        const v4f i = v4f{a[1], a[3], a[5], a[7]};
+        store4(b, r * r + i * i);
+        memcpy(&fft->_freq_bins[k], b, 4 * sizeof(float));
+    }
+    for (; k <= m; k++) {
+        fft->_freq_bins[k] = sq(out[2 * k]) + sq(out[2 * k + 1]);
+    }
+}
+
+/*
+  in-place radix-2 decimation in time FFT of the bit reversed half
+  length sequence in _re/_im. Stages with at least four butterflies
+  per group are done four at a time
+ */
+void DSP_SIMD::calculate_cfft(FFTWindowStateSIMD* fft) const
+{
+    const uint16_t m = fft->_window_size / 2;
+    float* re = fft->_re;
+    float* im = fft->_im;
+
+    // first two stages have trivial twiddles (1 and -i)
+    for (uint16_t s = 0; s + 4 <= m; s += 4) {
+        const float r0 = re[s] + re[s + 1], i0 = im[s] + im[s + 1];
+        const float r1 = re[s] - re[s + 1], i1 = im[s] - im[s + 1];
+        const float r2 = re[s + 2] + re[s + 3], i2 = im[s + 2] + im[s + 3];
+        const float r3 = re[s + 2] - re[s + 3], i3 = im[s + 2] - im[s + 3];
+        re[s] = r0 + r2;
+        im[s] = i0 + i2;
+        re[s + 2] = r0 - r2;
+        im[s + 2] = i0 - i2;
+        // multiply the odd term by -i
+        re[s + 1] = r1 + i3;
+        im[s + 1] = i1 - r3;
+        re[s + 3] = r1 - i3;
+        im[s + 3] = i1 + r3;
+    }
+
+    for (uint16_t h = 4; h < m; h <<= 1) {
+        const float* twr = &fft->_twiddle_re[h - 1];
+        const float* twi = &fft->_twiddle_im[h - 1];
+        for (uint16_t s = 0; s < m; s += 2 * h) {
+            float* ar = &re[s];
+            float* ai = &im[s];
+            float* br = &re[s + h];
+            float* bi = &im[s + h];
+            for (uint16_t k = 0; k < h; k += 4) {
+                const v4f wr = load4(&twr[k]);
+                const v4f wi = load4(&twi[k]);
+                const v4f xr = load4(&br[k]);
+                const v4f xi = load4(&bi[k]);
+                const v4f tr = xr * wr - xi * wi;
+                const v4f ti = xr * wi + xi * wr;
+                const v4f yr = load4(&ar[k]);
+                const v4f yi = load4(&ai[k]);
+                store4(&br[k], yr - tr);
+                store4(&bi[k], yi - ti);
+                store4(&ar[k], yr + tr);
+                store4(&ai[k], yi + ti);
+            }
+        }
+    }
+}
+
+void DSP_SIMD::vector_mult_float(const float* vin1, const float* vin2, float* vout, uint16_t len) const
+{
+    uint16_t i = 0;
+    for (; i + 4 <= len; i += 4) {
+        store4(&vout[i], load4(&vin1[i]) * load4(&vin2[i]));
+    }
+    for (; i < len; i++) {
+        vout[i] = vin1[i] * vin2[i];
+    }
+}
+
+void DSP_SIMD::vector_max_float(const float* vin, uint16_t len, float* max_value, uint16_t* max_index) const
+{
+    // find the largest value four lanes at a time, then its first index
+    float best = vin[0];
+    uint16_t i = 0;
+    if (len >= 4) {
+        v4f vmax = load4(&vin[0]);
+        for (i = 4; i + 4 <= len; i += 4) {
+            const v4f v = load4(&vin[i]);
+            vmax = v > vmax ? v : vmax;
+        }
+        float lanes[4];
+        store4(lanes, vmax);
+        best = MAX(MAX(lanes[0], lanes[1]), MAX(lanes[2], lanes[3]));
+    }
+    for (; i < len; i++) {
+        best = MAX(best, vin[i]);
+    }
+    *max_value = best;
+    *max_index = 0;
+    for (i = 0; i < len; i++) {
+        if (vin[i] == best) {
+            *max_index = i;
+            break;
+        }
+    }
+}
+
+void DSP_SIMD::vector_scale_float(const float* vin, float scale, float* vout, uint16_t len) const
+{
+    const v4f s = splat4(scale);
+    uint16_t i = 0;
+    for (; i + 4 <= len; i += 4) {
+        store4(&vout[i], load4(&vin[i]) * s);
+    }
+    for (; i < len; i++) {
+        vout[i] = vin[i] * scale;
+    }
+}
+
+void DSP_SIMD::vector_add_float(const float* vin1, const float* vin2, float* vout, uint16_t len) const
+{
+    uint16_t i = 0;
+    for (; i + 4 <= len; i += 4) {
+        store4(&vout[i], load4(&vin1[i]) + load4(&vin2[i]));
+    }
+    for (; i < len; i++) {
+        vout[i] = vin1[i] + vin2[i];
+    }
+}
+
+float DSP_SIMD::vector_mean_float(const float* vin, uint16_t len) const
+{
+    v4f sum4 = splat4(0);
+    uint16_t i = 0;
+    for (; i + 4 <= len; i += 4) {
+        sum4 += load4(&vin[i]);
+    }
+    float lanes[4];
+    store4(lanes, sum4);
+    float sum = (lanes[0] + lanes[1]) + (lanes[2] + lanes[3]);
+    for (; i < len; i++) {
+        sum += vin[i];
+    }
+    return sum / len;
+}
+
+#endif  // AP_HAL_DSP_SIMD_ENABLED
@@ -0,0 +1,79 @@
+/*
+ * This file is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This file is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+/*
+  portable DSP implementation for the SITL and Linux HALs. The real FFT
+  is computed as a half length complex FFT in split real/imaginary
+  form, with the butterflies and vector kernels written using the
+  compiler's generic vector types so they compile to SSE on x86 and
+  NEON on ARM
+ */
+#pragma once
+
+#include <AP_HAL/AP_HAL_Boards.h>
+
+#ifndef AP_HAL_DSP_SIMD_ENABLED
+#define AP_HAL_DSP_SIMD_ENABLED (HAL_WITH_DSP && (CONFIG_HAL_BOARD == HAL_BOARD_SITL || CONFIG_HAL_BOARD == HAL_BOARD_LINUX))
+#endif
+
+#if AP_HAL_DSP_SIMD_ENABLED
+
+#include <AP_HAL/DSP.h>
+
+class DSP_SIMD : public AP_HAL::DSP {
+public:
+    // initialise an FFT instance
+    FFTWindowState* fft_init(uint16_t window_size, uint16_t sample_rate, uint8_t sliding_window_size) override;
+    // start an FFT analysis with an ObjectBuffer
+    void fft_start(FFTWindowState* state, FloatBuffer& samples, uint16_t advance) override;
+    // perform remaining steps of an FFT analysis
+    uint16_t fft_analyse(FFTWindowState* state, uint16_t start_bin, uint16_t end_bin, float noise_att_cutoff) override;
+
+    class FFTWindowStateSIMD : public AP_HAL::DSP::FFTWindowState {
+        friend class DSP_SIMD;
+
+    public:
+        FFTWindowStateSIMD(uint16_t window_size, uint16_t sample_rate, uint8_t sliding_window_size);
+        virtual ~FFTWindowStateSIMD();
+
+    private:
+        // half length complex FFT work space
+        float* _re = nullptr;
+        float* _im = nullptr;
+        // per-stage twiddles of the complex FFT, stage with half width h starts at h-1
+        float* _twiddle_re = nullptr;
+        float* _twiddle_im = nullptr;
+        // twiddles for splitting the complex FFT into the real FFT
+        float* _split_re = nullptr;
+        float* _split_im = nullptr;
+        // bit reversed index for each complex sample
+        uint16_t* _bitrev = nullptr;
+    };
+
+protected:
+    void vector_max_float(const float* vin, uint16_t len, float* max_value, uint16_t* max_index) const override;
+    float vector_mean_float(const float* vin, uint16_t len) const override;
+    void vector_scale_float(const float* vin, float scale, float* vout, uint16_t len) const override;
+    void vector_add_float(const float* vin1, const float* vin2, float* vout, uint16_t len) const override;
+
+private:
+    // step 1: filter the incoming samples through a Hanning window
+    void step_hanning(FFTWindowStateSIMD* fft, FloatBuffer& samples, uint16_t advance);
+    // step 2: perform the real FFT of the windowed data
+    void step_fft(FFTWindowStateSIMD* fft);
+    void vector_mult_float(const float* vin1, const float* vin2, float* vout, uint16_t len) const;
+    void calculate_cfft(FFTWindowStateSIMD* fft) const;
+};
+
+#endif  // AP_HAL_DSP_SIMD_ENABLED
@@ -3,6 +3,15 @@
 
 #include "RingBuffer.h"
 
+/*
+  memory ordering: the writer owns tail and the reader owns head. Each
+  side loads its own index relaxed, loads the other side's index with
+  acquire and publishes its own index with release. That makes the
+  data written before a commit() visible to the reader that sees the
+  new tail, and guarantees the reader has finished with the bytes
+  before the writer sees them freed by advance()
+ */
+
 ByteBuffer::ByteBuffer(uint32_t _size)
 {
     buf = (uint8_t*)calloc(1, _size);
@@ -26,7 +35,8 @@ bool ByteBuffer::set_size(uint32_t _size)
         // resize not supported with external buffer
         return false;
     }
-    head = tail = 0;
+    head.store(0, std::memory_order_relaxed);
+    tail.store(0, std::memory_order_relaxed);
     if (_size != size) {
         free(buf);
         buf = (uint8_t*)calloc(1, _size);
@@ -59,17 +69,23 @@ uint32_t ByteBuffer::available(void) const
 {
     /* use a copy on stack to avoid race conditions of @tail being updated by
      * the writer thread */
-    uint32_t _tail = tail;
+    const uint32_t _tail = tail.load(std::memory_order_acquire);
+    const uint32_t _head = head.load(std::memory_order_relaxed);
 
-    if (head > _tail) {
-        return size - head + _tail;
+    if (_head > _tail) {
+        return size - _head + _tail;
     }
-    return _tail - head;
+    return _tail - _head;
 }
 
+/*
+  discard everything currently in the buffer. This only moves the read
+  pointer, so it is safe to call from the reader while a writer is
+  active
+ */
 void ByteBuffer::clear(void)
 {
-    head = tail = 0;
+    head.store(tail.load(std::memory_order_acquire), std::memory_order_release);
 }
 
 uint32_t ByteBuffer::space(void) const
@@ -80,21 +96,22 @@ uint32_t ByteBuffer::space(void) const
 
     /* use a copy on stack to avoid race conditions of @head being updated by
      * the reader thread */
-    uint32_t _head = head;
+    const uint32_t _head = head.load(std::memory_order_acquire);
+    const uint32_t _tail = tail.load(std::memory_order_relaxed);
     uint32_t ret = 0;
 
-    if (_head <= tail) {
+    if (_head <= _tail) {
         ret = size;
     }
 
-    ret += _head - tail - 1;
+    ret += _head - _tail - 1;
 
     return ret;
 }
 
 bool ByteBuffer::is_empty(void) const
 {
-    return head == tail;
+    return head.load(std::memory_order_relaxed) == tail.load(std::memory_order_acquire);
 }
 
 uint32_t ByteBuffer::write(const uint8_t *data, uint32_t len)
@@ -122,11 +139,12 @@ bool ByteBuffer::update(const uint8_t *data, uint32_t len)
         return false;
     }
     // perform as two memcpy calls
-    uint32_t n = size - head;
+    const uint32_t _head = head.load(std::memory_order_relaxed);
+    uint32_t n = size - _head;
     if (n > len) {
         n = len;
     }
-    memcpy(&buf[head], data, n);
+    memcpy(&buf[_head], data, n);
     data += n;
     if (len > n) {
         memcpy(&buf[0], data, len-n);
@@ -139,7 +157,7 @@ bool ByteBuffer::advance(uint32_t n)
     if (n > available()) {
         return false;
     }
-    head = (head + n) % size;
+    head.store((head.load(std::memory_order_relaxed) + n) % size, std::memory_order_release);
     return true;
 }
 
@@ -208,9 +226,10 @@ uint8_t ByteBuffer::reserve(ByteBuffer::IoVec iovec[2], uint32_t len)
         return 0;
     }
 
-    iovec[0].data = &buf[tail];
+    const uint32_t _tail = tail.load(std::memory_order_relaxed);
+    iovec[0].data = &buf[_tail];
 
-    n = size - tail;
+    n = size - _tail;
     if (len <= n) {
         iovec[0].len = len;
         return 1;
@@ -233,10 +252,27 @@ bool ByteBuffer::commit(uint32_t len)
         return false; //Someone broke the agreement
     }
 
-    tail = (tail + len) % size;
+    tail.store((tail.load(std::memory_order_relaxed) + len) % size, std::memory_order_release);
     return true;
 }
 
+/*
+ * Returns the pointer and size of the contiguous space at the write
+ * pointer. Bytes written there are published by 'commit()'
+ */
+uint8_t *ByteBuffer::writeptr(uint32_t &space_bytes)
+{
+    space_bytes = space();
+    if (space_bytes == 0) {
+        return nullptr;
+    }
+    const uint32_t _tail = tail.load(std::memory_order_relaxed);
+    if (space_bytes > size - _tail) {
+        space_bytes = size - _tail;
+    }
+    return &buf[_tail];
+}
+
 uint32_t ByteBuffer::read(uint8_t *data, uint32_t len)
 {
     uint32_t ret = peekbytes(data, len);
@@ -265,10 +301,11 @@ bool ByteBuffer::read_byte(uint8_t *data)
  */
 const uint8_t *ByteBuffer::readptr(uint32_t &available_bytes)
 {
-    uint32_t _tail = tail;
-    available_bytes = (head > _tail) ? size - head : _tail - head;
+    const uint32_t _tail = tail.load(std::memory_order_acquire);
+    const uint32_t _head = head.load(std::memory_order_relaxed);
+    available_bytes = (_head > _tail) ? size - _head : _tail - _head;
 
-    return available_bytes ? &buf[head] : nullptr;
+    return available_bytes ? &buf[_head] : nullptr;
 }
 
 int16_t ByteBuffer::peek(uint32_t ofs) const
@@ -276,5 +313,5 @@ int16_t ByteBuffer::peek(uint32_t ofs) const
     if (ofs >= available()) {
         return -1;
     }
-    return buf[(head+ofs)%size];
+    return buf[(head.load(std::memory_order_relaxed)+ofs)%size];
 }
@@ -8,6 +8,11 @@
 
 /*
  * Circular buffer of bytes.
+ *
+ * This is lock free for a single writer and a single reader. The
+ * writer may use write(), reserve(), writeptr() and commit(); the
+ * reader may use everything else apart from set_size(). Callers with
+ * more than one writer or reader must provide their own locking.
  */
 class ByteBuffer {
 public:
@@ -22,7 +27,7 @@ public:
     // number of bytes available to be read
     uint32_t available(void) const;
 
-    // Discards the buffer content, emptying it.
+    // Discards the buffer content, emptying it. Reader side.
     void clear(void);
 
     // number of bytes space available to write
@@ -94,6 +99,11 @@ public:
      */
     bool commit(uint32_t len);
 
+    // Returns the pointer and size of the contiguous space at the
+    // write pointer, for writers which produce data in place. Finish
+    // with 'commit()'
+    uint8_t *writeptr(uint32_t &space_bytes);
+
 private:
     uint8_t *buf;
     uint32_t size;
@@ -263,6 +273,31 @@ public:
     bool advance(uint32_t n) {
         return buffer->advance(n * sizeof(T));
     }
+
+    /*
+      return a pointer to the first contiguous array of free objects
+      at the back of the queue. Fill in up to n objects and then
+      commit() them. Return nullptr if there is no space. There is no
+      ObjectBuffer_TS equivalent as the pointer is only valid for the
+      single writer
+     */
+    T *writeptr(uint32_t &n) {
+        uint32_t space_bytes = 0;
+        #pragma GCC diagnostic push
+        #pragma GCC diagnostic ignored "-Wcast-align"
+        T *ret = (T *)buffer->writeptr(space_bytes);
+        #pragma GCC diagnostic pop
+        if (!ret || space_bytes < sizeof(T)) {
+            return nullptr;
+        }
+        n = space_bytes / sizeof(T);
+        return ret;
+    }
+
+    // push n objects previously filled in via writeptr()
+    bool commit(uint32_t n) {
+        return buffer->commit(n * sizeof(T));
+    }
     
     /* update the object at the front of the queue (the one that would
        be fetched by pop()) */
@@ -456,6 +491,36 @@ public:
         return buffer->update((uint8_t*)&object, sizeof(T));
     }
 
+    /*
+      push an object onto the back of the queue unless match(queued)
+      is true for an object already in the queue, in which case
+      matched is set. The search and the push are done under one
+      lock. Returns false if the object was neither found nor pushed
+     */
+    template <typename F>
+    bool push_unless_queued(const T &object, F match, bool &matched) {
+        WITH_SEMAPHORE(sem);
+        matched = false;
+        // objects never straddle the wrap as the buffer size is a
+        // multiple of the object size
+        ByteBuffer::IoVec vec[2];
+        const uint8_t n_vec = buffer->peekiovec(vec, buffer->available());
+        for (uint8_t i=0; i<n_vec; i++) {
+            for (uint32_t ofs=0; ofs+sizeof(T) <= vec[i].len; ofs += sizeof(T)) {
+                T queued;
+                memcpy((void *)&queued, &vec[i].data[ofs], sizeof(T));
+                if (match(queued)) {
+                    matched = true;
+                    return true;
+                }
+            }
+        }
+        if (buffer->space() < sizeof(T)) {
+            return false;
+        }
+        return buffer->write((uint8_t*)&object, sizeof(T)) == sizeof(T);
+    }
+
 private:
     ByteBuffer *buffer = nullptr;
     HAL_Semaphore sem;
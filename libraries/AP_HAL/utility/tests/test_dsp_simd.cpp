@@ -0,0 +1,81 @@
+/*
+ * This file is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This file is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <AP_gtest.h>
+
+#include <AP_HAL/AP_HAL.h>
+#include <AP_HAL/utility/DSP_SIMD.h>
+
+const AP_HAL::HAL& hal = AP_HAL::get_HAL();
+
+#if AP_HAL_DSP_SIMD_ENABLED
+
+class DSP_SIMD_Test : public DSP_SIMD {
+public:
+    using DSP_SIMD::vector_max_float;
+    using DSP_SIMD::vector_mean_float;
+};
+
+// compare the real FFT against a direct DFT of the windowed input
+TEST(DSPSIMDTest, MatchesDFT)
+{
+    for (uint16_t n = 32; n <= 512; n <<= 1) {
+        DSP_SIMD_Test dsp;
+        AP_HAL::DSP::FFTWindowState* fft = dsp.fft_init(n, 1000, 0);
+        ASSERT_NE(fft, nullptr);
+
+        FloatBuffer samples{uint32_t(n)};
+        float x[512];
+        for (uint16_t i = 0; i < n; i++) {
+            const float v = sinf(i * 0.37f) + 0.3f * cosf(i * 1.9f);
+            samples.push(v);
+            x[i] = v * fft->_hanning_window[i];
+        }
+
+        dsp.fft_start(fft, samples, n);
+        dsp.fft_analyse(fft, 1, n / 2 - 1, 0.5f);
+
+        const float* out = fft->_rfft_data;
+        for (uint16_t k = 0; k <= n / 2; k++) {
+            double re = 0, im = 0;
+            for (uint16_t i = 0; i < n; i++) {
+                re += x[i] * cos(2 * M_PI * k * i / n);
+                im -= x[i] * sin(2 * M_PI * k * i / n);
+            }
+            EXPECT_NEAR(out[2 * k], re, 1e-3) << "n=" << n << " k=" << k;
+            EXPECT_NEAR(out[2 * k + 1], im, 1e-3) << "n=" << n << " k=" << k;
+        }
+
+        delete fft;
+    }
+}
+
+TEST(DSPSIMDTest, VectorKernels)
+{
+    DSP_SIMD_Test dsp;
+    float v[11];
+    for (uint8_t i = 0; i < ARRAY_SIZE(v); i++) {
+        v[i] = i == 7 ? 5.0f : i * 0.25f;
+    }
+    float max_value;
+    uint16_t max_index;
+    dsp.vector_max_float(v, ARRAY_SIZE(v), &max_value, &max_index);
+    EXPECT_FLOAT_EQ(max_value, 5.0f);
+    EXPECT_EQ(max_index, 7);
+    EXPECT_FLOAT_EQ(dsp.vector_mean_float(v, ARRAY_SIZE(v)), (5.0f + 0.25f * (55 - 7)) / 11);
+}
+
+#endif  // AP_HAL_DSP_SIMD_ENABLED
+
+AP_GTEST_MAIN()
@@ -16,6 +16,8 @@
  */
 #include <AP_gtest.h>
 
+#include <algorithm>
+#include <thread>
 #include <utility>
 #include <AP_HAL/utility/RingBuffer.h>
 
@@ -122,4 +124,78 @@ TEST(ObjectBufferTest, PeekTest)
     }
 }
 
+TEST(ObjectBufferTest, WritePtr)
+{
+    ObjectBuffer<uint32_t> x{8};
+    uint32_t next_in = 0;
+    uint32_t next_out = 0;
+    for (uint8_t i=0; i<50; i++) {
+        // fill as much as is contiguous, which is less than the
+        // free space when the write pointer is near the end
+        uint32_t n = 0;
+        uint32_t *p = x.writeptr(n);
+        ASSERT_NE(p, nullptr);
+        EXPECT_LE(n, x.space());
+        n = std::min(n, 5U);
+        for (uint32_t j=0; j<n; j++) {
+            p[j] = next_in++;
+        }
+        EXPECT_TRUE(x.commit(n));
+        uint32_t v;
+        while (x.available() > 2) {
+            EXPECT_TRUE(x.pop(v));
+            EXPECT_EQ(v, next_out++);
+        }
+    }
+
+    // full buffer gives no write pointer
+    while (x.push(0)) {}
+    uint32_t n = 0;
+    EXPECT_EQ(x.writeptr(n), nullptr);
+}
+
+TEST(ByteBufferTest, SingleProducerSingleConsumer)
+{
+    ByteBuffer bb(61);
+    const uint32_t total = 200000;
+
+    std::thread producer([&bb, total]() {
+        uint32_t sent = 0;
+        while (sent < total) {
+            uint32_t n = 0;
+            uint8_t *p = bb.writeptr(n);
+            if (p == nullptr) {
+                std::this_thread::yield();
+                continue;
+            }
+            n = std::min(n, total - sent);
+            for (uint32_t i=0; i<n; i++) {
+                p[i] = uint8_t(sent + i);
+            }
+            bb.commit(n);
+            sent += n;
+        }
+    });
+
+    uint32_t received = 0;
+    uint32_t errors = 0;
+    while (received < total) {
+        uint8_t buf[17];
+        const uint32_t n = bb.read(buf, sizeof(buf));
+        if (n == 0) {
+            std::this_thread::yield();
+        }
+        for (uint32_t i=0; i<n; i++) {
+            if (buf[i] != uint8_t(received + i)) {
+                errors++;
+            }
+        }
+        received += n;
+    }
+    producer.join();
+
+    EXPECT_EQ(errors, 0U);
+    EXPECT_TRUE(bb.is_empty());
+}
+
 AP_GTEST_MAIN()
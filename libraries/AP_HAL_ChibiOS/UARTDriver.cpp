@@ -781,6 +781,8 @@ size_t UARTDriver::_write(const uint8_t *buffer, size_t size)
 		return 0;
 	}
 
+    // the lock serialises writers only, the UART thread reads
+    // _writebuf without it
     WITH_SEMAPHORE(_write_mutex);
 
     size_t ret = _writebuf.write(buffer, size);
@@ -855,19 +857,15 @@ void UARTDriver::write_pending_bytes_DMA(uint32_t n)
             return;
         }
 
-        uint16_t tx_len = 0;
+        // get some more to write. This thread is the only reader of
+        // _writebuf so no lock is needed against the writers
+        uint16_t tx_len = _writebuf.peekbytes(tx_bounce_buf, MIN(n, TX_BOUNCE_BUFSIZE));
 
-        {
-            WITH_SEMAPHORE(_write_mutex);
-            // get some more to write
-            tx_len = _writebuf.peekbytes(tx_bounce_buf, MIN(n, TX_BOUNCE_BUFSIZE));
-
-            if (tx_len == 0) {
-                return; // all done
-            }
-            // find out how much is still left to write while we still have the lock
-            n = MIN(_writebuf.available(), n);
+        if (tx_len == 0) {
+            return; // all done
         }
+        // find out how much is still left to write
+        n = MIN(_writebuf.available(), n);
 
         dma_handle->lock(); // we have our own thread so grab the lock
 
@@ -950,7 +948,6 @@ void UARTDriver::write_pending_bytes_DMA(uint32_t n)
         dma_handle->unlock(mask & EVT_TRANSMIT_DMA_COMPLETE);
 
         if (tx_len) {
-            WITH_SEMAPHORE(_write_mutex);
             // skip over amount actually written
             _writebuf.advance(tx_len);
 
@@ -975,8 +972,6 @@ void UARTDriver::write_pending_bytes_DMA(uint32_t n)
  */
 void UARTDriver::write_pending_bytes_NODMA(uint32_t n)
 {
-    WITH_SEMAPHORE(_write_mutex);
-
     ByteBuffer::IoVec vec[2];
     uint16_t nwritten = 0;
 
@@ -45,6 +45,7 @@
 #include "Util.h"
 #include "Util_RPI.h"
 #include "CANSocketIface.h"
+#include "DSP.h"
 
 using namespace Linux;
 
@@ -243,7 +244,7 @@ static Empty::OpticalFlow opticalFlow;
 #endif
 
 #if HAL_WITH_DSP
-static Empty::DSP dspDriver;
+static DSP dspDriver;
 #endif
 static Empty::Flash flashDriver;
 static Empty::WSPIDeviceManager wspi_mgr_instance;
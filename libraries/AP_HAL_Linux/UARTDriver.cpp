@@ -288,6 +288,8 @@ size_t UARTDriver::_write(const uint8_t *buffer, size_t size)
     if (!_initialised) {
         return 0;
     }
+    // the lock serialises writers only, the timer thread reads
+    // _writebuf without it
     if (!_write_mutex.take_nonblocking()) {
         return 0;
     }
@@ -346,10 +348,17 @@ bool UARTDriver::_write_pending_bytes(void)
         int ret;
 
         if (_packetise) {
-            // keep as a single UDP packet
-            uint8_t tmpbuf[n];
-            _writebuf.peekbytes(tmpbuf, n);
-            ret = _write_fd(tmpbuf, n);
+            // keep as a single UDP packet, only copying when the
+            // packet wraps around the end of the buffer
+            ByteBuffer::IoVec vec[2];
+            const auto n_vec = _writebuf.peekiovec(vec, n);
+            if (n_vec == 1) {
+                ret = _write_fd(vec[0].data, n);
+            } else {
+                uint8_t tmpbuf[n];
+                _writebuf.peekbytes(tmpbuf, n);
+                ret = _write_fd(tmpbuf, n);
+            }
             if (ret > 0)
                 _writebuf.advance(ret);
         } else {
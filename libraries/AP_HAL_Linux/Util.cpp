@@ -1,13 +1,16 @@
+#include <ctype.h>
 #include <errno.h>
 #include <fcntl.h>
 #include <stdarg.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include <sys/stat.h>
 #include <time.h>
 #include <unistd.h>
 
 #include <AP_HAL/AP_HAL.h>
+#include <AP_Common/ExpandingString.h>
 
 #include "Heat_Pwm.h"
 #include "Util.h"
@@ -106,6 +109,45 @@ uint32_t Util::available_memory(void)
     return 256*1024;
 }
 
+/*
+  report the utilisation of each core since the last call, from
+  /proc/stat. The first call reports utilisation since boot
+ */
+void Util::thread_info(ExpandingString &str)
+{
+    // a header to allow for machine parsers to determine format
+    str.printf("CpusV1\n");
+
+    FILE *f = fopen("/proc/stat", "r");
+    if (f == nullptr) {
+        return;
+    }
+    char line[256];
+    while (fgets(line, sizeof(line), f) != nullptr) {
+        unsigned cpu;
+        unsigned long long user, nice, system, idle, iowait, irq, softirq, steal;
+        // skip the aggregate "cpu " line and anything after the cpus
+        if (strncmp(line, "cpu", 3) != 0 || !isdigit(line[3])) {
+            continue;
+        }
+        if (sscanf(line, "cpu%u %llu %llu %llu %llu %llu %llu %llu %llu",
+                   &cpu, &user, &nice, &system, &idle, &iowait, &irq, &softirq, &steal) != 9) {
+            continue;
+        }
+        if (cpu >= max_cpus) {
+            continue;
+        }
+        const uint64_t busy = user + nice + system + irq + softirq + steal;
+        const uint64_t total = busy + idle + iowait;
+        const uint64_t dbusy = busy - last_cpu_times[cpu].busy;
+        const uint64_t dtotal = total - last_cpu_times[cpu].total;
+        last_cpu_times[cpu].busy = busy;
+        last_cpu_times[cpu].total = total;
+        str.printf("CPU%-2u LOAD=%5.1f%%\n", cpu, dtotal > 0 ? dbusy * 100.0 / dtotal : 0.0);
+    }
+    fclose(f);
+}
+
 #ifndef HAL_LINUX_DEFAULT_SYSTEM_ID
 #define HAL_LINUX_DEFAULT_SYSTEM_ID "linux-unknown"
 #endif
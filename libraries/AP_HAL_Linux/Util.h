@@ -95,6 +95,9 @@ public:
     // fills data with random values of requested size
     bool get_random_vals(uint8_t* data, size_t size) override;
 
+    // per-core utilisation since the last call, for @SYS/threads.txt
+    void thread_info(ExpandingString &str) override;
+
 private:
 #if CONFIG_HAL_BOARD_SUBTYPE == HAL_BOARD_SUBTYPE_LINUX_DISCO
     static ToneAlarm_Disco _toneAlarm;
@@ -109,6 +112,14 @@ private:
     const char *custom_storage_directory = nullptr;
     const char *custom_defaults = HAL_PARAM_DEFAULTS_PATH;
     static const char *_hw_names[UTIL_NUM_HARDWARES];
+
+    // per-core busy and total jiffies from /proc/stat at the last
+    // thread_info() call
+    static const uint8_t max_cpus = 16;
+    struct {
+        uint64_t busy;
+        uint64_t total;
+    } last_cpu_times[max_cpus];
 };
 
 }
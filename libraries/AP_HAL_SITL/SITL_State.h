@@ -53,6 +53,9 @@ public:
                                 Location &loc,
                                 float &yaw_degrees);
     
+    /* create a simulator model by name, nullptr if there is no such model */
+    static SITL::Aircraft *create_model(const char *model_str);
+
     uint8_t get_instance() const { return _instance; }
 
 private:
@@ -211,6 +211,16 @@ static const struct {
 #endif
 };
 
+SITL::Aircraft *SITL_State::create_model(const char *model_str)
+{
+    for (uint8_t i=0; i < ARRAY_SIZE(model_constructors); i++) {
+        if (strncasecmp(model_constructors[i].name, model_str, strlen(model_constructors[i].name)) == 0) {
+            return model_constructors[i].constructor(model_str);
+        }
+    }
+    return nullptr;
+}
+
 void SITL_State::_set_signal_handlers(void) const
 {
     struct sigaction sa_fpe = {};
@@ -589,36 +599,31 @@ void SITL_State::_parse_command_line(int argc, char * const argv[])
         exit(1);
     }
 
-    for (uint8_t i=0; i < ARRAY_SIZE(model_constructors); i++) {
-        if (strncasecmp(model_constructors[i].name, model_str, strlen(model_constructors[i].name)) == 0) {
-            // printf("Creating model %f,%f,%f,%f at speed %.1f\n", opos.lat, opos.lng, opos.alt, opos.hdg, speedup);
-            sitl_model = model_constructors[i].constructor(model_str);
-            if (home_str != nullptr) {
-                Location home;
-                float home_yaw;
-                if (strchr(home_str,',') == nullptr) {
-                    if (!lookup_location(home_str, home, home_yaw)) {
-                        ::printf("Failed to find location (%s).  Should be in locations.txt or LAT,LON,ALT,HDG e.g. 37.4003371,-122.0800351,0,353\n", home_str);
-                        exit(1);
-                    }
-                } else if (!parse_home(home_str, home, home_yaw)) {
-                    ::printf("Failed to parse home string (%s).  Should be LAT,LON,ALT,HDG e.g. 37.4003371,-122.0800351,0,353\n", home_str);
-                    exit(1);
-                }
-                sitl_model->set_start_location(home, home_yaw);
-            }
-            sitl_model->set_interface_ports(simulator_address, simulator_port_in, simulator_port_out);
-            sitl_model->set_speedup(speedup);
-            sitl_model->set_instance(_instance);
-            sitl_model->set_autotest_dir(autotest_dir);
-            sitl_model->set_config(config);
-            break;
-        }
-    }
+    // printf("Creating model %f,%f,%f,%f at speed %.1f\n", opos.lat, opos.lng, opos.alt, opos.hdg, speedup);
+    sitl_model = create_model(model_str);
     if (sitl_model == nullptr) {
         printf("Vehicle model (%s) not found\n", model_str);
         exit(1);
     }
+    if (home_str != nullptr) {
+        Location home;
+        float home_yaw;
+        if (strchr(home_str,',') == nullptr) {
+            if (!lookup_location(home_str, home, home_yaw)) {
+                ::printf("Failed to find location (%s).  Should be in locations.txt or LAT,LON,ALT,HDG e.g. 37.4003371,-122.0800351,0,353\n", home_str);
+                exit(1);
+            }
+        } else if (!parse_home(home_str, home, home_yaw)) {
+            ::printf("Failed to parse home string (%s).  Should be LAT,LON,ALT,HDG e.g. 37.4003371,-122.0800351,0,353\n", home_str);
+            exit(1);
+        }
+        sitl_model->set_start_location(home, home_yaw);
+    }
+    sitl_model->set_interface_ports(simulator_address, simulator_port_in, simulator_port_out);
+    sitl_model->set_speedup(speedup);
+    sitl_model->set_instance(_instance);
+    sitl_model->set_autotest_dir(autotest_dir);
+    sitl_model->set_config(config);
 
     if (storage_posix_enabled && storage_flash_enabled) {
         // this will change in the future!
@@ -1877,6 +1877,13 @@ void AP_InertialSensor::HarmonicNotch::update_params(uint8_t instance, bool conv
     }
 
     if (params.tracking_mode() != HarmonicNotchDynamicMode::Fixed) {
+#if HAL_GYROFFT_ENABLED
+        // per-IMU frequencies are only set by FFT tracking, ignore any left over from a change of mode
+        if (params.tracking_mode() == HarmonicNotchDynamicMode::UpdateGyroFFT &&
+            num_calculated_imu_notch_frequencies[instance] > 0) {
+            filter[instance].update(num_calculated_imu_notch_frequencies[instance], calculated_imu_notch_freq_hz[instance]);
+        } else
+#endif
         if (num_calculated_notch_frequencies > 1) {
             filter[instance].update(num_calculated_notch_frequencies, calculated_notch_freq_hz);
         } else {
@@ -2358,6 +2365,21 @@ void AP_InertialSensor::HarmonicNotch::update_frequencies_hz(uint8_t num_freqs,
     num_calculated_notch_frequencies = num_freqs;
 }
 
+#if HAL_GYROFFT_ENABLED
+// Update the harmonic notch frequencies of a single IMU, zero frequencies reverts to the shared values
+void AP_InertialSensor::HarmonicNotch::update_frequencies_hz(uint8_t instance, uint8_t num_freqs, const float scaled_freq[])
+{
+    if (instance >= INS_MAX_INSTANCES) {
+        return;
+    }
+    num_freqs = MIN(num_freqs, ARRAY_SIZE(calculated_imu_notch_freq_hz[instance]));
+    for (uint8_t i = 0; i < num_freqs; i++) {
+        calculated_imu_notch_freq_hz[instance][i] = fabsf(scaled_freq[i]);
+    }
+    num_calculated_imu_notch_frequencies[instance] = num_freqs;
+}
+#endif
+
 // setup the notch for throttle based tracking, called from FFT based tuning
 bool AP_InertialSensor::setup_throttle_gyro_harmonic_notch(float center_freq_hz, float lower_freq_hz, float ref, uint8_t harmonics)
 {
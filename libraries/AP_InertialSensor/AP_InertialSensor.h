@@ -161,14 +161,16 @@ public:
 
     // FFT support access
 #if HAL_GYROFFT_ENABLED
-    const Vector3f& get_gyro_for_fft(void) const { return _gyro_for_fft[_primary]; }
+    const Vector3f& get_gyro_for_fft(uint8_t instance) const { return _gyro_for_fft[instance]; }
+    const Vector3f& get_gyro_for_fft(void) const { return get_gyro_for_fft(_primary); }
+    uint8_t get_fft_primary_instance(void) const { return _primary; }
     FloatBuffer&  get_raw_gyro_window(uint8_t instance, uint8_t axis) { return _gyro_window[instance][axis]; }
     FloatBuffer&  get_raw_gyro_window(uint8_t axis) { return get_raw_gyro_window(_primary, axis); }
 #if AP_INERTIALSENSOR_HARMONICNOTCH_ENABLED
     bool has_fft_notch() const;
 #endif
 #endif
-    uint16_t get_raw_gyro_rate_hz(uint8_t instance) const { return _gyro_raw_sample_rates[_first_usable_gyro]; }
+    uint16_t get_raw_gyro_rate_hz(uint8_t instance) const { return _gyro_raw_sample_rates[instance]; }
     uint16_t get_raw_gyro_rate_hz() const { return get_raw_gyro_rate_hz(_first_usable_gyro); }
     bool set_gyro_window_size(uint16_t size);
     // get accel offsets in m/s/s
@@ -462,6 +464,14 @@ public:
         // Update the harmonic notch frequencies
         void update_freq_hz(float scaled_freq);
         void update_frequencies_hz(uint8_t num_freqs, const float scaled_freq[]);
+#if HAL_GYROFFT_ENABLED
+        // Update the frequencies of a single IMU, these take precedence over the shared frequencies
+        void update_frequencies_hz(uint8_t instance, uint8_t num_freqs, const float scaled_freq[]);
+
+        // per-IMU center frequencies when the FFT analyses every IMU
+        float calculated_imu_notch_freq_hz[INS_MAX_INSTANCES][INS_MAX_NOTCHES];
+        uint8_t num_calculated_imu_notch_frequencies[INS_MAX_INSTANCES];
+#endif
 
         // enable/disable the notch
         void set_inactive(bool _inactive) {
@@ -823,6 +833,8 @@ public:
     void set_rate_decimation(uint8_t rdec);
     // push a new gyro sample into the fast rate buffer
     bool push_next_gyro_sample(const Vector3f& gyro);
+    // push a burst of gyro samples, returning true and the index of the last one used if any were used
+    bool push_next_gyro_samples(const Vector3f *gyro, uint16_t n, uint16_t &last_used);
     // run the filter parmeter update code.
     void update_backend_filters();
     // are rate loop samples enabled for this instance?
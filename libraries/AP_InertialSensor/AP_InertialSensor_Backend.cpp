@@ -278,6 +278,81 @@ void AP_InertialSensor_Backend::apply_gyro_filters(const uint8_t instance, const
 #endif
 }
 
+/*
+  apply harmonic notch and low pass gyro filters to a burst of samples
+  in place. Each filter stage runs over the whole burst before the next
+ */
+void AP_InertialSensor_Backend::apply_gyro_filters(const uint8_t instance, Vector3f *gyro, uint16_t n)
+{
+    uint8_t filter_phase = 0;
+    for (uint16_t i = 0; i < n; i++) {
+        save_gyro_window(instance, gyro[i], filter_phase);
+    }
+    filter_phase++;
+
+#if AP_INERTIALSENSOR_HARMONICNOTCH_ENABLED
+    // apply the harmonic notch filters
+    for (auto &notch : _imu.harmonic_notches) {
+        if (!notch.params.enabled()) {
+            continue;
+        }
+        bool inactive = notch.is_inactive();
+        // by default we only run the expensive notch filters on the
+        // currently active IMU
+        if (!notch.params.hasOption(HarmonicNotchFilterParams::Options::EnableOnAllIMUs) &&
+            instance != _imu._primary) {
+            inactive = true;
+        }
+        if (inactive) {
+            notch.filter[instance].reset();
+        } else {
+            notch.filter[instance].apply(gyro, n);
+        }
+        for (uint16_t i = 0; i < n; i++) {
+            save_gyro_window(instance, gyro[i], filter_phase);
+        }
+        filter_phase++;
+    }
+#endif  // AP_INERTIALSENSOR_HARMONICNOTCH_ENABLED
+
+    // apply the low pass filter last to attenuate any notch induced noise
+    _imu._gyro_filter[instance].apply(gyro, n);
+
+    // if the filtering failed in any way then reset the filters and
+    // keep the old value for the rest of the burst
+    for (uint16_t i = 0; i < n; i++) {
+        if (!gyro[i].is_nan() && !gyro[i].is_inf()) {
+            continue;
+        }
+        _imu._gyro_filter[instance].reset();
+#if HAL_GYROFFT_ENABLED
+        _imu._post_filter_gyro_filter[instance].reset();
+#endif
+#if AP_INERTIALSENSOR_HARMONICNOTCH_ENABLED
+        for (auto &notch : _imu.harmonic_notches) {
+            notch.filter[instance].reset();
+        }
+#endif
+        const Vector3f last_good = i > 0 ? gyro[i-1] : _imu._gyro_filtered[instance];
+        for (uint16_t j = i; j < n; j++) {
+            gyro[j] = last_good;
+        }
+        break;
+    }
+
+#if AP_INERTIALSENSOR_FAST_SAMPLE_WINDOW_ENABLED
+    if (_imu.is_rate_loop_gyro_enabled(instance)) {
+        uint16_t last_used;
+        if (_imu.push_next_gyro_samples(gyro, n, last_used)) {
+            // if we used a value, record it for publication to the front-end
+            _imu._gyro_filtered[instance] = gyro[last_used];
+        }
+        return;
+    }
+#endif
+    _imu._gyro_filtered[instance] = gyro[n-1];
+}
+
 void AP_InertialSensor_Backend::_notify_new_gyro_raw_sample(uint8_t instance,
                                                             const Vector3f &gyro,
                                                             uint64_t sample_us)
@@ -323,42 +398,12 @@ void AP_InertialSensor_Backend::_notify_new_gyro_raw_sample(uint8_t instance,
     if (hal.opticalflow) {
         hal.opticalflow->push_gyro(gyro.x, gyro.y, dt);
     }
-    
-    // compute delta angle
-    Vector3f delta_angle = (gyro + _imu._last_raw_gyro[instance]) * 0.5f * dt;
-
-    // compute coning correction
-    // see page 26 of:
-    // Tian et al (2010) Three-loop Integration of GPS and Strapdown INS with Coning and Sculling Compensation
-    // Available: http://www.sage.unsw.edu.au/snap/publications/tian_etal2010b.pdf
-    // see also examples/coning.py
-    Vector3f delta_coning = (_imu._delta_angle_acc[instance] +
-                             _imu._last_delta_angle[instance] * (1.0f / 6.0f));
-    delta_coning = delta_coning % delta_angle;
-    delta_coning *= 0.5f;
 
     {
         WITH_SEMAPHORE(_sem);
         uint64_t now = AP_HAL::micros64();
 
-        if (now - last_sample_us > 100000U) {
-            // zero accumulator if sensor was unhealthy for 0.1s
-            _imu._delta_angle_acc[instance].zero();
-            _imu._delta_angle_acc_dt[instance] = 0;
-            dt = 0;
-            delta_angle.zero();
-        }
-
-        // integrate delta angle accumulator
-        // the angles and coning corrections are accumulated separately in the
-        // referenced paper, but in simulation little difference was found between
-        // integrating together and integrating separately (see examples/coning.py)
-        _imu._delta_angle_acc[instance] += delta_angle + delta_coning;
-        _imu._delta_angle_acc_dt[instance] += dt;
-
-        // save previous delta angle for coning correction
-        _imu._last_delta_angle[instance] = delta_angle;
-        _imu._last_raw_gyro[instance] = gyro;
+        integrate_gyro_sample(instance, gyro, dt, now - last_sample_us > 100000U);
 
         // apply gyro filters and sample for FFT
         apply_gyro_filters(instance, gyro);
@@ -371,6 +416,114 @@ void AP_InertialSensor_Backend::_notify_new_gyro_raw_sample(uint8_t instance,
     update_primary();
 }
 
+/*
+  handle a burst of raw gyro samples from a FIFO based sensor. This is
+  equivalent to calling _notify_new_gyro_raw_sample() with a zero
+  sample_us on each sample, but the filters are run over the whole
+  burst at once and the backend semaphore is taken once per burst
+ */
+void AP_InertialSensor_Backend::_notify_new_gyro_raw_samples(uint8_t instance,
+                                                             const Vector3f *gyro,
+                                                             uint16_t n)
+{
+    if (has_been_killed(instance)) {
+        return;
+    }
+
+    while (n > 0) {
+        const uint16_t len = MIN(n, uint16_t(INS_MAX_GYRO_BATCH_SAMPLES));
+
+        for (uint16_t i = 0; i < len; i++) {
+            _update_sensor_rate(_imu._sample_gyro_count[instance], _imu._sample_gyro_start_us[instance],
+                                _imu._gyro_raw_sample_rates[instance]);
+        }
+
+        // don't accept below 40Hz
+        if (_imu._gyro_raw_sample_rates[instance] < 40) {
+            return;
+        }
+
+        const float dt = 1.0f / _imu._gyro_raw_sample_rates[instance];
+        const uint64_t last_sample_us = _imu._gyro_last_sample_us[instance];
+        const uint64_t sample_us = AP_HAL::micros64();
+        _imu._gyro_last_sample_us[instance] = sample_us;
+
+        for (uint16_t i = 0; i < len; i++) {
+#if AP_MODULE_SUPPORTED
+            // call gyro_sample hook if any
+            AP_Module::call_hook_gyro_sample(instance, dt, gyro[i]);
+#endif
+            // push gyros if optical flow present
+            if (hal.opticalflow) {
+                hal.opticalflow->push_gyro(gyro[i].x, gyro[i].y, dt);
+            }
+        }
+
+        Vector3f *filtered = _gyro_filtered_batch;
+        {
+            WITH_SEMAPHORE(_sem);
+            const uint64_t now = AP_HAL::micros64();
+
+            for (uint16_t i = 0; i < len; i++) {
+                integrate_gyro_sample(instance, gyro[i], dt, i == 0 && now - last_sample_us > 100000U);
+                filtered[i] = gyro[i];
+            }
+
+            // apply gyro filters and sample for FFT
+            apply_gyro_filters(instance, filtered, len);
+
+            _imu._new_gyro_data[instance] = true;
+        }
+
+        for (uint16_t i = 0; i < len; i++) {
+            log_gyro_raw(instance, sample_us, gyro[i], filtered[i]);
+        }
+        update_primary();
+
+        gyro += len;
+        n -= len;
+    }
+}
+
+/*
+  integrate a gyro sample into the delta angle accumulator with coning
+  correction. Must be called with the backend semaphore held
+ */
+void AP_InertialSensor_Backend::integrate_gyro_sample(uint8_t instance, const Vector3f &gyro, float dt, bool reset_accumulator)
+{
+    // compute delta angle
+    Vector3f delta_angle = (gyro + _imu._last_raw_gyro[instance]) * 0.5f * dt;
+
+    // compute coning correction
+    // see page 26 of:
+    // Tian et al (2010) Three-loop Integration of GPS and Strapdown INS with Coning and Sculling Compensation
+    // Available: http://www.sage.unsw.edu.au/snap/publications/tian_etal2010b.pdf
+    // see also examples/coning.py
+    Vector3f delta_coning = (_imu._delta_angle_acc[instance] +
+                             _imu._last_delta_angle[instance] * (1.0f / 6.0f));
+    delta_coning = delta_coning % delta_angle;
+    delta_coning *= 0.5f;
+
+    if (reset_accumulator) {
+        // zero accumulator if sensor was unhealthy for 0.1s
+        _imu._delta_angle_acc[instance].zero();
+        _imu._delta_angle_acc_dt[instance] = 0;
+        dt = 0;
+        delta_angle.zero();
+    }
+
+    // integrate delta angle accumulator
+    // the angles and coning corrections are accumulated separately in the
+    // referenced paper, but in simulation little difference was found between
+    // integrating together and integrating separately (see examples/coning.py)
+    _imu._delta_angle_acc[instance] += delta_angle + delta_coning;
+    _imu._delta_angle_acc_dt[instance] += dt;
+
+    // save previous delta angle for coning correction
+    _imu._last_delta_angle[instance] = delta_angle;
+    _imu._last_raw_gyro[instance] = gyro;
+}
+
 /*
   handle a delta-angle sample from the backend. This assumes FIFO
   style sampling and the sample should not be rotated or corrected for
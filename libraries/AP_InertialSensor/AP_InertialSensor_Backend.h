@@ -178,7 +178,9 @@ protected:
 
     // apply notch and lowpass gyro filters and sample for FFT
     void apply_gyro_filters(const uint8_t instance, const Vector3f &gyro);
+    void apply_gyro_filters(const uint8_t instance, Vector3f *gyro, uint16_t n);
     void save_gyro_window(const uint8_t instance, const Vector3f &gyro, uint8_t phase);
+    void integrate_gyro_sample(uint8_t instance, const Vector3f &gyro, float dt, bool reset_accumulator);
 
     // this should be called every time a new gyro raw sample is
     // available - be it published or not the sample is raw in the
@@ -188,6 +190,10 @@ protected:
     // sensors, and should be set to zero for FIFO based sensors
     void _notify_new_gyro_raw_sample(uint8_t instance, const Vector3f &accel, uint64_t sample_us=0) __RAMFUNC__;
 
+    // burst version of _notify_new_gyro_raw_sample() for FIFO based
+    // sensors. The samples must be rotated and corrected
+    void _notify_new_gyro_raw_samples(uint8_t instance, const Vector3f *gyro, uint16_t n) __RAMFUNC__;
+
     // alternative interface using delta-angles. Rotation and correction is handled inside this function
     void _notify_new_delta_angle(uint8_t instance, const Vector3f &dangle);
     
@@ -362,6 +368,9 @@ protected:
 
 private:
 
+    // filtered copy of a gyro burst, kept off the bus thread stack
+    Vector3f _gyro_filtered_batch[INS_MAX_GYRO_BATCH_SAMPLES];
+
     bool should_log_imu_raw() const ;
     void log_accel_raw(uint8_t instance, const uint64_t sample_us, const Vector3f &accel) __RAMFUNC__;
     void log_gyro_raw(uint8_t instance, const uint64_t sample_us, const Vector3f &raw_gyro, const Vector3f &filtered_gyro) __RAMFUNC__;
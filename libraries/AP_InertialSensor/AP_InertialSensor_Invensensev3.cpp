@@ -448,6 +448,7 @@ bool AP_InertialSensor_Invensensev3::accumulate_samples(const FIFOData *data, ui
 #if INV3_ENABLE_FIFO_LOGGING
     const uint64_t tstart = AP_HAL::micros64();
 #endif
+    uint8_t n_gyro = 0;
     for (uint8_t i = 0; i < n_samples; i++) {
         const FIFOData &d = data[i];
 
@@ -457,6 +458,7 @@ bool AP_InertialSensor_Invensensev3::accumulate_samples(const FIFOData *data, ui
         // ICM42688 - HEADER_TIMESTAMP_FSYNC bit 2-3 : 10
         if ((d.header & 0xFC) != 0x68) { // ACCEL_EN | GYRO_EN | TMST_FIELD_EN
             // no or bad data
+            _notify_new_gyro_raw_samples(gyro_instance, gyro_batch, n_gyro);
             return false;
         }
 
@@ -477,10 +479,17 @@ bool AP_InertialSensor_Invensensev3::accumulate_samples(const FIFOData *data, ui
         _rotate_and_correct_gyro(gyro_instance, gyro);
 
         _notify_new_accel_raw_sample(accel_instance, accel, 0);
-        _notify_new_gyro_raw_sample(gyro_instance, gyro);
+
+        // gyro samples are filtered in bursts
+        gyro_batch[n_gyro++] = gyro;
+        if (n_gyro == ARRAY_SIZE(gyro_batch)) {
+            _notify_new_gyro_raw_samples(gyro_instance, gyro_batch, n_gyro);
+            n_gyro = 0;
+        }
 
         temp_filtered = temp_filter.apply(temp);
     }
+    _notify_new_gyro_raw_samples(gyro_instance, gyro_batch, n_gyro);
     return true;
 }
 
@@ -509,6 +518,7 @@ bool AP_InertialSensor_Invensensev3::accumulate_highres_samples(const FIFODataHi
 #if INV3_ENABLE_FIFO_LOGGING
     const uint64_t tstart = AP_HAL::micros64();
 #endif
+    uint8_t n_gyro = 0;
     for (uint8_t i = 0; i < n_samples; i++) {
         const FIFODataHighRes &d = data[i];
 
@@ -516,6 +526,7 @@ bool AP_InertialSensor_Invensensev3::accumulate_highres_samples(const FIFODataHi
         // about with the temperature registers
         if ((d.header & 0xFC) != 0x78) { // ACCEL_EN | GYRO_EN | HIRES_EN | TMST_FIELD_EN
             // no or bad data
+            _notify_new_gyro_raw_samples(gyro_instance, gyro_batch, n_gyro);
             return false;
         }
 
@@ -539,10 +550,17 @@ bool AP_InertialSensor_Invensensev3::accumulate_highres_samples(const FIFODataHi
         _rotate_and_correct_gyro(gyro_instance, gyro);
 
         _notify_new_accel_raw_sample(accel_instance, accel, 0);
-        _notify_new_gyro_raw_sample(gyro_instance, gyro);
+
+        // gyro samples are filtered in bursts
+        gyro_batch[n_gyro++] = gyro;
+        if (n_gyro == ARRAY_SIZE(gyro_batch)) {
+            _notify_new_gyro_raw_samples(gyro_instance, gyro_batch, n_gyro);
+            n_gyro = 0;
+        }
 
         temp_filtered = temp_filter.apply(temp);
     }
+    _notify_new_gyro_raw_samples(gyro_instance, gyro_batch, n_gyro);
     return true;
 }
 #endif
@@ -147,6 +147,10 @@ private:
     // buffer for fifo read
     void* fifo_buffer;
 
+    // gyro samples waiting to be filtered as a burst. Kept off the
+    // bus thread stack, which is small on ChibiOS
+    Vector3f gyro_batch[INS_MAX_GYRO_BATCH_SAMPLES];
+
     float temp_filtered;
     LowPassFilter2pFloat temp_filter;
     uint32_t sampling_rate_hz;
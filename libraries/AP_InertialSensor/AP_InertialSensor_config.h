@@ -40,6 +40,13 @@
 #define XYZ_AXIS_COUNT    3
 // The maximum we need to store is gyro-rate / loop-rate, worst case ArduCopter with BMI088 is 2000/400
 #define INS_MAX_GYRO_WINDOW_SAMPLES 8
+// largest burst of gyro samples filtered together. Every backend keeps
+// a filtered copy of the burst as a member, and drivers that read bursts
+// keep the raw samples too, so each sample costs 12 bytes of RAM per
+// backend, and again per driver that batches
+#ifndef INS_MAX_GYRO_BATCH_SAMPLES
+#define INS_MAX_GYRO_BATCH_SAMPLES 8
+#endif
 
 #define DEFAULT_IMU_LOG_BAT_MASK 0
 
@@ -142,6 +142,36 @@ bool AP_InertialSensor::push_next_gyro_sample(const Vector3f& gyro)
     return true;
 }
 
+/*
+  push a burst of samples, taking the lock and waking the rate thread
+  once for the whole burst
+ */
+bool AP_InertialSensor::push_next_gyro_samples(const Vector3f *gyro, uint16_t n, uint16_t &last_used)
+{
+    if (!fast_rate_buffer_enabled || fast_rate_buffer == nullptr) {
+        return false;
+    }
+
+    bool used = false;
+    WITH_SEMAPHORE(fast_rate_buffer->_mutex);
+
+    for (uint16_t i = 0; i < n; i++) {
+        if (++fast_rate_buffer->rate_decimation_count < fast_rate_buffer->rate_decimation) {
+            continue;
+        }
+        if (!fast_rate_buffer->_rate_loop_gyro_window.push(gyro[i])) {
+            debug("dropped rate loop sample");
+        }
+        fast_rate_buffer->rate_decimation_count = 0;
+        last_used = i;
+        used = true;
+    }
+    if (used) {
+        fast_rate_buffer->_notifier.signal();
+    }
+    return used;
+}
+
 void AP_InertialSensor::update_backend_filters()
 {
     for (uint8_t i=0; i<_backend_count; i++) {
@@ -202,6 +202,16 @@ const AP_Param::GroupInfo AP_Logger::var_info[] = {
     // @RebootRequired: True
     AP_GROUPINFO("_MAX_FILES", 12, AP_Logger, _params.max_log_files, MAX_LOG_FILES),
 
+#if AP_LOGGER_FILE_COMPRESSION_ENABLED
+    // @Param: _FILE_COMPRESS
+    // @DisplayName: Compress file logs
+    // @Description: When enabled, logs written to the filesystem are compressed in independent blocks, reducing the amount of data written to the card and downloaded. Replay reads compressed logs directly; other log tools need them expanded first with Tools/scripts/decompress_log.py.
+    // @Values: 0:Disabled,1:Enabled
+    // @User: Advanced
+    // @RebootRequired: True
+    AP_GROUPINFO("_FILE_COMPRESS", 13, AP_Logger, _params.file_compress, 0),
+#endif
+
     AP_GROUPEND
 };
 
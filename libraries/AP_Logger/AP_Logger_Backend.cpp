@@ -687,6 +687,8 @@ bool AP_Logger_Backend::logging_enabled() const
 
 void AP_Logger_Backend::Write_AP_Logger_Stats_File(const struct df_stats &_stats)
 {
+    struct df_write_stats ws {};
+    df_write_stats_take(ws);
     const struct log_DSF pkt {
         LOG_PACKET_HEADER_INIT(LOG_DF_FILE_STATS),
         time_us         : AP_HAL::micros64(),
@@ -696,6 +698,10 @@ void AP_Logger_Backend::Write_AP_Logger_Stats_File(const struct df_stats &_stats
         buf_space_min   : _stats.buf_space_min,
         buf_space_max   : _stats.buf_space_max,
         buf_space_avg   : (_stats.blocks) ? (_stats.buf_space_sigma / _stats.blocks) : 0,
+        wr_bytes        : ws.bytes,
+        wr_lat_p50      : ws.latency_p50_us,
+        wr_lat_p95      : ws.latency_p95_us,
+        wr_lat_max      : ws.latency_max_us,
     };
     WriteBlock(&pkt, sizeof(pkt));
 }
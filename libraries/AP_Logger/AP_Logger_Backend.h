@@ -250,6 +250,16 @@ protected:
     void df_stats_log();
     void df_stats_clear();
 
+    // throughput and latency of writes to storage since the last
+    // call, for backends which can measure them
+    struct df_write_stats {
+        uint32_t bytes;
+        uint32_t latency_p50_us;
+        uint32_t latency_p95_us;
+        uint32_t latency_max_us;
+    };
+    virtual void df_write_stats_take(struct df_write_stats &ws) {}
+
     AP_Logger_RateLimiter *rate_limiter;
 
 private:
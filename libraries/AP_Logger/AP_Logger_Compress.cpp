@@ -0,0 +1,200 @@
+#include "AP_Logger_Compress.h"
+
+#include <AP_Math/AP_Math.h>
+#include <string.h>
+
+// LZ4 block format constants
+#define LZ4_MIN_MATCH 4
+#define LZ4_LAST_LITERALS 5  // last bytes of a block are always literals
+#define LZ4_MF_LIMIT 12      // last match must start this far from the end
+
+static inline uint32_t read32(const uint8_t *p)
+{
+    uint32_t v;
+    memcpy(&v, p, sizeof(v));
+    return v;
+}
+
+/*
+  write an LZ4 length continuation: 255s followed by the remainder
+ */
+static uint8_t *write_length(uint8_t *op, uint32_t len)
+{
+    while (len >= 255) {
+        *op++ = 255;
+        len -= 255;
+    }
+    *op++ = len;
+    return op;
+}
+
+uint32_t AP_Logger_Compressor::compress_block(const uint8_t *src, uint16_t len, uint8_t *out, uint32_t out_space)
+{
+    const uint8_t *ip = src;
+    const uint8_t *anchor = src;
+    const uint8_t *const end = src + len;
+    uint8_t *op = out;
+    uint8_t *const oend = out + out_space;
+
+    if (len > LZ4_MF_LIMIT) {
+        const uint8_t *const mflimit = end - LZ4_MF_LIMIT;
+        const uint8_t *const matchlimit = end - LZ4_LAST_LITERALS;
+        while (ip < mflimit) {
+            const uint32_t seq = read32(ip);
+            const uint16_t h = (seq * 2654435761U) >> (32 - hash_bits);
+            const uint8_t *ref = src + table[h];
+            table[h] = ip - src;
+            if (ref >= ip || read32(ref) != seq) {
+                ip++;
+                continue;
+            }
+
+            // extend the match forwards
+            const uint8_t *mp = ip + LZ4_MIN_MATCH;
+            const uint8_t *rp = ref + LZ4_MIN_MATCH;
+            while (mp < matchlimit && *mp == *rp) {
+                mp++;
+                rp++;
+            }
+            const uint32_t lit_len = ip - anchor;
+            const uint32_t match_len = mp - ip - LZ4_MIN_MATCH;
+
+            // token, worst-case length bytes, literals and offset
+            if (uint32_t(oend - op) < 1 + lit_len/255 + 1 + lit_len + 2 + match_len/255 + 1) {
+                return 0;
+            }
+            uint8_t *token = op++;
+            *token = (MIN(lit_len, 15U) << 4) | MIN(match_len, 15U);
+            if (lit_len >= 15) {
+                op = write_length(op, lit_len - 15);
+            }
+            memcpy(op, anchor, lit_len);
+            op += lit_len;
+            const uint16_t offset = ip - ref;
+            *op++ = offset & 0xFF;
+            *op++ = offset >> 8;
+            if (match_len >= 15) {
+                op = write_length(op, match_len - 15);
+            }
+            ip = mp;
+            anchor = ip;
+        }
+    }
+
+    // trailing literals
+    const uint32_t lit_len = end - anchor;
+    if (uint32_t(oend - op) < 1 + lit_len/255 + 1 + lit_len) {
+        return 0;
+    }
+    *op++ = MIN(lit_len, 15U) << 4;
+    if (lit_len >= 15) {
+        op = write_length(op, lit_len - 15);
+    }
+    memcpy(op, anchor, lit_len);
+    op += lit_len;
+
+    return op - out;
+}
+
+uint32_t AP_Logger_Compressor::compress_frame(const uint8_t *raw, uint16_t raw_len, uint8_t *out)
+{
+    raw_len = MIN(raw_len, max_raw_len);
+
+    log_compressed_frame hdr {
+        magic1 : LOG_COMPRESSED_FRAME_MAGIC1,
+        magic2 : LOG_COMPRESSED_FRAME_MAGIC2,
+        raw_len : raw_len,
+        data_len : 0,
+    };
+    uint8_t *data = out + sizeof(hdr);
+    // only keep the compressed form if it is strictly smaller
+    if (raw_len > 0) {
+        hdr.data_len = compress_block(raw, raw_len, data, raw_len - 1);
+    }
+    if (hdr.data_len == 0) {
+        memcpy(data, raw, raw_len);
+        hdr.data_len = raw_len;
+    }
+    memcpy(out, &hdr, sizeof(hdr));
+    return sizeof(hdr) + hdr.data_len;
+}
+
+int32_t AP_Logger_Compressor::decompress_block(const uint8_t *src, uint16_t src_len, uint8_t *dst, uint16_t dst_len)
+{
+    const uint8_t *ip = src;
+    const uint8_t *const iend = src + src_len;
+    uint8_t *op = dst;
+    uint8_t *const oend = dst + dst_len;
+
+    while (ip < iend) {
+        const uint8_t token = *ip++;
+
+        uint32_t lit_len = token >> 4;
+        if (lit_len == 15) {
+            uint8_t b;
+            do {
+                if (ip >= iend) {
+                    return -1;
+                }
+                b = *ip++;
+                lit_len += b;
+            } while (b == 255);
+        }
+        if (lit_len > uint32_t(iend - ip) || lit_len > uint32_t(oend - op)) {
+            return -1;
+        }
+        memcpy(op, ip, lit_len);
+        op += lit_len;
+        ip += lit_len;
+        if (ip == iend) {
+            // the last sequence has no match
+            break;
+        }
+
+        if (iend - ip < 2) {
+            return -1;
+        }
+        const uint16_t offset = ip[0] | (ip[1] << 8);
+        ip += 2;
+        if (offset == 0 || offset > op - dst) {
+            return -1;
+        }
+        uint32_t match_len = token & 0x0F;
+        if (match_len == 15) {
+            uint8_t b;
+            do {
+                if (ip >= iend) {
+                    return -1;
+                }
+                b = *ip++;
+                match_len += b;
+            } while (b == 255);
+        }
+        match_len += LZ4_MIN_MATCH;
+        if (match_len > uint32_t(oend - op)) {
+            return -1;
+        }
+        // byte at a time as the match may overlap the output
+        const uint8_t *mp = op - offset;
+        for (uint32_t i=0; i<match_len; i++) {
+            op[i] = mp[i];
+        }
+        op += match_len;
+    }
+    return op - dst;
+}
+
+bool AP_Logger_Compressor::decompress_frame(const log_compressed_frame &hdr, const uint8_t *data, uint8_t *out)
+{
+    if (hdr.magic1 != LOG_COMPRESSED_FRAME_MAGIC1 ||
+        hdr.magic2 != LOG_COMPRESSED_FRAME_MAGIC2 ||
+        hdr.data_len > hdr.raw_len) {
+        return false;
+    }
+    if (hdr.data_len == hdr.raw_len) {
+        // stored
+        memcpy(out, data, hdr.raw_len);
+        return true;
+    }
+    return decompress_block(data, hdr.data_len, out, hdr.raw_len) == hdr.raw_len;
+}
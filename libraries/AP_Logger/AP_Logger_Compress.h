@@ -0,0 +1,63 @@
+/*
+  block-framed LZ4-style compression for log files
+
+  A compressed log is a sequence of independent frames, each a
+  log_compressed_frame header followed by data_len bytes. Every
+  frame can be decompressed on its own so a reader can start at any
+  frame boundary. The frame payload is an LZ4 block; when that would
+  not be smaller than the input the data is stored as-is and
+  data_len equals raw_len.
+ */
+#pragma once
+
+#include <AP_Common/AP_Common.h>
+#include <stdint.h>
+
+// chosen so a frame header never looks like a log message header
+#define LOG_COMPRESSED_FRAME_MAGIC1 0xA3
+#define LOG_COMPRESSED_FRAME_MAGIC2 0x5A
+
+struct PACKED log_compressed_frame {
+    uint8_t magic1;
+    uint8_t magic2;
+    uint16_t raw_len;
+    uint16_t data_len;
+};
+
+class AP_Logger_Compressor
+{
+public:
+    // largest amount of raw data in a single frame
+    static constexpr uint16_t max_raw_len = 16384;
+
+    // buffer space needed for a frame holding raw_len bytes of data
+    static constexpr uint32_t frame_bound(uint16_t raw_len) {
+        return sizeof(log_compressed_frame) + raw_len;
+    }
+
+    // compress raw_len bytes (at most max_raw_len) into a complete
+    // frame at out, which must have frame_bound(raw_len) bytes of
+    // space. Returns the length of the frame
+    uint32_t compress_frame(const uint8_t *raw, uint16_t raw_len, uint8_t *out);
+
+    // decode the payload of a frame into out, which must have
+    // hdr.raw_len bytes of space. Returns false on corrupt input
+    static bool decompress_frame(const log_compressed_frame &hdr, const uint8_t *data, uint8_t *out);
+
+    // check a buffer starts with a frame header
+    static bool is_frame_header(const uint8_t *buf) {
+        return buf[0] == LOG_COMPRESSED_FRAME_MAGIC1 && buf[1] == LOG_COMPRESSED_FRAME_MAGIC2;
+    }
+
+private:
+    // LZ4 block encode into out, giving up once out_space is used.
+    // Returns the encoded length or 0 if it did not fit
+    uint32_t compress_block(const uint8_t *src, uint16_t len, uint8_t *out, uint32_t out_space);
+    static int32_t decompress_block(const uint8_t *src, uint16_t src_len, uint8_t *dst, uint16_t dst_len);
+
+    // positions of recently seen 4-byte sequences, indexed by hash.
+    // Entries are never cleared; stale ones are rejected by
+    // comparing the bytes they point at
+    static constexpr uint8_t hash_bits = 12;
+    uint16_t table[1U<<hash_bits];
+};
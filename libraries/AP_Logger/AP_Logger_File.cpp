@@ -96,6 +96,27 @@ void AP_Logger_File::Init()
 
     _initialised = true;
 
+#if AP_LOGGER_FILE_COMPRESSION_ENABLED
+    if (_front._params.file_compress) {
+        compressor = NEW_NOTHROW AP_Logger_Compressor;
+        frame_buf = NEW_NOTHROW uint8_t[frame_buf_size];
+        if (compressor == nullptr || frame_buf == nullptr) {
+            delete compressor;
+            delete[] frame_buf;
+            compressor = nullptr;
+            frame_buf = nullptr;
+            DEV_PRINTF("AP_Logger_File: no memory for compression\n");
+        }
+    }
+#endif
+
+#if AP_LOGGER_FILE_WRITER_THREAD_ENABLED
+    writer_thread_created = hal.scheduler->thread_create(FUNCTOR_BIND_MEMBER(&AP_Logger_File::writer_thread, void), "log_write", 4096, AP_HAL::Scheduler::PRIORITY_IO, 0);
+    if (!writer_thread_created) {
+        DEV_PRINTF("AP_Logger_File: writer thread failed, writing from IO thread\n");
+    }
+#endif
+
     const char* custom_dir = hal.util->get_custom_log_directory();
     if (custom_dir != nullptr){
         _log_directory = custom_dir;
@@ -142,7 +163,7 @@ void AP_Logger_File::periodic_1Hz()
     AP_Logger_Backend::periodic_1Hz();
 
     if (_initialised &&
-        _write_fd == -1 && _read_fd == -1 &&
+        _write_fd == -1 && !_read_log.is_open() &&
         erase.log_num == 0 &&
         erase.was_logging) {
         // restart logging after an erase if needed
@@ -153,7 +174,7 @@ void AP_Logger_File::periodic_1Hz()
     
     if (_initialised &&
         !start_new_log_pending &&
-        _write_fd == -1 && _read_fd == -1 &&
+        _write_fd == -1 && !_read_log.is_open() &&
         logging_enabled() &&
         !recent_open_error()) {
         // setup to open the log in the backend thread
@@ -602,19 +623,17 @@ int16_t AP_Logger_File::get_log_data(const uint16_t list_entry, const uint16_t p
         return -1;
     }
 
-    if (_read_fd != -1 && log_num != _read_fd_log_num) {
-        AP::FS().close(_read_fd);
-        _read_fd = -1;
+    if (_read_log.is_open() && log_num != _read_log_num) {
+        _read_log.close();
     }
-    if (_read_fd == -1) {
+    if (!_read_log.is_open()) {
         char *fname = _log_file_name(log_num);
         if (fname == nullptr) {
             return -1;
         }
         stop_logging();
         EXPECT_DELAY_MS(3000);
-        _read_fd = AP::FS().open(fname, O_RDONLY);
-        if (_read_fd == -1) {
+        if (!_read_log.open(fname)) {
             _open_error_ms = AP_HAL::millis();
             int saved_errno = errno;
             ::printf("Log read open fail for %s - %s\n",
@@ -625,32 +644,20 @@ int16_t AP_Logger_File::get_log_data(const uint16_t list_entry, const uint16_t p
             return -1;            
         }
         free(fname);
-        _read_offset = 0;
-        _read_fd_log_num = log_num;
+        _read_log_num = log_num;
     }
     uint32_t ofs = page * (uint32_t)LOGGER_PAGE_SIZE + offset;
 
-    if (ofs != _read_offset) {
-        if (AP::FS().lseek(_read_fd, ofs, SEEK_SET) == (off_t)-1) {
-            AP::FS().close(_read_fd);
-            _read_fd = -1;
-            return -1;
-        }
-        _read_offset = ofs;
-    }
-    int16_t ret = (int16_t)AP::FS().read(_read_fd, data, len);
-    if (ret > 0) {
-        _read_offset += ret;
+    const int16_t ret = (int16_t)_read_log.read(ofs, data, len);
+    if (ret < 0) {
+        _read_log.close();
     }
     return ret;
 }
 
 void AP_Logger_File::end_log_transfer()
 {
-    if (_read_fd != -1) {
-        AP::FS().close(_read_fd);
-        _read_fd = -1;
-    }
+    _read_log.close();
 }
 
 /*
@@ -711,15 +718,29 @@ uint16_t AP_Logger_File::get_num_logs()
  */
 void AP_Logger_File::stop_logging(void)
 {
+    // if the file is in use, whoever is using it closes it when
+    // they are done with it
+    _write_fd_close_pending = true;
     // best-case effort to avoid annoying the IO thread
-    const bool have_sem = write_fd_semaphore.take(hal.util->get_soft_armed()?1:20);
+    if (write_fd_semaphore.take(hal.util->get_soft_armed()?1:20)) {
+        close_write_fd_if_pending();
+        write_fd_semaphore.give();
+    }
+}
+
+/*
+  close the log file if stop_logging() has asked for it. Must be
+  called with write_fd_semaphore held
+ */
+void AP_Logger_File::close_write_fd_if_pending(void)
+{
+    if (!_write_fd_close_pending) {
+        return;
+    }
+    _write_fd_close_pending = false;
     if (_write_fd != -1) {
-        int fd = _write_fd;
+        AP::FS().close(_write_fd);
         _write_fd = -1;
-        AP::FS().close(fd);
-    }
-    if (have_sem) {
-        write_fd_semaphore.give();
     }
 }
 
@@ -785,10 +806,7 @@ void AP_Logger_File::start_new_log(void)
 
     start_new_log_reset_variables();
 
-    if (_read_fd != -1) {
-        AP::FS().close(_read_fd);
-        _read_fd = -1;
-    }
+    _read_log.close();
 
     if (disk_space_avail() < _free_space_min_avail && disk_space() > 0) {
         DEV_PRINTF("Out of space for logging\n");
@@ -806,6 +824,8 @@ void AP_Logger_File::start_new_log(void)
     if (!write_fd_semaphore.take(1)) {
         return;
     }
+    // a log stopped while it was being written is still open
+    close_write_fd_if_pending();
     if (_write_filename) {
         free(_write_filename);
         _write_filename = nullptr;        
@@ -846,6 +866,11 @@ void AP_Logger_File::start_new_log(void)
     _open_error_ms = 0;
     _write_offset = 0;
     _writebuf.clear();
+#if AP_LOGGER_FILE_COMPRESSION_ENABLED
+    // each log starts on a frame boundary
+    frame_len = 0;
+    frame_ofs = 0;
+#endif
     write_fd_semaphore.give();
 
     // now update lastlog.txt with the new log number
@@ -883,7 +908,7 @@ void AP_Logger_File::flush(void)
 #if APM_BUILD_TYPE(APM_BUILD_Replay) || APM_BUILD_TYPE(APM_BUILD_UNKNOWN)
 {
     uint32_t tnow = AP_HAL::millis();
-    while (_write_fd != -1 && _initialised && !recent_open_error() && _writebuf.available()) {
+    while (_write_fd != -1 && _initialised && !recent_open_error() && pending_bytes()) {
         // convince the IO timer that it really is OK to write out
         // less than _writebuf_chunk bytes:
         if (tnow > 2001) { // avoid resetting _last_write_time to 0
@@ -923,6 +948,12 @@ void AP_Logger_File::io_timer(void)
         return;
     }
 
+    if (_write_fd_close_pending && write_fd_semaphore.take_nonblocking()) {
+        // the log was stopped while it was being written
+        close_write_fd_if_pending();
+        write_fd_semaphore.give();
+    }
+
     if (_write_fd == -1 || !_initialised || recent_open_error()) {
         return;
     }
@@ -934,7 +965,7 @@ void AP_Logger_File::io_timer(void)
         write_lastlog_file(log_num);
     }
 
-    uint32_t nbytes = _writebuf.available();
+    uint32_t nbytes = pending_bytes();
     if (nbytes == 0) {
         return;
     }
@@ -960,14 +991,57 @@ void AP_Logger_File::io_timer(void)
     }
 #endif
     _last_write_time = tnow;
-    if (nbytes > _writebuf_chunk) {
-        // be kind to the filesystem layer
-        nbytes = _writebuf_chunk;
+
+#if AP_LOGGER_FILE_WRITER_THREAD_ENABLED
+    if (writer_thread_created) {
+        // the writer thread does the actual writing in larger
+        // batches, so a slow card does not hold up the IO thread
+        writer_sem.signal();
+        return;
+    }
+#endif
+
+    write_chunk(_writebuf_chunk);
+}
+
+/*
+  write up to max_bytes from the write buffer to the log file
+  returns the number of bytes written
+ */
+uint32_t AP_Logger_File::write_chunk(uint32_t max_bytes)
+{
+    const uint32_t tnow = AP_HAL::millis();
+
+    last_io_operation = "write";
+    if (!write_fd_semaphore.take(1)) {
+        return 0;
+    }
+    close_write_fd_if_pending();
+    if (_write_fd == -1) {
+        write_fd_semaphore.give();
+        return 0;
     }
 
     uint32_t size;
-    const uint8_t *head = _writebuf.readptr(size);
-    nbytes = MIN(nbytes, size);
+    const uint8_t *head;
+#if AP_LOGGER_FILE_COMPRESSION_ENABLED
+    if (compressor != nullptr) {
+        if (frame_ofs == frame_len) {
+            fill_frame_buf(max_bytes);
+        }
+        head = &frame_buf[frame_ofs];
+        size = frame_len - frame_ofs;
+    } else
+#endif
+    {
+        head = _writebuf.readptr(size);
+    }
+    // be kind to the filesystem layer
+    uint32_t nbytes = MIN(max_bytes, size);
+    if (nbytes == 0) {
+        write_fd_semaphore.give();
+        return 0;
+    }
 
 #if !AP_FILESYSTEM_LITTLEFS_ENABLED
     // try to align writes on a 512 byte boundary to avoid filesystem reads
@@ -978,20 +1052,13 @@ void AP_Logger_File::io_timer(void)
         }
     }
 #endif
-    last_io_operation = "write";
-    if (!write_fd_semaphore.take(1)) {
-        return;
-    }
-    if (_write_fd == -1) {
-        write_fd_semaphore.give();
-        return;
-    }
 
     uint32_t bytes_until_fsync = AP::FS().bytes_until_fsync(_write_fd);
     if (bytes_until_fsync > 0 && nbytes > bytes_until_fsync) {
         nbytes = bytes_until_fsync; // write exactly enough to sync
     }
 
+    const uint32_t write_start_us = AP_HAL::micros();
     ssize_t nwritten = AP::FS().write(_write_fd, head, nbytes);
     last_io_operation = "";
     if (nwritten <= 0) {
@@ -1011,11 +1078,19 @@ void AP_Logger_File::io_timer(void)
             printf("Failed to write to File: %s\n", strerror(errno));
         }
         _last_write_failed = true;
+        nwritten = 0;
     } else {
         _last_write_failed = false;
         _last_write_ms = tnow;
         _write_offset += nwritten;
-        _writebuf.advance(nwritten);
+#if AP_LOGGER_FILE_COMPRESSION_ENABLED
+        if (compressor != nullptr) {
+            frame_ofs += nwritten;
+        } else
+#endif
+        {
+            _writebuf.advance(nwritten);
+        }
 
         // we know nwritten > 0 so we won't sync if bytes_until_fsync == 0
         if ((uint32_t)nwritten == bytes_until_fsync) {
@@ -1023,6 +1098,7 @@ void AP_Logger_File::io_timer(void)
             AP::FS().fsync(_write_fd);
             last_io_operation = "";
         }
+        write_stats_gather(nwritten, AP_HAL::micros() - write_start_us);
 
 #if AP_RTC_ENABLED && CONFIG_HAL_BOARD == HAL_BOARD_CHIBIOS
         // ChibiOS does not update mtime on writes, so if we opened
@@ -1037,6 +1113,109 @@ void AP_Logger_File::io_timer(void)
 #endif
     }
 
+    // stop_logging() may have been called during the write
+    close_write_fd_if_pending();
+    write_fd_semaphore.give();
+
+    return nwritten;
+}
+
+uint32_t AP_Logger_File::pending_bytes() const
+{
+    uint32_t ret = _writebuf.available();
+#if AP_LOGGER_FILE_COMPRESSION_ENABLED
+    ret += frame_len - frame_ofs;
+#endif
+    return ret;
+}
+
+#if AP_LOGGER_FILE_COMPRESSION_ENABLED
+/*
+  compress up to max_raw bytes from the write buffer into frames.
+  The raw data is released from the write buffer straight away; the
+  frames are kept until they have been written
+ */
+void AP_Logger_File::fill_frame_buf(uint32_t max_raw)
+{
+    frame_len = 0;
+    frame_ofs = 0;
+    uint32_t raw_total = 0;
+    while (raw_total < max_raw &&
+           frame_buf_size - frame_len >= AP_Logger_Compressor::frame_bound(_writebuf_chunk)) {
+        uint32_t size;
+        const uint8_t *raw = _writebuf.readptr(size);
+        size = MIN(size, _writebuf_chunk);
+        if (size == 0) {
+            break;
+        }
+        frame_len += compressor->compress_frame(raw, size, &frame_buf[frame_len]);
+        _writebuf.advance(size);
+        raw_total += size;
+    }
+}
+#endif
+
+#if AP_LOGGER_FILE_WRITER_THREAD_ENABLED
+/*
+  writer thread, woken by io_timer() when there is data to write.
+  Drains the buffer in large batches until less than a chunk remains;
+  io_timer() decides when a partial chunk is worth writing
+ */
+void AP_Logger_File::writer_thread(void)
+{
+    while (true) {
+        writer_sem.wait_blocking();
+        do {
+            if (write_chunk(HAL_LOGGER_WRITER_THREAD_BATCH_SIZE) == 0) {
+                break;
+            }
+        } while (pending_bytes() >= _writebuf_chunk);
+    }
+}
+#endif
+
+/*
+  record a completed write for the DSF message
+ */
+void AP_Logger_File::write_stats_gather(uint32_t bytes, uint32_t latency_us)
+{
+    write_stats.bytes += bytes;
+    write_stats.latency_max_us = MAX(write_stats.latency_max_us, latency_us);
+    uint8_t bucket = 0;
+    while (bucket < ARRAY_SIZE(write_stats.latency_hist)-1 && (latency_us >> (bucket+1)) != 0) {
+        bucket++;
+    }
+    write_stats.latency_hist[bucket]++;
+}
+
+/*
+  return write statistics since the last call. Percentiles are the
+  upper bound of the histogram bucket they fall in
+ */
+void AP_Logger_File::df_write_stats_take(struct df_write_stats &ws)
+{
+    // never make the caller wait on a slow write
+    if (!write_fd_semaphore.take_nonblocking()) {
+        return;
+    }
+    uint32_t count = 0;
+    for (const auto n : write_stats.latency_hist) {
+        count += n;
+    }
+    uint32_t sum = 0;
+    for (uint8_t i=0; i<ARRAY_SIZE(write_stats.latency_hist); i++) {
+        const uint32_t bucket_max_us = (1U << (i+1)) - 1;
+        sum += write_stats.latency_hist[i];
+        if (ws.latency_p50_us == 0 && sum*2 >= count) {
+            ws.latency_p50_us = MIN(bucket_max_us, write_stats.latency_max_us);
+        }
+        if (ws.latency_p95_us == 0 && sum*20 >= count*19) {
+            ws.latency_p95_us = MIN(bucket_max_us, write_stats.latency_max_us);
+        }
+    }
+    ws.bytes = write_stats.bytes;
+    ws.latency_max_us = write_stats.latency_max_us;
+    write_stats = {};
     write_fd_semaphore.give();
 }
 
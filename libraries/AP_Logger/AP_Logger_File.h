@@ -10,6 +10,8 @@
 
 #include <AP_HAL/utility/RingBuffer.h>
 #include "AP_Logger_Backend.h"
+#include "AP_Logger_FileView.h"
+#include "AP_Logger_Compress.h"
 
 #if HAL_LOGGING_FILESYSTEM_ENABLED
 
@@ -21,6 +23,10 @@
 #endif
 #endif
 
+#ifndef HAL_LOGGER_WRITER_THREAD_BATCH_SIZE
+#define HAL_LOGGER_WRITER_THREAD_BATCH_SIZE 65536
+#endif
+
 class AP_Logger_File : public AP_Logger_Backend
 {
 public:
@@ -63,7 +69,7 @@ public:
     // this method is used for mavlink system status and arming checks
     bool logging_failed() const override;
 
-    bool logging_started(void) const override { return _write_fd != -1; }
+    bool logging_started(void) const override { return _write_fd != -1 && !_write_fd_close_pending; }
     void io_timer(void) override;
 
 protected:
@@ -71,6 +77,7 @@ protected:
     bool WritesOK() const override;
     bool StartNewLogOK() const override;
     void PrepForArming_start_logging() override;
+    void df_write_stats_take(struct df_write_stats &ws) override;
 
 private:
     int _write_fd = -1;
@@ -81,9 +88,8 @@ private:
     bool _need_rtc_update;
 #endif
     
-    int _read_fd = -1;
-    uint16_t _read_fd_log_num;
-    uint32_t _read_offset;
+    AP_Logger_FileView _read_log;
+    uint16_t _read_log_num;
     uint32_t _write_offset;
     volatile uint32_t _open_error_ms;
     const char *_log_directory;
@@ -146,6 +152,11 @@ private:
     // bad fd
     HAL_Semaphore write_fd_semaphore;
 
+    // set by stop_logging() when it could not take write_fd_semaphore,
+    // so the next holder of the semaphore closes the file
+    volatile bool _write_fd_close_pending;
+    void close_write_fd_if_pending(void);
+
     // async erase state
     struct {
         bool was_logging;
@@ -156,6 +167,43 @@ private:
     const char *last_io_operation = "";
 
     bool start_new_log_pending;
+
+    uint32_t write_chunk(uint32_t max_bytes);
+
+    // bytes waiting to be written, including compressed frames
+    uint32_t pending_bytes() const;
+
+#if AP_LOGGER_FILE_COMPRESSION_ENABLED
+    // compressed frames waiting to be written. Each frame holds up to
+    // one chunk of the write buffer
+#if AP_LOGGER_FILE_WRITER_THREAD_ENABLED
+    static const uint8_t frames_per_write = HAL_LOGGER_WRITER_THREAD_BATCH_SIZE / HAL_LOGGER_WRITE_CHUNK_SIZE;
+#else
+    static const uint8_t frames_per_write = 1;
+#endif
+    static_assert(HAL_LOGGER_WRITE_CHUNK_SIZE <= AP_Logger_Compressor::max_raw_len, "a chunk must fit in one compressed frame");
+    static const uint32_t frame_buf_size = frames_per_write * AP_Logger_Compressor::frame_bound(HAL_LOGGER_WRITE_CHUNK_SIZE);
+    AP_Logger_Compressor *compressor;
+    uint8_t *frame_buf;
+    uint32_t frame_len;
+    uint32_t frame_ofs;
+    void fill_frame_buf(uint32_t max_raw);
+#endif
+
+#if AP_LOGGER_FILE_WRITER_THREAD_ENABLED
+    HAL_BinarySemaphore writer_sem;
+    bool writer_thread_created;
+    void writer_thread(void);
+#endif
+
+    // storage write statistics, protected by write_fd_semaphore.
+    // latency_hist[n] counts writes taking less than 2^(n+1) us
+    struct {
+        uint32_t bytes;
+        uint32_t latency_max_us;
+        uint16_t latency_hist[20];
+    } write_stats;
+    void write_stats_gather(uint32_t bytes, uint32_t latency_us);
 };
 
 #endif // HAL_LOGGING_FILESYSTEM_ENABLED
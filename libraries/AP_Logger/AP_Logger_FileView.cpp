@@ -0,0 +1,105 @@
+#include "AP_Logger_FileView.h"
+
+#if HAL_LOGGING_FILESYSTEM_ENABLED
+
+#include <AP_Filesystem/AP_Filesystem.h>
+#include <AP_Math/AP_Math.h>
+
+#if AP_LOGGER_FILE_MMAP_ENABLED
+#include <sys/mman.h>
+#endif
+
+bool AP_Logger_FileView::open(const char *filename)
+{
+    close();
+
+    fd = AP::FS().open(filename, O_RDONLY);
+    if (fd == -1) {
+        return false;
+    }
+    struct stat st;
+    if (AP::FS().stat(filename, &st) == 0) {
+        file_size = st.st_size;
+    }
+    fd_offset = 0;
+
+#if AP_LOGGER_FILE_MMAP_ENABLED
+    map();
+#endif
+    return true;
+}
+
+#if AP_LOGGER_FILE_MMAP_ENABLED
+/*
+  map the whole file. Fails (and we fall back to read()) for empty
+  files, filesystems which can't be mapped or if there is not enough
+  address space, which can happen with very large logs on 32 bit
+  boards
+ */
+void AP_Logger_FileView::map()
+{
+    if (file_size == 0 || file_size > SIZE_MAX) {
+        return;
+    }
+    map_base = (const uint8_t *)AP::FS().map(fd, file_size);
+    if (map_base == nullptr) {
+        return;
+    }
+    // logs are almost always read front to back
+    madvise(const_cast<uint8_t *>(map_base), file_size, MADV_SEQUENTIAL);
+}
+#endif
+
+void AP_Logger_FileView::close()
+{
+#if AP_LOGGER_FILE_MMAP_ENABLED
+    if (map_base != nullptr) {
+        AP::FS().unmap(fd, map_base, file_size);
+        map_base = nullptr;
+    }
+#endif
+    if (fd != -1) {
+        AP::FS().close(fd);
+        fd = -1;
+    }
+    file_size = 0;
+}
+
+bool AP_Logger_FileView::is_open() const
+{
+    return fd != -1;
+}
+
+ssize_t AP_Logger_FileView::read(uint64_t ofs, void *buf, size_t len)
+{
+#if AP_LOGGER_FILE_MMAP_ENABLED
+    if (map_base != nullptr) {
+        if (ofs >= file_size) {
+            return 0;
+        }
+        len = MIN(len, file_size - ofs);
+        memcpy(buf, &map_base[ofs], len);
+        return len;
+    }
+#endif
+    if (fd == -1) {
+        return -1;
+    }
+    if (ofs != fd_offset) {
+        // AP_Filesystem can only seek within the first 2GB
+        if (ofs > INT32_MAX) {
+            return -1;
+        }
+        if (AP::FS().lseek(fd, int32_t(ofs), SEEK_SET) == -1) {
+            return -1;
+        }
+        fd_offset = ofs;
+    }
+    const ssize_t ret = AP::FS().read(fd, buf, len);
+    if (ret > 0) {
+        fd_offset += ret;
+    }
+    return ret;
+}
+
+#endif // HAL_LOGGING_FILESYSTEM_ENABLED
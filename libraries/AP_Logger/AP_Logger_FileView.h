@@ -0,0 +1,58 @@
+/*
+  read-only random access to a log file.
+
+  Where AP_Filesystem can map the file it is memory-mapped so
+  callers can read it without a system call per chunk; otherwise
+  this falls back to lseek()/read()
+ */
+#pragma once
+
+#include "AP_Logger_config.h"
+
+#if HAL_LOGGING_FILESYSTEM_ENABLED
+
+#include <AP_Common/AP_Common.h>
+#include <sys/types.h>
+
+class AP_Logger_FileView
+{
+public:
+    AP_Logger_FileView() {}
+    ~AP_Logger_FileView() { close(); }
+
+    CLASS_NO_COPY(AP_Logger_FileView);
+
+    bool open(const char *filename);
+    void close();
+
+    bool is_open() const;
+
+    // size of the file when it was opened
+    uint64_t size() const { return file_size; }
+
+    // read up to len bytes starting at offset ofs. Returns the
+    // number of bytes read, 0 at end of file or -1 on error
+    ssize_t read(uint64_t ofs, void *buf, size_t len);
+
+    // the contents of the file if it is memory-mapped, otherwise
+    // nullptr
+    const uint8_t *mapped() const {
+#if AP_LOGGER_FILE_MMAP_ENABLED
+        return map_base;
+#else
+        return nullptr;
+#endif
+    }
+
+private:
+#if AP_LOGGER_FILE_MMAP_ENABLED
+    void map();
+    const uint8_t *map_base = nullptr;
+#endif
+
+    int fd = -1;
+    uint64_t fd_offset;
+    uint64_t file_size;
+};
+
+#endif // HAL_LOGGING_FILESYSTEM_ENABLED
@@ -47,6 +47,21 @@
 
 #endif
 
+// read logs through a memory mapping rather than a read() per chunk
+#ifndef AP_LOGGER_FILE_MMAP_ENABLED
+#define AP_LOGGER_FILE_MMAP_ENABLED HAL_LOGGING_FILESYSTEM_ENABLED && (CONFIG_HAL_BOARD == HAL_BOARD_SITL || CONFIG_HAL_BOARD == HAL_BOARD_LINUX)
+#endif
+
+// write file logs from a dedicated thread in large batches
+#ifndef AP_LOGGER_FILE_WRITER_THREAD_ENABLED
+#define AP_LOGGER_FILE_WRITER_THREAD_ENABLED HAL_LOGGING_FILESYSTEM_ENABLED && (CONFIG_HAL_BOARD == HAL_BOARD_LINUX)
+#endif
+
+// optional block-framed compression of file logs, see LOG_FILE_COMPRESS
+#ifndef AP_LOGGER_FILE_COMPRESSION_ENABLED
+#define AP_LOGGER_FILE_COMPRESSION_ENABLED HAL_LOGGING_FILESYSTEM_ENABLED && HAL_PROGRAM_SIZE_LIMIT_KB > 1024
+#endif
+
 #ifndef HAL_LOGGER_FILE_CONTENTS_ENABLED
 #define HAL_LOGGER_FILE_CONTENTS_ENABLED HAL_LOGGING_FILESYSTEM_ENABLED && !AP_FILESYSTEM_LITTLEFS_ENABLED
 #endif
@@ -228,6 +228,10 @@ struct PACKED log_DSF {
     uint32_t buf_space_min;
     uint32_t buf_space_max;
     uint32_t buf_space_avg;
+    uint32_t wr_bytes;
+    uint32_t wr_lat_p50;
+    uint32_t wr_lat_p95;
+    uint32_t wr_lat_max;
 };
 
 struct PACKED log_Event {
@@ -317,6 +321,9 @@ struct PACKED log_MAV {
     uint16_t stream_slowdown_ms;
     uint16_t times_full;
     uint32_t GCS_SYSID_last_seen_ms;
+    uint32_t sched_us;
+    uint16_t sched_max_us;
+    uint16_t missed_intervals;
 };
 
 struct PACKED log_RSSI {
@@ -714,6 +721,10 @@ struct PACKED log_VER {
 // @Field: FMn: Minimum free space in write buffer in last time period
 // @Field: FMx: Maximum free space in write buffer in last time period
 // @Field: FAv: Average free space in write buffer in last time period
+// @Field: WBy: Bytes written to storage in last time period
+// @Field: WL50: Median storage write time in last time period
+// @Field: WL95: 95th percentile storage write time in last time period
+// @Field: WLMx: Maximum storage write time in last time period
 
 // @LoggerMessage: ERR
 // @Description: Specifically coded error messages
@@ -780,6 +791,9 @@ struct PACKED log_VER {
 // @Field: ss: stream slowdown is the number of ms being added to each message to fit within bandwidth
 // @Field: tf: times buffer was full when a message was going to be sent
 // @Field: mgs: time MAV_GCS_SYSID heartbeat (or manual control) last seen
+// @Field: sus: time spent choosing which messages to send since the last MAV message
+// @Field: smx: longest time spent choosing messages in a single update since the last MAV message
+// @Field: mi: times a streamed message fell a whole interval behind since the last MAV message
 
 // @LoggerMessage: MAVC
 // @Description: MAVLink command we have just executed
@@ -1229,11 +1243,11 @@ LOG_STRUCTURE_FROM_HAL \
 LOG_STRUCTURE_FROM_RPM \
 LOG_STRUCTURE_FROM_FENCE \
     { LOG_DF_FILE_STATS, sizeof(log_DSF), \
-      "DSF", "QIHIIII", "TimeUS,Dp,Blk,Bytes,FMn,FMx,FAv", "s--b---", "F--0---" }, \
+      "DSF", "QIHIIIIIIII", "TimeUS,Dp,Blk,Bytes,FMn,FMx,FAv,WBy,WL50,WL95,WLMx", "s--b---bsss", "F--0---0FFF" }, \
     { LOG_RALLY_MSG, sizeof(log_Rally), \
       "RALY", "QBBLLhB", "TimeUS,Tot,Seq,Lat,Lng,Alt,Flags", "s--DUm-", "F--GGB-" },  \
     { LOG_MAV_MSG, sizeof(log_MAV),   \
-      "MAV", "QBHHHBHHI",   "TimeUS,chan,txp,rxp,rxdp,flags,ss,tf,mgs", "s#----s-s", "F-000-C-C" },   \
+      "MAV", "QBHHHBHHIIHH",   "TimeUS,chan,txp,rxp,rxdp,flags,ss,tf,mgs,sus,smx,mi", "s#----s-sss-", "F-000-C-CFF0" },   \
 LOG_STRUCTURE_FROM_VISUALODOM \
     { LOG_OPTFLOW_MSG, sizeof(log_Optflow), \
       "OF",   "QBffff",   "TimeUS,Qual,flowX,flowY,bodyX,bodyY", "s-EEEE", "F-0000" , true }, \
@@ -0,0 +1,69 @@
+#include <AP_gbenchmark.h>
+
+#include <AP_Logger/AP_Logger_Compress.h>
+#include <AP_Math/AP_Math.h>
+
+const AP_HAL::HAL& hal = AP_HAL::get_HAL();
+
+/*
+  cost of LOG_FILE_COMPRESS per MB of log data. The input is built
+  from IMU-like messages: a header, an incrementing timestamp and
+  sensor values with a little noise
+ */
+static uint8_t raw[1U<<20];
+static uint8_t frames[AP_Logger_Compressor::frame_bound(4096) * (sizeof(raw) / 4096)];
+static uint32_t frames_len;
+static AP_Logger_Compressor compressor;
+
+static void fill_log_data(void)
+{
+    uint64_t time_us = 0;
+    for (uint32_t ofs=0; ofs+40 <= sizeof(raw); ofs += 40) {
+        uint8_t *msg = &raw[ofs];
+        msg[0] = 0xA3;
+        msg[1] = 0x95;
+        msg[2] = 36;
+        time_us += 2500;
+        memcpy(&msg[3], &time_us, sizeof(time_us));
+        for (uint8_t i=0; i<7; i++) {
+            const float v = roundf(sinf(time_us * 1.0e-7 * (i+1)) * 100) * 0.01 + (random() % 8) * 0.001;
+            memcpy(&msg[11+4*i], &v, sizeof(v));
+        }
+        msg[39] = 0;
+    }
+}
+
+static void BM_LogCompress(benchmark::State &state)
+{
+    fill_log_data();
+    for (auto _ : state) {
+        frames_len = 0;
+        for (uint32_t ofs=0; ofs<sizeof(raw); ofs += 4096) {
+            frames_len += compressor.compress_frame(&raw[ofs], 4096, &frames[frames_len]);
+        }
+        gbenchmark_escape(frames);
+    }
+    state.SetBytesProcessed(int64_t(state.iterations()) * sizeof(raw));
+    state.counters["ratio"] = float(sizeof(raw)) / frames_len;
+}
+
+static void BM_LogDecompress(benchmark::State &state)
+{
+    static uint8_t out[4096];
+    for (auto _ : state) {
+        uint32_t ofs = 0;
+        while (ofs < frames_len) {
+            log_compressed_frame hdr;
+            memcpy(&hdr, &frames[ofs], sizeof(hdr));
+            AP_Logger_Compressor::decompress_frame(hdr, &frames[ofs+sizeof(hdr)], out);
+            ofs += sizeof(hdr) + hdr.data_len;
+        }
+        gbenchmark_escape(out);
+    }
+    state.SetBytesProcessed(int64_t(state.iterations()) * sizeof(raw));
+}
+
+BENCHMARK(BM_LogCompress);
+BENCHMARK(BM_LogDecompress);
+
+BENCHMARK_MAIN();
@@ -0,0 +1,101 @@
+#include <AP_gtest.h>
+
+/*
+  tests for AP_Logger/AP_Logger_Compress.cpp
+ */
+
+#include <AP_Logger/AP_Logger_Compress.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <AP_HAL/AP_HAL.h>
+const AP_HAL::HAL& hal = AP_HAL::get_HAL();
+
+static AP_Logger_Compressor compressor;
+
+// compress and expand a buffer, returning the frame length
+static uint32_t roundtrip(const uint8_t *raw, uint16_t len)
+{
+    static uint8_t frame[AP_Logger_Compressor::frame_bound(AP_Logger_Compressor::max_raw_len)];
+    static uint8_t out[AP_Logger_Compressor::max_raw_len];
+    const uint32_t frame_len = compressor.compress_frame(raw, len, frame);
+    EXPECT_LE(frame_len, AP_Logger_Compressor::frame_bound(len));
+    EXPECT_TRUE(AP_Logger_Compressor::is_frame_header(frame));
+
+    log_compressed_frame hdr;
+    memcpy(&hdr, frame, sizeof(hdr));
+    EXPECT_EQ(hdr.raw_len, len);
+    EXPECT_EQ(frame_len, sizeof(hdr) + hdr.data_len);
+    EXPECT_TRUE(AP_Logger_Compressor::decompress_frame(hdr, &frame[sizeof(hdr)], out));
+    EXPECT_EQ(memcmp(raw, out, len), 0);
+    return frame_len;
+}
+
+TEST(AP_Logger_Compress, repetitive)
+{
+    // log-like data: a repeated header and slowly changing payload
+    static uint8_t raw[4096];
+    for (uint16_t i=0; i<sizeof(raw); i++) {
+        raw[i] = (i % 32 < 3) ? 0xA3 : (i / 512);
+    }
+    const uint32_t frame_len = roundtrip(raw, sizeof(raw));
+    EXPECT_LT(frame_len, sizeof(raw) / 4);
+}
+
+TEST(AP_Logger_Compress, incompressible)
+{
+    static uint8_t raw[4096];
+    srandom(17);
+    for (uint16_t i=0; i<sizeof(raw); i++) {
+        raw[i] = random();
+    }
+    // stored frames cost exactly the header
+    EXPECT_EQ(roundtrip(raw, sizeof(raw)), sizeof(raw) + sizeof(log_compressed_frame));
+}
+
+TEST(AP_Logger_Compress, lengths)
+{
+    static uint8_t raw[1024];
+    srandom(3);
+    for (uint16_t i=0; i<sizeof(raw); i++) {
+        raw[i] = random() % 4;
+    }
+    for (uint16_t len=0; len<=sizeof(raw); len++) {
+        roundtrip(raw, len);
+    }
+}
+
+TEST(AP_Logger_Compress, corrupt)
+{
+    static uint8_t raw[2048];
+    for (uint16_t i=0; i<sizeof(raw); i++) {
+        raw[i] = (i * 7) % 61;
+    }
+    uint8_t frame[AP_Logger_Compressor::frame_bound(sizeof(raw))];
+    uint8_t out[sizeof(raw)];
+    compressor.compress_frame(raw, sizeof(raw), frame);
+    log_compressed_frame hdr;
+    memcpy(&hdr, frame, sizeof(hdr));
+    ASSERT_LT(hdr.data_len, hdr.raw_len);
+
+    // a truncated payload must be rejected rather than over-read
+    log_compressed_frame short_hdr = hdr;
+    short_hdr.data_len = hdr.data_len / 2;
+    EXPECT_FALSE(AP_Logger_Compressor::decompress_frame(short_hdr, &frame[sizeof(hdr)], out));
+
+    // bad magic
+    log_compressed_frame bad_hdr = hdr;
+    bad_hdr.magic2 = 0x95;
+    EXPECT_FALSE(AP_Logger_Compressor::decompress_frame(bad_hdr, &frame[sizeof(hdr)], out));
+
+    // random damage must never write outside the output buffer
+    srandom(5);
+    for (uint16_t i=0; i<1000; i++) {
+        uint8_t damaged[sizeof(frame)];
+        memcpy(damaged, frame, sizeof(frame));
+        damaged[sizeof(hdr) + random() % hdr.data_len] ^= 1U << (random() % 8);
+        AP_Logger_Compressor::decompress_frame(hdr, &damaged[sizeof(hdr)], out);
+    }
+}
+
+AP_GTEST_MAIN()
@@ -0,0 +1,114 @@
+/*
+  Levenberg-Marquardt least squares solver for small, fixed size
+  parameter sets, as used by the compass and accelerometer calibrators
+
+  The caller accumulates the normal equations from the jacobian and
+  residual of each sample with add(), then either takes a single
+  damped step with solve() or runs a full LM iteration with iterate()
+*/
+
+#pragma once
+
+#include <stdint.h>
+#include <math.h>
+
+#include "AP_Math.h"
+
+template <uint8_t N>
+class LevenbergMarquardt
+{
+public:
+    // clear the normal equations ready for a new set of samples
+    void reset()
+    {
+        memset(JTJ, 0, sizeof(JTJ));
+        memset(JTFI, 0, sizeof(JTFI));
+    }
+
+    // add one sample's jacobian and residual to the normal equations
+    void add(const float jacob[N], float residual)
+    {
+        for (uint8_t i = 0; i < N; i++) {
+            for (uint8_t j = 0; j < N; j++) {
+                JTJ[i*N+j] += jacob[i] * jacob[j];
+            }
+            JTFI[i] += jacob[i] * residual;
+        }
+    }
+
+    /*
+      step params along the solution of the normal equations, with
+      lambda added to the diagonal. A lambda of zero gives a
+      Gauss-Newton step. Returns false, leaving params untouched, if
+      the equations are singular
+     */
+    bool solve(float lambda, float params[N]) const
+    {
+        float inv[N*N];
+        memcpy(inv, JTJ, sizeof(inv));
+        for (uint8_t i = 0; i < N; i++) {
+            inv[i*N+i] += lambda;
+        }
+        if (!mat_inverse(inv, inv, N)) {
+            return false;
+        }
+        for (uint8_t row = 0; row < N; row++) {
+            for (uint8_t col = 0; col < N; col++) {
+                params[row] -= JTFI[col] * inv[row*N+col];
+            }
+        }
+        return true;
+    }
+
+    /*
+      one Levenberg-Marquardt iteration: try the steps damped by lambda
+      and lambda/damping, keep whichever improves the fitness most and
+      adjust lambda, see
+      http://en.wikipedia.org/wiki/Levenberg%E2%80%93Marquardt_algorithm#Choice_of_damping_parameter
+
+      P is the caller's parameter type, get_params(P&) returns the N
+      parameters being fitted within it and calc_fitness(const P&)
+      returns the mean squared residual of a parameter set. Returns
+      true if params and fitness were improved
+     */
+    template <typename P, typename GetParams, typename Fitness>
+    bool iterate(P &params, float &fitness, float &lambda, float damping,
+                 GetParams get_params, Fitness calc_fitness) const
+    {
+        P fit1_params = params;
+        P fit2_params = params;
+        if (!solve(lambda, get_params(fit1_params)) ||
+            !solve(lambda/damping, get_params(fit2_params))) {
+            return false;
+        }
+
+        // calculate fitness of two possible sets of parameters
+        const float fit1 = calc_fitness(fit1_params);
+        const float fit2 = calc_fitness(fit2_params);
+
+        // decide which of the two sets of parameters is best and store in fit1_params
+        float new_fitness = fitness;
+        if (fit1 > fitness && fit2 > fitness) {
+            // if neither set of parameters provided better results, increase lambda
+            lambda *= damping;
+        } else if (fit2 < fitness && fit2 < fit1) {
+            // if fit2 was better we will use it. decrease lambda
+            lambda /= damping;
+            fit1_params = fit2_params;
+            new_fitness = fit2;
+        } else if (fit1 < fitness) {
+            new_fitness = fit1;
+        }
+
+        if (isnan(new_fitness) || !(new_fitness < fitness)) {
+            return false;
+        }
+        fitness = new_fitness;
+        params = fit1_params;
+        return true;
+    }
+
+private:
+    float JTJ[N*N] {};
+    float JTFI[N] {};
+};
@@ -0,0 +1,131 @@
+#include <AP_gtest.h>
+
+#include <AP_Math/AP_Math.h>
+#include <AP_Math/LevenbergMarquardt.h>
+
+/*
+  a straight line y = a + b*x fitted to points off the line. The
+  residual is linear in the parameters, so a single undamped step from
+  any start lands on the least squares solution
+ */
+static const uint8_t num_points = 10;
+
+static float line_y(uint8_t i)
+{
+    // alternately above and below the line 2 + 0.5x
+    return 2 + 0.5f * i + ((i % 3) - 1) * 0.1f;
+}
+
+TEST(LevenbergMarquardt, SolvesLinearLeastSquares)
+{
+    float sx = 0, sy = 0, sxx = 0, sxy = 0;
+    for (uint8_t i = 0; i < num_points; i++) {
+        sx += i;
+        sy += line_y(i);
+        sxx += i * i;
+        sxy += i * line_y(i);
+    }
+    const float b = (num_points * sxy - sx * sy) / (num_points * sxx - sx * sx);
+    const float a = (sy - b * sx) / num_points;
+
+    float params[2] { -3, 7 };
+    LevenbergMarquardt<2> lm;
+    for (uint8_t i = 0; i < num_points; i++) {
+        const float jacob[2] { 1, float(i) };
+        lm.add(jacob, params[0] + params[1] * i - line_y(i));
+    }
+    ASSERT_TRUE(lm.solve(0, params));
+    EXPECT_NEAR(params[0], a, 1e-4);
+    EXPECT_NEAR(params[1], b, 1e-4);
+
+    // the gradient of the squared residuals is zero there
+    float grad_a = 0, grad_b = 0;
+    for (uint8_t i = 0; i < num_points; i++) {
+        const float r = params[0] + params[1] * i - line_y(i);
+        grad_a += r;
+        grad_b += r * i;
+    }
+    EXPECT_NEAR(grad_a, 0, 1e-4);
+    EXPECT_NEAR(grad_b, 0, 1e-3);
+}
+
+/*
+  an exponential decay y = A*exp(-k*t) fitted to exact samples, which
+  needs several damped iterations from a poor start
+ */
+struct Decay {
+    float *get_params() { return params; }
+    float params[2];    // A, k
+};
+
+static const uint8_t num_samples = 20;
+static const float decay_A = 5;
+static const float decay_k = 0.7;
+
+static float decay_t(uint8_t i)
+{
+    return i * 0.2f;
+}
+
+static float decay_residual(const Decay &d, uint8_t i)
+{
+    return d.params[0] * expf(-d.params[1] * decay_t(i)) - decay_A * expf(-decay_k * decay_t(i));
+}
+
+static float decay_fitness(const Decay &d)
+{
+    float sum = 0;
+    for (uint8_t i = 0; i < num_samples; i++) {
+        sum += sq(decay_residual(d, i));
+    }
+    return sum / num_samples;
+}
+
+TEST(LevenbergMarquardt, IterateConverges)
+{
+    Decay d { { 1, 0.1 } };
+    float fitness = decay_fitness(d);
+    float lambda = 1;
+    for (uint8_t iter = 0; iter < 50; iter++) {
+        LevenbergMarquardt<2> lm;
+        for (uint8_t i = 0; i < num_samples; i++) {
+            const float e = expf(-d.params[1] * decay_t(i));
+            const float jacob[2] { e, -d.params[0] * decay_t(i) * e };
+            lm.add(jacob, decay_residual(d, i));
+        }
+        const float last_fitness = fitness;
+        const Decay last = d;
+        if (lm.iterate(d, fitness, lambda, 10,
+                       [](Decay &fd) { return fd.get_params(); }, decay_fitness)) {
+            EXPECT_LT(fitness, last_fitness);
+            EXPECT_FLOAT_EQ(fitness, decay_fitness(d));
+        } else {
+            // no improvement leaves the fit as it was
+            EXPECT_EQ(fitness, last_fitness);
+            EXPECT_EQ(d.params[0], last.params[0]);
+            EXPECT_EQ(d.params[1], last.params[1]);
+        }
+    }
+
+    EXPECT_LT(fitness, 1e-8);
+    EXPECT_NEAR(d.params[0], decay_A, 1e-3);
+    EXPECT_NEAR(d.params[1], decay_k, 1e-3);
+}
+
+TEST(LevenbergMarquardt, SingularFails)
+{
+    // a single sample can not determine three parameters
+    LevenbergMarquardt<3> lm;
+    const float jacob[3] { 1, 1, 1 };
+    lm.add(jacob, 1);
+    float params[3] { 3, 4, 5 };
+    EXPECT_FALSE(lm.solve(0, params));
+    EXPECT_FLOAT_EQ(params[0], 3);
+    EXPECT_FLOAT_EQ(params[1], 4);
+    EXPECT_FLOAT_EQ(params[2], 5);
+
+    // damping makes it solvable
+    EXPECT_TRUE(lm.solve(1, params));
+}
+
+AP_GTEST_MAIN()
@@ -16,10 +16,10 @@
  */
 #include "AP_NavEKF_core_common.h"
 
-NavEKF_core_common::Matrix24 NavEKF_core_common::KH;
-NavEKF_core_common::Matrix24 NavEKF_core_common::KHP;
-NavEKF_core_common::Matrix24 NavEKF_core_common::nextP;
-NavEKF_core_common::Vector28 NavEKF_core_common::Kfusion;
+NAVEKF_SCRATCH_STORAGE NavEKF_core_common::Matrix24 NavEKF_core_common::KH;
+NAVEKF_SCRATCH_STORAGE NavEKF_core_common::Matrix24 NavEKF_core_common::KHP;
+NAVEKF_SCRATCH_STORAGE NavEKF_core_common::Matrix24 NavEKF_core_common::nextP;
+NAVEKF_SCRATCH_STORAGE NavEKF_core_common::Vector28 NavEKF_core_common::Kfusion;
 
 /*
   fill common scratch variables, for detecting re-use of variables between loops in SITL
@@ -17,10 +17,25 @@
 #pragma once
 
 #include <stdint.h>
+#include <AP_HAL/AP_HAL_Boards.h>
 #include <AP_Math/AP_Math.h>
 #include <AP_Math/vectorN.h>
 #include "AP_Nav_Common.h"
 
+/*
+  on Linux boards the EKF3 lanes may be run on parallel threads, so
+  each thread needs its own copy of the scratch variables
+ */
+#ifndef NAVEKF_SCRATCH_THREAD_LOCAL
+#define NAVEKF_SCRATCH_THREAD_LOCAL (CONFIG_HAL_BOARD == HAL_BOARD_LINUX)
+#endif
+
+#if NAVEKF_SCRATCH_THREAD_LOCAL
+#define NAVEKF_SCRATCH_STORAGE thread_local
+#else
+#define NAVEKF_SCRATCH_STORAGE
+#endif
+
 /*
   this declares a common parent class for AP_NavEKF2 and
   AP_NavEKF3. The purpose of this class is to hold common static
@@ -42,14 +57,42 @@ public:
 #endif
 
 protected:
-    static Matrix24 KH;                   // intermediate result used for covariance updates
-    static Matrix24 KHP;                  // intermediate result used for covariance updates
-    static Matrix24 nextP;                // Predicted covariance matrix before addition of process noise to diagonals
-    static Vector28 Kfusion;              // intermediate fusion vector
+    static NAVEKF_SCRATCH_STORAGE Matrix24 KH;      // intermediate result used for covariance updates
+    static NAVEKF_SCRATCH_STORAGE Matrix24 KHP;     // intermediate result used for covariance updates
+    static NAVEKF_SCRATCH_STORAGE Matrix24 nextP;   // Predicted covariance matrix before addition of process noise to diagonals
+    static NAVEKF_SCRATCH_STORAGE Vector28 Kfusion; // intermediate fusion vector
 
     // fill all the common scratch variables with NaN on SITL
     void fill_scratch_variables(void);
 
+    /*
+      calculate KHP = K*H*P for the fusion of a single observation
+      whose Jacobian H is non-zero only at the NumIdx state indexes
+      in idx. K*H has rank one, so KHP[i][j] = K[i] * (H*P)[j]. H*P is
+      formed first, then KHP row by row, with all inner loops running
+      along contiguous rows so the compiler is able to vectorise them
+     */
+    template <uint8_t NumIdx, typename HType>
+    static void calcKHP(const Vector28 &K, const HType &H, const uint8_t (&idx)[NumIdx],
+                        const Matrix24 &P, uint8_t stateIndexLim) {
+        ftype HP[24];
+        for (uint8_t j = 0; j <= stateIndexLim; j++) {
+            HP[j] = 0;
+        }
+        for (uint8_t k = 0; k < NumIdx; k++) {
+            const ftype Hk = H[idx[k]];
+            for (uint8_t j = 0; j <= stateIndexLim; j++) {
+                HP[j] += Hk * P[idx[k]][j];
+            }
+        }
+        for (uint8_t i = 0; i <= stateIndexLim; i++) {
+            const ftype Ki = K[i];
+            for (uint8_t j = 0; j <= stateIndexLim; j++) {
+                KHP[i][j] = Ki * HP[j];
+            }
+        }
+    }
+
     // zero part of an array for index range [n1,n2]
     static void zero_range(ftype *v, uint8_t n1, uint8_t n2) {
         memset(&v[n1], 0, sizeof(ftype)*(1+(n2-n1)));
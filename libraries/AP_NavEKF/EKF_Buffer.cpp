@@ -10,39 +10,33 @@
 
 // constructor
 ekf_ring_buffer::ekf_ring_buffer(uint8_t _elsize) :
-    elsize(_elsize),
-    buffer(nullptr)
+    datasize(_elsize - sizeof(EKF_obs_element_t)),
+    timestamps(nullptr),
+    data(nullptr)
 {}
 
 bool ekf_ring_buffer::init(uint8_t _size)
 {
-    if (buffer) {
-        free(buffer);
+    if (timestamps) {
+        free(timestamps);
     }
-    buffer = calloc(_size, elsize);
-    if (buffer == nullptr) {
+    timestamps = (uint32_t *)calloc(_size, sizeof(uint32_t) + datasize);
+    if (timestamps == nullptr) {
+        data = nullptr;
         return false;
     }
+    data = (uint8_t *)&timestamps[_size];
     size = _size;
     reset();
     return true;
 }
 
 /*
-  get buffer offset for an index
- */
-void *ekf_ring_buffer::get_offset(uint8_t idx) const
-{
-    return (void*)(((uint8_t*)buffer)+idx*uint32_t(elsize));
-}
-
-/*
-  get a reference to the timestamp for an index
+  get element data offset for an index
  */
-uint32_t ekf_ring_buffer::time_ms(uint8_t idx) const
+uint8_t *ekf_ring_buffer::get_offset(uint8_t idx) const
 {
-    EKF_obs_element_t *el = (EKF_obs_element_t *)get_offset(idx);
-    return el->time_ms;
+    return &data[idx*uint32_t(datasize)];
 }
 
 /*
@@ -55,25 +49,24 @@ bool ekf_ring_buffer::recall(void *element, const uint32_t sample_time_ms)
     bool ret = false;
     uint8_t best_index = 0;  // only valid when ret becomes true
     while (count > 0) {
-        const uint32_t toldest = time_ms(oldest);
-        const int32_t dt = sample_time_ms - toldest;
-        const bool matches = dt >= 0 && dt < 100;
-        if (matches) {
-            best_index = oldest;
-            ret = true;
-        }
+        const int32_t dt = sample_time_ms - timestamps[oldest];
         if (dt < 0) {
             // the oldest element is younger than we want, stop
             // searching and don't consume this element
             break;
         }
+        if (dt < 100) {
+            best_index = oldest;
+            ret = true;
+        }
         // discard the sample
         count--;
-        oldest = (oldest+1) % size;
+        oldest = next_index(oldest);
     }
 
     if (ret) {
-        memcpy(element, get_offset(best_index), elsize);
+        ((EKF_obs_element_t *)element)->time_ms = timestamps[best_index];
+        memcpy(((uint8_t *)element)+sizeof(EKF_obs_element_t), get_offset(best_index), datasize);
     }
 
     return ret;
@@ -85,20 +78,24 @@ bool ekf_ring_buffer::recall(void *element, const uint32_t sample_time_ms)
  */
 void ekf_ring_buffer::push(const void *element)
 {
-    if (buffer == nullptr) {
+    if (timestamps == nullptr) {
         return;
     }
 
     // Advance head to next available index
-    const uint8_t head = (oldest+count) % size;
+    uint8_t head = oldest+count;
+    if (head >= size) {
+        head -= size;
+    }
 
     // New data is written at the head
-    memcpy(get_offset(head), element, elsize);
+    timestamps[head] = ((const EKF_obs_element_t *)element)->time_ms;
+    memcpy(get_offset(head), ((const uint8_t *)element)+sizeof(EKF_obs_element_t), datasize);
 
     if (count < size) {
         count++;
     } else {
-        oldest = (oldest+1) % size;
+        oldest = next_index(oldest);
     }
 }
 
@@ -40,10 +40,19 @@ public:
     void reset();
 
 private:
-    const uint8_t elsize;
-    void *buffer;
+    // size of an element excluding the timestamp
+    const uint8_t datasize;
 
-    // size of allocated buffer in elsize units
+    /*
+      the timestamps are stored in their own array so that recall()
+      only needs to touch the element data it returns. The element
+      data, less the timestamp, follows the timestamps in the same
+      allocation
+     */
+    uint32_t *timestamps;
+    uint8_t *data;
+
+    // size of allocated buffer in elements
     uint8_t size;
 
     // index of the oldest element in the buffer
@@ -52,8 +61,13 @@ private:
     // total number of elements in the buffer
     uint8_t count;
 
-    uint32_t time_ms(uint8_t idx) const;
-    void *get_offset(uint8_t idx) const;
+    // return the index following idx
+    uint8_t next_index(uint8_t idx) const {
+        idx++;
+        return idx == size ? 0 : idx;
+    }
+
+    uint8_t *get_offset(uint8_t idx) const;
 };
 
 /*
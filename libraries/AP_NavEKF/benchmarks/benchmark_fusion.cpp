@@ -0,0 +1,95 @@
+#include <AP_gbenchmark.h>
+
+#include <AP_NavEKF/AP_NavEKF_core_common.h>
+
+const AP_HAL::HAL& hal = AP_HAL::get_HAL();
+
+/*
+  compare the cost of the K*H*P covariance correction for a single
+  magnetometer axis observation, which has ten non-zero Jacobian
+  entries, using the explicit KH product and the shared kernel
+ */
+class FusionBench : public NavEKF_core_common {
+public:
+    FusionBench() {
+        for (uint8_t i=0; i<24; i++) {
+            for (uint8_t j=0; j<24; j++) {
+                P[i][j] = (i == j) ? 1.0 : 0.01 * (i + j);
+            }
+            H[i] = 0;
+        }
+        for (uint8_t i=0; i<28; i++) {
+            Kfusion[i] = 0.001 * i;
+        }
+        for (uint8_t k=0; k<ARRAY_SIZE(magIdx); k++) {
+            H[magIdx[k]] = 0.1 * (k + 1);
+        }
+    }
+
+    void explicit_KH(void) {
+        for (unsigned i = 0; i<=23; i++) {
+            for (unsigned j = 0; j<=3; j++) {
+                KH[i][j] = Kfusion[i] * H[j];
+            }
+            for (unsigned j = 4; j<=15; j++) {
+                KH[i][j] = 0.0f;
+            }
+            for (unsigned j = 16; j<=21; j++) {
+                KH[i][j] = Kfusion[i] * H[j];
+            }
+            for (unsigned j = 22; j<=23; j++) {
+                KH[i][j] = 0.0f;
+            }
+        }
+        for (unsigned j = 0; j<=23; j++) {
+            for (unsigned i = 0; i<=23; i++) {
+                ftype res = 0;
+                res += KH[i][0] * P[0][j];
+                res += KH[i][1] * P[1][j];
+                res += KH[i][2] * P[2][j];
+                res += KH[i][3] * P[3][j];
+                res += KH[i][16] * P[16][j];
+                res += KH[i][17] * P[17][j];
+                res += KH[i][18] * P[18][j];
+                res += KH[i][19] * P[19][j];
+                res += KH[i][20] * P[20][j];
+                res += KH[i][21] * P[21][j];
+                KHP[i][j] = res;
+            }
+        }
+        gbenchmark_escape(&KHP);
+    }
+
+    void kernel_KHP(void) {
+        calcKHP(Kfusion, H, magIdx, P, 23);
+        gbenchmark_escape(&KHP);
+    }
+
+private:
+    static constexpr uint8_t magIdx[] { 0, 1, 2, 3, 16, 17, 18, 19, 20, 21 };
+    Matrix24 P;
+    ftype H[24];
+};
+
+constexpr uint8_t FusionBench::magIdx[];
+
+static void BM_FusionExplicitKH(benchmark::State& state)
+{
+    static FusionBench bench;
+    while (state.KeepRunning()) {
+        bench.explicit_KH();
+    }
+}
+
+static void BM_FusionKernel(benchmark::State& state)
+{
+    static FusionBench bench;
+    while (state.KeepRunning()) {
+        bench.kernel_KHP();
+    }
+}
+
+BENCHMARK(BM_FusionExplicitKH);
+BENCHMARK(BM_FusionKernel);
+
+BENCHMARK_MAIN();
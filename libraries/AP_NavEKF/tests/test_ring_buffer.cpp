@@ -122,6 +122,38 @@ TEST(EKF_Buffer, EKF_Buffer)
     EXPECT_FALSE(buf.recall(d2, 103));
 }
 
+TEST(EKF_Buffer, element_layout)
+{
+    // elements are stored with the timestamp separate from the rest
+    // of the data, check a padded element survives the round trip
+    struct test_data : EKF_obs_element_t {
+        double value;
+        uint8_t index;
+    };
+    EKF_obs_buffer_t<test_data> buf;
+    buf.init(3);
+    struct test_data d, d2;
+    for (uint8_t i=0; i<5; i++) {
+        d.time_ms = 100+i;
+        d.value = i * 1.5;
+        d.index = i;
+        buf.push(d);
+    }
+
+    // the two oldest elements have been overwritten
+    EXPECT_TRUE(buf.recall(d2, 103));
+    EXPECT_EQ(d2.time_ms, uint32_t(103));
+    EXPECT_EQ(d2.value, 4.5);
+    EXPECT_EQ(d2.index, 3U);
+
+    EXPECT_TRUE(buf.recall(d2, 110));
+    EXPECT_EQ(d2.time_ms, uint32_t(104));
+    EXPECT_EQ(d2.value, 6.0);
+    EXPECT_EQ(d2.index, 4U);
+
+    EXPECT_FALSE(buf.recall(d2, 110));
+}
+
 TEST(ekf_imu_buffer, one_element_case)
 {
     // test degenerate 1-element case:
@@ -13,6 +13,10 @@
 
 #include <new>
 
+#if EK3_FEATURE_PARALLEL_LANES
+extern const AP_HAL::HAL& hal;
+#endif
+
 /*
   parameter defaults for different types of vehicle. The
   APM_BUILD_DIRECTORY is taken from the main vehicle directory name
@@ -739,8 +743,8 @@ const AP_Param::GroupInfo NavEKF3::var_info2[] = {
 
     // @Param: OPTIONS
     // @DisplayName: Optional EKF behaviour
-    // @Description: EKF optional behaviour. Bit 0 (JammingExpected): Setting JammingExpected will change the EKF behaviour such that if dead reckoning navigation is possible it will require the preflight alignment GPS quality checks controlled by EK3_GPS_CHECK and EK3_CHECK_SCALE to pass before resuming GPS use if GPS lock is lost for more than 2 seconds to prevent bad position estimate. Bit 1 (Manual lane switching): DANGEROUS – If enabled, this disables automatic lane switching. If the active lane becomes unhealthy, no automatic switching will occur. Users must manually set EK3_PRIMARY to change lanes. No health checks will be performed on the selected lane. Use with extreme caution.  Bit 2 (Optflow may use terrain alt): Terrain SRTM data will be used if the vehicle climbs above the rangefinder's range allowing optical flow to be used at higher altitudes.
-    // @Bitmask: 0:JammingExpected, 1:ManualLaneSwitching, 2:Optflow may use terrain alt
+    // @Description: EKF optional behaviour. Bit 0 (JammingExpected): Setting JammingExpected will change the EKF behaviour such that if dead reckoning navigation is possible it will require the preflight alignment GPS quality checks controlled by EK3_GPS_CHECK and EK3_CHECK_SCALE to pass before resuming GPS use if GPS lock is lost for more than 2 seconds to prevent bad position estimate. Bit 1 (Manual lane switching): DANGEROUS – If enabled, this disables automatic lane switching. If the active lane becomes unhealthy, no automatic switching will occur. Users must manually set EK3_PRIMARY to change lanes. No health checks will be performed on the selected lane. Use with extreme caution.  Bit 2 (Optflow may use terrain alt): Terrain SRTM data will be used if the vehicle climbs above the rangefinder's range allowing optical flow to be used at higher altitudes. Bit 3 (Parallel lanes): On multi-core Linux boards each lane is run on its own thread, with lane selection waiting for all lanes to complete. The shared EKF origin is published after all lanes have run.
+    // @Bitmask: 0:JammingExpected, 1:ManualLaneSwitching, 2:Optflow may use terrain alt, 3:Parallel lanes
     // @User: Advanced
     AP_GROUPINFO("OPTIONS",  11, NavEKF3, _options, 0),
 
@@ -877,6 +881,111 @@ bool NavEKF3::InitialiseFilter(void)
     return ret;
 }
 
+#if EK3_FEATURE_PARALLEL_LANES
+/*
+  run a single lane each time the main thread signals the start of an update
+ */
+void NavEKF3::LaneWorker::thread_main(void)
+{
+    while (true) {
+        if (!start_sem.wait_blocking()) {
+            continue;
+        }
+        frontend->core[core_index].UpdateFilter(allow_state_prediction);
+        done_sem.signal();
+    }
+}
+
+/*
+  start one worker thread for each lane other than lane zero
+ */
+bool NavEKF3::start_lane_workers(void)
+{
+    if (lane_workers != nullptr) {
+        return true;
+    }
+    if (lane_workers_failed) {
+        return false;
+    }
+    lane_workers = NEW_NOTHROW LaneWorker[num_cores];
+    if (lane_workers == nullptr) {
+        lane_workers_failed = true;
+        return false;
+    }
+    for (uint8_t i=1; i<num_cores; i++) {
+        LaneWorker &worker = lane_workers[i];
+        worker.frontend = this;
+        worker.core_index = i;
+        if (!hal.scheduler->thread_create(FUNCTOR_BIND(&worker, &NavEKF3::LaneWorker::thread_main, void),
+                                          "EKF3",
+                                          16384, AP_HAL::Scheduler::PRIORITY_MAIN, 0)) {
+            // threads which have started are left idle and never signalled
+            GCS_SEND_TEXT(MAV_SEVERITY_WARNING, "EKF3: failed to start lane threads");
+            lane_workers_failed = true;
+            return false;
+        }
+    }
+    return true;
+}
+#endif  // EK3_FEATURE_PARALLEL_LANES
+
+/*
+  if we have not overrun by more than 3 IMU frames, and we have
+  already used more than 1/3 of the CPU budget for this loop then
+  suppress the prediction step. This allows multiple EKF instances to
+  cooperate on scheduling
+ */
+bool NavEKF3::allow_state_prediction(uint8_t i) const
+{
+    return !(core[i].getFramesSincePredict() < (_framesPerPrediction+3) &&
+             dal.ekf_low_time_remaining(AP_DAL::EKFType::EKF3, i));
+}
+
+/*
+  run the filter update for all cores. With the ParallelLanes option
+  set the lanes are run concurrently on multi-core boards and the
+  main thread waits for all lanes to complete before lane selection.
+  Lanes do not share state during an update, with the exception of
+  the common origin which is published here in lane order so the
+  result is independent of thread scheduling and is reproduced by
+  Replay, which always runs the lanes serially
+ */
+void NavEKF3::UpdateFilterCores(void)
+{
+    const bool parallel_lanes = option_is_enabled(Option::ParallelLanes);
+
+#if EK3_FEATURE_PARALLEL_LANES
+    if (parallel_lanes && num_cores > 1 && start_lane_workers()) {
+        // the lanes share the loop's time budget, so decide on
+        // prediction for all of them before any starts
+        bool allow_prediction[MAX_EKF_CORES];
+        for (uint8_t i=0; i<num_cores; i++) {
+            allow_prediction[i] = allow_state_prediction(i);
+        }
+        for (uint8_t i=1; i<num_cores; i++) {
+            lane_workers[i].allow_state_prediction = allow_prediction[i];
+            lane_workers[i].start_sem.signal();
+        }
+        core[0].UpdateFilter(allow_prediction[0]);
+        for (uint8_t i=1; i<num_cores; i++) {
+            IGNORE_RETURN(lane_workers[i].done_sem.wait_blocking());
+        }
+    } else
+#endif
+    {
+        for (uint8_t i=0; i<num_cores; i++) {
+            // each lane sees the time used by the lanes before it
+            core[i].UpdateFilter(allow_state_prediction(i));
+        }
+    }
+
+    if (parallel_lanes) {
+        for (uint8_t i=0; i<num_cores; i++) {
+            core[i].publishPendingOrigin();
+        }
+    }
+}
+
 /*
   return true if a new core index has a better score than the current
   core
@@ -917,18 +1026,7 @@ void NavEKF3::UpdateFilter(void)
 
     imuSampleTime_us = dal.micros64();
 
-    for (uint8_t i=0; i<num_cores; i++) {
-        // if we have not overrun by more than 3 IMU frames, and we
-        // have already used more than 1/3 of the CPU budget for this
-        // loop then suppress the prediction step. This allows
-        // multiple EKF instances to cooperate on scheduling
-        bool allow_state_prediction = true;
-        if (core[i].getFramesSincePredict() < (_framesPerPrediction+3) &&
-            dal.ekf_low_time_remaining(AP_DAL::EKFType::EKF3, i)) {
-            allow_state_prediction = false;
-        }
-        core[i].UpdateFilter(allow_state_prediction);
-    }
+    UpdateFilterCores();
 
     // If the current core selected has a bad error score or is unhealthy, switch to a healthy core with the lowest fault score
     // Don't start running the check until the primary core has started returned healthy for at least 10 seconds to avoid switching
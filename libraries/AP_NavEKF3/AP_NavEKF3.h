@@ -24,12 +24,18 @@
 #include <AP_Param/AP_Param.h>
 #include <AP_NavEKF/AP_Nav_Common.h>
 #include <AP_NavEKF/AP_NavEKF_Source.h>
+#include "AP_NavEKF3_feature.h"
+
+#if EK3_FEATURE_PARALLEL_LANES
+#include <AP_HAL/AP_HAL.h>
+#endif
 
 class NavEKF3_core;
 class EKFGSF_yaw;
 
 class NavEKF3 {
     friend class NavEKF3_core;
+    friend class NavEKF3_core_Test;
 
 public:
     NavEKF3();
@@ -466,6 +472,7 @@ private:
         JammingExpected         = (1<<0),
         ManualLaneSwitch        = (1<<1),
         OptflowMayUseTerrainAlt = (1<<2),
+        ParallelLanes           = (1<<3),
     };
     bool option_is_enabled(Option option) const {
         return (_options & (uint32_t)option) != 0;
@@ -554,6 +561,30 @@ private:
     // origin set by one of the cores
     Location common_EKF_origin;
     bool common_origin_valid;
+
+#if EK3_FEATURE_PARALLEL_LANES
+    // worker thread used to run a single lane in parallel with the
+    // main thread. Lane zero is always run on the main thread
+    struct LaneWorker {
+        NavEKF3 *frontend;
+        uint8_t core_index;
+        bool allow_state_prediction;
+        HAL_BinarySemaphore start_sem;
+        HAL_BinarySemaphore done_sem;
+        void thread_main(void);
+    };
+    LaneWorker *lane_workers;
+    bool lane_workers_failed;       // true if the lane threads could not be started
+
+    // start the lane worker threads, returns true if they are running
+    bool start_lane_workers(void);
+#endif
+
+    // true if a core may run its state prediction within this loop's time budget
+    bool allow_state_prediction(uint8_t i) const;
+
+    // run UpdateFilter on all cores, in parallel if enabled
+    void UpdateFilterCores(void);
     
     // update the yaw reset data to capture changes due to a lane switch
     // new_primary - index of the ekf instance that we are about to switch to as the primary
@@ -714,7 +714,11 @@ bool NavEKF3_core::setOrigin(const Location &loc)
 
     GCS_SEND_TEXT(MAV_SEVERITY_INFO, "EKF3 IMU%u origin set",(unsigned)imu_index);
 
-    if (!frontend->common_origin_valid) {
+    if (frontend->option_is_enabled(NavEKF3::Option::ParallelLanes)) {
+        // other lanes may be running concurrently, so the frontend
+        // publishes the origin in lane order after the update
+        publicOriginPending = true;
+    } else if (!frontend->common_origin_valid) {
         frontend->common_origin_valid = true;
         // put origin in frontend as well to ensure it stays in sync between lanes
         public_origin = EKF_origin;
@@ -724,6 +728,20 @@ bool NavEKF3_core::setOrigin(const Location &loc)
     return true;
 }
 
+// publish an origin set during the last update as the common origin
+// if no other lane has already done so
+void NavEKF3_core::publishPendingOrigin(void)
+{
+    if (!publicOriginPending) {
+        return;
+    }
+    publicOriginPending = false;
+    if (!frontend->common_origin_valid && validOrigin) {
+        frontend->common_origin_valid = true;
+        public_origin = EKF_origin;
+    }
+}
+
 // record all requested yaw resets completed
 void NavEKF3_core::recordYawResetsCompleted()
 {
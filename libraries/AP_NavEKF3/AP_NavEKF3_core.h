@@ -126,6 +126,8 @@
 
 class NavEKF3_core : public NavEKF_core_common
 {
+    friend class NavEKF3_core_Test;
+
 public:
     // Constructor
     NavEKF3_core(class NavEKF3 *_frontend, class AP_DAL &dal);
@@ -230,6 +232,11 @@ public:
     // returns false if the origin has already been set
     bool setOriginLLH(const Location &loc);
 
+    // publish an origin set during the last update as the common
+    // origin if no other lane has already done so. Used when lanes
+    // may be run in parallel
+    void publishPendingOrigin(void);
+
     // Set the EKF's NE horizontal position states and their corresponding variances from a supplied WGS-84 location and uncertainty
     // The altitude element of the location is not used.
     // Returns true if the set was successful
@@ -1165,6 +1172,7 @@ private:
     Location EKF_origin;     // LLH origin of the NED axis system, internal only
     Location &public_origin; // LLH origin of the NED axis system, public functions
     bool validOrigin;               // true when the EKF origin is valid
+    bool publicOriginPending;       // true when the EKF origin is waiting to be published as the common origin
     ftype gpsSpdAccuracy;           // estimated speed accuracy in m/s returned by the GPS receiver
     ftype gpsPosAccuracy;           // estimated position accuracy in m returned by the GPS receiver
     ftype gpsHgtAccuracy;           // estimated height accuracy in m returned by the GPS receiver
@@ -51,3 +51,8 @@
 #ifndef EK3_FEATURE_OPTFLOW_SRTM
 #define EK3_FEATURE_OPTFLOW_SRTM EK3_FEATURE_OPTFLOW_FUSION
 #endif
+
+// running lanes on parallel threads on multi-core Linux boards
+#ifndef EK3_FEATURE_PARALLEL_LANES
+#define EK3_FEATURE_PARALLEL_LANES ((CONFIG_HAL_BOARD == HAL_BOARD_LINUX) && !(EK3_FEATURE_ALL))
+#endif
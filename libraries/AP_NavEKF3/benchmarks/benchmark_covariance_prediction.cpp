@@ -0,0 +1,57 @@
+#include <AP_gbenchmark.h>
+
+#include "../tests/NavEKF3_core_test.h"
+
+const AP_HAL::HAL& hal = AP_HAL::get_HAL();
+
+static NavEKF3 ekf;
+
+/*
+  cost of one covariance prediction with the wind states active,
+  with the magnetic field states active, which evaluates every
+  column, and inhibited, which skips their columns
+ */
+class CovariancePredictionBench
+{
+public:
+    CovariancePredictionBench(bool inhibit_mag) :
+        core(ekf)
+    {
+        core.setup(false, false, inhibit_mag, false);
+        core.get_P(initial_P);
+    }
+
+    void predict(void)
+    {
+        // start from the same covariance each time so the cost does
+        // not drift as it converges
+        core.set_P(initial_P);
+        core.predict();
+        gbenchmark_escape(&core);
+    }
+
+private:
+    NavEKF3_core_Test core;
+    ftype initial_P[24][24];
+};
+
+static void BM_CovariancePredictionMagActive(benchmark::State& state)
+{
+    static CovariancePredictionBench bench(false);
+    while (state.KeepRunning()) {
+        bench.predict();
+    }
+}
+
+static void BM_CovariancePredictionMagInhibited(benchmark::State& state)
+{
+    static CovariancePredictionBench bench(true);
+    while (state.KeepRunning()) {
+        bench.predict();
+    }
+}
+
+BENCHMARK(BM_CovariancePredictionMagActive);
+BENCHMARK(BM_CovariancePredictionMagInhibited);
+
+BENCHMARK_MAIN();
@@ -0,0 +1,113 @@
+#pragma once
+
+/*
+  drive the covariance prediction of a single NavEKF3 core directly,
+  from a repeatable mid-flight state. Shared by the covariance
+  prediction test and benchmark
+ */
+
+#include <AP_DAL/AP_DAL.h>
+#include <AP_NavEKF3/AP_NavEKF3.h>
+#include <AP_NavEKF3/AP_NavEKF3_core.h>
+
+class NavEKF3_core_Test
+{
+public:
+    NavEKF3_core_Test(NavEKF3 &_ekf) :
+        ekf(_ekf),
+        core(&_ekf, AP::dal()) {}
+
+    // set up the state and covariances, with the given states inhibited
+    void setup(bool inhibit_dang_bias, bool inhibit_dvel_bias, bool inhibit_mag, bool inhibit_wind)
+    {
+        // IMU noise as the parameter defaults. The bias, magnetic field
+        // and wind states get no process noise, so that the predicted
+        // covariance is only the propagation through the state
+        // transition
+        ekf._gyrNoise.set(0.015);
+        ekf._accNoise.set(0.35);
+        ekf._gyroBiasProcessNoise.set(0);
+        ekf._accelBiasProcessNoise.set(0);
+        ekf._magEarthProcessNoise.set(0);
+        ekf._magBodyProcessNoise.set(0);
+        ekf._windVelProcessNoise.set(0);
+
+        core.dtEkfAvg = EKF_TARGET_DT;
+        core.imuDataDelayed.delAng = Vector3F(0.003, -0.002, 0.001);
+        core.imuDataDelayed.delVel = Vector3F(0.01, 0.02, -0.098);
+        core.imuDataDelayed.delAngDT = EKF_TARGET_DT;
+        core.imuDataDelayed.delVelDT = EKF_TARGET_DT;
+
+        core.stateStruct.quat.from_euler(0.1, -0.2, 1.3);
+        core.stateStruct.gyro_bias = Vector3F(1e-5, -2e-5, 3e-5);
+        core.stateStruct.accel_bias = Vector3F(1e-4, 2e-4, -1e-4);
+        core.prevTnb.from_euler(0.1, -0.2, 1.3);
+        core.onGround = false;
+
+        core.inhibitDelAngBiasStates = inhibit_dang_bias;
+        core.inhibitDelVelBiasStates = inhibit_dvel_bias;
+        core.inhibitMagStates = inhibit_mag;
+        core.lastInhibitMagStates = inhibit_mag;
+        core.inhibitWindStates = inhibit_wind;
+        core.windStateIsObservable = true;
+        core.treatWindStatesAsTruth = false;
+        core.needMagBodyVarReset = false;
+        core.needEarthBodyVarReset = false;
+        core.updateStateIndexLim();
+
+        // a symmetric positive definite covariance, coupled between
+        // every pair of states
+        for (uint8_t i=0; i<24; i++) {
+            for (uint8_t j=0; j<24; j++) {
+                core.P[i][j] = (i == j) ? 1e-3 * (i + 1) : 1e-6 * ((i * 7 + j * 7) % 11);
+            }
+        }
+
+        // keep the tilt variance check from logging
+        core.imuSampleTime_ms = core.lastLogTime_ms;
+    }
+
+    void predict(void)
+    {
+        core.CovariancePrediction(nullptr);
+    }
+
+    // apply the variance limits and inhibited state resets
+    void constrain_variances(void)
+    {
+        core.ConstrainVariances();
+    }
+
+    ftype P(uint8_t i, uint8_t j) const { return core.P[i][j]; }
+    void get_P(ftype P[24][24]) const
+    {
+        for (uint8_t i=0; i<24; i++) {
+            for (uint8_t j=0; j<24; j++) {
+                P[i][j] = core.P[i][j];
+            }
+        }
+    }
+    void set_P(const ftype P[24][24])
+    {
+        for (uint8_t i=0; i<24; i++) {
+            for (uint8_t j=0; j<24; j++) {
+                core.P[i][j] = P[i][j];
+            }
+        }
+    }
+
+    // inputs to the state transition
+    uint8_t state_index_lim() const { return core.stateIndexLim; }
+    ftype dt() const { return core.dt; }
+    const QuaternionF &quat() const { return core.stateStruct.quat; }
+    const Vector3F &gyro_bias() const { return core.stateStruct.gyro_bias; }
+    const Vector3F &accel_bias() const { return core.stateStruct.accel_bias; }
+    const Vector3F &del_ang() const { return core.imuDataDelayed.delAng; }
+    const Vector3F &del_vel() const { return core.imuDataDelayed.delVel; }
+    ftype gyro_noise() const { return ekf._gyrNoise; }
+    ftype accel_noise() const { return ekf._accNoise; }
+
+private:
+    NavEKF3 &ekf;
+    NavEKF3_core core;
+};
@@ -0,0 +1,174 @@
+#include <AP_gtest.h>
+
+#include "NavEKF3_core_test.h"
+
+const AP_HAL::HAL& hal = AP_HAL::get_HAL();
+
+static NavEKF3 ekf;
+
+/*
+  the covariance prediction written out densely as F*P*F' + G*Q*G',
+  independently of the generated code in CovariancePrediction(). The
+  state transition is the one the EKF3 equations were derived from:
+
+    quat  <- quat * [1, (delAng - gyro_bias)/2]
+    vel   <- vel + Tbn * (delVel - accel_bias) + gravity*dt
+    pos   <- pos + vel*dt
+
+  with every other state constant, and delAng and delVel noise as the
+  process noise. Only covariances between states up to stateIndexLim
+  are predicted, the rest are left as they were
+ */
+static void dense_prediction(const NavEKF3_core_Test &ekf_core, const ftype P[24][24], ftype nextP[24][24])
+{
+    const double q0 = ekf_core.quat()[0];
+    const double q1 = ekf_core.quat()[1];
+    const double q2 = ekf_core.quat()[2];
+    const double q3 = ekf_core.quat()[3];
+    const double dt = ekf_core.dt();
+
+    // bias corrected delta angle halved, and delta velocity
+    const double rx = 0.5 * (double(ekf_core.del_ang().x) - ekf_core.gyro_bias().x);
+    const double ry = 0.5 * (double(ekf_core.del_ang().y) - ekf_core.gyro_bias().y);
+    const double rz = 0.5 * (double(ekf_core.del_ang().z) - ekf_core.gyro_bias().z);
+    const double vx = double(ekf_core.del_vel().x) - ekf_core.accel_bias().x;
+    const double vy = double(ekf_core.del_vel().y) - ekf_core.accel_bias().y;
+    const double vz = double(ekf_core.del_vel().z) - ekf_core.accel_bias().z;
+
+    double F[24][24] {};
+    for (uint8_t i=0; i<24; i++) {
+        F[i][i] = 1;
+    }
+
+    // quaternion product with respect to the quaternion
+    const double dq_dq[4][4] {
+        { 1, -rx, -ry, -rz },
+        { rx,  1,  rz, -ry },
+        { ry, -rz,  1,  rx },
+        { rz,  ry, -rx,  1 },
+    };
+    // and with respect to the gyro bias
+    const double dq_db[4][3] {
+        {  0.5*q1,  0.5*q2,  0.5*q3 },
+        { -0.5*q0,  0.5*q3, -0.5*q2 },
+        { -0.5*q3, -0.5*q0,  0.5*q1 },
+        {  0.5*q2, -0.5*q1, -0.5*q0 },
+    };
+    for (uint8_t i=0; i<4; i++) {
+        for (uint8_t j=0; j<4; j++) {
+            F[i][j] = dq_dq[i][j];
+        }
+        for (uint8_t j=0; j<3; j++) {
+            F[i][10+j] = dq_db[i][j];
+        }
+    }
+
+    // body to earth rotation, in the form the equations were derived with
+    const double Tbn[3][3] {
+        { 1 - 2*(q2*q2 + q3*q3), 2*(q1*q2 - q0*q3),     2*(q1*q3 + q0*q2) },
+        { 2*(q1*q2 + q0*q3),     1 - 2*(q1*q1 + q3*q3), 2*(q2*q3 - q0*q1) },
+        { 2*(q1*q3 - q0*q2),     2*(q2*q3 + q0*q1),     1 - 2*(q1*q1 + q2*q2) },
+    };
+    // derivative of Tbn * v with respect to the quaternion
+    const double dv_dq[3][4] {
+        { 2*(q2*vz - q3*vy), 2*(q2*vy + q3*vz),  2*(q1*vy + q0*vz) - 4*q2*vx, 2*(q1*vz - q0*vy) - 4*q3*vx },
+        { 2*(q3*vx - q1*vz), 2*(q2*vx - q0*vz) - 4*q1*vy, 2*(q1*vx + q3*vz), 2*(q0*vx + q2*vz) - 4*q3*vy },
+        { 2*(q1*vy - q2*vx), 2*(q3*vx + q0*vy) - 4*q1*vz, 2*(q3*vy - q0*vx) - 4*q2*vz, 2*(q1*vx + q2*vy) },
+    };
+    for (uint8_t i=0; i<3; i++) {
+        for (uint8_t j=0; j<4; j++) {
+            F[4+i][j] = dv_dq[i][j];
+        }
+        for (uint8_t j=0; j<3; j++) {
+            F[4+i][13+j] = -Tbn[i][j];
+        }
+        F[7+i][4+i] = dt;
+    }
+
+    // delta angle noise drives the quaternion as the gyro bias does,
+    // with the opposite sign, and delta velocity noise the velocity
+    // through Tbn
+    const double daVar = sq(dt * constrain_float(ekf_core.gyro_noise(), 0, 1));
+    const double dvVar = sq(dt * ekf_core.accel_noise());
+    double GQGt[24][24] {};
+    for (uint8_t i=0; i<4; i++) {
+        for (uint8_t j=0; j<4; j++) {
+            for (uint8_t k=0; k<3; k++) {
+                GQGt[i][j] += dq_db[i][k] * dq_db[j][k] * daVar;
+            }
+        }
+    }
+    for (uint8_t i=0; i<3; i++) {
+        for (uint8_t j=0; j<3; j++) {
+            for (uint8_t k=0; k<3; k++) {
+                GQGt[4+i][4+j] += Tbn[i][k] * Tbn[j][k] * dvVar;
+            }
+        }
+    }
+
+    const uint8_t lim = ekf_core.state_index_lim();
+    for (uint8_t i=0; i<24; i++) {
+        for (uint8_t j=0; j<24; j++) {
+            if (i > lim || j > lim) {
+                nextP[i][j] = P[i][j];
+                continue;
+            }
+            double sum = GQGt[i][j];
+            for (uint8_t k=0; k<24; k++) {
+                for (uint8_t l=0; l<24; l++) {
+                    sum += F[i][k] * P[k][l] * F[j][l];
+                }
+            }
+            nextP[i][j] = sum;
+        }
+    }
+}
+
+class CovariancePredictionTest : public ::testing::TestWithParam<uint8_t> {};
+
+TEST_P(CovariancePredictionTest, MatchesDense)
+{
+    const uint8_t inhibit = GetParam();
+    const bool inhibit_dang_bias = inhibit & 1;
+    const bool inhibit_dvel_bias = inhibit & 2;
+    const bool inhibit_mag = inhibit & 4;
+    const bool inhibit_wind = inhibit & 8;
+
+    NavEKF3_core_Test *predicted = NEW_NOTHROW NavEKF3_core_Test(ekf);
+    NavEKF3_core_Test *reference = NEW_NOTHROW NavEKF3_core_Test(ekf);
+    ASSERT_NE(predicted, nullptr);
+    ASSERT_NE(reference, nullptr);
+    predicted->setup(inhibit_dang_bias, inhibit_dvel_bias, inhibit_mag, inhibit_wind);
+    reference->setup(inhibit_dang_bias, inhibit_dvel_bias, inhibit_mag, inhibit_wind);
+
+    // several steps, so that skipped columns would feed later
+    // predictions. Each step is checked against the dense prediction
+    // from the covariance the step started with
+    for (uint8_t step=0; step<10; step++) {
+        ftype P[24][24];
+        predicted->get_P(P);
+        predicted->predict();
+
+        ftype nextP[24][24];
+        dense_prediction(*predicted, P, nextP);
+        reference->set_P(nextP);
+        reference->constrain_variances();
+
+        for (uint8_t i=0; i<24; i++) {
+            for (uint8_t j=0; j<24; j++) {
+                const ftype expected = reference->P(i, j);
+                EXPECT_NEAR(predicted->P(i, j), expected, 1e-7 + 1e-5 * fabsF(expected))
+                    << "step " << unsigned(step) << " P[" << unsigned(i) << "][" << unsigned(j) << "]";
+            }
+        }
+    }
+
+    delete predicted;
+    delete reference;
+}
+
+// every combination of the delta angle bias, delta velocity bias,
+// magnetic field and wind inhibits
+INSTANTIATE_TEST_CASE_P(Inhibits, CovariancePredictionTest, ::testing::Range<uint8_t>(0, 16));
+
+AP_GTEST_MAIN()
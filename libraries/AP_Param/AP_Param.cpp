@@ -25,6 +25,7 @@
 
 #include <cmath>
 #include <string.h>
+#include <ctype.h>
 
 #include <AP_Common/AP_Common.h>
 #include <AP_HAL/AP_HAL.h>
@@ -36,6 +37,8 @@
 #include <AP_Filesystem/AP_Filesystem.h>
 #include <stdio.h>
 #include <AP_ROMFS/AP_ROMFS.h>
+#include <AP_Logger/AP_Logger.h>
+#include <AP_Common/ExpandingString.h>
 
 #if CONFIG_HAL_BOARD == HAL_BOARD_SITL
     #include <SITL/SITL.h>
@@ -107,6 +110,11 @@ HAL_Semaphore AP_Param::_count_sem;
 // storage and naming information about all types that can be saved
 const AP_Param::Info *AP_Param::_var_info;
 
+#if AP_PARAM_NAME_INDEX_ENABLED
+const uint32_t *AP_Param::_name_index;
+uint16_t AP_Param::_name_index_count;
+#endif
+
 struct AP_Param::param_override *AP_Param::param_overrides;
 uint16_t AP_Param::param_overrides_len;
 uint16_t AP_Param::num_param_overrides;
@@ -115,7 +123,11 @@ uint16_t AP_Param::num_read_only;
 // goes true if we run out of param space
 bool AP_Param::eeprom_full;
 
-ObjectBuffer_TS<AP_Param::param_save> AP_Param::save_queue{30};
+ObjectBuffer_TS<AP_Param::param_save> AP_Param::save_queue{AP_Param::save_queue_size};
+struct AP_Param::save_stats AP_Param::_save_stats;
+HAL_Semaphore AP_Param::_save_stats_sem;
+uint32_t AP_Param::_save_stats_logged_requested;
+uint32_t AP_Param::_save_stats_last_log_ms;
 bool AP_Param::registered_save_handler;
 
 bool AP_Param::done_all_default_params;
@@ -153,9 +165,19 @@ uint16_t AP_Param::_frame_type_flags;
 // write to EEPROM
 void AP_Param::eeprom_write_check(const void *ptr, uint16_t ofs, uint8_t size)
 {
-    _storage.write_block(ofs, ptr, size);
+    // skip unchanged data. Some storage backends mark every written
+    // line dirty, causing a flash write even if nothing changed
+    uint8_t old[16];
+    const bool check = size <= sizeof(old);
+    if (!check || !_storage.read_block(old, ofs, size) || memcmp(old, ptr, size) != 0) {
+        _storage.write_block(ofs, ptr, size);
+        WITH_SEMAPHORE(_save_stats_sem);
+        _save_stats.bytes_written += size;
+    }
 #if AP_PARAM_STORAGE_BAK_ENABLED
-    _storage_bak.write_block(ofs, ptr, size);
+    if (!check || !_storage_bak.read_block(old, ofs, size) || memcmp(old, ptr, size) != 0) {
+        _storage_bak.write_block(ofs, ptr, size);
+    }
 #endif
 }
 
@@ -912,52 +934,78 @@ AP_Param::find_group(const char *name, uint16_t vindex, ptrdiff_t group_offset,
 }
 
 
+// Find a variable by name within a single top level var_info entry
+AP_Param *
+AP_Param::find_in_var(const char *name, uint16_t vindex, enum ap_var_type *ptype, uint16_t *flags)
+{
+    const auto &info = var_info(vindex);
+    uint8_t type = info.type;
+    if (type == AP_PARAM_GROUP) {
+        uint8_t len = strnlen(info.name, AP_MAX_NAME_SIZE);
+        if (strncmp(name, info.name, len) != 0) {
+            return nullptr;
+        }
+        const struct GroupInfo *group_info = get_group_info(info);
+        if (group_info == nullptr) {
+            return nullptr;
+        }
+        AP_Param *ap = find_group(name + len, vindex, 0, group_info, ptype);
+        if (ap != nullptr) {
+            if (flags != nullptr) {
+                uint32_t group_element = 0;
+                const struct GroupInfo *ginfo;
+                struct GroupNesting group_nesting {};
+                uint8_t idx;
+                ap->find_var_info(&group_element, ginfo, group_nesting, &idx);
+                if (ginfo != nullptr) {
+                    *flags = ginfo->flags;
+                } else {
+                    *flags = 0;
+                }
+            }
+            return ap;
+        }
+    } else if (strcasecmp(name, info.name) == 0) {
+        *ptype = (enum ap_var_type)type;
+        ptrdiff_t base;
+        if (!get_base(info, base)) {
+            return nullptr;
+        }
+        if (flags != nullptr) {
+            *flags = 0;
+        }
+        return (AP_Param *)base;
+    }
+    return nullptr;
+}
+
 // Find a variable by name.
 //
 AP_Param *
 AP_Param::find(const char *name, enum ap_var_type *ptype, uint16_t *flags)
 {
-    for (uint16_t i=0; i<_num_vars; i++) {
-        const auto &info = var_info(i);
-        uint8_t type = info.type;
-        if (type == AP_PARAM_GROUP) {
-            uint8_t len = strnlen(info.name, AP_MAX_NAME_SIZE);
-            if (strncmp(name, info.name, len) != 0) {
-                continue;
-            }
-            const struct GroupInfo *group_info = get_group_info(info);
-            if (group_info == nullptr) {
-                continue;
-            }
-            AP_Param *ap = find_group(name + len, i, 0, group_info, ptype);
+#if AP_PARAM_NAME_INDEX_ENABLED
+    if (_name_index != nullptr) {
+        const uint16_t hash = name_hash(name);
+        for (uint16_t i=name_index_lower_bound(hash);
+             i<_name_index_count && (_name_index[i]>>16) == hash;
+             i++) {
+            AP_Param *ap = find_in_var(name, _name_index[i] & 0xFFFF, ptype, flags);
             if (ap != nullptr) {
-                if (flags != nullptr) {
-                    uint32_t group_element = 0;
-                    const struct GroupInfo *ginfo;
-                    struct GroupNesting group_nesting {};
-                    uint8_t idx;
-                    ap->find_var_info(&group_element, ginfo, group_nesting, &idx);
-                    if (ginfo != nullptr) {
-                        *flags = ginfo->flags;
-                    } else {
-                        *flags = 0;
-                    }
-                }
                 return ap;
             }
-            // we continue looking as we want to allow top level
-            // parameter to have the same prefix name as group
-            // parameters, for example CAM_P_G
-        } else if (strcasecmp(name, info.name) == 0) {
-            *ptype = (enum ap_var_type)type;
-            ptrdiff_t base;
-            if (!get_base(info, base)) {
-                return nullptr;
-            }
-            if (flags != nullptr) {
-                *flags = 0;
-            }
-            return (AP_Param *)base;
+        }
+        // not indexed; may be in a dynamic table or an object
+        // allocated after the index was built
+    }
+#endif
+    for (uint16_t i=0; i<_num_vars; i++) {
+        // we continue looking after a failed match in a group as we
+        // want to allow top level parameter to have the same prefix
+        // name as group parameters, for example CAM_P_G
+        AP_Param *ap = find_in_var(name, i, ptype, flags);
+        if (ap != nullptr) {
+            return ap;
         }
     }
     return nullptr;
@@ -978,9 +1026,74 @@ AP_Param::find_by_index(uint16_t idx, enum ap_var_type *ptype, ParamToken *token
     return ap;    
 }
 
+#if AP_PARAM_NAME_INDEX_ENABLED
+/*
+  find_by_name() restricted to the scalars of one top level var_info
+  entry, leaving token where a full walk with next_scalar() would
+ */
+AP_Param *AP_Param::find_by_name_in_var(const char *name, uint16_t vindex, enum ap_var_type *ptype, ParamToken *token)
+{
+    const auto &info = var_info(vindex);
+    if (!check_frame_type(info.flags)) {
+        return nullptr;
+    }
+    if (strncasecmp(name, info.name, strlen(info.name)) != 0) {
+        return nullptr;
+    }
+
+    // position the token on the first variable of this entry
+    token->key = vindex;
+    token->group_element = 0;
+    token->idx = 0;
+    token->last_disabled = 0;
+    AP_Param *ap;
+    if (info.type == AP_PARAM_GROUP) {
+        const struct GroupInfo *group_info = get_group_info(info);
+        if (group_info == nullptr) {
+            return nullptr;
+        }
+        bool found_current = true;
+        ap = next_group(vindex, group_info, &found_current, 0, 0, 0, token, ptype, true, nullptr);
+    } else {
+        ptrdiff_t base;
+        if (!get_base(info, base)) {
+            return nullptr;
+        }
+        *ptype = (enum ap_var_type)info.type;
+        ap = (AP_Param *)base;
+    }
+    if (ap != nullptr && *ptype > AP_PARAM_FLOAT) {
+        ap = next_scalar(token, ptype);
+    }
+
+    for (; ap != nullptr && token->key == vindex; ap = next_scalar(token, ptype)) {
+        char buf[AP_MAX_NAME_SIZE];
+        ap->copy_name_token(*token, buf, AP_MAX_NAME_SIZE);
+        if (strncasecmp(name, buf, AP_MAX_NAME_SIZE) == 0) {
+            return ap;
+        }
+    }
+    return nullptr;
+}
+#endif
+
 // by-name equivalent of find_by_index()
 AP_Param* AP_Param::find_by_name(const char* name, enum ap_var_type *ptype, ParamToken *token)
 {
+#if AP_PARAM_NAME_INDEX_ENABLED
+    if (_name_index != nullptr) {
+        const uint16_t hash = name_hash(name);
+        for (uint16_t i=name_index_lower_bound(hash);
+             i<_name_index_count && (_name_index[i]>>16) == hash;
+             i++) {
+            AP_Param *ap = find_by_name_in_var(name, _name_index[i] & 0xFFFF, ptype, token);
+            if (ap != nullptr) {
+                return ap;
+            }
+        }
+    }
+#endif
+
     AP_Param *ap;
     for (ap = AP_Param::first(token, ptype);
          ap && *ptype != AP_PARAM_GROUP && *ptype != AP_PARAM_NONE;
@@ -1247,19 +1360,20 @@ void AP_Param::save_sync(bool force_save, bool send_to_gcs)
 */
 void AP_Param::save(bool force_save)
 {
-    struct param_save p, p2;
+    struct param_save p;
     p.param = this;
     p.force_save = force_save;
-    if (save_queue.peek(p2) &&
-        p2.param == this &&
-        p2.force_save == force_save) {
-        // this one is already at the head of the list to be
-        // saved. This check is cheap and catches the case where we
-        // are flooding the save queue with one parameter (eg. mission
-        // creation, changing MIS_TOTAL)
-        return;
-    }
-    while (!save_queue.push(p)) {
+
+    // if this parameter is already waiting to be saved then that
+    // save will write the latest value, as the value is read when it
+    // runs. This catches flooding of the queue with a few
+    // parameters (eg. mission creation changing MIS_TOTAL, or
+    // autotune and scripts repeatedly saving gains)
+    const auto already_queued = [&p](const param_save &queued) {
+        return queued.param == p.param && (queued.force_save || !p.force_save);
+    };
+    bool coalesced;
+    while (!save_queue.push_unless_queued(p, already_queued, coalesced)) {
         // if we can't save to the queue
         if (hal.util->get_soft_armed() && hal.scheduler->in_main_thread()) {
             // if we are armed in main thread then don't sleep, instead we lose the
@@ -1274,6 +1388,12 @@ void AP_Param::save(bool force_save)
         hal.scheduler->delay_microseconds(500);
         hal.scheduler->expect_delay_ms(0);
     }
+
+    WITH_SEMAPHORE(_save_stats_sem);
+    _save_stats.requested++;
+    if (coalesced) {
+        _save_stats.coalesced++;
+    }
 }
 
 /*
@@ -1284,11 +1404,58 @@ void AP_Param::save_io_handler(void)
     struct param_save p;
     while (save_queue.pop(p)) {
         p.param->save_sync(p.force_save, true);
+        WITH_SEMAPHORE(_save_stats_sem);
+        _save_stats.saved++;
     }
     if (hal.scheduler->is_system_initialized()) {
         // pay the cost of parameter counting in the IO thread
         count_parameters();
     }
+
+#if HAL_LOGGING_ENABLED
+    // log the save statistics when they change, at most once a second
+    const uint32_t now_ms = AP_HAL::millis();
+    struct save_stats stats;
+    {
+        WITH_SEMAPHORE(_save_stats_sem);
+        stats = _save_stats;
+    }
+    if (stats.requested != _save_stats_logged_requested &&
+        now_ms - _save_stats_last_log_ms >= 1000) {
+        _save_stats_last_log_ms = now_ms;
+        _save_stats_logged_requested = stats.requested;
+// @LoggerMessage: PSAV
+// @Description: Parameter save statistics since boot
+// @Field: TimeUS: Time since system startup
+// @Field: Req: saves requested
+// @Field: Coal: saves combined with one already queued for the same parameter
+// @Field: Save: saves performed
+// @Field: Bytes: bytes changed in storage
+        AP::logger().WriteStreaming("PSAV", "TimeUS,Req,Coal,Save,Bytes", "QIIII",
+                                    AP_HAL::micros64(),
+                                    stats.requested,
+                                    stats.coalesced,
+                                    stats.saved,
+                                    stats.bytes_written);
+    }
+#endif
+}
+
+/*
+  report parameter save statistics, for @SYS/params.txt
+ */
+void AP_Param::save_info(ExpandingString &str)
+{
+    struct save_stats stats;
+    {
+        WITH_SEMAPHORE(_save_stats_sem);
+        stats = _save_stats;
+    }
+    str.printf("SavesRequested: %u\n", unsigned(stats.requested));
+    str.printf("SavesCoalesced: %u\n", unsigned(stats.coalesced));
+    str.printf("SavesPerformed: %u\n", unsigned(stats.saved));
+    str.printf("BytesWritten: %u\n", unsigned(stats.bytes_written));
+    str.printf("QueueSpace: %u/%u\n", unsigned(save_queue.space()), unsigned(save_queue_size));
 }
 
 /*
@@ -1553,6 +1720,96 @@ void AP_Param::setup_sketch_defaults(void)
 }
 
 
+#if AP_PARAM_NAME_INDEX_ENABLED
+/*
+  hash of a parameter name for the name index. Case is folded as
+  find() ignores it for the last part of a name
+ */
+uint16_t AP_Param::name_hash(const char *name)
+{
+    // FNV-1a
+    uint32_t hash = 2166136261U;
+    for (uint8_t i=0; i<AP_MAX_NAME_SIZE && name[i] != 0; i++) {
+        hash ^= uint8_t(toupper(name[i]));
+        hash *= 16777619U;
+    }
+    return (hash >> 16) ^ (hash & 0xFFFF);
+}
+
+// first entry in the name index with a hash not less than hash
+uint16_t AP_Param::name_index_lower_bound(uint16_t hash)
+{
+    const uint32_t key = uint32_t(hash) << 16;
+    uint16_t lo = 0;
+    uint16_t hi = _name_index_count;
+    while (lo < hi) {
+        const uint16_t mid = (lo + hi) / 2;
+        if (_name_index[mid] < key) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+    return lo;
+}
+
+static int name_index_compare(const void *a, const void *b)
+{
+    const uint32_t ia = *(const uint32_t *)a;
+    const uint32_t ib = *(const uint32_t *)b;
+    return ia < ib ? -1 : (ia > ib ? 1 : 0);
+}
+
+/*
+  build the name index from every variable in the static var_info
+  tree. Names which cannot be reached at this point, such as those
+  in objects which are yet to be allocated, are left out and found
+  by the full search
+ */
+void AP_Param::build_name_index(void)
+{
+    if (_name_index != nullptr) {
+        return;
+    }
+#if AP_PARAM_DYNAMIC_ENABLED
+    const uint16_t num_vars = _num_vars_base;
+#else
+    const uint16_t num_vars = _num_vars;
+#endif
+
+    // count first so the index is a single allocation of the right size
+    ParamToken token {};
+    enum ap_var_type type;
+    uint16_t count = 0;
+    for (AP_Param *ap = first(&token, &type);
+         ap != nullptr && token.key < num_vars;
+         ap = next(&token, &type, false)) {
+        count++;
+    }
+    if (count == 0) {
+        return;
+    }
+    uint32_t *index = NEW_NOTHROW uint32_t[count];
+    if (index == nullptr) {
+        return;
+    }
+
+    uint16_t n = 0;
+    for (AP_Param *ap = first(&token, &type);
+         ap != nullptr && token.key < num_vars && n < count;
+         ap = next(&token, &type, false)) {
+        char name[AP_MAX_NAME_SIZE+1] {};
+        // Vector3f elements are named with their _X/_Y/_Z suffix
+        ap->copy_name_token(token, name, AP_MAX_NAME_SIZE, type != AP_PARAM_VECTOR3F);
+        index[n++] = (uint32_t(name_hash(name)) << 16) | token.key;
+    }
+    qsort(index, n, sizeof(index[0]), name_index_compare);
+
+    _name_index_count = n;
+    _name_index = index;
+}
+#endif // AP_PARAM_NAME_INDEX_ENABLED
+
 // Load all variables from EEPROM
 //
 bool AP_Param::load_all()
@@ -1562,6 +1819,10 @@ bool AP_Param::load_all()
 
     reload_defaults_file(false);
 
+#if AP_PARAM_NAME_INDEX_ENABLED
+    build_name_index();
+#endif
+
     if (!registered_save_handler) {
         registered_save_handler = true;
         hal.scheduler->register_io_process(FUNCTOR_BIND((&save_dummy), &AP_Param::save_io_handler, void));
@@ -367,6 +367,12 @@ public:
     // by-name equivalent of find_by_index()
     static AP_Param* find_by_name(const char* name, enum ap_var_type *ptype, ParamToken *token);
 
+#if AP_PARAM_NAME_INDEX_ENABLED
+    // build the index used by find() and find_by_name(). Called by
+    // load_all(); later calls do nothing
+    static void build_name_index(void);
+#endif
+
     /// Find a variable by pointer
     ///
     ///
@@ -396,6 +402,9 @@ public:
     ///
     void save_sync(bool force_save, bool send_to_gcs);
 
+    // report counts of saves requested, coalesced and written
+    static void save_info(class ExpandingString &str);
+
     /// flush all pending parameter saves
     /// used on reboot
     static void flush(void);
@@ -736,6 +745,16 @@ private:
                                     ptrdiff_t group_offset,
                                     const struct GroupInfo *group_info,
                                     enum ap_var_type *ptype);
+    static AP_Param *           find_in_var(
+                                    const char *name,
+                                    uint16_t vindex,
+                                    enum ap_var_type *ptype,
+                                    uint16_t *flags);
+    static AP_Param *           find_by_name_in_var(
+                                    const char *name,
+                                    uint16_t vindex,
+                                    enum ap_var_type *ptype,
+                                    ParamToken *token);
     static void                 write_sentinal(uint16_t ofs);
     static uint16_t             get_key(const Param_header &phdr);
     static void                 set_key(Param_header &phdr, uint16_t key);
@@ -811,6 +830,18 @@ private:
     static HAL_Semaphore        _count_sem;
     static const struct Info *  _var_info;
 
+#if AP_PARAM_NAME_INDEX_ENABLED
+    // every parameter name in the static var_info tree, sorted so a
+    // lookup is a bisection rather than a walk of the tree.  Each
+    // entry is a 16 bit name hash in the top half and the index of
+    // the top level var_info holding the name in the bottom half.
+    // Built once in load_all() and never changed after that
+    static const uint32_t *     _name_index;
+    static uint16_t             _name_index_count;
+    static uint16_t             name_hash(const char *name);
+    static uint16_t             name_index_lower_bound(uint16_t hash);
+#endif
+
 #if AP_PARAM_DYNAMIC_ENABLED
     // allow for a dynamically allocated var table
     static uint16_t             _num_vars_base;
@@ -852,7 +883,21 @@ private:
         AP_Param *param;
         bool force_save;
     };
+    static constexpr uint8_t save_queue_size = 30;
     static ObjectBuffer_TS<struct param_save> save_queue;
+
+    // counters for save(), see save_info(). These are updated from
+    // several threads, so only under _save_stats_sem
+    static struct save_stats {
+        uint32_t requested;
+        uint32_t coalesced;
+        uint32_t saved;
+        uint32_t bytes_written;
+    } _save_stats;
+    static HAL_Semaphore _save_stats_sem;
+    // for logging the counters, used only by the IO thread
+    static uint32_t _save_stats_logged_requested;
+    static uint32_t _save_stats_last_log_ms;
     static bool registered_save_handler;
 
     // background function for saving parameters
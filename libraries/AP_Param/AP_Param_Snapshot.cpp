@@ -0,0 +1,87 @@
+/*
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "AP_Param_Snapshot.h"
+
+#if AP_PARAM_SNAPSHOT_ENABLED
+
+#include <string.h>
+
+float AP_Param_Snapshot::Entry::value_float() const
+{
+    switch (type) {
+    case AP_PARAM_INT8:
+        return int8_t(value[0]);
+    case AP_PARAM_INT16: {
+        int16_t v;
+        memcpy(&v, value, sizeof(v));
+        return v;
+    }
+    case AP_PARAM_INT32: {
+        int32_t v;
+        memcpy(&v, value, sizeof(v));
+        return v;
+    }
+    case AP_PARAM_FLOAT: {
+        float v;
+        memcpy(&v, value, sizeof(v));
+        return v;
+    }
+    }
+    return 0;
+}
+
+bool AP_Param_Snapshot::build(void)
+{
+    delete[] entries;
+    entries = nullptr;
+    _count = 0;
+
+    const uint16_t max_count = AP_Param::count_parameters();
+    entries = NEW_NOTHROW Entry[max_count];
+    if (entries == nullptr) {
+        return false;
+    }
+
+    AP_Param::ParamToken token {};
+    enum ap_var_type type;
+    float default_val = 0;
+    uint16_t n = 0;
+    for (AP_Param *ap = AP_Param::first(&token, &type, &default_val);
+         ap != nullptr;
+         ap = AP_Param::next_scalar(&token, &type, &default_val)) {
+        if (n == max_count) {
+            // a parameter has been enabled since the count was taken
+            AP_Param::invalidate_count();
+            return false;
+        }
+        Entry &e = entries[n++];
+        ap->copy_name_token(token, e.name, sizeof(e.name), true);
+        e.type = type;
+        memset(e.value, 0, sizeof(e.value));
+        memcpy(e.value, (const void *)ap, AP_Param::type_size(type));
+#if AP_PARAM_DEFAULTS_ENABLED
+        e.default_value = default_val;
+#endif
+    }
+    if (n != max_count) {
+        // the count is out of date, have it recalculated
+        AP_Param::invalidate_count();
+    }
+    _count = n;
+    return true;
+}
+
+#endif  // AP_PARAM_SNAPSHOT_ENABLED
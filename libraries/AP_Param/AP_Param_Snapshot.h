@@ -0,0 +1,61 @@
+/*
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+/*
+  a copy of the name, type and value of every parameter, taken in one
+  pass over the var_info tree. Sending a full parameter list from a
+  snapshot avoids walking the tree and rebuilding each name per
+  parameter, which is what limits download speed on fast links
+ */
+#pragma once
+
+#include "AP_Param_config.h"
+
+#if AP_PARAM_SNAPSHOT_ENABLED
+
+#include "AP_Param.h"
+
+class AP_Param_Snapshot
+{
+public:
+    AP_Param_Snapshot() {}
+    ~AP_Param_Snapshot() { delete[] entries; }
+
+    CLASS_NO_COPY(AP_Param_Snapshot);
+
+    struct PACKED Entry {
+        char name[AP_MAX_NAME_SIZE];    // not null terminated if AP_MAX_NAME_SIZE long
+        uint8_t type;                   // ap_var_type, always a scalar
+        uint8_t value[4];               // type_size(type) bytes as held by AP_Param
+#if AP_PARAM_DEFAULTS_ENABLED
+        float default_value;
+#endif
+
+        float value_float() const;
+    };
+
+    // copy all parameters. Returns false if out of memory or the
+    // parameter count was out of date, in which case the count is
+    // invalidated and a retry will succeed
+    bool build(void);
+
+    uint16_t count(void) const { return _count; }
+    const Entry &entry(uint16_t i) const { return entries[i]; }
+
+private:
+    Entry *entries = nullptr;
+    uint16_t _count = 0;
+};
+
+#endif  // AP_PARAM_SNAPSHOT_ENABLED
@@ -11,3 +11,15 @@
 #ifndef FORCE_APJ_DEFAULT_PARAMETERS
 #define FORCE_APJ_DEFAULT_PARAMETERS 0
 #endif
+
+// index parameter names for find() and find_by_name(). Costs 4 bytes
+// of RAM per parameter
+#ifndef AP_PARAM_NAME_INDEX_ENABLED
+#define AP_PARAM_NAME_INDEX_ENABLED HAL_PROGRAM_SIZE_LIMIT_KB > 1024
+#endif
+
+// copy of every parameter for bulk download over fast links. Costs
+// about 25 bytes of RAM per parameter while a download is running
+#ifndef AP_PARAM_SNAPSHOT_ENABLED
+#define AP_PARAM_SNAPSHOT_ENABLED (CONFIG_HAL_BOARD == HAL_BOARD_SITL || CONFIG_HAL_BOARD == HAL_BOARD_LINUX)
+#endif
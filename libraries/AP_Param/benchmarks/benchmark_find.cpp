@@ -0,0 +1,100 @@
+#include <AP_gbenchmark.h>
+
+#include <AP_Param/AP_Param.h>
+
+const AP_HAL::HAL& hal = AP_HAL::get_HAL();
+
+/*
+  cost of looking up parameters by name in a tree of 1400 parameters,
+  similar in size to a Copter build. Names are looked up in tree
+  order so the early and late parts of the tree are both covered
+ */
+class BenchGroup {
+public:
+    static const struct AP_Param::GroupInfo var_info[];
+    AP_Float p[20];
+};
+
+#define P(n) AP_GROUPINFO(#n, n, BenchGroup, p[n], 0)
+
+const AP_Param::GroupInfo BenchGroup::var_info[] = {
+    P(0),  P(1),  P(2),  P(3),  P(4),  P(5),  P(6),  P(7),  P(8),  P(9),
+    P(10), P(11), P(12), P(13), P(14), P(15), P(16), P(17), P(18), P(19),
+    AP_GROUPEND
+};
+
+static AP_Int16 format_version;
+static BenchGroup groups[70];
+
+#define G(n) { "G" #n "_", (const void *)&groups[n], {group_info : BenchGroup::var_info}, 0, n+1, AP_PARAM_GROUP }
+
+// vehicles start with a scalar, which find_by_name() relies on
+static const AP_Param::Info var_info[] = {
+    { "FORMAT_VERSION", (const void *)&format_version, {def_value : 0}, 0, 0, AP_PARAM_INT16 },
+    G(0),  G(1),  G(2),  G(3),  G(4),  G(5),  G(6),  G(7),  G(8),  G(9),
+    G(10), G(11), G(12), G(13), G(14), G(15), G(16), G(17), G(18), G(19),
+    G(20), G(21), G(22), G(23), G(24), G(25), G(26), G(27), G(28), G(29),
+    G(30), G(31), G(32), G(33), G(34), G(35), G(36), G(37), G(38), G(39),
+    G(40), G(41), G(42), G(43), G(44), G(45), G(46), G(47), G(48), G(49),
+    G(50), G(51), G(52), G(53), G(54), G(55), G(56), G(57), G(58), G(59),
+    G(60), G(61), G(62), G(63), G(64), G(65), G(66), G(67), G(68), G(69),
+    AP_VAREND
+};
+
+static AP_Param param_loader(var_info);
+
+static char names[ARRAY_SIZE(groups) * ARRAY_SIZE(BenchGroup::p)][AP_MAX_NAME_SIZE+1];
+
+static void fill_names(void)
+{
+    uint16_t n = 0;
+    for (uint8_t g=0; g<ARRAY_SIZE(groups); g++) {
+        for (uint8_t i=0; i<ARRAY_SIZE(BenchGroup::p); i++) {
+            hal.util->snprintf(names[n++], sizeof(names[0]), "G%u_%u", g, i);
+        }
+    }
+}
+
+static void BM_ParamFind(benchmark::State &state)
+{
+    fill_names();
+#if AP_PARAM_NAME_INDEX_ENABLED
+    if (state.range(0)) {
+        AP_Param::build_name_index();
+    }
+#endif
+    uint16_t n = 0;
+    for (auto _ : state) {
+        enum ap_var_type ptype;
+        AP_Param *ap = AP_Param::find(names[n], &ptype);
+        gbenchmark_escape(ap);
+        n = (n + 1) % ARRAY_SIZE(names);
+    }
+}
+
+static void BM_ParamFindByName(benchmark::State &state)
+{
+    fill_names();
+#if AP_PARAM_NAME_INDEX_ENABLED
+    if (state.range(0)) {
+        AP_Param::build_name_index();
+    }
+#endif
+    uint16_t n = 0;
+    for (auto _ : state) {
+        enum ap_var_type ptype;
+        AP_Param::ParamToken token;
+        AP_Param *ap = AP_Param::find_by_name(names[n], &ptype, &token);
+        gbenchmark_escape(ap);
+        n = (n + 1) % ARRAY_SIZE(names);
+    }
+}
+
+// the argument selects the index. It can not be removed once built
+// so all of the unindexed runs come first
+BENCHMARK(BM_ParamFind)->Arg(0);
+BENCHMARK(BM_ParamFindByName)->Arg(0);
+BENCHMARK(BM_ParamFind)->Arg(1);
+BENCHMARK(BM_ParamFindByName)->Arg(1);
+
+BENCHMARK_MAIN();
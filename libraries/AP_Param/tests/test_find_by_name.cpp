@@ -13,10 +13,44 @@ public:
         k_param_a,
         k_param_b,
         k_param_c,
+        k_param_vec,
+        k_param_grp,
+        k_param_dis,
     };
     AP_Int8 a;
     AP_Int8 b;
     AP_Int8 c;
+    AP_Vector3f vec;
+};
+
+class TestSubGroup {
+public:
+    static const struct AP_Param::GroupInfo var_info[];
+    AP_Float x;
+    AP_Vector3f ofs;
+};
+
+const AP_Param::GroupInfo TestSubGroup::var_info[] = {
+    AP_GROUPINFO("X", 1, TestSubGroup, x, 0),
+    AP_GROUPINFO("OFS", 2, TestSubGroup, ofs, 0),
+    AP_GROUPEND
+};
+
+class TestGroup {
+public:
+    static const struct AP_Param::GroupInfo var_info[];
+    AP_Int8 enable;
+    AP_Int16 val;
+    AP_Vector3f vec;
+    TestSubGroup sub;
+};
+
+const AP_Param::GroupInfo TestGroup::var_info[] = {
+    AP_GROUPINFO_FLAGS("ENABLE", 1, TestGroup, enable, 1, AP_PARAM_FLAG_ENABLE),
+    AP_GROUPINFO("VAL", 2, TestGroup, val, 0),
+    AP_GROUPINFO("VEC", 3, TestGroup, vec, 0),
+    AP_SUBGROUPINFO(sub, "S_", 4, TestGroup, TestSubGroup),
+    AP_GROUPEND
 };
 
 class TestVehicle : public AP_Vehicle {
@@ -60,6 +94,8 @@ public:
     static const AP_Param::Info var_info[];
 
     Parameters g;
+    TestGroup grp;
+    TestGroup dis;
     // setup the var_info table
     AP_Param param_loader{var_info};
 
@@ -73,11 +109,17 @@ const AP_Param::Info TestVehicle::var_info[] {
     GSCALAR(b,         "AA", 0),
     GSCALAR(b,         "CC", 0),
     GSCALAR(b,         "BB", 0),
+    GSCALAR(vec,       "VEC", 0),
+    GOBJECT(grp,       "GRP_", TestGroup),
+    GOBJECT(dis,       "DIS_", TestGroup),
 };
 
 TEST(FindByName, Bob)
 {
     for (const auto &x : TestVehicle::var_info) {
+        if (x.type != AP_PARAM_INT8) {
+            continue;
+        }
         enum ap_var_type ptype = (ap_var_type)-1;
         AP_Param::ParamToken token = AP_Param::ParamToken {};
         AP_Param *p = AP_Param::find_by_name(x.name, &ptype, &token);
@@ -85,4 +127,121 @@ TEST(FindByName, Bob)
     }
 }
 
+#if AP_PARAM_NAME_INDEX_ENABLED
+TEST(FindByName, Indexed)
+{
+    AP_Param::build_name_index();
+    for (const auto &x : TestVehicle::var_info) {
+        if (x.type != AP_PARAM_INT8) {
+            continue;
+        }
+        enum ap_var_type ptype = (ap_var_type)-1;
+        AP_Param::ParamToken token = AP_Param::ParamToken {};
+        AP_Param *p = AP_Param::find_by_name(x.name, &ptype, &token);
+        EXPECT_EQ(p, x.ptr);
+        EXPECT_EQ(ptype, AP_PARAM_INT8);
+        EXPECT_EQ(token.key, uint32_t(&x - TestVehicle::var_info));
+
+        enum ap_var_type ptype2 = (ap_var_type)-1;
+        EXPECT_EQ(AP_Param::find(x.name, &ptype2), x.ptr);
+        EXPECT_EQ(ptype2, AP_PARAM_INT8);
+    }
+
+    // top level names ignore case
+    enum ap_var_type ptype;
+    EXPECT_EQ(AP_Param::find("bb", &ptype), &testvehicle.g.b);
+
+    AP_Param::ParamToken token {};
+    EXPECT_EQ(AP_Param::find("XX", &ptype), nullptr);
+    EXPECT_EQ(AP_Param::find_by_name("XX", &ptype, &token), nullptr);
+}
+
+/*
+  find a scalar as find_by_name() did before the name index, walking
+  every scalar in order
+ */
+static AP_Param *find_by_walk(const char *name, enum ap_var_type *ptype, AP_Param::ParamToken *token)
+{
+    for (AP_Param *ap = AP_Param::first(token, ptype);
+         ap != nullptr;
+         ap = AP_Param::next_scalar(token, ptype)) {
+        if (*ptype > AP_PARAM_FLOAT) {
+            continue;
+        }
+        char buf[AP_MAX_NAME_SIZE+1] {};
+        ap->copy_name_token(*token, buf, AP_MAX_NAME_SIZE);
+        if (strncasecmp(name, buf, AP_MAX_NAME_SIZE) == 0) {
+            return ap;
+        }
+    }
+    return nullptr;
+}
+
+TEST(FindByName, IndexedMatchesWalk)
+{
+    AP_Param::build_name_index();
+    testvehicle.grp.enable.set(1);
+    testvehicle.dis.enable.set(0);
+
+    // every scalar name, including those hidden by the disabled group
+    char names[64][AP_MAX_NAME_SIZE+1] {};
+    AP_Param *ptrs[64] {};
+    uint8_t count = 0;
+    AP_Param::set_hide_disabled_groups(false);
+    AP_Param::ParamToken token {};
+    enum ap_var_type ptype;
+    for (AP_Param *ap = AP_Param::first(&token, &ptype);
+         ap != nullptr;
+         ap = AP_Param::next_scalar(&token, &ptype)) {
+        if (ptype > AP_PARAM_FLOAT) {
+            continue;
+        }
+        ASSERT_LT(count, ARRAY_SIZE(names));
+        ap->copy_name_token(token, names[count], AP_MAX_NAME_SIZE);
+        ptrs[count++] = ap;
+    }
+    AP_Param::set_hide_disabled_groups(true);
+    // 6 scalars, VEC_[XYZ] and 9 each in GRP_ and DIS_
+    EXPECT_EQ(count, 27);
+
+    for (uint8_t i=0; i<count; i++) {
+        const char *name = names[i];
+        enum ap_var_type walk_type = AP_PARAM_NONE;
+        AP_Param::ParamToken walk_token {};
+        AP_Param *walk = find_by_walk(name, &walk_type, &walk_token);
+
+        enum ap_var_type type = AP_PARAM_NONE;
+        AP_Param::ParamToken tok {};
+        EXPECT_EQ(AP_Param::find_by_name(name, &type, &tok), walk) << name;
+        if (walk != nullptr) {
+            EXPECT_EQ(type, walk_type) << name;
+            EXPECT_EQ(tok.key, walk_token.key) << name;
+            EXPECT_EQ(tok.group_element, walk_token.group_element) << name;
+            EXPECT_EQ(tok.idx, walk_token.idx) << name;
+        }
+
+        // find() matches names within groups whether or not the
+        // group is enabled
+        if (strncmp(name, "GRP_", 4) == 0 || strncmp(name, "DIS_", 4) == 0) {
+            EXPECT_EQ(AP_Param::find(name, &type), ptrs[i]) << name;
+        }
+    }
+
+    // group, nested group and Vector3f elements
+    EXPECT_EQ(AP_Param::find_by_name("GRP_VAL", &ptype, &token), &testvehicle.grp.val);
+    EXPECT_EQ(AP_Param::find_by_name("GRP_S_X", &ptype, &token), &testvehicle.grp.sub.x);
+    EXPECT_EQ((const void *)AP_Param::find_by_name("GRP_VEC_Y", &ptype, &token), &testvehicle.grp.vec.get().y);
+    EXPECT_EQ(ptype, AP_PARAM_FLOAT);
+    EXPECT_EQ((const void *)AP_Param::find_by_name("GRP_S_OFS_Z", &ptype, &token), &testvehicle.grp.sub.ofs.get().z);
+    EXPECT_EQ((const void *)AP_Param::find_by_name("VEC_X", &ptype, &token), &testvehicle.g.vec.get().x);
+    EXPECT_EQ((const void *)AP_Param::find("GRP_S_OFS_Z", &ptype), &testvehicle.grp.sub.ofs.get().z);
+
+    // only the enable parameter of a disabled group is visible
+    EXPECT_EQ(AP_Param::find_by_name("DIS_ENABLE", &ptype, &token), &testvehicle.dis.enable);
+    EXPECT_EQ(AP_Param::find_by_name("DIS_VAL", &ptype, &token), nullptr);
+    EXPECT_EQ(AP_Param::find_by_name("DIS_S_X", &ptype, &token), nullptr);
+    EXPECT_EQ(AP_Param::find("DIS_VAL", &ptype), &testvehicle.dis.val);
+}
+#endif
+
 AP_GTEST_MAIN()
@@ -69,11 +69,28 @@ const AP_Param::GroupInfo AP_Scheduler::var_info[] = {
 
     // @Param: OPTIONS
     // @DisplayName: Scheduling options
-    // @Description: This controls optional aspects of the scheduler.
-    // @Bitmask: 0:Enable per-task perf info
+    // @Description: This controls optional aspects of the scheduler. Adapting task time budgets replaces the time each task is expected to take, as given in the vehicle's task table, with the 99th percentile of the task's measured run times, capped at twice the table value.
+    // @Bitmask: 0:Enable per-task perf info,1:Adapt task time budgets
     // @User: Advanced
     AP_GROUPINFO("OPTIONS",  2, AP_Scheduler, _options, 0),
 
+    // @Param: POLICY
+    // @DisplayName: Scheduling policy
+    // @Description: This controls the order in which scheduled tasks are run. With Priority the tasks that are due run in task table order, and a task is skipped if the time it is expected to take does not fit in the rest of the loop. With EarliestDeadlineFirst the tasks that are due run in order of their deadline, which is the time the task is next due, so tasks that have been skipped run ahead of tasks that are on time. Fast loop tasks always run first, in table order.
+    // @Values: 0:Priority,1:EarliestDeadlineFirst
+    // @User: Advanced
+    AP_GROUPINFO("POLICY",  3, AP_Scheduler, _policy, 0),
+
+#if AP_SCHEDULER_WORKERS_ENABLED
+    // @Param: WORKERS
+    // @DisplayName: Scheduler worker threads
+    // @Description: The number of threads used to run scheduled tasks which have been marked as safe to run outside the main thread. When this is zero all tasks run on the main thread. On multi-core boards this moves low priority work off the core running the main loop.
+    // @Range: 0 4
+    // @RebootRequired: True
+    // @User: Advanced
+    AP_GROUPINFO("WORKERS",  4, AP_Scheduler, _num_workers, 0),
+#endif
+
     AP_GROUPEND
 };
 
@@ -139,7 +156,7 @@ void AP_Scheduler::init(const AP_Scheduler::Task *tasks, uint8_t num_tasks, uint
     perf_info.set_loop_rate(get_loop_rate_hz());
     perf_info.reset();
 
-    if (_options & uint8_t(Options::RECORD_TASK_INFO)) {
+    if (task_info_wanted()) {
         perf_info.allocate_task_info(_num_tasks);
     }
 
@@ -163,6 +180,10 @@ void AP_Scheduler::init(const AP_Scheduler::Task *tasks, uint8_t num_tasks, uint
         }
         old = _vehicle_tasks[i].priority;
     }
+
+#if AP_SCHEDULER_WORKERS_ENABLED
+    start_workers();
+#endif
 }
 
 // one tick has passed
@@ -196,37 +217,24 @@ void AP_Scheduler::run(uint32_t time_available)
     uint8_t vehicle_tasks_offset = 0;
     uint8_t common_tasks_offset = 0;
 
+    // with the EDF policy due tasks are queued here and run after the
+    // table has been walked
+    const bool use_edf = _policy == uint8_t(Policy::EDF) && allocate_edf_queue();
+    uint8_t num_edf = 0;
+
+#if AP_SCHEDULER_WORKERS_ENABLED
+    collect_worker_tasks();
+#endif
+
     for (uint8_t i=0; i<_num_tasks; i++) {
         // determine which of the common task / vehicle task to run
-        bool run_vehicle_task = false;
-        if (vehicle_tasks_offset < _num_vehicle_tasks &&
-            common_tasks_offset < _num_common_tasks) {
-            // still have entries on both lists; compare the
-            // priorities.  In case of a tie the vehicle-specific
-            // entry wins.
-            const Task &vehicle_task = _vehicle_tasks[vehicle_tasks_offset];
-            const Task &common_task = _common_tasks[common_tasks_offset];
-            if (vehicle_task.priority <= common_task.priority) {
-                run_vehicle_task = true;
-            }
-        } else if (vehicle_tasks_offset < _num_vehicle_tasks) {
-            // out of common tasks to run
-            run_vehicle_task = true;
-        } else if (common_tasks_offset < _num_common_tasks) {
-            // out of vehicle tasks to run
-            run_vehicle_task = false;
-        } else {
+        const Task *next = next_task(vehicle_tasks_offset, common_tasks_offset);
+        if (next == nullptr) {
             // this is an error; the outside loop should have terminated
             INTERNAL_ERROR(AP_InternalError::error_t::flow_of_control);
             break;
         }
-
-        const AP_Scheduler::Task &task = run_vehicle_task ? _vehicle_tasks[vehicle_tasks_offset] : _common_tasks[common_tasks_offset];
-        if (run_vehicle_task) {
-            vehicle_tasks_offset++;
-        } else {
-            common_tasks_offset++;
-        }
+        const AP_Scheduler::Task &task = *next;
 
         if (task.priority > MAX_FAST_TASK_PRIORITIES) {
             const uint16_t dt = _tick_counter - _last_run[i];
@@ -239,8 +247,6 @@ void AP_Scheduler::run(uint32_t time_available)
                 // this task is not yet scheduled to run again
                 continue;
             }
-            // this task is due to run. Do we have enough time to run it?
-            _task_time_allowed = task.max_time_micros;
 
             if (dt >= interval_ticks*2) {
                 perf_info.task_slipped(i);
@@ -252,6 +258,28 @@ void AP_Scheduler::run(uint32_t time_available)
                 task_not_achieved++;
             }
 
+#if AP_SCHEDULER_WORKERS_ENABLED
+            if (task.affinity == Affinity::WORKER && _workers_running > 0) {
+                // the main loop spends no time on these. If the task
+                // is still running from last time it will be
+                // dispatched on a later loop
+                dispatch_to_worker(i, task);
+                continue;
+            }
+#endif
+
+            if (use_edf) {
+                // a task should run before it is due again, so its
+                // deadline is one interval after it became due
+                edf_entry &e = _edf_queue[num_edf++];
+                e.task = &task;
+                e.index = i;
+                e.ticks_to_deadline = int32_t(interval_ticks*2) - dt;
+                continue;
+            }
+
+            // this task is due to run. Do we have enough time to run it?
+            _task_time_allowed = task_budget_us(i, task);
             if (_task_time_allowed > time_available) {
                 // not enough time to run this task.  Continue loop -
                 // maybe another task will fit into time remaining
@@ -261,48 +289,29 @@ void AP_Scheduler::run(uint32_t time_available)
             _task_time_allowed = get_loop_period_us();
         }
 
-        // run it
-        _task_time_started = now;
-        hal.util->persistent_data.scheduler_task = i;
-#if CONFIG_HAL_BOARD == HAL_BOARD_SITL
-        fill_nanf_stack();
-#endif
-        task.function();
-        hal.util->persistent_data.scheduler_task = -1;
-
-        // record the tick counter when we ran. This drives
-        // when we next run the event
-        _last_run[i] = _tick_counter;
-
-        // work out how long the event actually took
-        now = AP_HAL::micros();
-        uint32_t time_taken = now - _task_time_started;
-        bool overrun = false;
-        if (time_taken > _task_time_allowed) {
-            overrun = true;
-            // the event overran!
-            debug(3, "Scheduler overrun task[%u-%s] (%u/%u)\n",
-                  (unsigned)i,
-                  task.name,
-                  (unsigned)time_taken,
-                  (unsigned)_task_time_allowed);
-        }
+        run_task(i, task, now, time_available);
+    }
 
-        perf_info.update_task_info(i, time_taken, overrun);
-
-        if (time_taken >= time_available) {
-            /*
-              we are out of time, but we need to keep walking the task
-              table in case there is another fast loop task after this
-              task, plus we need to update the accouting so we can
-              work out if we need to allocate extra time for the loop
-              (lower the loop rate)
-              Just set time_available to zero, which means we will
-              only run fast tasks after this one
-             */
-            time_available = 0;
-        } else {
-            time_available -= time_taken;
+    if (num_edf > 0) {
+        // insertion sort on deadline. Ties keep table order, so tasks
+        // of the same rate run in the order the vehicle expects
+        for (uint8_t i=1; i<num_edf; i++) {
+            const edf_entry e = _edf_queue[i];
+            uint8_t j = i;
+            while (j > 0 && _edf_queue[j-1].ticks_to_deadline > e.ticks_to_deadline) {
+                _edf_queue[j] = _edf_queue[j-1];
+                j--;
+            }
+            _edf_queue[j] = e;
+        }
+        for (uint8_t i=0; i<num_edf; i++) {
+            const edf_entry &e = _edf_queue[i];
+            _task_time_allowed = task_budget_us(e.index, *e.task);
+            if (_task_time_allowed > time_available) {
+                // a later deadline task may still fit
+                continue;
+            }
+            run_task(e.index, *e.task, now, time_available);
         }
     }
 
@@ -316,6 +325,235 @@ void AP_Scheduler::run(uint32_t time_available)
     }
 }
 
+/*
+  run a single task with _task_time_allowed already set, and account
+  for the time it took
+ */
+void AP_Scheduler::run_task(uint8_t i, const Task &task, uint32_t &now, uint32_t &time_available)
+{
+    // run it
+    _task_time_started = now;
+    hal.util->persistent_data.scheduler_task = i;
+#if CONFIG_HAL_BOARD == HAL_BOARD_SITL
+    fill_nanf_stack();
+#endif
+    task.function();
+    hal.util->persistent_data.scheduler_task = -1;
+
+    // record the tick counter when we ran. This drives
+    // when we next run the event
+    _last_run[i] = _tick_counter;
+
+    // work out how long the event actually took
+    now = AP_HAL::micros();
+    uint32_t time_taken = now - _task_time_started;
+    bool overrun = false;
+    if (time_taken > _task_time_allowed) {
+        overrun = true;
+        // the event overran!
+        debug(3, "Scheduler overrun task[%u-%s] (%u/%u)\n",
+              (unsigned)i,
+              task.name,
+              (unsigned)time_taken,
+              (unsigned)_task_time_allowed);
+    }
+
+    perf_info.update_task_info(i, time_taken, overrun);
+
+    if (time_taken >= time_available) {
+        /*
+          we are out of time, but we need to keep walking the task
+          table in case there is another fast loop task after this
+          task, plus we need to update the accouting so we can
+          work out if we need to allocate extra time for the loop
+          (lower the loop rate)
+          Just set time_available to zero, which means we will
+          only run fast tasks after this one
+         */
+        time_available = 0;
+    } else {
+        time_available -= time_taken;
+    }
+}
+
+/*
+  allocate the queue of due tasks for the EDF policy. This is done on
+  first use so the policy can be changed in flight
+ */
+bool AP_Scheduler::allocate_edf_queue(void)
+{
+    if (_edf_queue == nullptr && !_edf_alloc_failed) {
+        _edf_queue = NEW_NOTHROW edf_entry[_num_tasks];
+        if (_edf_queue == nullptr) {
+            // fall back to priority order
+            _edf_alloc_failed = true;
+        }
+    }
+    return _edf_queue != nullptr;
+}
+
+#if AP_SCHEDULER_WORKERS_ENABLED
+/*
+  start the worker threads and allocate their state. Tasks which
+  can run on a worker run on the main thread if this fails
+ */
+void AP_Scheduler::start_workers(void)
+{
+    const uint8_t num_workers = constrain_int16(_num_workers, 0, 4);
+    if (num_workers == 0) {
+        return;
+    }
+    _worker_tasks = NEW_NOTHROW worker_task[_num_tasks];
+    _worker_queue = NEW_NOTHROW uint8_t[_num_tasks];
+    _workers = NEW_NOTHROW Worker[num_workers];
+    if (_worker_tasks == nullptr || _worker_queue == nullptr || _workers == nullptr) {
+        DEV_PRINTF("Unable to allocate scheduler workers\n");
+        delete[] _worker_tasks;
+        delete[] _worker_queue;
+        delete[] _workers;
+        _worker_tasks = nullptr;
+        _worker_queue = nullptr;
+        _workers = nullptr;
+        return;
+    }
+    for (uint8_t i=0; i<num_workers; i++) {
+        Worker &worker = _workers[i];
+        worker.scheduler = this;
+        worker.index = i;
+        if (!hal.scheduler->thread_create(FUNCTOR_BIND(&worker, &AP_Scheduler::Worker::thread_main, void),
+                                          "sched_worker",
+                                          16384, AP_HAL::Scheduler::PRIORITY_IO, 0)) {
+            DEV_PRINTF("Unable to start scheduler worker\n");
+            break;
+        }
+        WITH_SEMAPHORE(_worker_sem);
+        _idle_workers |= 1U<<i;
+        _workers_running++;
+    }
+}
+
+void AP_Scheduler::Worker::thread_main(void)
+{
+    while (true) {
+        IGNORE_RETURN(wake_sem.wait_blocking());
+        while (scheduler->run_worker_task(index)) {
+        }
+    }
+}
+
+/*
+  queue a task for the workers. Returns false if it is still queued
+  or running from its last dispatch
+ */
+bool AP_Scheduler::dispatch_to_worker(uint8_t i, const Task &task)
+{
+    int8_t wake = -1;
+    {
+        WITH_SEMAPHORE(_worker_sem);
+        worker_task &wt = _worker_tasks[i];
+        if (wt.state != WorkerTaskState::IDLE) {
+            return false;
+        }
+        wt.task = &task;
+        wt.state = WorkerTaskState::QUEUED;
+        _worker_queue[(_worker_queue_head + _worker_queue_len) % _num_tasks] = i;
+        _worker_queue_len++;
+
+        // wake a worker which is waiting for work. If they are all
+        // busy the first to finish takes the task from the queue
+        for (uint8_t w=0; w<_workers_running; w++) {
+            if (_idle_workers & (1U<<w)) {
+                _idle_workers &= ~(1U<<w);
+                wake = w;
+                break;
+            }
+        }
+    }
+
+    // this drives when we next run the task, as for the main thread
+    _last_run[i] = _tick_counter;
+
+    if (wake != -1) {
+        _workers[wake].wake_sem.signal();
+    }
+    return true;
+}
+
+/*
+  run one queued task on the calling worker thread. Returns false,
+  marking the worker idle, if the queue was empty
+ */
+bool AP_Scheduler::run_worker_task(uint8_t worker)
+{
+    uint8_t i;
+    const Task *task;
+    {
+        WITH_SEMAPHORE(_worker_sem);
+        if (_worker_queue_len == 0) {
+            // checked and marked under the semaphore, so a task
+            // queued after this wakes us
+            _idle_workers |= 1U<<worker;
+            return false;
+        }
+        i = _worker_queue[_worker_queue_head];
+        _worker_queue_head = (_worker_queue_head + 1) % _num_tasks;
+        _worker_queue_len--;
+        task = _worker_tasks[i].task;
+    }
+
+    const uint32_t start_us = AP_HAL::micros();
+    task->function();
+    const uint32_t time_taken = AP_HAL::micros() - start_us;
+
+    WITH_SEMAPHORE(_worker_sem);
+    _worker_tasks[i].time_taken_us = time_taken;
+    _worker_tasks[i].state = WorkerTaskState::DONE;
+    _worker_done++;
+    return true;
+}
+
+/*
+  account for the tasks the workers have finished. PerfInfo is only
+  updated from the main thread
+ */
+void AP_Scheduler::collect_worker_tasks(void)
+{
+    if (_workers_running == 0) {
+        return;
+    }
+    WITH_SEMAPHORE(_worker_sem);
+    for (uint8_t i=0; i<_num_tasks && _worker_done > 0; i++) {
+        worker_task &wt = _worker_tasks[i];
+        if (wt.state != WorkerTaskState::DONE) {
+            continue;
+        }
+        const uint16_t budget_us = task_budget_us(i, *wt.task);
+        perf_info.update_task_info(i, wt.time_taken_us, wt.time_taken_us > budget_us);
+        wt.state = WorkerTaskState::IDLE;
+        _worker_done--;
+    }
+}
+#endif // AP_SCHEDULER_WORKERS_ENABLED
+
+/*
+  time budget for a task, from the task table or from its measured
+  run times
+ */
+uint16_t AP_Scheduler::task_budget_us(uint8_t task_index, const Task &task) const
+{
+#if AP_SCHEDULER_TASK_HISTOGRAM_ENABLED
+    if (_options & uint8_t(Options::ADAPT_TASK_BUDGETS)) {
+        const uint16_t p99_us = perf_info.get_task_p99_us(task_index);
+        if (p99_us != 0) {
+            // tasks which size their work from time_available_usec()
+            // would otherwise slowly grow their own budget
+            return MIN(p99_us, uint32_t(task.max_time_micros) * 2U);
+        }
+    }
+#endif
+    return task.max_time_micros;
+}
+
 /*
   return number of micros until the current task reaches its deadline
  */
@@ -443,9 +681,9 @@ void AP_Scheduler::update_logging()
     perf_info.set_loop_rate(get_loop_rate_hz());
     perf_info.reset();
     // dynamically update the per-task perf counter
-    if (!(_options & uint8_t(Options::RECORD_TASK_INFO)) && perf_info.has_task_info()) {
+    if (!task_info_wanted() && perf_info.has_task_info()) {
         perf_info.free_task_info();
-    } else if ((_options & uint8_t(Options::RECORD_TASK_INFO)) && !perf_info.has_task_info()) {
+    } else if (task_info_wanted() && !perf_info.has_task_info()) {
         perf_info.allocate_task_info(_num_tasks);
     }
 }
@@ -511,40 +749,80 @@ void AP_Scheduler::task_info(ExpandingString &str)
 
     for (uint8_t i = 0; i < _num_tasks; i++) {
         const AP::PerfInfo::TaskInfo* ti = perf_info.get_task_info(i);
-        const char *task_name;
-
-        // determine which of the common task / vehicle task to run
-        bool run_vehicle_task = false;
-        if (vehicle_tasks_offset < _num_vehicle_tasks &&
-            common_tasks_offset < _num_common_tasks) {
-            // still have entries on both lists; compare the
-            // priorities.  In case of a tie the vehicle-specific
-            // entry wins.
-            const Task &vehicle_task = _vehicle_tasks[vehicle_tasks_offset];
-            const Task &common_task = _common_tasks[common_tasks_offset];
-            if (vehicle_task.priority <= common_task.priority) {
-                run_vehicle_task = true;
-            }
-        } else if (vehicle_tasks_offset < _num_vehicle_tasks) {
-            // out of common tasks to run
-            run_vehicle_task = true;
-        } else if (common_tasks_offset < _num_common_tasks) {
-            // out of vehicle tasks to run
-            run_vehicle_task = false;
-        } else {
+        const Task *task = next_task(vehicle_tasks_offset, common_tasks_offset);
+        if (task == nullptr) {
             // this is an error; the outside loop should have terminated
             INTERNAL_ERROR(AP_InternalError::error_t::flow_of_control);
             return;
         }
 
-        if (run_vehicle_task) {
-            task_name = _vehicle_tasks[vehicle_tasks_offset++].name;
-        } else {
-            task_name = _common_tasks[common_tasks_offset++].name;
+        ti->print(task->name, total_time, str);
+    }
+}
+
+#if AP_SCHEDULER_TASK_HISTOGRAM_ENABLED
+// display task run time histograms as text buffer for @SYS/task_hist.txt
+void AP_Scheduler::task_histograms(ExpandingString &str)
+{
+    // a header to allow for machine parsers to determine format
+    str.printf("TaskHistV1\n");
+
+    // dynamically enable statistics collection
+    if (!task_info_wanted()) {
+        _options.set(_options | uint8_t(Options::RECORD_TASK_INFO));
+        return;
+    }
+
+    if (perf_info.get_task_histogram(0) == nullptr) {
+        return;
+    }
+
+    uint8_t vehicle_tasks_offset = 0;
+    uint8_t common_tasks_offset = 0;
+
+    for (uint8_t i = 0; i < _num_tasks; i++) {
+        const Task *task = next_task(vehicle_tasks_offset, common_tasks_offset);
+        if (task == nullptr) {
+            INTERNAL_ERROR(AP_InternalError::error_t::flow_of_control);
+            return;
         }
+        // fast tasks always get the whole loop period
+        const uint16_t budget_us = task->priority > MAX_FAST_TASK_PRIORITIES ? task_budget_us(i, *task) : 0;
+        perf_info.get_task_histogram(i)->print(task->name, budget_us, str);
+    }
+}
+#endif
+
+/*
+  return the next task in run order, merging the vehicle and common
+  task lists by priority.  In case of a tie the vehicle-specific
+  entry wins
+ */
+const AP_Scheduler::Task *AP_Scheduler::next_task(uint8_t &vehicle_tasks_offset, uint8_t &common_tasks_offset) const
+{
+    bool run_vehicle_task = false;
+    if (vehicle_tasks_offset < _num_vehicle_tasks &&
+        common_tasks_offset < _num_common_tasks) {
+        // still have entries on both lists; compare the priorities
+        const Task &vehicle_task = _vehicle_tasks[vehicle_tasks_offset];
+        const Task &common_task = _common_tasks[common_tasks_offset];
+        if (vehicle_task.priority <= common_task.priority) {
+            run_vehicle_task = true;
+        }
+    } else if (vehicle_tasks_offset < _num_vehicle_tasks) {
+        // out of common tasks to run
+        run_vehicle_task = true;
+    } else if (common_tasks_offset < _num_common_tasks) {
+        // out of vehicle tasks to run
+        run_vehicle_task = false;
+    } else {
+        return nullptr;
+    }
 
-        ti->print(task_name, total_time, str);
+    if (run_vehicle_task) {
+        return &_vehicle_tasks[vehicle_tasks_offset++];
     }
+    return &_common_tasks[common_tasks_offset++];
 }
 
 namespace AP {
@@ -51,6 +51,22 @@
     .priority = _priority \
 }
 
+/*
+  a task which may be run on a worker thread when SCHED_WORKERS is
+  set. It then runs concurrently with the main loop, so it must only
+  touch state that its library protects with its own semaphore, and
+  the main thread must take that semaphore too. A worker task never
+  runs concurrently with itself
+ */
+#define SCHED_TASK_CLASS_WORKER(classname, classptr, func, _rate_hz, _max_time_micros, _priority) { \
+    .function = FUNCTOR_BIND(classptr, &classname::func, void),\
+    AP_SCHEDULER_NAME_INITIALIZER(classname, func)\
+    .rate_hz = _rate_hz,\
+    .max_time_micros = _max_time_micros,        \
+    .priority = _priority, \
+    .affinity = AP_Scheduler::Affinity::WORKER \
+}
+
 /*
   useful macro for creating the fastloop task table
  */
@@ -74,6 +90,8 @@
 
 class AP_Scheduler
 {
+    friend class AP_Scheduler_Test;
+
 public:
     AP_Scheduler();
 
@@ -85,16 +103,29 @@ public:
 
     FUNCTOR_TYPEDEF(task_fn_t, void);
 
+    // which thread a task may run on
+    enum class Affinity : uint8_t {
+        MAIN = 0,       // always the main thread
+        WORKER = 1,     // a worker thread if there are any
+    };
+
     struct Task {
         task_fn_t function;
         const char *name;
         float rate_hz;
         uint16_t max_time_micros;
         uint8_t priority; // task priority
+        Affinity affinity;
     };
 
     enum class Options : uint8_t {
-        RECORD_TASK_INFO = 1 << 0
+        RECORD_TASK_INFO = 1 << 0,
+        ADAPT_TASK_BUDGETS = 1 << 1,
+    };
+
+    enum class Policy : uint8_t {
+        PRIORITY = 0,
+        EDF = 1,
     };
 
     enum FastTaskPriorities {
@@ -129,6 +160,9 @@ public:
     // tasks in microseconds
     void run(uint32_t time_available);
 
+    // select the order due tasks are run in
+    void set_policy(Policy policy) { _policy.set(uint8_t(policy)); }
+
     // return the number of microseconds available for the current task
     uint16_t time_available_usec(void) const;
 
@@ -193,6 +227,9 @@ public:
     HAL_Semaphore &get_semaphore(void) { return _rsem; }
 
     void task_info(ExpandingString &str);
+#if AP_SCHEDULER_TASK_HISTOGRAM_ENABLED
+    void task_histograms(ExpandingString &str);
+#endif
 
     static const struct AP_Param::GroupInfo var_info[];
 
@@ -211,6 +248,9 @@ private:
 
     // scheduler options
     AP_Int8 _options;
+
+    // scheduling policy, one of Policy
+    AP_Int8 _policy;
     
     // calculated loop period in usec
     uint16_t _loop_period_us;
@@ -218,6 +258,74 @@ private:
     // calculated loop period in seconds
     float _loop_period_s;
     
+    // true if per-task statistics should be collected
+    bool task_info_wanted() const {
+        return (_options & (uint8_t(Options::RECORD_TASK_INFO) | uint8_t(Options::ADAPT_TASK_BUDGETS))) != 0;
+    }
+
+    // run one task and account for its time
+    void run_task(uint8_t i, const Task &task, uint32_t &now, uint32_t &time_available);
+
+    // a task that is due to run under the EDF policy
+    struct edf_entry {
+        const Task *task;
+        int32_t ticks_to_deadline;
+        uint8_t index;
+    };
+    edf_entry *_edf_queue;
+    bool _edf_alloc_failed;
+    bool allocate_edf_queue(void);
+
+#if AP_SCHEDULER_WORKERS_ENABLED
+    // number of worker threads to start
+    AP_Int8 _num_workers;
+
+    // a thread which runs tasks with Affinity::WORKER
+    struct Worker {
+        AP_Scheduler *scheduler;
+        uint8_t index;
+        HAL_BinarySemaphore wake_sem;
+        void thread_main(void);
+    };
+    Worker *_workers;
+    uint8_t _workers_running;
+
+    enum class WorkerTaskState : uint8_t {
+        IDLE = 0,       // not dispatched
+        QUEUED = 1,     // waiting for or running on a worker
+        DONE = 2,       // finished, waiting for the main thread to account for it
+    };
+    struct worker_task {
+        const Task *task;
+        uint32_t time_taken_us;
+        WorkerTaskState state;
+    };
+    // per-task state, indexed as _last_run
+    worker_task *_worker_tasks;
+    // indexes of tasks waiting for a worker
+    uint8_t *_worker_queue;
+    uint8_t _worker_queue_head;
+    uint8_t _worker_queue_len;
+    // number of tasks in the DONE state
+    uint8_t _worker_done;
+    // bitmask of workers waiting to be woken for a task
+    uint8_t _idle_workers;
+    // protects all of the above worker state
+    HAL_Semaphore _worker_sem;
+
+    void start_workers(void);
+    bool dispatch_to_worker(uint8_t i, const Task &task);
+    bool run_worker_task(uint8_t worker);
+    void collect_worker_tasks(void);
+#endif
+
+    // time budget for a task that is not a fast task
+    uint16_t task_budget_us(uint8_t task_index, const Task &task) const;
+
+    // step through the vehicle and common task lists in the order
+    // they are run. Returns nullptr when both lists are exhausted
+    const Task *next_task(uint8_t &vehicle_tasks_offset, uint8_t &common_tasks_offset) const;
+
     // list of tasks to run
     const struct Task *_vehicle_tasks;
     uint8_t _num_vehicle_tasks;
@@ -9,3 +9,15 @@
 #ifndef AP_SCHEDULER_EXTENDED_TASKINFO_ENABLED
 #define AP_SCHEDULER_EXTENDED_TASKINFO_ENABLED 1
 #endif
+
+// per-task run time histograms for @SYS/task_hist.txt and adaptive
+// task time budgets
+#ifndef AP_SCHEDULER_TASK_HISTOGRAM_ENABLED
+#define AP_SCHEDULER_TASK_HISTOGRAM_ENABLED AP_SCHEDULER_ENABLED && HAL_PROGRAM_SIZE_LIMIT_KB > 1024
+#endif
+
+// allow tasks marked with SCHED_TASK_CLASS_WORKER to run on a pool of
+// worker threads, see SCHED_WORKERS
+#ifndef AP_SCHEDULER_WORKERS_ENABLED
+#define AP_SCHEDULER_WORKERS_ENABLED AP_SCHEDULER_ENABLED && (CONFIG_HAL_BOARD == HAL_BOARD_LINUX || CONFIG_HAL_BOARD == HAL_BOARD_SITL)
+#endif
@@ -51,6 +51,12 @@ void AP::PerfInfo::allocate_task_info(uint8_t num_tasks)
         _num_tasks = 0;
         return;
     }
+#if AP_SCHEDULER_TASK_HISTOGRAM_ENABLED
+    _task_histogram = NEW_NOTHROW TaskHistogram[num_tasks];
+    if (_task_histogram == nullptr) {
+        DEV_PRINTF("Unable to allocate scheduler TaskHistogram\n");
+    }
+#endif
     _num_tasks = num_tasks;
 }
 
@@ -58,6 +64,10 @@ void AP::PerfInfo::free_task_info()
 {
     delete[] _task_info;
     _task_info = nullptr;
+#if AP_SCHEDULER_TASK_HISTOGRAM_ENABLED
+    delete[] _task_histogram;
+    _task_histogram = nullptr;
+#endif
     _num_tasks = 0;
 }
 
@@ -74,6 +84,11 @@ void AP::PerfInfo::update_task_info(uint8_t task_index, uint16_t task_time_us, b
     }
     TaskInfo& ti = _task_info[task_index];
     ti.update(task_time_us, overrun);
+#if AP_SCHEDULER_TASK_HISTOGRAM_ENABLED
+    if (_task_histogram != nullptr) {
+        _task_histogram[task_index].update(task_time_us);
+    }
+#endif
 }
 
 void AP::PerfInfo::TaskInfo::update(uint16_t task_time_us, bool overrun)
@@ -109,6 +124,87 @@ void AP::PerfInfo::TaskInfo::print(const char* task_name, uint32_t total_time, E
                 unsigned(MIN(overrun_count, 999)), unsigned(MIN(slip_count, 999)), pct);
 }
 
+#if AP_SCHEDULER_TASK_HISTOGRAM_ENABLED
+/*
+  bucket for a run time. Times below 8us get a bucket each, above
+  that there are four buckets per power of two
+ */
+uint8_t AP::PerfInfo::TaskHistogram::bucket(uint16_t time_us)
+{
+    if (time_us < 8) {
+        return time_us;
+    }
+    const uint8_t msb = 31 - __builtin_clz(time_us);
+    return 4*(msb-1) + ((time_us >> (msb-2)) & 3);
+}
+
+// largest run time that falls in a bucket
+uint16_t AP::PerfInfo::TaskHistogram::bucket_max_us(uint8_t b)
+{
+    if (b < 8) {
+        return b;
+    }
+    const uint8_t msb = b/4 + 1;
+    const uint32_t width = 1U << (msb-2);
+    return (1U << msb) + (b & 3) * width + width - 1;
+}
+
+void AP::PerfInfo::TaskHistogram::update(uint16_t task_time_us)
+{
+    const uint8_t b = bucket(task_time_us);
+    if (total >= 4096 || count[b] == UINT16_MAX) {
+        // age the histogram
+        total = 0;
+        for (auto &c : count) {
+            c /= 2;
+            total += c;
+        }
+    }
+    count[b]++;
+    total++;
+    // the percentile is only needed by the scheduler for budgets,
+    // so don't walk the buckets on every run
+    if ((total & 0x1F) == 0) {
+        p99_us = total >= 100 ? percentile_us(99) : 0;
+    }
+}
+
+/*
+  upper bound of the run time that pct percent of runs finished within
+ */
+uint16_t AP::PerfInfo::TaskHistogram::percentile_us(uint8_t pct) const
+{
+    const uint32_t needed = (uint32_t(total) * pct + 99) / 100;
+    uint32_t sum = 0;
+    for (uint8_t b = 0; b < num_buckets; b++) {
+        sum += count[b];
+        if (sum >= needed && sum > 0) {
+            return bucket_max_us(b);
+        }
+    }
+    return 0;
+}
+
+void AP::PerfInfo::TaskHistogram::print(const char* task_name, uint16_t budget_us, ExpandingString& str) const
+{
+#if AP_SCHEDULER_EXTENDED_TASKINFO_ENABLED
+    const char* fmt = "%-32.32s N=%4u P50=%5u P90=%5u P99=%5u BUD=%5u";
+#else
+    const char* fmt = "%-16.16s N=%4u P50=%5u P90=%5u P99=%5u BUD=%5u";
+#endif
+    str.printf(fmt, task_name, unsigned(total),
+               unsigned(percentile_us(50)), unsigned(percentile_us(90)), unsigned(percentile_us(99)),
+               unsigned(budget_us));
+    // non-empty buckets as upper bound:count
+    for (uint8_t b = 0; b < num_buckets; b++) {
+        if (count[b] != 0) {
+            str.printf(" %u:%u", unsigned(bucket_max_us(b)), unsigned(count[b]));
+        }
+    }
+    str.printf("\n");
+}
+#endif // AP_SCHEDULER_TASK_HISTOGRAM_ENABLED
+
 // check_loop_time - check latest loop time vs min, max and overtime threshold
 void AP::PerfInfo::check_loop_time(uint32_t time_in_micros)
 {
@@ -26,6 +26,30 @@ public:
         void print(const char* task_name, uint32_t total_time, ExpandingString& str) const;
     };
 
+#if AP_SCHEDULER_TASK_HISTOGRAM_ENABLED
+    /*
+      histogram of task run times in log-spaced buckets, four per
+      power of two, covering 0 to 65535us. Unlike TaskInfo it is not
+      cleared every second. Instead all counts are halved when the
+      total gets large, so recent runs carry the most weight
+     */
+    struct TaskHistogram {
+        static const uint8_t num_buckets = 60;
+        uint16_t count[num_buckets];
+        uint16_t total;
+        // run time that 99% of runs finish within, 0 until there
+        // are enough runs to say
+        uint16_t p99_us;
+
+        void update(uint16_t task_time_us);
+        uint16_t percentile_us(uint8_t pct) const;
+        void print(const char* task_name, uint16_t budget_us, ExpandingString& str) const;
+
+        static uint8_t bucket(uint16_t time_us);
+        static uint16_t bucket_max_us(uint8_t b);
+    };
+#endif
+
     /* Do not allow copies */
     CLASS_NO_COPY(PerfInfo);
 
@@ -55,10 +79,19 @@ public:
     }
     // called after each run of a task to update its statistics based on measurements taken by the scheduler
     void update_task_info(uint8_t task_index, uint16_t task_time_us, bool overrun);
+#if AP_SCHEDULER_TASK_HISTOGRAM_ENABLED
+    const TaskHistogram* get_task_histogram(uint8_t task_index) const {
+        return (_task_histogram && task_index < _num_tasks) ? &_task_histogram[task_index] : nullptr;
+    }
+    // observed 99th percentile run time of a task, or 0 if not known
+    uint16_t get_task_p99_us(uint8_t task_index) const {
+        return (_task_histogram && task_index < _num_tasks) ? _task_histogram[task_index].p99_us : 0;
+    }
+#endif
     // record that a task slipped
     void task_slipped(uint8_t task_index) {
         if (_task_info && task_index < _num_tasks) {
-            _task_info[task_index].overrun_count++;
+            _task_info[task_index].slip_count++;
         }
     }
 
@@ -77,6 +110,9 @@ private:
     // performance monitoring
     uint8_t _num_tasks;
     TaskInfo* _task_info;
+#if AP_SCHEDULER_TASK_HISTOGRAM_ENABLED
+    TaskHistogram* _task_histogram;
+#endif
 };
 
 };
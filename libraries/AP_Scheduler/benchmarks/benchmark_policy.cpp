@@ -0,0 +1,96 @@
+#include <AP_gbenchmark.h>
+
+#include <AP_Scheduler/AP_Scheduler.h>
+
+const AP_HAL::HAL& hal = AP_HAL::get_HAL();
+
+/*
+  task rate fidelity of the Priority and EDF scheduling policies on
+  an overloaded CPU. The tasks busy-wait for their expected time,
+  and together ask for about 110% of the time left after the fast
+  task. Each benchmark iteration is one main loop.
+
+  The counters give the achieved rate of each task as a fraction of
+  its table rate: the mean over all tasks and the worst task
+ */
+#define LOOP_TIME_US 1000
+
+class BenchTasks {
+public:
+    static const AP_Scheduler::Task tasks[];
+    uint32_t runs[10];
+
+    void fast(void) { busy(400); runs[0]++; }
+    void t1(void) { busy(100); runs[1]++; }
+    void t2(void) { busy(150); runs[2]++; }
+    void t3(void) { busy(200); runs[3]++; }
+    void t4(void) { busy(250); runs[4]++; }
+    void t5(void) { busy(300); runs[5]++; }
+    void t6(void) { busy(250); runs[6]++; }
+    void t7(void) { busy(450); runs[7]++; }
+    void t8(void) { busy(550); runs[8]++; }
+    void t9(void) { busy(575); runs[9]++; }
+
+private:
+    void busy(uint32_t us) {
+        const uint32_t start = AP_HAL::micros();
+        while (AP_HAL::micros() - start < us) {
+        }
+    }
+};
+
+static BenchTasks bench;
+
+#define TASK(func, rate_hz, max_time_micros, priority) SCHED_TASK_CLASS(BenchTasks, &bench, func, rate_hz, max_time_micros, priority)
+
+const AP_Scheduler::Task BenchTasks::tasks[] = {
+    FAST_TASK_CLASS(BenchTasks, &bench, fast),
+    TASK(t1, 50, 100, 3),
+    TASK(t2, 50, 150, 6),
+    TASK(t3, 25, 200, 9),
+    TASK(t4, 25, 250, 12),
+    TASK(t5, 10, 300, 15),
+    TASK(t6, 10, 250, 18),
+    TASK(t7,  5, 450, 21),
+    TASK(t8,  2, 550, 24),
+    TASK(t9,  1, 575, 27),
+};
+
+static AP_Scheduler scheduler;
+
+static void BM_SchedulerPolicy(benchmark::State &state)
+{
+    static bool initialised;
+    if (!initialised) {
+        scheduler.init(BenchTasks::tasks, ARRAY_SIZE(BenchTasks::tasks), (uint32_t)-1);
+        initialised = true;
+    }
+    scheduler.set_policy(AP_Scheduler::Policy(state.range(0)));
+    memset(bench.runs, 0, sizeof(bench.runs));
+
+    uint32_t loops = 0;
+    for (auto _ : state) {
+        scheduler.tick();
+        scheduler.run(LOOP_TIME_US);
+        loops++;
+    }
+
+    const float loop_rate_hz = scheduler.get_loop_rate_hz();
+    float sum = 0;
+    float worst = 1;
+    for (uint8_t i=1; i<ARRAY_SIZE(BenchTasks::tasks); i++) {
+        const float expected = loops * BenchTasks::tasks[i].rate_hz / loop_rate_hz;
+        const float fidelity = MIN(bench.runs[i] / expected, 1);
+        sum += fidelity;
+        worst = MIN(worst, fidelity);
+    }
+    state.counters["mean_rate"] = sum / (ARRAY_SIZE(BenchTasks::tasks) - 1);
+    state.counters["worst_rate"] = worst;
+}
+
+// 0 is the Priority policy, 1 is EDF. At the default 50Hz loop rate
+// 5000 loops is 100 seconds, so the 1Hz task is due 100 times
+BENCHMARK(BM_SchedulerPolicy)->Arg(0)->Iterations(5000);
+BENCHMARK(BM_SchedulerPolicy)->Arg(1)->Iterations(5000);
+
+BENCHMARK_MAIN();
@@ -0,0 +1,234 @@
+#include <AP_gtest.h>
+
+#include <AP_Scheduler/AP_Scheduler.h>
+
+#include <atomic>
+#include <chrono>
+#include <thread>
+
+const AP_HAL::HAL& hal = AP_HAL::get_HAL();
+
+#if AP_SCHEDULER_WORKERS_ENABLED
+
+/*
+  tasks which record where and how often they ran. The slow worker
+  task can be held running, to keep one worker busy
+ */
+class WorkerTasks {
+public:
+    static const AP_Scheduler::Task tasks[];
+
+    std::thread::id main_thread;
+    std::atomic<uint32_t> main_runs;
+    std::atomic<uint32_t> main_off_thread;
+
+    std::atomic<uint32_t> quick_runs;
+    std::atomic<uint32_t> quick_on_main;
+    std::atomic<uint8_t> quick_active;
+    std::atomic<uint8_t> quick_overlaps;
+
+    std::atomic<uint32_t> slow_starts;
+    std::atomic<uint32_t> slow_runs;
+    std::atomic<uint32_t> slow_on_main;
+    std::atomic<bool> slow_running;
+    std::atomic<bool> slow_hold;
+
+    void main_task(void)
+    {
+        if (std::this_thread::get_id() != main_thread) {
+            main_off_thread++;
+        }
+        main_runs++;
+    }
+
+    void quick_task(void)
+    {
+        if (quick_active++ != 0) {
+            quick_overlaps++;
+        }
+        if (std::this_thread::get_id() == main_thread) {
+            quick_on_main++;
+        }
+        quick_active--;
+        quick_runs++;
+    }
+
+    void slow_task(void)
+    {
+        slow_starts++;
+        slow_running = true;
+        if (std::this_thread::get_id() == main_thread) {
+            slow_on_main++;
+        }
+        while (slow_hold) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+        slow_running = false;
+        slow_runs++;
+    }
+};
+
+static WorkerTasks worker_tasks;
+
+const AP_Scheduler::Task WorkerTasks::tasks[] = {
+    SCHED_TASK_CLASS(WorkerTasks, &worker_tasks, main_task, 0, 100, 3),
+    SCHED_TASK_CLASS_WORKER(WorkerTasks, &worker_tasks, slow_task, 0, 100, 6),
+    SCHED_TASK_CLASS_WORKER(WorkerTasks, &worker_tasks, quick_task, 0, 100, 9),
+};
+
+static AP_Scheduler scheduler;
+
+/*
+  run the scheduler as a vehicle's main loop would, and look at the
+  state it shares with its workers
+ */
+class AP_Scheduler_Test {
+public:
+    static void init(uint8_t num_workers)
+    {
+        static bool initialised;
+        if (initialised) {
+            return;
+        }
+        initialised = true;
+        worker_tasks.main_thread = std::this_thread::get_id();
+        scheduler._num_workers.set(num_workers);
+        scheduler.init(WorkerTasks::tasks, ARRAY_SIZE(WorkerTasks::tasks), (uint32_t)-1);
+    }
+
+    // one main loop
+    static void loop(void)
+    {
+        scheduler.tick();
+        scheduler.run(1000);
+    }
+
+    static void collect(void) { scheduler.collect_worker_tasks(); }
+
+    static uint8_t workers_running(void) { return scheduler._workers_running; }
+
+    // number of tasks the workers have finished which the main
+    // thread has not yet accounted for
+    static uint8_t tasks_done(void)
+    {
+        WITH_SEMAPHORE(scheduler._worker_sem);
+        return scheduler._worker_done;
+    }
+
+    // true if no worker task is queued or running
+    static bool none_running(void)
+    {
+        WITH_SEMAPHORE(scheduler._worker_sem);
+        for (uint8_t i=0; i<scheduler._num_tasks; i++) {
+            if (scheduler._worker_tasks[i].state == AP_Scheduler::WorkerTaskState::QUEUED) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    // true if no worker task is queued, running or waiting to be
+    // accounted for
+    static bool all_idle(void)
+    {
+        WITH_SEMAPHORE(scheduler._worker_sem);
+        for (uint8_t i=0; i<scheduler._num_tasks; i++) {
+            if (scheduler._worker_tasks[i].state != AP_Scheduler::WorkerTaskState::IDLE) {
+                return false;
+            }
+        }
+        return scheduler._worker_done == 0 && scheduler._worker_queue_len == 0;
+    }
+};
+
+// wait up to a second for cond to become true
+template <typename Cond>
+static bool wait_for(Cond cond)
+{
+    for (uint16_t i=0; i<1000; i++) {
+        if (cond()) {
+            return true;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    return cond();
+}
+
+class SchedulerWorkersTest : public ::testing::Test {
+protected:
+    void SetUp() override
+    {
+        AP_Scheduler_Test::init(2);
+        ASSERT_EQ(AP_Scheduler_Test::workers_running(), 2);
+        // let the last test's tasks finish, and account for them
+        worker_tasks.slow_hold = false;
+        ASSERT_TRUE(wait_for(AP_Scheduler_Test::none_running));
+        AP_Scheduler_Test::collect();
+        ASSERT_TRUE(AP_Scheduler_Test::all_idle());
+    }
+};
+
+TEST_F(SchedulerWorkersTest, RunsWorkerTasksOffMainThread)
+{
+    const uint32_t main_runs = worker_tasks.main_runs;
+    const uint32_t quick_runs = worker_tasks.quick_runs;
+    const uint32_t slow_runs = worker_tasks.slow_runs;
+    const uint16_t loops = 100;
+
+    for (uint16_t n=1; n<=loops; n++) {
+        AP_Scheduler_Test::loop();
+        // the main thread task ran in the loop. The worker tasks
+        // are waited for, so each can be dispatched again next loop
+        EXPECT_EQ(worker_tasks.main_runs.load(), main_runs + n);
+        ASSERT_TRUE(wait_for([]() { return AP_Scheduler_Test::tasks_done() == 2; })) << "loop " << n;
+        EXPECT_EQ(worker_tasks.quick_runs.load(), quick_runs + n);
+        EXPECT_EQ(worker_tasks.slow_runs.load(), slow_runs + n);
+    }
+
+    EXPECT_EQ(worker_tasks.main_off_thread.load(), 0U);
+    EXPECT_EQ(worker_tasks.quick_on_main.load(), 0U);
+    EXPECT_EQ(worker_tasks.slow_on_main.load(), 0U);
+    EXPECT_EQ(worker_tasks.quick_overlaps.load(), 0U);
+
+    // the main thread accounts for the last runs
+    EXPECT_FALSE(AP_Scheduler_Test::all_idle());
+    AP_Scheduler_Test::collect();
+    EXPECT_TRUE(AP_Scheduler_Test::all_idle());
+}
+
+/*
+  with one worker held by a long task, tasks must still reach the
+  other worker rather than queue behind the busy one
+ */
+TEST_F(SchedulerWorkersTest, BusyWorkerDoesNotStallOthers)
+{
+    worker_tasks.slow_hold = true;
+    const uint32_t slow_starts = worker_tasks.slow_starts;
+    AP_Scheduler_Test::loop();
+    ASSERT_TRUE(wait_for([]() {
+        return worker_tasks.slow_running && AP_Scheduler_Test::tasks_done() == 1;
+    }));
+
+    const uint32_t quick_runs = worker_tasks.quick_runs;
+    const uint16_t loops = 50;
+    for (uint16_t n=1; n<=loops; n++) {
+        AP_Scheduler_Test::loop();
+        ASSERT_TRUE(wait_for([]() { return AP_Scheduler_Test::tasks_done() == 1; })) << "loop " << n;
+        EXPECT_EQ(worker_tasks.quick_runs.load(), quick_runs + n);
+    }
+
+    // the held task is not dispatched again while it runs
+    EXPECT_EQ(worker_tasks.slow_starts.load(), slow_starts + 1);
+    EXPECT_TRUE(worker_tasks.slow_running);
+
+    // once it finishes it is accounted for and runs again
+    worker_tasks.slow_hold = false;
+    ASSERT_TRUE(wait_for([]() { return AP_Scheduler_Test::tasks_done() == 2; }));
+    AP_Scheduler_Test::loop();
+    ASSERT_TRUE(wait_for([&]() { return worker_tasks.slow_starts == slow_starts + 2; }));
+    EXPECT_EQ(worker_tasks.quick_overlaps.load(), 0U);
+}
+
+#endif // AP_SCHEDULER_WORKERS_ENABLED
+
+AP_GTEST_MAIN()
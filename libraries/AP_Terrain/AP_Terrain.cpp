@@ -58,7 +58,7 @@ const AP_Param::GroupInfo AP_Terrain::var_info[] = {
     // @Param: OPTIONS
     // @DisplayName: Terrain options
     // @Description: Options to change behaviour of terrain system
-    // @Bitmask: 0:Disable Download,1:Disable Disk
+    // @Bitmask: 0:Disable Download,1:Disable Disk,2:Disable Prefetch,3:Memory map terrain files
     // @User: Advanced
     AP_GROUPINFO("OPTIONS",   2, AP_Terrain, options, 0),
 
@@ -80,8 +80,8 @@ const AP_Param::GroupInfo AP_Terrain::var_info[] = {
 
     // @Param: CACHE_SZ
     // @DisplayName: Terrain cache size
-    // @Description: The number of 32x28 cache blocks to keep in memory. Each block uses about 1800 bytes of memory
-    // @Range: 0 128
+    // @Description: The number of 32x28 cache blocks to keep in memory. Each block uses about 1800 bytes of memory. A larger cache lets more of the terrain ahead of the vehicle be read from the SD card before it is needed
+    // @Range: 1 512
     // @User: Advanced
     AP_GROUPINFO("CACHE_SZ",  5, AP_Terrain, config_cache_size, TERRAIN_GRID_BLOCK_CACHE_SIZE),
 
@@ -393,6 +393,7 @@ void AP_Terrain::update(void)
     // update tiles surrounding our current location:
     if (pos_valid) {
         have_surrounding_tiles = update_surrounding_tiles(loc);
+        update_prefetch(loc);
     } else {
         have_surrounding_tiles = false;
     }
@@ -485,6 +486,30 @@ void AP_Terrain::log_terrain_data()
         reference_offset : have_reference_offset?reference_offset:0,
     };
     AP::logger().WriteBlock(&pkt, sizeof(pkt));
+
+// @LoggerMessage: TERC
+// @Description: Terrain cache statistics
+// @Field: TimeUS: Time since system startup
+// @Field: Size: number of grid blocks in the cache
+// @Field: Hit: lookups answered from the cache
+// @Field: Miss: lookups of blocks not yet in memory
+// @Field: Pf: blocks queued for reading by the prefetcher
+// @Field: PfHit: prefetched blocks later used
+// @Field: Rd: completed disk reads
+// @Field: RdLat: average time from a block being needed to it being read from disk
+// @Field: RdLatM: maximum time from a block being needed to it being read from disk
+    AP::logger().WriteStreaming("TERC", "TimeUS,Size,Hit,Miss,Pf,PfHit,Rd,RdLat,RdLatM",
+                                "s------ss", "F------CC",
+                                "QHIIIIIII",
+                                AP_HAL::micros64(),
+                                cache_size,
+                                cache_stats.hits,
+                                cache_stats.misses,
+                                cache_stats.prefetches,
+                                cache_stats.prefetch_hits,
+                                cache_stats.disk_reads,
+                                cache_stats.disk_reads?cache_stats.read_latency_total_ms/cache_stats.disk_reads:0U,
+                                cache_stats.read_latency_max_ms);
 }
 #endif
 
@@ -500,13 +525,25 @@ bool AP_Terrain::allocate(void)
     if (cache != nullptr) {
         return true;
     }
-    cache = (struct grid_cache *)calloc(config_cache_size, sizeof(cache[0]));
-    if (cache == nullptr) {
+    const uint16_t size = constrain_int16(config_cache_size, 1, 512);
+    // hash buckets are a power of two, with at least one per block
+    uint16_t hash_size = 1;
+    while (hash_size < size) {
+        hash_size <<= 1;
+    }
+    cache = (struct grid_cache *)calloc(size, sizeof(cache[0]));
+    cache_hash = (uint16_t *)calloc(hash_size, sizeof(cache_hash[0]));
+    if (cache == nullptr || cache_hash == nullptr) {
+        free(cache);
+        free(cache_hash);
+        cache = nullptr;
+        cache_hash = nullptr;
         GCS_SEND_TEXT(MAV_SEVERITY_CRITICAL, "Terrain: Allocation failed");
         memory_alloc_failed = true;
         return false;
     }
-    cache_size = config_cache_size;
+    cache_hash_mask = hash_size - 1;
+    cache_size = size;
     return true;
 }
 
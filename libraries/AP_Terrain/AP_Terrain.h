@@ -23,6 +23,7 @@
 #include <AP_Param/AP_Param.h>
 #include <GCS_MAVLink/GCS_MAVLink.h>
 #include <AP_Logger/AP_Logger_config.h>
+#include "AP_Terrain_MMap.h"
 
 #define TERRAIN_DEBUG 0
 
@@ -45,11 +46,19 @@
 #define TERRAIN_GRID_BLOCK_SIZE_X (TERRAIN_GRID_MAVLINK_SIZE*TERRAIN_GRID_BLOCK_MUL_X)
 #define TERRAIN_GRID_BLOCK_SIZE_Y (TERRAIN_GRID_MAVLINK_SIZE*TERRAIN_GRID_BLOCK_MUL_Y)
 
-// number of grid_blocks in the LRU memory cache
+// default number of grid_blocks in the LRU memory cache. TERR_CACHE_SZ
+// can be raised on boards with RAM to spare so more of the flight path
+// can be read ahead of the vehicle
 #ifndef TERRAIN_GRID_BLOCK_CACHE_SIZE
 #define TERRAIN_GRID_BLOCK_CACHE_SIZE 12
 #endif
 
+// how far ahead of the vehicle to read grid blocks from disk, in
+// seconds of flight at the current groundspeed
+#ifndef TERRAIN_PREFETCH_TIME_S
+#define TERRAIN_PREFETCH_TIME_S 60
+#endif
+
 // format of grid on disk
 #define TERRAIN_GRID_FORMAT_VERSION 1
 
@@ -76,6 +85,8 @@
  */
 
 class AP_Terrain {
+    friend class AP_Terrain_Bench;
+
 public:
     AP_Terrain();
 
@@ -267,6 +278,15 @@ private:
 
         // the last time access was requested to this block, used for LRU
         uint32_t last_access_ms;
+
+        // time the block started waiting for a disk read
+        uint32_t diskwait_ms;
+
+        // next entry in the same hash bucket, as cache index plus one
+        uint16_t hash_next;
+
+        // true if loaded by the prefetcher and not yet used
+        bool prefetched;
     };
 
     /*
@@ -306,6 +326,25 @@ private:
     */
     struct grid_cache &find_grid_cache(const struct grid_info &info);
 
+    /*
+      hashed lookup of the cache, returning nullptr if not present
+     */
+    struct grid_cache *lookup_grid_cache(const struct grid_info &info);
+
+    /*
+      take over the least recently used block for a new grid. If
+      min_age_ms is non-zero then only blocks that are valid and have
+      not been used for that long are taken
+     */
+    struct grid_cache *claim_grid_cache(const struct grid_info &info, uint32_t min_age_ms);
+
+    /*
+      maintain the hash index of the cache
+     */
+    uint16_t hash_bucket(int8_t lat_degrees, int16_t lon_degrees, uint16_t grid_idx_x, uint16_t grid_idx_y) const;
+    void hash_insert(uint16_t idx);
+    void hash_remove(uint16_t idx);
+
     /*
       calculate bit number in grid_block bitmap. This corresponds to a
       bit representing a 4x4 mavlink transmitted block
@@ -346,13 +385,37 @@ private:
     void io_timer(void);
     void open_file(void);
     void seek_offset(void);
-    uint32_t east_blocks(struct grid_block &block) const;
+    uint32_t east_blocks(const struct grid_block &block) const;
+    uint32_t block_file_offset(const struct grid_block &block) const;
+    bool check_block(struct grid_block &block, int32_t lat, int32_t lon);
     void write_block(void);
     void read_block(void);
 
+#if AP_TERRAIN_MMAP_ENABLED
+    /*
+      fill a newly claimed cache block from a degree file that is
+      already mapped, in the main thread
+     */
+    bool load_mapped_block(uint16_t idx);
+    /*
+      read disk_block from the memory-mapped degree file, in the IO
+      thread, opening or remapping the file as needed
+     */
+    bool read_mapped_block(void);
+    AP_Terrain_MMap *mapped_files;
+#endif
+
     // check for missing data in squares surrounding loc:
     bool update_surrounding_tiles(const Location &loc);
 
+    /*
+      queue disk reads for the blocks the vehicle will reach next,
+      along its velocity vector and the mission legs ahead
+     */
+    void update_prefetch(const Location &loc);
+    bool prefetch_leg(const Location &from, const Location &to, float &distance_left);
+    bool prefetch_location(const Location &loc);
+
     /*
       check for missing mission terrain data
      */
@@ -380,6 +443,8 @@ private:
     enum class Options {
         DisableDownload = (1U<<0),
         DisableDisk = (1U<<1),
+        DisablePrefetch = (1U<<2),
+        MemoryMapFiles = (1U<<3),
     };
 
     inline bool diskless() const {
@@ -387,9 +452,29 @@ private:
     }
 
     // cache of grids in memory, LRU
-    uint8_t cache_size = 0;
+    uint16_t cache_size = 0;
     struct grid_cache *cache = nullptr;
 
+    // hash buckets over the cache, each the cache index plus one of
+    // the first entry in the bucket. Only blocks that are in use
+    // (state not GRID_CACHE_INVALID) are in the index
+    uint16_t *cache_hash = nullptr;
+    uint16_t cache_hash_mask;
+
+    // number of prefetched blocks queued for the current update
+    uint8_t prefetch_queued;
+
+    // cache statistics, logged in TERC messages
+    struct {
+        uint32_t hits;
+        uint32_t misses;
+        uint32_t prefetches;
+        uint32_t prefetch_hits;
+        uint32_t disk_reads;
+        uint32_t read_latency_total_ms;
+        uint32_t read_latency_max_ms;
+    } cache_stats;
+
     // a grid_cache block waiting for disk IO
     enum DiskIoState {
         DiskIoIdle      = 0,
@@ -0,0 +1,222 @@
+/*
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "AP_Terrain_MMap.h"
+
+#if AP_TERRAIN_MMAP_ENABLED
+
+#include <AP_Filesystem/AP_Filesystem.h>
+#include <AP_HAL/AP_HAL.h>
+#include <AP_Math/AP_Math.h>
+#include <stdlib.h>
+#include <sys/mman.h>
+
+extern const AP_HAL::HAL& hal;
+
+bool AP_Terrain_MMap::read_block(int8_t lat_degrees, int16_t lon_degrees, uint32_t ofs, uint32_t len, void *buf)
+{
+    WITH_SEMAPHORE(sem);
+    mapped_file *f = find_file(lat_degrees, lon_degrees);
+    if (f == nullptr) {
+        return false;
+    }
+    f->last_use = ++use_counter;
+    if (uint64_t(ofs) + len > f->size) {
+        // the IO thread may have extended the file since we mapped it
+        if (!remap(*f) || uint64_t(ofs) + len > f->size) {
+            return false;
+        }
+    }
+    memcpy(buf, &f->base[ofs], len);
+    return true;
+}
+
+bool AP_Terrain_MMap::read_block_nonblocking(int8_t lat_degrees, int16_t lon_degrees, uint32_t ofs, uint32_t len, void *buf)
+{
+    if (!sem.take_nonblocking()) {
+        // the IO thread is changing the mappings
+        return false;
+    }
+    mapped_file *f = find_mapped(lat_degrees, lon_degrees);
+    const bool ret = f != nullptr && uint64_t(ofs) + len <= f->size;
+    if (ret) {
+        f->last_use = ++use_counter;
+        memcpy(buf, &f->base[ofs], len);
+    }
+    sem.give();
+    return ret;
+}
+
+/*
+  find the open mapping for a degree square
+ */
+AP_Terrain_MMap::mapped_file *AP_Terrain_MMap::find_mapped(int8_t lat_degrees, int16_t lon_degrees)
+{
+    for (auto &f : files) {
+        if (f.fd != -1 && f.lat_degrees == lat_degrees && f.lon_degrees == lon_degrees) {
+            return &f;
+        }
+    }
+    return nullptr;
+}
+
+/*
+  find the mapping for a degree square, opening the file in place of
+  the least recently used one if needed. The old mapping is only
+  replaced once the new file has been opened
+ */
+AP_Terrain_MMap::mapped_file *AP_Terrain_MMap::find_file(int8_t lat_degrees, int16_t lon_degrees)
+{
+    mapped_file *f = find_mapped(lat_degrees, lon_degrees);
+    if (f != nullptr) {
+        return f;
+    }
+    if (is_missing(lat_degrees, lon_degrees)) {
+        return nullptr;
+    }
+    mapped_file newf;
+    if (!open_file(newf, lat_degrees, lon_degrees)) {
+        set_missing(lat_degrees, lon_degrees);
+        return nullptr;
+    }
+    mapped_file *oldest = &files[0];
+    for (auto &of : files) {
+        if (of.fd == -1) {
+            oldest = &of;
+            break;
+        }
+        if (of.last_use < oldest->last_use) {
+            oldest = &of;
+        }
+    }
+    close_file(*oldest);
+    *oldest = newf;
+    return oldest;
+}
+
+/*
+  return true if a degree file was recently found not to exist
+ */
+bool AP_Terrain_MMap::is_missing(int8_t lat_degrees, int16_t lon_degrees) const
+{
+    const uint32_t now_ms = AP_HAL::millis();
+    for (const auto &m : missing) {
+        if (m.valid &&
+            m.lat_degrees == lat_degrees &&
+            m.lon_degrees == lon_degrees &&
+            now_ms - m.checked_ms < missing_retry_ms) {
+            return true;
+        }
+    }
+    return false;
+}
+
+void AP_Terrain_MMap::set_missing(int8_t lat_degrees, int16_t lon_degrees)
+{
+    missing_file &m = missing[missing_next];
+    missing_next = (missing_next + 1) % max_missing;
+    m.valid = true;
+    m.lat_degrees = lat_degrees;
+    m.lon_degrees = lon_degrees;
+    m.checked_ms = AP_HAL::millis();
+}
+
+void AP_Terrain_MMap::file_written(int8_t lat_degrees, int16_t lon_degrees)
+{
+    WITH_SEMAPHORE(sem);
+    for (auto &m : missing) {
+        if (m.lat_degrees == lat_degrees && m.lon_degrees == lon_degrees) {
+            m.valid = false;
+        }
+    }
+}
+
+bool AP_Terrain_MMap::open_file(mapped_file &f, int8_t lat_degrees, int16_t lon_degrees)
+{
+    char path[128];
+    const int n = hal.util->snprintf(path, sizeof(path), "%s/%c%02u%c%03u.DAT",
+                                     directory,
+                                     lat_degrees<0?'S':'N',
+                                     (unsigned)MIN(abs((int32_t)lat_degrees), 99),
+                                     lon_degrees<0?'W':'E',
+                                     (unsigned)MIN(abs((int32_t)lon_degrees), 999));
+    if (n <= 0 || size_t(n) >= sizeof(path)) {
+        return false;
+    }
+    // the file is created by the IO thread when it first writes a block
+    f.fd = AP::FS().open(path, O_RDONLY);
+    if (f.fd == -1) {
+        return false;
+    }
+    f.lat_degrees = lat_degrees;
+    f.lon_degrees = lon_degrees;
+    f.base = nullptr;
+    f.size = 0;
+    remap(f);
+    return true;
+}
+
+/*
+  map the whole file again if it has grown
+ */
+bool AP_Terrain_MMap::remap(mapped_file &f)
+{
+    // a degree file is a few MB at most, well within lseek's range
+    const int32_t size = AP::FS().lseek(f.fd, 0, SEEK_END);
+    if (size <= 0 || size_t(size) <= f.size) {
+        return false;
+    }
+    if (f.base != nullptr) {
+        AP::FS().unmap(f.fd, f.base, f.size);
+        f.base = nullptr;
+        f.size = 0;
+    }
+    const void *p = AP::FS().map(f.fd, size);
+    if (p == nullptr) {
+        return false;
+    }
+    // have the kernel read the whole file in the background so
+    // lookups rarely wait on a page fault
+    madvise(const_cast<void *>(p), size, MADV_WILLNEED);
+    f.base = (const uint8_t *)p;
+    f.size = size;
+    return true;
+}
+
+void AP_Terrain_MMap::close_file(mapped_file &f)
+{
+    if (f.fd == -1) {
+        return;
+    }
+    // the mapping goes through the file's backend, so must be
+    // removed before the file is closed
+    if (f.base != nullptr) {
+        AP::FS().unmap(f.fd, f.base, f.size);
+        f.base = nullptr;
+        f.size = 0;
+    }
+    AP::FS().close(f.fd);
+    f.fd = -1;
+}
+
+void AP_Terrain_MMap::close_all()
+{
+    WITH_SEMAPHORE(sem);
+    for (auto &f : files) {
+        close_file(f);
+    }
+}
+
+#endif // AP_TERRAIN_MMAP_ENABLED
@@ -0,0 +1,104 @@
+/*
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+/*
+  read-only memory mappings of the per-degree terrain files.
+
+  Blocks are copied straight from the page cache. The IO thread opens,
+  maps and remaps the files through AP_Filesystem. The main thread
+  only copies from files that are already mapped, and never waits for
+  the IO thread to do so. The mappings are shared, so blocks the IO
+  thread writes are seen without remapping unless the file grows
+ */
+#pragma once
+
+#include "AP_Terrain_config.h"
+
+#if AP_TERRAIN_MMAP_ENABLED
+
+#include <AP_Common/AP_Common.h>
+#include <AP_HAL/Semaphores.h>
+
+class AP_Terrain_MMap
+{
+public:
+    AP_Terrain_MMap(const char *_directory) :
+        directory(_directory) {}
+    ~AP_Terrain_MMap() { close_all(); }
+
+    CLASS_NO_COPY(AP_Terrain_MMap);
+
+    // copy len bytes at offset ofs of the file for a degree square
+    // into buf, opening or remapping the file if needed. Returns
+    // false if the file does not exist, is too short or can't be
+    // mapped. For the IO thread
+    bool read_block(int8_t lat_degrees, int16_t lon_degrees, uint32_t ofs, uint32_t len, void *buf);
+
+    // as read_block(), but only from a file that is already mapped
+    // and long enough, and without waiting if the IO thread holds the
+    // mappings. Safe to call from the main thread
+    bool read_block_nonblocking(int8_t lat_degrees, int16_t lon_degrees, uint32_t ofs, uint32_t len, void *buf);
+
+    // the IO thread has written to the file for a degree square, so
+    // it may exist now even if an earlier open failed
+    void file_written(int8_t lat_degrees, int16_t lon_degrees);
+
+    // unmap all files
+    void close_all();
+
+private:
+    struct mapped_file {
+        const uint8_t *base;
+        size_t size;
+        int fd = -1;
+        int8_t lat_degrees;
+        int16_t lon_degrees;
+        uint32_t last_use;
+    };
+
+    // a vehicle rarely needs more than the four degree squares
+    // around a corner
+    static const uint8_t max_files = 4;
+    mapped_file files[max_files];
+    uint32_t use_counter;
+
+    // degree files recently found not to exist, so each read of a
+    // block the GCS hasn't sent yet doesn't try to open the file again
+    struct missing_file {
+        bool valid = false;
+        int8_t lat_degrees;
+        int16_t lon_degrees;
+        uint32_t checked_ms;
+    };
+    static const uint8_t max_missing = 4;
+    static const uint32_t missing_retry_ms = 5000;
+    missing_file missing[max_missing];
+    uint8_t missing_next = 0;
+
+    // protects files[]. Held by the IO thread while it maps or
+    // unmaps, and by both threads while copying a block
+    HAL_Semaphore sem;
+
+    const char *directory;
+
+    mapped_file *find_mapped(int8_t lat_degrees, int16_t lon_degrees);
+    mapped_file *find_file(int8_t lat_degrees, int16_t lon_degrees);
+    bool open_file(mapped_file &f, int8_t lat_degrees, int16_t lon_degrees);
+    bool is_missing(int8_t lat_degrees, int16_t lon_degrees) const;
+    void set_missing(int8_t lat_degrees, int16_t lon_degrees);
+    bool remap(mapped_file &f);
+    void close_file(mapped_file &f);
+};
+
+#endif // AP_TERRAIN_MMAP_ENABLED
@@ -29,17 +29,28 @@
 extern const AP_HAL::HAL& hal;
 
 /*
-  check for blocks that need to be read from disk
+  check for blocks that need to be read from disk. Blocks the vehicle
+  has asked for are read before prefetched ones
  */
 void AP_Terrain::check_disk_read(void)
 {
+    int16_t read_idx = -1;
     for (uint16_t i=0; i<cache_size; i++) {
-        if (cache[i].state == GRID_CACHE_DISKWAIT) {
-            disk_block.block = cache[i].grid;
-            disk_io_state = DiskIoWaitRead;
-            return;
+        if (cache[i].state != GRID_CACHE_DISKWAIT) {
+            continue;
         }
-    }    
+        if (!cache[i].prefetched) {
+            read_idx = i;
+            break;
+        }
+        if (read_idx == -1) {
+            read_idx = i;
+        }
+    }
+    if (read_idx != -1) {
+        disk_block.block = cache[read_idx].grid;
+        disk_io_state = DiskIoWaitRead;
+    }
 }
 
 /*
@@ -72,24 +83,25 @@ void AP_Terrain::schedule_disk_io(void)
 
     switch (disk_io_state) {
     case DiskIoIdle:
-        // look for a block that needs reading or writing
-        check_disk_read();
-        if (disk_io_state == DiskIoIdle) {
-            // still idle, check for writes
-            check_disk_write();            
-        }
         break;
-        
+
     case DiskIoDoneRead: {
         // a read has completed
         int16_t cache_idx = find_io_idx(GRID_CACHE_DISKWAIT);
         if (cache_idx != -1) {
+            struct grid_cache &gcache = cache[cache_idx];
             if (disk_block.block.bitmap != 0) {
                 // when bitmap is zero we read an empty block
-                cache[cache_idx].grid = disk_block.block;
+                hash_remove(cache_idx);
+                gcache.grid = disk_block.block;
+                hash_insert(cache_idx);
             }
-            cache[cache_idx].state = GRID_CACHE_VALID;
-            cache[cache_idx].last_access_ms = AP_HAL::millis();
+            gcache.state = GRID_CACHE_VALID;
+            gcache.last_access_ms = AP_HAL::millis();
+            const uint32_t latency_ms = gcache.last_access_ms - gcache.diskwait_ms;
+            cache_stats.disk_reads++;
+            cache_stats.read_latency_total_ms += latency_ms;
+            cache_stats.read_latency_max_ms = MAX(cache_stats.read_latency_max_ms, latency_ms);
         }
         disk_io_state = DiskIoIdle;
         break;
@@ -113,8 +125,62 @@ void AP_Terrain::schedule_disk_io(void)
         // waiting for io_timer()
         break;
     }
+
+#if AP_TERRAIN_MMAP_ENABLED
+    if (disk_io_state == DiskIoIdle &&
+        mapped_files == nullptr &&
+        (options.get() & uint16_t(Options::MemoryMapFiles)) != 0) {
+        // created while the IO thread is idle, so it never sees the
+        // pointer change
+        const char* terrain_dir = hal.util->get_custom_terrain_directory();
+        if (terrain_dir == nullptr) {
+            terrain_dir = HAL_BOARD_TERRAIN_DIRECTORY;
+        }
+        mapped_files = NEW_NOTHROW AP_Terrain_MMap(terrain_dir);
+    }
+#endif
+
+    if (disk_io_state == DiskIoIdle) {
+        // look for a block that needs reading or writing, straight
+        // after a completed IO so the IO thread is kept busy
+        check_disk_read();
+        if (disk_io_state == DiskIoIdle) {
+            // still idle, check for writes
+            check_disk_write();            
+        }
+    }
 }
 
+#if AP_TERRAIN_MMAP_ENABLED
+/*
+  fill a newly claimed cache block straight from the memory-mapped
+  degree file, so height_amsl() and the prefetcher don't wait for the
+  IO thread. This runs in the main thread and only copies from a file
+  the IO thread has already mapped, without waiting if the IO thread
+  is changing the mappings. Returns false if the block couldn't be
+  copied or doesn't hold valid data, leaving it to the IO thread,
+  which also handles a block the GCS is still writing
+ */
+bool AP_Terrain::load_mapped_block(uint16_t idx)
+{
+    if ((options.get() & uint16_t(Options::MemoryMapFiles)) == 0 || mapped_files == nullptr) {
+        return false;
+    }
+    struct grid_cache &gcache = cache[idx];
+    union grid_io_block io_block;
+    if (!mapped_files->read_block_nonblocking(gcache.grid.lat_degrees, gcache.grid.lon_degrees,
+                                              block_file_offset(gcache.grid), sizeof(io_block), &io_block) ||
+        !check_block(io_block.block, gcache.grid.lat, gcache.grid.lon)) {
+        return false;
+    }
+    hash_remove(idx);
+    gcache.grid = io_block.block;
+    hash_insert(idx);
+    gcache.state = GRID_CACHE_VALID;
+    cache_stats.disk_reads++;
+    return true;
+}
+#endif // AP_TERRAIN_MMAP_ENABLED
 
 /********************************************************
 All the functions below this point run in the IO timer context, which
@@ -126,7 +192,9 @@ The IO timer context owns the data when disk_io_state is
 DiskIoWaitWrite or DiskIoWaitRead. The main thread owns the data when
 disk_io_state is DiskIoIdle, DiskIoDoneWrite or DiskIoDoneRead
 
-All file operations are done by the IO thread.
+All file operations are done by the IO thread. With memory-mapped
+files the main thread may also copy a block from a file the IO thread
+has already mapped, see load_mapped_block()
 *********************************************************/
 
 
@@ -220,7 +288,7 @@ void AP_Terrain::open_file(void)
 /*
   work out how many blocks needed in a stride for a given location
  */
-uint32_t AP_Terrain::east_blocks(struct grid_block &block) const
+uint32_t AP_Terrain::east_blocks(const struct grid_block &block) const
 {
     Location loc1, loc2;
     loc1.lat = block.lat_degrees*10*1000*1000L;
@@ -235,14 +303,21 @@ uint32_t AP_Terrain::east_blocks(struct grid_block &block) const
 }
 
 /*
-  seek to the right offset for disk_block
+  offset of a block within its degree file
  */
-void AP_Terrain::seek_offset(void)
+uint32_t AP_Terrain::block_file_offset(const struct grid_block &block) const
 {
-    struct grid_block &block = disk_block.block;
     // work out how many longitude blocks there are at this latitude
     uint32_t blocknum = east_blocks(block) * block.grid_idx_x + block.grid_idx_y;
-    uint32_t file_offset = blocknum * sizeof(union grid_io_block);
+    return blocknum * sizeof(union grid_io_block);
+}
+
+/*
+  seek to the right offset for disk_block
+ */
+void AP_Terrain::seek_offset(void)
+{
+    const uint32_t file_offset = block_file_offset(disk_block.block);
     if (AP::FS().lseek(fd, file_offset, SEEK_SET) != (off_t)file_offset) {
 #if TERRAIN_DEBUG
         hal.console->printf("Seek %lu failed - %s\n",
@@ -276,6 +351,11 @@ void AP_Terrain::write_block(void)
         io_failure = true;
     } else {
         AP::FS().fsync(fd);
+#if AP_TERRAIN_MMAP_ENABLED
+        if (mapped_files != nullptr) {
+            mapped_files->file_written(disk_block.block.lat_degrees, disk_block.block.lon_degrees);
+        }
+#endif
 #if TERRAIN_DEBUG
         printf("wrote block at %ld %ld ret=%d mask=%07llx\n",
                (long)disk_block.block.lat,
@@ -287,6 +367,20 @@ void AP_Terrain::write_block(void)
     disk_io_state = DiskIoDoneWrite;
 }
 
+/*
+  check that a block read from disk is the one at lat/lon and holds
+  valid data for the current grid spacing
+ */
+bool AP_Terrain::check_block(struct grid_block &block, int32_t lat, int32_t lon)
+{
+    return TERRAIN_LATLON_EQUAL(block.lat,lat) &&
+        TERRAIN_LATLON_EQUAL(block.lon,lon) &&
+        block.bitmap != 0 &&
+        block.spacing == grid_spacing &&
+        block.version == TERRAIN_GRID_FORMAT_VERSION &&
+        block.crc == get_block_crc(block);
+}
+
 /*
   read in disk_block
  */
@@ -301,12 +395,7 @@ void AP_Terrain::read_block(void)
 
     ssize_t ret = AP::FS().read(fd, &disk_block, sizeof(disk_block));
     if (ret != sizeof(disk_block) || 
-        !TERRAIN_LATLON_EQUAL(disk_block.block.lat,lat) ||
-        !TERRAIN_LATLON_EQUAL(disk_block.block.lon,lon) ||
-        disk_block.block.bitmap == 0 ||
-        disk_block.block.spacing != grid_spacing ||
-        disk_block.block.version != TERRAIN_GRID_FORMAT_VERSION ||
-        disk_block.block.crc != get_block_crc(disk_block.block)) {
+        !check_block(disk_block.block, lat, lon)) {
 #if TERRAIN_DEBUG
         printf("read empty block at %ld %ld ret=%d (%ld %ld %u 0x%08lx) 0x%04x:0x%04x\n",
                (long)lat,
@@ -337,6 +426,38 @@ void AP_Terrain::read_block(void)
     disk_io_state = DiskIoDoneRead;
 }
 
+#if AP_TERRAIN_MMAP_ENABLED
+/*
+  read in disk_block from the memory-mapped degree file, saving a
+  seek and read per block. This is the IO thread's fallback for blocks
+  load_mapped_block() couldn't fill, and opens or remaps the file as
+  needed. Bad data is treated as read_block() treats it. Returns false
+  if the file doesn't exist yet, is too short or can't be mapped,
+  leaving the block to read_block()
+ */
+bool AP_Terrain::read_mapped_block(void)
+{
+    if ((options.get() & uint16_t(Options::MemoryMapFiles)) == 0 || mapped_files == nullptr) {
+        return false;
+    }
+    const struct grid_block &block = disk_block.block;
+    const int32_t lat = block.lat;
+    const int32_t lon = block.lon;
+    if (!mapped_files->read_block(block.lat_degrees, block.lon_degrees,
+                                  block_file_offset(block), sizeof(disk_block), &disk_block)) {
+        return false;
+    }
+    if (!check_block(disk_block.block, lat, lon)) {
+        memset(&disk_block, 0, sizeof(disk_block));
+        disk_block.block.lat = lat;
+        disk_block.block.lon = lon;
+        disk_block.block.bitmap = 0;
+    }
+    disk_io_state = DiskIoDoneRead;
+    return true;
+}
+#endif // AP_TERRAIN_MMAP_ENABLED
+
 /*
   timer called to do disk IO
  */
@@ -372,6 +493,11 @@ void AP_Terrain::io_timer(void)
 
     case DiskIoWaitRead:
         // need to read in the block
+#if AP_TERRAIN_MMAP_ENABLED
+        if (read_mapped_block()) {
+            break;
+        }
+#endif
         open_file();
         if (fd == -1) {
             return;
@@ -26,6 +26,7 @@
 #include <AP_Mission/AP_Mission.h>
 #include <AP_Rally/AP_Rally.h>
 #include <AP_GPS/AP_GPS.h>
+#include <AP_AHRS/AP_AHRS.h>
 
 extern const AP_HAL::HAL& hal;
 
@@ -114,6 +115,128 @@ void AP_Terrain::update_mission_data(void)
 #endif  // AP_MISSION_ENABLED
 }
 
+/*
+  queue disk reads for the grid blocks ahead of the vehicle. When
+  flying a mission the legs to the next waypoints are followed,
+  otherwise the current groundspeed vector
+ */
+void AP_Terrain::update_prefetch(const Location &loc)
+{
+    if (diskless() ||
+        (options.get() & uint16_t(Options::DisablePrefetch)) != 0 ||
+        grid_spacing <= 0 ||
+        !allocate()) {
+        return;
+    }
+
+    // don't queue more reads while earlier ones are outstanding
+    prefetch_queued = 0;
+    for (uint16_t i=0; i<cache_size; i++) {
+        if (cache[i].state == GRID_CACHE_DISKWAIT && cache[i].prefetched) {
+            prefetch_queued++;
+        }
+    }
+
+    // look TERRAIN_PREFETCH_TIME_S ahead, at least a block and at
+    // most 32 steps of half a block
+    const float step = MIN(TERRAIN_GRID_BLOCK_SPACING_X, TERRAIN_GRID_BLOCK_SPACING_Y) * grid_spacing * 0.5f;
+    const Vector2f &vel = AP::ahrs().groundspeed_vector();
+    const float speed = vel.length();
+    float distance_left = constrain_float(speed * TERRAIN_PREFETCH_TIME_S, 2 * step, 32 * step);
+
+#if AP_MISSION_ENABLED
+    AP_Mission *mission = AP::mission();
+    if (mission != nullptr && mission->state() == AP_Mission::MISSION_RUNNING) {
+        // follow up to three legs from the current location
+        Location from = loc;
+        AP_Mission::Mission_Command cmd = mission->get_current_nav_cmd();
+        bool have_leg = false;
+        for (uint8_t leg=0; leg<3 && distance_left > 0; leg++) {
+            const Location &to = cmd.content.location;
+            if (to.lat == 0 && to.lng == 0) {
+                break;
+            }
+            have_leg = true;
+            if (!prefetch_leg(from, to, distance_left)) {
+                return;
+            }
+            from = to;
+            if (!mission->get_next_nav_cmd(cmd.index+1, cmd)) {
+                break;
+            }
+        }
+        if (have_leg) {
+            return;
+        }
+    }
+#endif  // AP_MISSION_ENABLED
+
+    if (speed < 1) {
+        // not going anywhere, update_surrounding_tiles() covers us
+        return;
+    }
+    Location ahead = loc;
+    ahead.offset(vel.x * distance_left / speed, vel.y * distance_left / speed);
+    prefetch_leg(loc, ahead, distance_left);
+}
+
+/*
+  prefetch the blocks along a leg, using up distance_left. Returns
+  false if no more blocks can be queued
+ */
+bool AP_Terrain::prefetch_leg(const Location &from, const Location &to, float &distance_left)
+{
+    const float step = MIN(TERRAIN_GRID_BLOCK_SPACING_X, TERRAIN_GRID_BLOCK_SPACING_Y) * grid_spacing * 0.5f;
+    const float leg_length = from.get_distance(to);
+    const float bearing = degrees(from.get_bearing(to));
+    float d = 0;
+    while (distance_left > 0) {
+        d = MIN(d + step, leg_length);
+        distance_left -= step;
+        Location loc = from;
+        loc.offset_bearing(bearing, d);
+        if (!prefetch_location(loc)) {
+            return false;
+        }
+        if (d >= leg_length) {
+            break;
+        }
+    }
+    return true;
+}
+
+/*
+  make sure the block holding loc is in the cache or queued for
+  reading, without evicting blocks that are in use
+ */
+bool AP_Terrain::prefetch_location(const Location &loc)
+{
+    struct grid_info info;
+    calculate_grid_info(loc, info);
+
+    struct grid_cache *grid = lookup_grid_cache(info);
+    if (grid != nullptr) {
+        // keep blocks on the path in the cache
+        grid->last_access_ms = AP_HAL::millis();
+        return true;
+    }
+    if (prefetch_queued >= MAX(cache_size/4, 1)) {
+        return false;
+    }
+    // only replace blocks not used for 10 seconds
+    grid = claim_grid_cache(info, 10000);
+    if (grid == nullptr) {
+        return false;
+    }
+    grid->prefetched = true;
+    if (grid->state == GRID_CACHE_DISKWAIT) {
+        // not already filled from a mapped file
+        prefetch_queued++;
+    }
+    cache_stats.prefetches++;
+    return true;
+}
+
 #if HAL_RALLY_ENABLED
 /*
   check that we have fetched all rally terrain data
@@ -102,29 +102,92 @@ void AP_Terrain::calculate_grid_info(const Location &loc, struct grid_info &info
 
 
 /*
-  find a grid structure given a grid_info
+  hash bucket for a grid block, from the indices which uniquely
+  identify it for a grid spacing
  */
-AP_Terrain::grid_cache &AP_Terrain::find_grid_cache(const struct grid_info &info)
+uint16_t AP_Terrain::hash_bucket(int8_t lat_degrees, int16_t lon_degrees, uint16_t grid_idx_x, uint16_t grid_idx_y) const
+{
+    uint32_t h = grid_idx_x * 73856093U;
+    h ^= grid_idx_y * 19349663U;
+    h ^= uint32_t(lat_degrees + 90) * 83492791U;
+    h ^= uint32_t(lon_degrees + 180) * 2654435761U;
+    h ^= h >> 16;
+    return h & cache_hash_mask;
+}
+
+/*
+  add a cache entry to the hash index
+ */
+void AP_Terrain::hash_insert(uint16_t idx)
+{
+    const struct grid_block &grid = cache[idx].grid;
+    const uint16_t b = hash_bucket(grid.lat_degrees, grid.lon_degrees, grid.grid_idx_x, grid.grid_idx_y);
+    cache[idx].hash_next = cache_hash[b];
+    cache_hash[b] = idx + 1;
+}
+
+/*
+  remove a cache entry from the hash index
+ */
+void AP_Terrain::hash_remove(uint16_t idx)
+{
+    const struct grid_block &grid = cache[idx].grid;
+    uint16_t *link = &cache_hash[hash_bucket(grid.lat_degrees, grid.lon_degrees, grid.grid_idx_x, grid.grid_idx_y)];
+    while (*link != 0) {
+        if (*link == idx + 1) {
+            *link = cache[idx].hash_next;
+            cache[idx].hash_next = 0;
+            return;
+        }
+        link = &cache[*link - 1].hash_next;
+    }
+}
+
+/*
+  find a grid in the cache given a grid_info
+ */
+AP_Terrain::grid_cache *AP_Terrain::lookup_grid_cache(const struct grid_info &info)
 {
-    uint16_t oldest_i = 0;
+    uint16_t i = cache_hash[hash_bucket(info.lat_degrees, info.lon_degrees, info.grid_idx_x, info.grid_idx_y)];
+    while (i != 0) {
+        struct grid_cache &gcache = cache[i-1];
+        if (TERRAIN_LATLON_EQUAL(gcache.grid.lat,info.grid_lat) &&
+            TERRAIN_LATLON_EQUAL(gcache.grid.lon,info.grid_lon) &&
+            gcache.grid.spacing == grid_spacing) {
+            return &gcache;
+        }
+        i = gcache.hash_next;
+    }
+    return nullptr;
+}
 
-    // see if we have that grid
+/*
+  take over the least recently used grid and make it the grid for
+  info, initially unpopulated
+ */
+AP_Terrain::grid_cache *AP_Terrain::claim_grid_cache(const struct grid_info &info, uint32_t min_age_ms)
+{
     const auto now_ms = AP_HAL::millis();
+    int16_t oldest_i = -1;
     for (uint16_t i=0; i<cache_size; i++) {
-        if (TERRAIN_LATLON_EQUAL(cache[i].grid.lat,info.grid_lat) &&
-            TERRAIN_LATLON_EQUAL(cache[i].grid.lon,info.grid_lon) &&
-            cache[i].grid.spacing == grid_spacing) {
-            cache[i].last_access_ms = now_ms;
-            return cache[i];
+        if (min_age_ms != 0 &&
+            (cache[i].state == GRID_CACHE_DISKWAIT ||
+             cache[i].state == GRID_CACHE_DIRTY ||
+             now_ms - cache[i].last_access_ms < min_age_ms)) {
+            continue;
         }
-        if (cache[i].last_access_ms < cache[oldest_i].last_access_ms) {
+        if (oldest_i == -1 || cache[i].last_access_ms < cache[oldest_i].last_access_ms) {
             oldest_i = i;
         }
     }
+    if (oldest_i == -1) {
+        return nullptr;
+    }
 
-    // Not found. Use the oldest grid and make it this grid,
-    // initially unpopulated
     struct grid_cache &grid = cache[oldest_i];
+    if (grid.state != GRID_CACHE_INVALID) {
+        hash_remove(oldest_i);
+    }
     memset(&grid, 0, sizeof(grid));
 
     grid.grid.lat = info.grid_lat;
@@ -136,11 +199,42 @@ AP_Terrain::grid_cache &AP_Terrain::find_grid_cache(const struct grid_info &info
     grid.grid.lon_degrees = info.lon_degrees;
     grid.grid.version = TERRAIN_GRID_FORMAT_VERSION;
     grid.last_access_ms = now_ms;
+    grid.diskwait_ms = now_ms;
 
     // mark as waiting for disk read
     grid.state = GRID_CACHE_DISKWAIT;
+    hash_insert(oldest_i);
 
-    return grid;
+#if AP_TERRAIN_MMAP_ENABLED
+    // with memory-mapped files the block can often be read straight away
+    load_mapped_block(oldest_i);
+#endif
+
+    return &grid;
+}
+
+/*
+  find a grid structure given a grid_info
+ */
+AP_Terrain::grid_cache &AP_Terrain::find_grid_cache(const struct grid_info &info)
+{
+    struct grid_cache *grid = lookup_grid_cache(info);
+    if (grid == nullptr) {
+        // Not found. Use the oldest grid and make it this grid
+        cache_stats.misses++;
+        return *claim_grid_cache(info, 0);
+    }
+    if (grid->state == GRID_CACHE_DISKWAIT) {
+        cache_stats.misses++;
+    } else {
+        cache_stats.hits++;
+        if (grid->prefetched) {
+            cache_stats.prefetch_hits++;
+        }
+    }
+    grid->prefetched = false;
+    grid->last_access_ms = AP_HAL::millis();
+    return *grid;
 }
 
 /*
@@ -0,0 +1,216 @@
+#include <AP_gbenchmark.h>
+
+#include <AP_Terrain/AP_Terrain.h>
+#include <AP_Terrain/AP_Terrain_MMap.h>
+#include <AP_Filesystem/AP_Filesystem.h>
+#include <AP_Math/AP_Math.h>
+
+#include <errno.h>
+
+const AP_HAL::HAL& hal = AP_HAL::get_HAL();
+
+/*
+  cost of a terrain cache miss, from find_grid_cache() not finding a
+  grid to the block holding valid data. With memory-mapped files the
+  main thread fills the block itself in load_mapped_block(). Without,
+  the IO thread seeks and reads the block and the main thread then
+  picks it up in schedule_disk_io().
+
+  Grids are taken in a random order from a degree file of 1000 valid
+  blocks at 100m grid spacing, and each block is dropped from the
+  cache once loaded, so every lookup is a miss. The file has just
+  been written, so is in the page cache for both; this measures the
+  work per block, not the disk
+ */
+#define BENCH_DIR "terrain_bench"
+#define GRID_SPACING 100
+#define CACHE_SIZE 16
+#define BLOCKS_NORTH 40
+#define BLOCKS_EAST 25
+#define NUM_BLOCKS (BLOCKS_NORTH * BLOCKS_EAST)
+
+class AP_Terrain_Bench
+{
+public:
+    // write the degree file and set the terrain up to read it, without
+    // the IO thread. Returns false if the file couldn't be written or
+    // mapped
+    bool setup(void)
+    {
+        terrain.enable.set(1);
+        terrain.grid_spacing.set(GRID_SPACING);
+        terrain.config_cache_size.set(CACHE_SIZE);
+        terrain.options.set(0);
+        if (!terrain.allocate()) {
+            return false;
+        }
+        // the benchmark does the IO thread's work itself
+        terrain.timer_setup = true;
+
+        if (AP::FS().mkdir(BENCH_DIR) != 0 && errno != EEXIST) {
+            return false;
+        }
+        terrain.directory_created = true;
+        if (asprintf(&terrain.file_path, "%s/NxxExxx.DAT", BENCH_DIR) <= 0) {
+            terrain.file_path = nullptr;
+            return false;
+        }
+        terrain.mapped_files = NEW_NOTHROW AP_Terrain_MMap(BENCH_DIR);
+        if (terrain.mapped_files == nullptr || !write_file()) {
+            return false;
+        }
+        for (uint16_t i=0; i<ARRAY_SIZE(order); i++) {
+            order[i] = random() % NUM_BLOCKS;
+        }
+
+        // load_mapped_block() only copies from a file the IO thread
+        // has already mapped
+        union AP_Terrain::grid_io_block io_block;
+        return terrain.mapped_files->read_block(45, 7, 0, sizeof(io_block), &io_block);
+    }
+
+    void use_mapped_files(bool enable)
+    {
+        terrain.options.set(enable ? uint16_t(AP_Terrain::Options::MemoryMapFiles) : 0);
+    }
+
+    // miss on grid n, filling the block from the mapping. Returns
+    // false unless the block is valid straight away
+    bool load_mapped(uint16_t n)
+    {
+        AP_Terrain::grid_cache &gcache = terrain.find_grid_cache(info[n]);
+        const bool ret = gcache.state == AP_Terrain::GRID_CACHE_VALID;
+        forget(gcache);
+        return ret;
+    }
+
+    // miss on grid n, with the block read by the IO thread's path and
+    // then taken by the main thread. Returns false unless the read
+    // gave the block valid data
+    bool load_read(uint16_t n)
+    {
+        AP_Terrain::grid_cache &gcache = terrain.find_grid_cache(info[n]);
+        terrain.check_disk_read();
+        if (terrain.disk_io_state != AP_Terrain::DiskIoWaitRead) {
+            return false;
+        }
+        terrain.open_file();
+        if (terrain.fd == -1) {
+            return false;
+        }
+        terrain.read_block();
+        terrain.schedule_disk_io();
+        const bool ret = gcache.state == AP_Terrain::GRID_CACHE_VALID && gcache.grid.bitmap != 0;
+        forget(gcache);
+        return ret;
+    }
+
+    uint16_t order[4096];
+
+private:
+    AP_Terrain terrain;
+    struct AP_Terrain::grid_info info[NUM_BLOCKS];
+
+    // drop a block from the cache, so the next lookup of its grid is
+    // a miss however the least recently used block is chosen
+    void forget(AP_Terrain::grid_cache &gcache)
+    {
+        terrain.hash_remove(&gcache - terrain.cache);
+        gcache.state = AP_Terrain::GRID_CACHE_INVALID;
+    }
+
+    // write a complete block for every grid in the degree square of
+    // 45N 7E, at the offsets the terrain code reads them from
+    bool write_file(void)
+    {
+        const int fd = AP::FS().open(BENCH_DIR "/N45E007.DAT", O_WRONLY|O_CREAT|O_TRUNC);
+        if (fd == -1) {
+            return false;
+        }
+        bool ok = true;
+        for (uint16_t i=0; i<NUM_BLOCKS && ok; i++) {
+            Location loc;
+            loc.lat = 45 * 10 * 1000 * 1000L;
+            loc.lng = 7 * 10 * 1000 * 1000L;
+            loc.offset(((i / BLOCKS_EAST) * TERRAIN_GRID_BLOCK_SPACING_X + 0.5) * GRID_SPACING,
+                       ((i % BLOCKS_EAST) * TERRAIN_GRID_BLOCK_SPACING_Y + 0.5) * GRID_SPACING);
+            terrain.calculate_grid_info(loc, info[i]);
+
+            union AP_Terrain::grid_io_block io_block {};
+            struct AP_Terrain::grid_block &block = io_block.block;
+            block.bitmap = AP_Terrain::bitmap_mask;
+            block.lat = info[i].grid_lat;
+            block.lon = info[i].grid_lon;
+            block.version = TERRAIN_GRID_FORMAT_VERSION;
+            block.spacing = GRID_SPACING;
+            for (uint8_t x=0; x<TERRAIN_GRID_BLOCK_SIZE_X; x++) {
+                for (uint8_t y=0; y<TERRAIN_GRID_BLOCK_SIZE_Y; y++) {
+                    block.height[x][y] = random() % 1000;
+                }
+            }
+            block.grid_idx_x = info[i].grid_idx_x;
+            block.grid_idx_y = info[i].grid_idx_y;
+            block.lat_degrees = info[i].lat_degrees;
+            block.lon_degrees = info[i].lon_degrees;
+            block.crc = terrain.get_block_crc(block);
+
+            const int32_t ofs = terrain.block_file_offset(block);
+            ok = AP::FS().lseek(fd, ofs, SEEK_SET) == ofs &&
+                AP::FS().write(fd, &io_block, sizeof(io_block)) == int32_t(sizeof(io_block));
+        }
+        AP::FS().close(fd);
+        return ok;
+    }
+};
+
+static AP_Terrain_Bench bench;
+
+static bool setup_bench(void)
+{
+    static bool done;
+    static bool ok;
+    if (!done) {
+        done = true;
+        ok = bench.setup();
+    }
+    return ok;
+}
+
+static void BM_TerrainMissFileRead(benchmark::State &state)
+{
+    if (!setup_bench()) {
+        state.SkipWithError("failed to write terrain file");
+        return;
+    }
+    bench.use_mapped_files(false);
+    uint16_t n = 0;
+    for (auto _ : state) {
+        if (!bench.load_read(bench.order[n])) {
+            state.SkipWithError("block read failed");
+            break;
+        }
+        n = (n + 1) % ARRAY_SIZE(bench.order);
+    }
+}
+
+static void BM_TerrainMissMapped(benchmark::State &state)
+{
+    if (!setup_bench()) {
+        state.SkipWithError("failed to write terrain file");
+        return;
+    }
+    bench.use_mapped_files(true);
+    uint16_t n = 0;
+    for (auto _ : state) {
+        if (!bench.load_mapped(bench.order[n])) {
+            state.SkipWithError("mapped block load failed");
+            break;
+        }
+        n = (n + 1) % ARRAY_SIZE(bench.order);
+    }
+}
+
+BENCHMARK(BM_TerrainMissFileRead);
+BENCHMARK(BM_TerrainMissMapped);
+
+BENCHMARK_MAIN();
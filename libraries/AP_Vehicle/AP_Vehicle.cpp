@@ -626,7 +626,8 @@ const AP_Scheduler::Task AP_Vehicle::scheduler_tasks[] = {
 #endif
 #if HAL_GYROFFT_ENABLED
     SCHED_TASK_CLASS(AP_GyroFFT,   &vehicle.gyro_fft,       update,                  400, 50, 205),
-    SCHED_TASK_CLASS(AP_GyroFFT,   &vehicle.gyro_fft,       update_parameters,         1, 50, 210),
+    // only touches the FFT configuration, under the FFT semaphore
+    SCHED_TASK_CLASS_WORKER(AP_GyroFFT, &vehicle.gyro_fft,  update_parameters,         1, 50, 210),
 #endif
 #if AP_INERTIALSENSOR_HARMONICNOTCH_ENABLED && !AP_INERTIALSENSOR_FAST_SAMPLE_WINDOW_ENABLED
     SCHED_TASK(update_dynamic_notch_at_specified_rate,      LOOP_RATE,                    200, 215),
@@ -897,6 +898,13 @@ void AP_Vehicle::update_dynamic_notch(AP_InertialSensor::HarmonicNotch &notch)
                 } else {    // since FFT can be used post-filter it is better to disable the notch when there is no data
                     notch.set_inactive(true);
                 }
+                // IMUs with their own healthy peaks track them, the others follow the primary
+                if (gyro_fft.analysing_all_imus()) {
+                    for (uint8_t i = 0; i < INS_MAX_INSTANCES; i++) {
+                        const uint8_t imu_peaks = gyro_fft.get_weighted_noise_center_frequencies_hz(i, notch.num_dynamic_notches, notches);
+                        notch.update_frequencies_hz(i, imu_peaks, notches);
+                    }
+                }
             } else {
                 float center_freq = gyro_fft.get_weighted_noise_center_freq_hz();
                 notch.update_freq_hz(center_freq);
@@ -427,6 +427,22 @@ T HarmonicNotchFilter<T>::apply(const T &sample)
     return output;
 }
 
+/*
+  apply a burst of samples in place. Each underlying filter runs over
+  the whole burst before the next one so that its coefficients and
+  state stay in registers
+ */
+template <class T>
+void HarmonicNotchFilter<T>::apply(T *samples, uint16_t n)
+{
+    if (!_initialised) {
+        return;
+    }
+    for (uint16_t i = 0; i < _num_enabled_filters; i++) {
+        _filters[i].apply(samples, n);
+    }
+}
+
 /*
   reset all of the underlying filters
  */
@@ -51,6 +51,8 @@ public:
 
     // apply a sample to each of the underlying filters in turn
     T apply(const T &sample);
+    // apply a burst of samples in place, one underlying filter at a time
+    void apply(T *samples, uint16_t n);
     // reset each of the underlying filters
     void reset();
 
@@ -34,6 +34,58 @@ T DigitalBiquadFilter<T>::apply(const T &sample, const struct biquad_params &par
     return output;
 }
 
+/*
+  apply a burst of samples in place, stepping all of the channels of T
+  together with the state held in locals. The results match calling
+  apply() on each sample, apart from rounding where the compiler fuses
+  multiply-adds
+ */
+template <class T>
+void DigitalBiquadFilter<T>::apply(T *samples, uint16_t n, const struct biquad_params &params) {
+    if(n == 0 || !is_positive(params.cutoff_freq) || !is_positive(params.sample_freq)) {
+        return;
+    }
+
+    if (std::is_integral<T>::value) {
+        // integer filters keep the per-sample arithmetic
+        for (uint16_t i = 0; i < n; i++) {
+            samples[i] = apply(samples[i], params);
+        }
+        return;
+    }
+
+    if (!initialised) {
+        reset(samples[0], params);
+    }
+
+    constexpr uint8_t N = sizeof(T) / sizeof(float);
+    float *x = reinterpret_cast<float*>(samples);
+    float *s_d1 = reinterpret_cast<float*>(&_delay_element_1);
+    float *s_d2 = reinterpret_cast<float*>(&_delay_element_2);
+
+    float d1[N], d2[N];
+    for (uint8_t c = 0; c < N; c++) {
+        d1[c] = s_d1[c];
+        d2[c] = s_d2[c];
+    }
+    const float a1 = params.a1, a2 = params.a2;
+    const float b0 = params.b0, b1 = params.b1, b2 = params.b2;
+
+    for (uint16_t i = 0; i < n; i++, x += N) {
+        for (uint8_t c = 0; c < N; c++) {
+            const float d0 = x[c] - d1[c] * a1 - d2[c] * a2;
+            x[c] = d0 * b0 + d1[c] * b1 + d2[c] * b2;
+            d2[c] = d1[c];
+            d1[c] = d0;
+        }
+    }
+
+    for (uint8_t c = 0; c < N; c++) {
+        s_d1[c] = d1[c];
+        s_d2[c] = d2[c];
+    }
+}
+
 template <class T>
 void DigitalBiquadFilter<T>::reset() { 
     initialised = false;
@@ -105,6 +157,11 @@ T LowPassFilter2p<T>::apply(const T &sample) {
     return _filter.apply(sample, _params);
 }
 
+template <class T>
+void LowPassFilter2p<T>::apply(T *samples, uint16_t n) {
+    _filter.apply(samples, n, _params);
+}
+
 template <class T>
 void LowPassFilter2p<T>::reset(void) {
     return _filter.reset();
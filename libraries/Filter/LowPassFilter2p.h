@@ -40,6 +40,8 @@ public:
     DigitalBiquadFilter();
 
     T apply(const T &sample, const struct biquad_params &params);
+    // filter a burst of samples in place
+    void apply(T *samples, uint16_t n, const struct biquad_params &params);
     void reset();
     void reset(const T &value, const struct biquad_params &params);
     static void compute_params(float sample_freq, float cutoff_freq, biquad_params &ret);
@@ -62,6 +64,7 @@ public:
     float get_cutoff_freq(void) const;
     float get_sample_freq(void) const;
     T apply(const T &sample);
+    void apply(T *samples, uint16_t n);
     void reset(void);
     void reset(const T &value);
 
@@ -128,6 +128,67 @@ T NotchFilter<T>::apply(const T &sample)
     return output;
 }
 
+/*
+  apply a burst of samples in place. The state and coefficients are
+  held in locals for the whole burst and all of the channels of T are
+  stepped together, giving the compiler independent chains to
+  interleave or vectorise. The results match calling apply() on each
+  sample, apart from rounding where the compiler fuses multiply-adds
+ */
+template <class T>
+void NotchFilter<T>::apply(T *samples, uint16_t n)
+{
+    if (n == 0) {
+        return;
+    }
+    if (!initialised) {
+        // pass through, leaving the delayed samples at the last input
+        apply(samples[n-1]);
+        return;
+    }
+    if (need_reset) {
+        samples[0] = apply(samples[0]);
+        samples++;
+        n--;
+    }
+
+    static_assert(sizeof(T) % sizeof(float) == 0, "notch filters are made of floats");
+    constexpr uint8_t N = sizeof(T) / sizeof(float);
+    float *x = reinterpret_cast<float*>(samples);
+    float *s_in1 = reinterpret_cast<float*>(&ntchsig1);
+    float *s_in2 = reinterpret_cast<float*>(&ntchsig2);
+    float *s_out1 = reinterpret_cast<float*>(&signal1);
+    float *s_out2 = reinterpret_cast<float*>(&signal2);
+
+    float in1[N], in2[N], out1[N], out2[N];
+    for (uint8_t c = 0; c < N; c++) {
+        in1[c] = s_in1[c];
+        in2[c] = s_in2[c];
+        out1[c] = s_out1[c];
+        out2[c] = s_out2[c];
+    }
+    const float _b0 = b0, _b1 = b1, _b2 = b2, _a1 = a1, _a2 = a2;
+
+    for (uint16_t i = 0; i < n; i++, x += N) {
+        for (uint8_t c = 0; c < N; c++) {
+            const float in = x[c];
+            const float out = in*_b0 + in1[c]*_b1 + in2[c]*_b2 - out1[c]*_a1 - out2[c]*_a2;
+            in2[c] = in1[c];
+            in1[c] = in;
+            out2[c] = out1[c];
+            out1[c] = out;
+            x[c] = out;
+        }
+    }
+
+    for (uint8_t c = 0; c < N; c++) {
+        s_in1[c] = in1[c];
+        s_in2[c] = in2[c];
+        s_out1[c] = out1[c];
+        s_out2[c] = out2[c];
+    }
+}
+
 template <class T>
 void NotchFilter<T>::reset()
 {
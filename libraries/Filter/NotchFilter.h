@@ -37,6 +37,8 @@ public:
     void init(float sample_freq_hz, float center_freq_hz, float bandwidth_hz, float attenuation_dB);
     void init_with_A_and_Q(float sample_freq_hz, float center_freq_hz, float A, float Q);
     T apply(const T &sample);
+    // filter a burst of samples in place
+    void apply(T *samples, uint16_t n);
     void reset();
     float center_freq_hz() const { return _center_freq_hz; }
     float sample_freq_hz() const { return _sample_freq_hz; }
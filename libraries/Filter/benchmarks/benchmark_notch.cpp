@@ -0,0 +1,82 @@
+/*
+  gyro filter chain throughput, one sample at a time against bursts
+  of samples, for different numbers of notches
+ */
+#include <AP_gbenchmark.h>
+
+#include <Filter/HarmonicNotchFilter.h>
+#include <Filter/LowPassFilter2p.h>
+
+const AP_HAL::HAL& hal = AP_HAL::get_HAL();
+
+static const uint16_t rate_hz = 8000;
+static const uint16_t burst = 8;
+
+static void setup_notch(HarmonicNotchFilter<Vector3f> &notch, HarmonicNotchFilterParams &params, uint8_t num_notches)
+{
+    params.set_attenuation(40);
+    params.set_bandwidth_hz(40);
+    params.set_center_freq_hz(80);
+    params.set_freq_min_ratio(1.0);
+    notch.allocate_filters(1, (1U<<num_notches)-1, 1);
+    notch.init(rate_hz, params);
+    notch.update(80);
+}
+
+// precomputed input so the trig functions stay out of the timing
+static Vector3f input[1024];
+
+static void fill_burst(Vector3f *samples, uint32_t &n)
+{
+    if (n == 0) {
+        for (uint16_t i = 0; i < ARRAY_SIZE(input); i++) {
+            const float t = float(i) / rate_hz;
+            input[i] = Vector3f{sinf(t * 300), sinf(t * 700), cosf(t * 1100)};
+        }
+    }
+    for (uint16_t i = 0; i < burst; i++, n++) {
+        samples[i] = input[n % ARRAY_SIZE(input)];
+    }
+}
+
+static void BM_NotchChainSingle(benchmark::State& state)
+{
+    HarmonicNotchFilterParams params {};
+    HarmonicNotchFilter<Vector3f> notch;
+    LowPassFilter2pVector3f lpf{rate_hz, 90};
+    setup_notch(notch, params, state.range_x());
+
+    Vector3f samples[burst];
+    uint32_t n = 0;
+    while (state.KeepRunning()) {
+        fill_burst(samples, n);
+        for (uint16_t i = 0; i < burst; i++) {
+            samples[i] = lpf.apply(notch.apply(samples[i]));
+        }
+        gbenchmark_escape(samples);
+    }
+    state.SetItemsProcessed(uint64_t(state.iterations()) * burst);
+}
+
+static void BM_NotchChainBatch(benchmark::State& state)
+{
+    HarmonicNotchFilterParams params {};
+    HarmonicNotchFilter<Vector3f> notch;
+    LowPassFilter2pVector3f lpf{rate_hz, 90};
+    setup_notch(notch, params, state.range_x());
+
+    Vector3f samples[burst];
+    uint32_t n = 0;
+    while (state.KeepRunning()) {
+        fill_burst(samples, n);
+        notch.apply(samples, burst);
+        lpf.apply(samples, burst);
+        gbenchmark_escape(samples);
+    }
+    state.SetItemsProcessed(uint64_t(state.iterations()) * burst);
+}
+
+BENCHMARK(BM_NotchChainSingle)->Arg(1)->Arg(4)->Arg(8)->Arg(16);
+BENCHMARK(BM_NotchChainBatch)->Arg(1)->Arg(4)->Arg(8)->Arg(16);
+
+BENCHMARK_MAIN();
@@ -363,4 +363,54 @@ TEST(NotchFilterTest, HarmonicNotchTest5)
     fclose(f);
 }
 
+/*
+  check that filtering bursts of samples in place gives the same
+  output as filtering them one at a time
+ */
+TEST(NotchFilterTest, BatchTest)
+{
+    const uint16_t rate_hz = 4000;
+    const uint16_t burst = 7;
+    const uint32_t samples = burst * 300;
+
+    HarmonicNotchFilterParams notch_params {};
+    notch_params.set_options(uint16_t(HarmonicNotchFilterParams::Options::DoubleNotch));
+    notch_params.set_attenuation(40);
+    notch_params.set_bandwidth_hz(40);
+    notch_params.set_center_freq_hz(80);
+    notch_params.set_freq_min_ratio(1.0);
+
+    HarmonicNotchFilter<Vector3f> single, batch;
+    for (auto *f : { &single, &batch }) {
+        f->allocate_filters(1, 0x0F, notch_params.num_composite_notches());
+        f->init(rate_hz, notch_params);
+        f->update(80);
+    }
+    LowPassFilter2pVector3f single_lpf{rate_hz, 90};
+    LowPassFilter2pVector3f batch_lpf{rate_hz, 90};
+
+    Vector3f buf[burst];
+    for (uint32_t s=0; s<samples; s += burst) {
+        if (s == samples/2) {
+            single.reset();
+            batch.reset();
+        }
+        for (uint16_t i=0; i<burst; i++) {
+            const float t = float(s+i) / rate_hz;
+            buf[i] = Vector3f{sinf(t * 80 * 2 * M_PI), sinf(t * 160 * 2 * M_PI), cosf(t * 33 * 2 * M_PI)};
+        }
+        Vector3f expected[burst];
+        for (uint16_t i=0; i<burst; i++) {
+            expected[i] = single_lpf.apply(single.apply(buf[i]));
+        }
+        batch.apply(buf, burst);
+        batch_lpf.apply(buf, burst);
+        for (uint16_t i=0; i<burst; i++) {
+            EXPECT_NEAR(buf[i].x, expected[i].x, 1e-5);
+            EXPECT_NEAR(buf[i].y, expected[i].y, 1e-5);
+            EXPECT_NEAR(buf[i].z, expected[i].z, 1e-5);
+        }
+    }
+}
+
 AP_GTEST_MAIN()
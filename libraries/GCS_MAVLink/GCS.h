@@ -29,6 +29,7 @@
 #include <AP_Arming/AP_Arming_config.h>
 #include <AP_Airspeed/AP_Airspeed_config.h>
 #include <AP_Follow/AP_Follow.h>
+#include <AP_Param/AP_Param_Snapshot.h>
 
 #include "ap_message.h"
 
@@ -879,7 +880,12 @@ private:
     struct deferred_message_bucket_t {
         Bitmask<MSG_LAST> ap_message_ids;
         uint16_t interval_ms;
-        uint16_t last_sent_ms; // from AP_HAL::millis16()
+        uint32_t last_sent_ms; // from AP_HAL::millis()
+        // when the bucket is next due.  This is worked out when the
+        // bucket is rescheduled, so a change in slowdown is only
+        // seen in the ordering once each bucket has been sent again
+        uint32_t due_ms;
+        uint8_t heap_pos;      // index in bucket_heap if in use
     };
     deferred_message_bucket_t deferred_message_bucket[10];
     static const uint8_t no_bucket_to_send = -1;
@@ -887,10 +893,33 @@ private:
     uint8_t sending_bucket_id = no_bucket_to_send;
     Bitmask<MSG_LAST> bucket_message_ids_to_send;
 
-    ap_message next_deferred_bucket_message_to_send(uint16_t now16_ms);
-    void find_next_bucket_to_send(uint16_t now16_ms);
+    // buckets in use, as a min-heap ordered by due_ms, so the next
+    // bucket to send is always bucket_heap[0]
+    uint8_t bucket_heap[ARRAY_SIZE(deferred_message_bucket)];
+    uint8_t bucket_heap_len;
+    bool bucket_due_before(uint8_t a, uint8_t b) const {
+        return int32_t(deferred_message_bucket[a].due_ms - deferred_message_bucket[b].due_ms) < 0;
+    }
+    void bucket_heap_swap(uint8_t i, uint8_t j);
+    void bucket_heap_sift_up(uint8_t pos);
+    void bucket_heap_sift_down(uint8_t pos);
+    void bucket_heap_insert(uint8_t bucket);
+    void bucket_heap_remove(uint8_t bucket);
+    // set due_ms for a bucket from its last_sent_ms and interval
+    void bucket_reschedule(uint8_t bucket);
+
+    ap_message next_deferred_bucket_message_to_send(uint32_t now_ms);
+    void find_next_bucket_to_send();
     void remove_message_from_bucket(int8_t bucket, ap_message id);
 
+    // deferred message scheduling statistics, logged in MAV
+    struct {
+        uint32_t sched_us;          // time in update_send() not spent in try_send_message()
+        uint16_t sched_max_us;      // most scheduling time in a single update_send()
+        uint16_t missed_intervals;  // times a message fell a whole interval behind
+        uint32_t send_us;           // running total of time in try_send_message()
+    } deferred_stats;
+
     // bitmask of IDs the code has spontaneously decided it wants to
     // send out.  Examples include HEARTBEAT (gcs_send_heartbeat)
     Bitmask<MSG_LAST> pushed_ap_message_ids;
@@ -983,6 +1012,34 @@ private:
     // IO timer callback for parameters
     void param_io_timer(void);
 
+#if AP_PARAM_SNAPSHOT_ENABLED
+    // links at least this fast are networks, where the CPU time per
+    // parameter rather than bandwidth limits a full download. These
+    // are sent the parameter list from a snapshot
+    static constexpr uint32_t param_snapshot_min_bw = 1000000;
+
+    // a snapshot shared by all channels sending from it
+    struct shared_param_snapshot {
+        AP_Param_Snapshot params;
+        uint32_t seq;       // request number it was taken for
+        uint8_t users;      // channels sending from it
+    };
+    static HAL_Semaphore param_snapshot_sem;
+    static shared_param_snapshot *param_snapshot;   // most recent
+    static uint32_t param_snapshot_requested_seq;
+    static uint32_t param_snapshot_done_seq;        // last request tried
+    static uint8_t param_snapshot_waiters;
+
+    // snapshot this channel is sending from, and the request it is
+    // waiting on (0 if none)
+    shared_param_snapshot *_param_snapshot;
+    uint32_t _param_snapshot_wait_seq;
+
+    static void param_snapshot_update(void);
+    bool queued_param_snapshot_send(void);
+    void param_snapshot_release(void);
+#endif
+
     // support for returning explicit error for parameter protocol
     void send_param_error(const mavlink_message_t &msg, const mavlink_param_set_t &param_set, MAV_PARAM_ERROR error);
     void send_param_error(const pending_param_reply &msg, MAV_PARAM_ERROR error);
@@ -1279,39 +1279,95 @@ uint16_t GCS_MAVLINK::get_reschedule_interval_ms(const deferred_message_bucket_t
     return interval_ms;
 }
 
-// typical runtime on fmuv3: 5 microseconds for 3 buckets
-void GCS_MAVLINK::find_next_bucket_to_send(uint16_t now16_ms)
+void GCS_MAVLINK::bucket_heap_swap(uint8_t i, uint8_t j)
 {
-#if GCS_DEBUG_SEND_MESSAGE_TIMINGS
-    void *data = hal.scheduler->disable_interrupts_save();
-    uint32_t start_us = AP_HAL::micros();
-#endif
+    const uint8_t bi = bucket_heap[i];
+    const uint8_t bj = bucket_heap[j];
+    bucket_heap[i] = bj;
+    bucket_heap[j] = bi;
+    deferred_message_bucket[bj].heap_pos = i;
+    deferred_message_bucket[bi].heap_pos = j;
+}
 
-    // all done sending this bucket... find another bucket...
-    sending_bucket_id = no_bucket_to_send;
-    uint16_t ms_before_send_next_bucket_to_send = UINT16_MAX;
-    for (uint8_t i=0; i<ARRAY_SIZE(deferred_message_bucket); i++) {
-        if (deferred_message_bucket[i].ap_message_ids.count() == 0) {
-            // no entries
-            continue;
+void GCS_MAVLINK::bucket_heap_sift_up(uint8_t pos)
+{
+    while (pos > 0) {
+        const uint8_t parent = (pos - 1) / 2;
+        if (!bucket_due_before(bucket_heap[pos], bucket_heap[parent])) {
+            break;
         }
-        const uint16_t interval = get_reschedule_interval_ms(deferred_message_bucket[i]);
-        const uint16_t ms_since_last_sent = now16_ms - deferred_message_bucket[i].last_sent_ms;
-        uint16_t ms_before_send_this_bucket;
-        if (ms_since_last_sent > interval) {
-            // should already have sent this bucket!
-            ms_before_send_this_bucket = 0;
-        } else {
-            ms_before_send_this_bucket = interval - ms_since_last_sent;
+        bucket_heap_swap(pos, parent);
+        pos = parent;
+    }
+}
+
+void GCS_MAVLINK::bucket_heap_sift_down(uint8_t pos)
+{
+    while (true) {
+        const uint8_t l = 2*pos + 1;
+        const uint8_t r = l + 1;
+        uint8_t smallest = pos;
+        if (l < bucket_heap_len && bucket_due_before(bucket_heap[l], bucket_heap[smallest])) {
+            smallest = l;
+        }
+        if (r < bucket_heap_len && bucket_due_before(bucket_heap[r], bucket_heap[smallest])) {
+            smallest = r;
         }
-        if (ms_before_send_this_bucket < ms_before_send_next_bucket_to_send) {
-            sending_bucket_id = i;
-            ms_before_send_next_bucket_to_send = ms_before_send_this_bucket;
+        if (smallest == pos) {
+            break;
         }
+        bucket_heap_swap(pos, smallest);
+        pos = smallest;
+    }
+}
+
+void GCS_MAVLINK::bucket_heap_insert(uint8_t bucket)
+{
+    const uint8_t pos = bucket_heap_len++;
+    bucket_heap[pos] = bucket;
+    deferred_message_bucket[bucket].heap_pos = pos;
+    bucket_heap_sift_up(pos);
+}
+
+void GCS_MAVLINK::bucket_heap_remove(uint8_t bucket)
+{
+    const uint8_t pos = deferred_message_bucket[bucket].heap_pos;
+    const uint8_t last = --bucket_heap_len;
+    if (pos != last) {
+        // move the last entry into the hole and restore heap order
+        bucket_heap_swap(pos, last);
+        const uint8_t moved = bucket_heap[pos];
+        bucket_heap_sift_up(pos);
+        bucket_heap_sift_down(deferred_message_bucket[moved].heap_pos);
+    }
+    deferred_message_bucket[bucket].heap_pos = no_bucket_to_send;
+}
+
+void GCS_MAVLINK::bucket_reschedule(uint8_t bucket)
+{
+    deferred_message_bucket_t &b = deferred_message_bucket[bucket];
+    const uint32_t old_due_ms = b.due_ms;
+    b.due_ms = b.last_sent_ms + get_reschedule_interval_ms(b);
+    if (int32_t(b.due_ms - old_due_ms) < 0) {
+        bucket_heap_sift_up(b.heap_pos);
+    } else {
+        bucket_heap_sift_down(b.heap_pos);
     }
-    if (sending_bucket_id != no_bucket_to_send) {
+}
+
+void GCS_MAVLINK::find_next_bucket_to_send()
+{
+#if GCS_DEBUG_SEND_MESSAGE_TIMINGS
+    void *data = hal.scheduler->disable_interrupts_save();
+    uint32_t start_us = AP_HAL::micros();
+#endif
+
+    // all done sending this bucket... the next is at the top of the heap
+    if (bucket_heap_len != 0) {
+        sending_bucket_id = bucket_heap[0];
         bucket_message_ids_to_send = deferred_message_bucket[sending_bucket_id].ap_message_ids;
     } else {
+        sending_bucket_id = no_bucket_to_send;
         bucket_message_ids_to_send.clearall();
     }
 
@@ -1324,14 +1380,14 @@ void GCS_MAVLINK::find_next_bucket_to_send(uint16_t now16_ms)
 #endif
 }
 
-ap_message GCS_MAVLINK::next_deferred_bucket_message_to_send(uint16_t now16_ms)
+ap_message GCS_MAVLINK::next_deferred_bucket_message_to_send(uint32_t now_ms)
 {
     if (sending_bucket_id == no_bucket_to_send) {
         // could happen if all streamrates are zero?
         return no_message_to_send;
     }
 
-    const uint16_t ms_since_last_sent = now16_ms - deferred_message_bucket[sending_bucket_id].last_sent_ms;
+    const uint32_t ms_since_last_sent = now_ms - deferred_message_bucket[sending_bucket_id].last_sent_ms;
     if (ms_since_last_sent < get_reschedule_interval_ms(deferred_message_bucket[sending_bucket_id])) {
         // not time to send this bucket
         return no_message_to_send;
@@ -1343,7 +1399,7 @@ ap_message GCS_MAVLINK::next_deferred_bucket_message_to_send(uint16_t now16_ms)
 #if CONFIG_HAL_BOARD == HAL_BOARD_SITL
         AP_HAL::panic("next_deferred_bucket_message_to_send called on empty bucket");
 #endif
-        find_next_bucket_to_send(now16_ms);
+        find_next_bucket_to_send();
         return no_message_to_send;
     }
     return (ap_message)next;
@@ -1366,7 +1422,10 @@ bool GCS_MAVLINK::do_try_send_message(const ap_message id)
     void *data = hal.scheduler->disable_interrupts_save();
     uint32_t start_send_message_us = AP_HAL::micros();
 #endif
-    if (!try_send_message(id)) {
+    const uint32_t send_start_us = AP_HAL::micros();
+    const bool sent = try_send_message(id);
+    deferred_stats.send_us += AP_HAL::micros() - send_start_us;
+    if (!sent) {
         // didn't fit in buffer...
 #if GCS_DEBUG_SEND_MESSAGE_TIMINGS
         try_send_message_stats.no_space_for_message++;
@@ -1586,6 +1645,9 @@ void GCS_MAVLINK::update_send()
     // check for any in-progress tasks; check_tasks does its own rate-limiting
     GCS_MAVLINK_InProgress::check_tasks();
 
+    const uint32_t sched_start_us = AP_HAL::micros();
+    const uint32_t send_us_at_start = deferred_stats.send_us;
+
     const uint32_t start = AP_HAL::millis();
     const uint16_t start16 = start & 0xFFFF;
     while (AP_HAL::millis() - start < 5) { // spend a max of 5ms sending messages.  This should never trigger - out_of_time() should become true
@@ -1614,6 +1676,7 @@ void GCS_MAVLINK::update_send()
                 // but we do not want to try to catch up too much:
                 if (uint16_t(start16 - deferred_message[next].last_sent_ms) > interval_ms) {
                     deferred_message[next].last_sent_ms = start16;
+                    deferred_stats.missed_intervals++;
                 }
 
                 next_deferred_message_to_send_cache = -1; // deferred_message_to_send will recalculate
@@ -1648,7 +1711,7 @@ void GCS_MAVLINK::update_send()
             continue;
         }
 
-        ap_message next = next_deferred_bucket_message_to_send(start16);
+        ap_message next = next_deferred_bucket_message_to_send(start);
         if (next != no_message_to_send) {
             if (!do_try_send_message(next)) {
                 break;
@@ -1658,13 +1721,16 @@ void GCS_MAVLINK::update_send()
                 // we sent everything in the bucket.  Reschedule it.
                 // we try to keep output on a regular clock to avoid
                 // user support questions:
-                const uint16_t interval_ms = get_reschedule_interval_ms(deferred_message_bucket[sending_bucket_id]);
-                deferred_message_bucket[sending_bucket_id].last_sent_ms += interval_ms;
+                deferred_message_bucket_t &bucket = deferred_message_bucket[sending_bucket_id];
+                const uint16_t interval_ms = get_reschedule_interval_ms(bucket);
+                bucket.last_sent_ms += interval_ms;
                 // but we do not want to try to catch up too much:
-                if (uint16_t(start16 - deferred_message_bucket[sending_bucket_id].last_sent_ms) > interval_ms) {
-                    deferred_message_bucket[sending_bucket_id].last_sent_ms = start16;
+                if (start - bucket.last_sent_ms > interval_ms) {
+                    bucket.last_sent_ms = start;
+                    deferred_stats.missed_intervals++;
                 }
-                find_next_bucket_to_send(start16);
+                bucket_reschedule(sending_bucket_id);
+                find_next_bucket_to_send();
             }
 #if GCS_DEBUG_SEND_MESSAGE_TIMINGS
                 const uint32_t stop = AP_HAL::micros();
@@ -1687,6 +1753,12 @@ void GCS_MAVLINK::update_send()
     }
 #endif
 
+    const uint32_t sched_us = (AP_HAL::micros() - sched_start_us) - (deferred_stats.send_us - send_us_at_start);
+    deferred_stats.sched_us += sched_us;
+    if (sched_us > deferred_stats.sched_max_us) {
+        deferred_stats.sched_max_us = MIN(sched_us, UINT16_MAX);
+    }
+
     // update the number of packets transmitted base on seqno, making
     // the assumption that we don't send more than 256 messages
     // between the last pass through here
@@ -1699,6 +1771,7 @@ void GCS_MAVLINK::remove_message_from_bucket(int8_t bucket, ap_message id)
     deferred_message_bucket[bucket].ap_message_ids.clear(id);
     if (deferred_message_bucket[bucket].ap_message_ids.count() == 0) {
         // bucket empty.  Free it:
+        bucket_heap_remove(bucket);
         deferred_message_bucket[bucket].interval_ms = 0;
         deferred_message_bucket[bucket].last_sent_ms = 0;
     }
@@ -1706,7 +1779,7 @@ void GCS_MAVLINK::remove_message_from_bucket(int8_t bucket, ap_message id)
     if (bucket == sending_bucket_id) {
         bucket_message_ids_to_send.clear(id);
         if (bucket_message_ids_to_send.count() == 0) {
-            find_next_bucket_to_send(AP_HAL::millis16());
+            find_next_bucket_to_send();
         } else {
 #if CONFIG_HAL_BOARD == HAL_BOARD_SITL
             if (deferred_message_bucket[bucket].interval_ms == 0 &&
@@ -1811,8 +1884,11 @@ bool GCS_MAVLINK::set_ap_message_interval(enum ap_message id, uint16_t interval_
     if (closest_bucket_interval_delta != 0 &&
         empty_bucket_id != -1) {
         // allocate a bucket for this interval
-        deferred_message_bucket[empty_bucket_id].interval_ms = interval_ms;
-        deferred_message_bucket[empty_bucket_id].last_sent_ms = AP_HAL::millis16();
+        deferred_message_bucket_t &bucket = deferred_message_bucket[empty_bucket_id];
+        bucket.interval_ms = interval_ms;
+        bucket.last_sent_ms = AP_HAL::millis();
+        bucket.due_ms = bucket.last_sent_ms + get_reschedule_interval_ms(bucket);
+        bucket_heap_insert(empty_bucket_id);
         closest_bucket = empty_bucket_id;
     }
 
@@ -2124,9 +2200,16 @@ void GCS_MAVLINK::log_mavlink_stats()
     stream_slowdown_ms     : stream_slowdown_ms,
     times_full             : out_of_space_to_send_count,
     GCS_SYSID_last_seen_ms : _sysid_gcs_last_seen_time_ms,
+    sched_us               : deferred_stats.sched_us,
+    sched_max_us           : deferred_stats.sched_max_us,
+    missed_intervals       : deferred_stats.missed_intervals,
     };
 
     AP::logger().WriteBlock(&pkt, sizeof(pkt));
+
+    deferred_stats.sched_us = 0;
+    deferred_stats.sched_max_us = 0;
+    deferred_stats.missed_intervals = 0;
 }
 #endif
 
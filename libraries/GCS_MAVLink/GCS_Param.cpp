@@ -33,6 +33,14 @@ ObjectBuffer<GCS_MAVLINK::pending_param_reply> GCS_MAVLINK::param_replies(5);
 
 bool GCS_MAVLINK::param_timer_registered;
 
+#if AP_PARAM_SNAPSHOT_ENABLED
+HAL_Semaphore GCS_MAVLINK::param_snapshot_sem;
+GCS_MAVLINK::shared_param_snapshot *GCS_MAVLINK::param_snapshot;
+uint32_t GCS_MAVLINK::param_snapshot_requested_seq;
+uint32_t GCS_MAVLINK::param_snapshot_done_seq;
+uint8_t GCS_MAVLINK::param_snapshot_waiters;
+#endif
+
 /**
  * @brief Send the next pending parameter, called from deferred message
  * handling code
@@ -43,6 +51,12 @@ GCS_MAVLINK::queued_param_send()
     // send parameter async replies
     uint8_t async_replies_sent_count = send_parameter_async_replies();
 
+#if AP_PARAM_SNAPSHOT_ENABLED
+    if (queued_param_snapshot_send()) {
+        return;
+    }
+#endif
+
     // now send the streaming parameters (from PARAM_REQUEST_LIST)
     if (_queued_parameter == nullptr) {
         // .... or not....
@@ -99,6 +113,125 @@ GCS_MAVLINK::queued_param_send()
     _queued_parameter_send_time_ms = tnow;
 }
 
+#if AP_PARAM_SNAPSHOT_ENABLED
+/*
+  send the parameter list from a snapshot. The only limit is the
+  space in the transmit buffer as sending a parameter is no more than
+  a copy. Returns true if this channel is sending or waiting on a
+  snapshot
+ */
+bool GCS_MAVLINK::queued_param_snapshot_send()
+{
+    if (_param_snapshot_wait_seq != 0) {
+        WITH_SEMAPHORE(param_snapshot_sem);
+        if (param_snapshot != nullptr && param_snapshot->seq >= _param_snapshot_wait_seq) {
+            _param_snapshot = param_snapshot;
+            _param_snapshot->users++;
+            _queued_parameter_index = 0;
+            _queued_parameter_count = _param_snapshot->params.count();
+        } else if (param_snapshot_done_seq >= _param_snapshot_wait_seq) {
+            // no snapshot could be taken; send one parameter at a time
+            _queued_parameter = AP_Param::first(&_queued_parameter_token, &_queued_parameter_type);
+            _queued_parameter_index = 0;
+            _queued_parameter_count = AP_Param::count_parameters();
+        } else {
+            return true;
+        }
+        param_snapshot_waiters--;
+        _param_snapshot_wait_seq = 0;
+    }
+
+    if (_param_snapshot == nullptr) {
+        return false;
+    }
+
+    const AP_Param_Snapshot &params = _param_snapshot->params;
+    const uint32_t tstart = AP_HAL::micros();
+    while (_queued_parameter_index < params.count() &&
+           txspace() >= PAYLOAD_SIZE(chan, PARAM_VALUE) &&
+           last_txbuf_is_greater(33)) {
+        const AP_Param_Snapshot::Entry &e = params.entry(_queued_parameter_index);
+        mavlink_msg_param_value_send(
+            chan,
+            e.name,
+            e.value_float(),
+            mav_param_type((enum ap_var_type)e.type),
+            _queued_parameter_count,
+            _queued_parameter_index);
+        _queued_parameter_index++;
+
+        if (AP_HAL::micros() - tstart > 1000) {
+            break;
+        }
+    }
+    if (_queued_parameter_index >= params.count()) {
+        param_snapshot_release();
+    }
+    _queued_parameter_send_time_ms = AP_HAL::millis();
+    return true;
+}
+
+/*
+  stop using or waiting on a snapshot. The most recent snapshot is
+  kept while channels are waiting for it
+ */
+void GCS_MAVLINK::param_snapshot_release()
+{
+    WITH_SEMAPHORE(param_snapshot_sem);
+    if (_param_snapshot_wait_seq != 0) {
+        param_snapshot_waiters--;
+        _param_snapshot_wait_seq = 0;
+    }
+    if (_param_snapshot == nullptr) {
+        return;
+    }
+    _param_snapshot->users--;
+    if (_param_snapshot->users == 0 &&
+        (_param_snapshot != param_snapshot || param_snapshot_waiters == 0)) {
+        if (_param_snapshot == param_snapshot) {
+            param_snapshot = nullptr;
+        }
+        delete _param_snapshot;
+    }
+    _param_snapshot = nullptr;
+}
+
+/*
+  take a snapshot if a channel has asked for one since the last. Runs
+  in the IO thread as walking all parameters takes several ms
+ */
+void GCS_MAVLINK::param_snapshot_update()
+{
+    uint32_t seq;
+    {
+        WITH_SEMAPHORE(param_snapshot_sem);
+        seq = param_snapshot_requested_seq;
+        if (seq == param_snapshot_done_seq) {
+            return;
+        }
+    }
+
+    shared_param_snapshot *s = NEW_NOTHROW shared_param_snapshot;
+    if (s != nullptr && !s->params.build()) {
+        delete s;
+        s = nullptr;
+    }
+
+    WITH_SEMAPHORE(param_snapshot_sem);
+    param_snapshot_done_seq = seq;
+    if (s == nullptr) {
+        return;
+    }
+    s->seq = seq;
+    // channels still sending from the previous snapshot free it
+    // when they finish
+    if (param_snapshot != nullptr && param_snapshot->users == 0) {
+        delete param_snapshot;
+    }
+    param_snapshot = s;
+}
+#endif  // AP_PARAM_SNAPSHOT_ENABLED
+
 /*
   return true if a channel has flow control
  */
@@ -215,6 +348,25 @@ void GCS_MAVLINK::handle_param_request_list(const mavlink_message_t &msg)
     // requesting parameters is a convenient way to get extra information
     send_banner();
 
+#if AP_PARAM_SNAPSHOT_ENABLED
+    param_snapshot_release();
+    if (_port != nullptr && _port->bw_in_bytes_per_second() >= param_snapshot_min_bw) {
+        // send from a snapshot once the IO timer has taken one
+        {
+            WITH_SEMAPHORE(param_snapshot_sem);
+            _param_snapshot_wait_seq = ++param_snapshot_requested_seq;
+            param_snapshot_waiters++;
+        }
+        _queued_parameter = nullptr;
+        _queued_parameter_send_time_ms = AP_HAL::millis();
+        if (!param_timer_registered) {
+            param_timer_registered = true;
+            hal.scheduler->register_io_process(FUNCTOR_BIND_MEMBER(&GCS_MAVLINK::param_io_timer, void));
+        }
+        return;
+    }
+#endif
+
     // Start sending parameters - next call to ::update will kick the first one out
     _queued_parameter = AP_Param::first(&_queued_parameter_token, &_queued_parameter_type);
     _queued_parameter_index = 0;
@@ -380,6 +532,10 @@ void GCS_MAVLINK::param_io_timer(void)
     // block the main thread counting parameters (~30ms on PH)
     AP_Param::count_parameters();
 
+#if AP_PARAM_SNAPSHOT_ENABLED
+    param_snapshot_update();
+#endif
+
     if (param_replies.space() == 0) {
         // no room
         return;
@@ -327,12 +327,37 @@ void Aircraft::sync_frame_time(void)
 /* add noise based on throttle level (from 0..1) */
 void Aircraft::add_noise(float throttle)
 {
-    gyro += Vector3f(rand_normal(0, 1),
-                     rand_normal(0, 1),
-                     rand_normal(0, 1)) * gyro_noise * fabsf(throttle);
-    accel_body += Vector3f(rand_normal(0, 1),
-                           rand_normal(0, 1),
-                           rand_normal(0, 1)) * accel_noise * fabsf(throttle);
+    gyro += Vector3f(rng.normal(0, 1),
+                     rng.normal(0, 1),
+                     rng.normal(0, 1)) * gyro_noise * fabsf(throttle);
+    accel_body += Vector3f(rng.normal(0, 1),
+                           rng.normal(0, 1),
+                           rng.normal(0, 1)) * accel_noise * fabsf(throttle);
+}
+
+double Aircraft::rand_normal(double mean, double stddev)
+{
+    static Random shared_rng;
+    return shared_rng.normal(mean, stddev);
+}
+
+void Aircraft::Random::seed(uint32_t s)
+{
+    // xorshift can not leave a zero state
+    state = (s + 1) * 2654435761U;
+    if (state == 0) {
+        state = 1;
+    }
+    n2_cached = false;
+}
+
+double Aircraft::Random::uniform()
+{
+    // xorshift32
+    state ^= state << 13;
+    state ^= state >> 17;
+    state ^= state << 5;
+    return 2.0 * state / UINT32_MAX - 1;
 }
 
 /*
@@ -340,26 +365,24 @@ void Aircraft::add_noise(float throttle)
   See
   http://en.literateprograms.org/index.php?title=Special:DownloadCode/Box-Muller_transform_%28C%29&oldid=7011
 */
-double Aircraft::rand_normal(double mean, double stddev)
+double Aircraft::Random::normal(double mean, double stddev)
 {
-    static double n2 = 0.0;
-    static int n2_cached = 0;
     if (!n2_cached) {
         double x, y, r;
         do
         {
-            x = 2.0 * rand()/RAND_MAX - 1;
-            y = 2.0 * rand()/RAND_MAX - 1;
+            x = uniform();
+            y = uniform();
             r = x*x + y*y;
         } while (is_zero(r) || r > 1.0);
         const double d = sqrt(-2.0 * log(r)/r);
         const double n1 = x * d;
         n2 = y * d;
         const double result = n1 * stddev + mean;
-        n2_cached = 1;
+        n2_cached = true;
         return result;
     } else {
-        n2_cached = 0;
+        n2_cached = false;
         return n2 * stddev + mean;
     }
 }
@@ -554,11 +577,8 @@ float Aircraft::rangefinder_range() const
     // n.b. the following code is assuming rotation-pitch-270:
     // adjust altitude for position of the sensor on the vehicle if position offset is non-zero
     if (!relPosSensorBF.is_zero()) {
-        // get a rotation matrix following DCM conventions (body to earth)
-        Matrix3f rotmat;
-        sitl->state.quaternion.rotation_matrix(rotmat);
         // rotate the offset into earth frame
-        const Vector3f relPosSensorEF = rotmat * relPosSensorBF;
+        const Vector3f relPosSensorEF = dcm * relPosSensorBF;
         // correct the altitude at the sensor
         altitude -= relPosSensorEF.z;
     }
@@ -566,8 +586,10 @@ float Aircraft::rangefinder_range() const
     const auto orientation = (Rotation)sitl->sonar_rot.get();
 #if SITL_RANGEFINDER_AS_OBJECT_SENSOR
 
-    float roll = sitl->state.rollDeg;
-    float pitch = sitl->state.pitchDeg;
+    float roll, pitch, yaw;
+    dcm.to_euler(&roll, &pitch, &yaw);
+    roll = degrees(roll);
+    pitch = degrees(pitch);
 
     if (roll > 0) {
         roll -= rangefinder_beam_width();
@@ -605,11 +627,9 @@ float Aircraft::rangefinder_range() const
 #endif
     {
         // adjust for rotation based on orientation of the sensor
-        Matrix3f rotmat;
-        sitl->state.quaternion.rotation_matrix(rotmat);
         Vector3f v{1, 0, 0};
         v.rotate(orientation);
-        v = rotmat * v;
+        v = dcm * v;
 
         if (!is_positive(v.z)) {
             return INFINITY;
@@ -627,7 +647,7 @@ float Aircraft::rangefinder_range() const
     }
 
     // Add some noise on reading
-    altitude += sitl->sonar_noise * rand_float();
+    altitude += sitl->sonar_noise * float(rangefinder_rng.uniform());
 
     // our starting positions can disagree with the terrain database:
     if (altitude < 0) {
@@ -705,12 +725,6 @@ void Aircraft::update_dynamics(const Vector3f &rot_accel)
 {
     WITH_SEMAPHORE(pose_sem);
 
-    // update eas2tas and air density
-#if AP_AHRS_ENABLED
-    eas2tas = AP::ahrs().get_EAS2TAS();
-#endif
-    air_density = SSL_AIR_DENSITY / sq(eas2tas);
-
     const float delta_time = frame_time_us * 1.0e-6f;
 
     // update eas2tas and air density
@@ -894,12 +908,12 @@ void Aircraft::update_wind(const struct sitl_input &input)
 
     if (wind_turb > 0 && !on_ground()) {
 
-        turbulence_azimuth = turbulence_azimuth + (2 * rand());
+        turbulence_azimuth = wrap_360(turbulence_azimuth + 360 * float(rng.uniform()));
 
         turbulence_horizontal_speed =
-                static_cast<float>(turbulence_horizontal_speed * iir_coef+wind_turb * rand_normal(0, 1) * (1 - iir_coef));
+                static_cast<float>(turbulence_horizontal_speed * iir_coef+wind_turb * rng.normal(0, 1) * (1 - iir_coef));
 
-        turbulence_vertical_speed = static_cast<float>((turbulence_vertical_speed * iir_coef) + (wind_turb * rand_normal(0, 1) * (1 - iir_coef)));
+        turbulence_vertical_speed = static_cast<float>((turbulence_vertical_speed * iir_coef) + (wind_turb * rng.normal(0, 1) * (1 - iir_coef)));
 
         wind_ef += Vector3f(
             cosf(radians(turbulence_azimuth)) * turbulence_horizontal_speed,
@@ -64,6 +64,12 @@ public:
     void set_speedup(float speedup);
     float get_speedup() const { return target_speedup; }
 
+    /*
+      enable or disable syncing simulation time to the wall clock, for
+      hosts that pace the simulation themselves
+     */
+    void set_time_sync(bool enable) { use_time_sync = enable; }
+
     /*
       set instance number
      */
@@ -72,6 +78,8 @@ public:
         if (instance < MAX_SIM_INSTANCES) {
             instances[instance] = this;
         }
+        rng.seed(instance);
+        rangefinder_rng.seed(0x10000U + instance);
     }
 
     /*
@@ -99,7 +107,8 @@ public:
     /* smooth sensors to provide kinematic consistancy */
     void smooth_sensors(void);
 
-    /* return normal distribution random numbers */
+    /* return normal distribution random numbers, for simulations
+       other than the models, which use their own generator */
     static double rand_normal(double mean, double stddev);
 
     // get frame rate of model in Hz
@@ -252,6 +261,28 @@ protected:
         float direction;
     } wind_vane_apparent;
 
+    /*
+      random number generator. Each model has its own, seeded from its
+      instance, so a model's noise and turbulence do not depend on how
+      it is stepped alongside other models
+     */
+    class Random {
+    public:
+        void seed(uint32_t s);
+        // uniform random number between -1 and 1
+        double uniform();
+        // normal distribution random number
+        double normal(double mean, double stddev);
+    private:
+        uint32_t state = 1;
+        // second number of the last Box-Muller pair
+        double n2;
+        bool n2_cached = false;
+    } rng;
+    // rangefinder noise has its own generator, so how often the
+    // rangefinder is read doesn't change the turbulence
+    mutable Random rangefinder_rng;
+
     // Wind Turbulence simulated Data
     float turbulence_azimuth;
     float turbulence_horizontal_speed;  // m/s
@@ -629,6 +629,32 @@ Frame *Frame::find_frame(const char *name)
     return nullptr;
 }
 
+/*
+  the frames in supported_frames[] share their motors with every
+  aircraft that uses them. Aircraft that may be simulated alongside
+  others in one process take a copy instead, so motor and battery
+  state is not shared between them
+ */
+Frame *Frame::clone_frame(const char *name)
+{
+    const Frame *f = find_frame(name);
+    if (f == nullptr) {
+        return nullptr;
+    }
+    Frame *ret = NEW_NOTHROW Frame(*f);
+    Motor *motors_copy = (Motor *)calloc(f->num_motors, sizeof(Motor));
+    if (ret == nullptr || motors_copy == nullptr) {
+        delete ret;
+        free(motors_copy);
+        return nullptr;
+    }
+    for (uint8_t i = 0; i < f->num_motors; i++) {
+        new (&motors_copy[i]) Motor(f->motors[i]);
+    }
+    ret->motors = motors_copy;
+    return ret;
+}
+
 // calculate rotational and linear accelerations
 void Frame::calculate_forces(const Aircraft &aircraft,
                              const struct sitl_input &input,
@@ -79,7 +79,7 @@ QuadPlane::QuadPlane(const char *frame_str) :
         ground_behavior = GROUND_BEHAVIOR_TAILSITTER;
         thrust_scale *= 1.5;
     }
-    frame = Frame::find_frame(frame_type);
+    frame = Frame::clone_frame(frame_type);
     if (frame == nullptr) {
         printf("Failed to find frame '%s'\n", frame_type);
         exit(1);
@@ -0,0 +1,124 @@
+#include <AP_gtest.h>
+
+#include <SITL/SITL.h>
+#include <SITL/SIM_Aircraft.h>
+
+#include <thread>
+
+const AP_HAL::HAL& hal = AP_HAL::get_HAL();
+
+static SITL::SIM sitl;
+
+/*
+  an airborne model whose only dynamics are wind turbulence, sensor
+  noise and rangefinder noise, the parts of a model which draw random
+  numbers
+ */
+class NoisyModel : public SITL::Aircraft {
+public:
+    NoisyModel() : SITL::Aircraft("quad") {
+        // level, so a downward rangefinder sees the ground
+        dcm.identity();
+    }
+
+    void update(const struct sitl_input &input) override
+    {
+        gyro.zero();
+        accel_body.zero();
+        update_wind(input);
+        add_noise(1);
+        gyro_sum += gyro;
+        accel_sum += accel_body;
+        wind_sum += wind_ef;
+        range_sum += rangefinder_range();
+    }
+
+    float perpendicular_distance_to_rangefinder_surface() const override
+    {
+        return 0;
+    }
+
+    bool on_ground() const override
+    {
+        return false;
+    }
+
+    // summed over every step
+    Vector3f gyro_sum;
+    Vector3f accel_sum;
+    Vector3f wind_sum;
+    float range_sum;
+};
+
+static const uint8_t num_models = 8;
+static const uint16_t num_steps = 2000;
+
+/*
+  step the models for num_steps frames, either all on this thread as
+  with SwarmSim --jobs 1, or each on its own thread
+ */
+static void run_models(NoisyModel *models, bool threaded)
+{
+    struct sitl_input input {};
+    input.wind.speed = 5;
+    input.wind.turbulence = 1;
+
+    for (uint8_t i = 0; i < num_models; i++) {
+        models[i].set_instance(i);
+    }
+
+    if (!threaded) {
+        for (uint16_t step = 0; step < num_steps; step++) {
+            for (uint8_t i = 0; i < num_models; i++) {
+                models[i].update_model(input);
+            }
+        }
+        return;
+    }
+
+    std::thread threads[num_models];
+    for (uint8_t i = 0; i < num_models; i++) {
+        threads[i] = std::thread([models, i, &input]() {
+            for (uint16_t step = 0; step < num_steps; step++) {
+                models[i].update_model(input);
+            }
+        });
+    }
+    for (uint8_t i = 0; i < num_models; i++) {
+        threads[i].join();
+    }
+}
+
+TEST(Aircraft, random_independent_of_threads)
+{
+    // a downward rangefinder, so every reading draws noise
+    sitl.sonar_rot.set(ROTATION_PITCH_270);
+    sitl.sonar_noise.set(0.5);
+
+    NoisyModel *single = NEW_NOTHROW NoisyModel[num_models];
+    NoisyModel *threaded = NEW_NOTHROW NoisyModel[num_models];
+    ASSERT_NE(single, nullptr);
+    ASSERT_NE(threaded, nullptr);
+
+    run_models(single, false);
+    run_models(threaded, true);
+
+    for (uint8_t i = 0; i < num_models; i++) {
+        EXPECT_EQ(single[i].gyro_sum, threaded[i].gyro_sum) << "model " << unsigned(i);
+        EXPECT_EQ(single[i].accel_sum, threaded[i].accel_sum) << "model " << unsigned(i);
+        EXPECT_EQ(single[i].wind_sum, threaded[i].wind_sum) << "model " << unsigned(i);
+        EXPECT_EQ(single[i].range_sum, threaded[i].range_sum) << "model " << unsigned(i);
+    }
+
+    // each instance has its own noise
+    for (uint8_t i = 1; i < num_models; i++) {
+        EXPECT_NE(single[0].gyro_sum, single[i].gyro_sum) << "model " << unsigned(i);
+        EXPECT_NE(single[0].wind_sum, single[i].wind_sum) << "model " << unsigned(i);
+        EXPECT_NE(single[0].range_sum, single[i].range_sum) << "model " << unsigned(i);
+    }
+
+    delete[] single;
+    delete[] threaded;
+}
+
+AP_GTEST_MAIN()